@@ -0,0 +1,652 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Offline tuning tool that runs every combination of codec, compression
+  level, filters, block size and number of threads over a sample of real
+  data (a raw file or a Blosc2 frame), prints the Pareto front of the
+  compression ratio against the compression and decompression speeds, and
+  recommends a set of cparams.  Combinations that do not compress are only
+  recommended when no other one does.
+
+  To compile this program:
+
+  $ gcc -O3 blosc2-tune.c -o blosc2-tune -lblosc2
+
+  To run:
+
+  $ ./blosc2-tune [options] file
+
+  Run it without arguments for the list of options.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <sys/stat.h>
+#include <blosc2.h>
+
+#define KB  1024
+#define MB  (1024*KB)
+#define GB  (1024*MB)
+
+/* Maximum number of values in a comma-separated option */
+#define MAX_VALUES 32
+
+#define DEFAULT_TYPESIZE 4
+#define DEFAULT_CHUNKSIZE (4 * MB)
+#define DEFAULT_SAMPLESIZE (16 * MB)
+/* The ratio weighs more than each speed, as not compressing is always the fastest */
+#define DEFAULT_RATIO_WEIGHT 2
+
+
+typedef struct {
+  const char* name;
+  uint8_t delta;
+  uint8_t shuffle;
+} filter_chain;
+
+static const filter_chain filter_chains[] = {
+    {"nofilter", BLOSC_NOFILTER, BLOSC_NOFILTER},
+    {"shuffle", BLOSC_NOFILTER, BLOSC_SHUFFLE},
+    {"bitshuffle", BLOSC_NOFILTER, BLOSC_BITSHUFFLE},
+    {"delta+shuffle", BLOSC_DELTA, BLOSC_SHUFFLE},
+    {"delta_sub+shuffle", BLOSC_DELTA_SUB, BLOSC_SHUFFLE},
+};
+#define NCHAINS ((int)(sizeof(filter_chains) / sizeof(filter_chains[0])))
+
+static const char* filter_names[] = {
+    "BLOSC_NOFILTER", "BLOSC_SHUFFLE", "BLOSC_BITSHUFFLE", "BLOSC_DELTA", "BLOSC_TRUNC_PREC",
+    "BLOSC_DELTA_SUB",
+};
+
+static const char* codec_macros[] = {
+    "BLOSC_BLOSCLZ", "BLOSC_LZ4", "BLOSC_LZ4HC", "BLOSC_SNAPPY", "BLOSC_ZLIB", "BLOSC_ZSTD",
+};
+
+
+typedef struct {
+  int compcode;
+  int clevel;
+  int chain;
+  int32_t blocksize;
+  int nthreads;
+  double ratio;
+  double cspeed;  // GB/s
+  double dspeed;  // GB/s
+  bool pareto;
+} trial;
+
+typedef struct {
+  int32_t typesize;
+  int32_t chunksize;
+  int64_t samplesize;
+  int niter;
+  int codecs[MAX_VALUES];
+  int ncodecs;
+  int clevels[MAX_VALUES];
+  int nclevels;
+  int chains[MAX_VALUES];
+  int nchains;
+  int blocksizes[MAX_VALUES];
+  int nblocksizes;
+  int nthreads[MAX_VALUES];
+  int nnthreads;
+  double weights[3];
+  const char* json_path;
+  bool verbose;
+} options;
+
+
+static void print_usage(void) {
+  printf("Usage: blosc2-tune [options] file\n\n"
+         "The file can be a Blosc2 frame (contiguous or sparse) or raw data.\n\n"
+         "Options:\n"
+         "  -t typesize     Size of the items (default: the one of the frame, or %d)\n"
+         "  -c chunksize    Size of the chunks in bytes (default: the one of the frame, or %d)\n"
+         "  -s samplesize   Maximum of bytes of the file that are used (default: %d)\n"
+         "  -C codecs       Comma-separated codec names (default: all the available ones)\n"
+         "  -l clevels      Comma-separated compression levels (default: 1,3,5,7,9)\n"
+         "  -f filters      Comma-separated filter chains (default: all of them)\n"
+         "  -b blocksizes   Comma-separated block sizes in bytes, 0 is automatic\n"
+         "                  (default: 0,16384,65536,262144,1048576)\n"
+         "  -n nthreads     Comma-separated numbers of threads (default: 1 and the number of cores)\n"
+         "  -i niter        Number of iterations, the best time is kept (default: 1)\n"
+         "  -w r,c,d        Weights of the ratio and the compression and decompression\n"
+         "                  speeds (relative to the best ones) for choosing the recommended\n"
+         "                  cparams (default: %d,1,1)\n"
+         "  -j file         Write the Pareto front and the recommended cparams as JSON\n"
+         "  -v              Print every combination, not only the Pareto front\n\n",
+         DEFAULT_TYPESIZE, DEFAULT_CHUNKSIZE, DEFAULT_SAMPLESIZE, DEFAULT_RATIO_WEIGHT);
+  printf("Filter chains:");
+  for (int i = 0; i < NCHAINS; i++) {
+    printf(" %s", filter_chains[i].name);
+  }
+  printf("\nCodecs: %s\n", blosc_list_compressors());
+}
+
+
+/* Parse a comma-separated list of ints.  Returns the number of values, or -1 on error. */
+static int parse_ints(const char* list, int* values) {
+  int n = 0;
+  const char* p = list;
+  while (*p != '\0') {
+    char* end;
+    long value = strtol(p, &end, 10);
+    if (end == p || n == MAX_VALUES) {
+      return -1;
+    }
+    values[n++] = (int)value;
+    p = (*end == ',') ? end + 1 : end;
+  }
+  return n;
+}
+
+/* Parse a comma-separated list of names with `lookup`.  Returns the number of values, or -1 on error. */
+static int parse_names(const char* list, int* values, int (*lookup)(const char*)) {
+  char name[64];
+  int n = 0;
+  const char* p = list;
+  while (*p != '\0') {
+    size_t len = strcspn(p, ",");
+    if (len >= sizeof(name) || n == MAX_VALUES) {
+      return -1;
+    }
+    memcpy(name, p, len);
+    name[len] = '\0';
+    int value = lookup(name);
+    if (value < 0) {
+      printf("Unknown or unavailable: %s\n", name);
+      return -1;
+    }
+    values[n++] = value;
+    p += len;
+    if (*p == ',') {
+      p++;
+    }
+  }
+  return n;
+}
+
+static int chain_lookup(const char* name) {
+  for (int i = 0; i < NCHAINS; i++) {
+    if (strcmp(name, filter_chains[i].name) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+
+static int parse_options(int argc, char* argv[], options* opts, const char** path) {
+  *path = NULL;
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    if (arg[0] != '-') {
+      *path = arg;
+      continue;
+    }
+    if (strcmp(arg, "-v") == 0) {
+      opts->verbose = true;
+      continue;
+    }
+    if (i + 1 >= argc || strlen(arg) != 2) {
+      return -1;
+    }
+    const char* value = argv[++i];
+    int rc = 0;
+    switch (arg[1]) {
+      case 't':
+        opts->typesize = (int32_t)strtol(value, NULL, 10);
+        rc = opts->typesize > 0 && opts->typesize <= BLOSC_MAX_TYPESIZE ? 0 : -1;
+        break;
+      case 'c':
+        opts->chunksize = (int32_t)strtol(value, NULL, 10);
+        rc = opts->chunksize > 0 ? 0 : -1;
+        break;
+      case 's':
+        opts->samplesize = strtoll(value, NULL, 10);
+        rc = opts->samplesize > 0 ? 0 : -1;
+        break;
+      case 'C':
+        opts->ncodecs = rc = parse_names(value, opts->codecs, blosc_compname_to_compcode);
+        break;
+      case 'l':
+        opts->nclevels = rc = parse_ints(value, opts->clevels);
+        break;
+      case 'f':
+        opts->nchains = rc = parse_names(value, opts->chains, chain_lookup);
+        break;
+      case 'b':
+        opts->nblocksizes = rc = parse_ints(value, opts->blocksizes);
+        break;
+      case 'n':
+        opts->nnthreads = rc = parse_ints(value, opts->nthreads);
+        break;
+      case 'i':
+        opts->niter = (int)strtol(value, NULL, 10);
+        rc = opts->niter > 0 ? 0 : -1;
+        break;
+      case 'w':
+        rc = sscanf(value, "%lf,%lf,%lf", &opts->weights[0], &opts->weights[1], &opts->weights[2]) == 3 ? 0 : -1;
+        break;
+      case 'j':
+        opts->json_path = value;
+        break;
+      default:
+        rc = -1;
+    }
+    if (rc < 0) {
+      printf("Bad value for %s: %s\n", arg, value);
+      return -1;
+    }
+  }
+  return *path == NULL ? -1 : 0;
+}
+
+
+/* Whether the file at `path` is a Blosc2 frame */
+static bool is_frame(const char* path) {
+  struct stat info;
+  if (stat(path, &info) != 0) {
+    return false;
+  }
+  if (info.st_mode & S_IFDIR) {
+    // A sparse frame
+    return true;
+  }
+  char header[16];
+  FILE* file = fopen(path, "rb");
+  if (file == NULL) {
+    return false;
+  }
+  size_t nread = fread(header, 1, sizeof(header), file);
+  fclose(file);
+  return nread == sizeof(header) && memcmp(header + 2, "b2frame", 8) == 0;
+}
+
+/* Read up to opts->samplesize bytes out of `path` into *sample.  Returns the number of bytes read. */
+static int64_t read_sample(const char* path, options* opts, uint8_t** sample) {
+  int64_t nbytes = 0;
+  *sample = malloc(opts->samplesize);
+  if (*sample == NULL) {
+    return -1;
+  }
+
+  if (is_frame(path)) {
+    blosc2_schunk* schunk = blosc2_schunk_open(path);
+    if (schunk == NULL) {
+      printf("Cannot open the frame %s\n", path);
+      return -1;
+    }
+    if (opts->typesize == 0) {
+      opts->typesize = schunk->typesize;
+    }
+    if (opts->chunksize == 0) {
+      opts->chunksize = schunk->chunksize;
+    }
+    uint8_t* chunk = malloc(schunk->chunksize);
+    for (int nchunk = 0; nchunk < schunk->nchunks && nbytes < opts->samplesize; nchunk++) {
+      int dsize = blosc2_schunk_decompress_chunk(schunk, nchunk, chunk, schunk->chunksize);
+      if (dsize < 0) {
+        printf("Cannot decompress the chunk %d of the frame.  Error code: %d\n", nchunk, dsize);
+        free(chunk);
+        blosc2_schunk_free(schunk);
+        return -1;
+      }
+      if (dsize > opts->samplesize - nbytes) {
+        dsize = (int)(opts->samplesize - nbytes);
+      }
+      memcpy(*sample + nbytes, chunk, dsize);
+      nbytes += dsize;
+    }
+    free(chunk);
+    blosc2_schunk_free(schunk);
+  }
+  else {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+      printf("Cannot open the file %s\n", path);
+      return -1;
+    }
+    nbytes = (int64_t)fread(*sample, 1, opts->samplesize, file);
+    fclose(file);
+  }
+
+  if (opts->typesize == 0) {
+    opts->typesize = DEFAULT_TYPESIZE;
+  }
+  if (opts->chunksize == 0) {
+    opts->chunksize = DEFAULT_CHUNKSIZE;
+  }
+  opts->chunksize = opts->chunksize / opts->typesize * opts->typesize;
+  return nbytes / opts->typesize * opts->typesize;
+}
+
+
+/* Compress and decompress the sample in chunks with the parameters of `t`.  Returns 0 on success. */
+static int run_trial(trial* t, const options* opts, const uint8_t* sample, int64_t nbytes,
+                     uint8_t* cbuffer, uint8_t* dbuffer) {
+  blosc_timestamp_t last, current;
+  int32_t chunksize = opts->chunksize;
+  int64_t nchunks = (nbytes + chunksize - 1) / chunksize;
+  int32_t cchunksize = chunksize + BLOSC_MAX_OVERHEAD;
+
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = opts->typesize;
+  cparams.compcode = (uint8_t)t->compcode;
+  cparams.clevel = (uint8_t)t->clevel;
+  cparams.blocksize = t->blocksize;
+  cparams.nthreads = (int16_t)t->nthreads;
+  cparams.filters[BLOSC2_MAX_FILTERS - 2] = filter_chains[t->chain].delta;
+  cparams.filters[BLOSC2_MAX_FILTERS - 1] = filter_chains[t->chain].shuffle;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = (int16_t)t->nthreads;
+  blosc2_context* cctx = blosc2_create_cctx(cparams);
+  blosc2_context* dctx = blosc2_create_dctx(dparams);
+  if (cctx == NULL || dctx == NULL) {
+    return -1;
+  }
+
+  int64_t cbytes = 0;
+  double ctime = 0, dtime = 0;
+  int rc = 0;
+  for (int iter = 0; iter < opts->niter && rc >= 0; iter++) {
+    cbytes = 0;
+    blosc_set_timestamp(&last);
+    for (int64_t nchunk = 0; nchunk < nchunks; nchunk++) {
+      int64_t start = nchunk * chunksize;
+      int32_t size = (int32_t)(nbytes - start < chunksize ? nbytes - start : chunksize);
+      rc = blosc2_compress_ctx(cctx, sample + start, size, cbuffer + nchunk * cchunksize, cchunksize);
+      if (rc <= 0) {
+        printf("Compression error.  Error code: %d\n", rc);
+        rc = -1;
+        break;
+      }
+      cbytes += rc;
+    }
+    blosc_set_timestamp(&current);
+    double elapsed = blosc_elapsed_secs(last, current);
+    ctime = (iter == 0 || elapsed < ctime) ? elapsed : ctime;
+    if (rc < 0) {
+      break;
+    }
+
+    blosc_set_timestamp(&last);
+    for (int64_t nchunk = 0; nchunk < nchunks; nchunk++) {
+      int64_t start = nchunk * chunksize;
+      int32_t size = (int32_t)(nbytes - start < chunksize ? nbytes - start : chunksize);
+      rc = blosc2_decompress_ctx(dctx, cbuffer + nchunk * cchunksize, cchunksize, dbuffer + start, size);
+      if (rc != size) {
+        printf("Decompression error.  Error code: %d\n", rc);
+        rc = -1;
+        break;
+      }
+    }
+    blosc_set_timestamp(&current);
+    elapsed = blosc_elapsed_secs(last, current);
+    dtime = (iter == 0 || elapsed < dtime) ? elapsed : dtime;
+  }
+  blosc2_free_ctx(cctx);
+  blosc2_free_ctx(dctx);
+  if (rc < 0) {
+    return rc;
+  }
+  if (memcmp(sample, dbuffer, nbytes) != 0) {
+    printf("Decompressed data differs from original!\n");
+    return -1;
+  }
+
+  t->ratio = (double)nbytes / (double)cbytes;
+  t->cspeed = (double)nbytes / (GB * ctime);
+  t->dspeed = (double)nbytes / (GB * dtime);
+  return 0;
+}
+
+
+/* Mark the trials that no other one beats in ratio and in both speeds */
+static void mark_pareto(trial* trials, int ntrials) {
+  for (int i = 0; i < ntrials; i++) {
+    trials[i].pareto = true;
+    for (int j = 0; j < ntrials && trials[i].pareto; j++) {
+      trial* a = &trials[i];
+      trial* b = &trials[j];
+      if (j != i && b->ratio >= a->ratio && b->cspeed >= a->cspeed && b->dspeed >= a->dspeed &&
+          (b->ratio > a->ratio || b->cspeed > a->cspeed || b->dspeed > a->dspeed)) {
+        a->pareto = false;
+      }
+    }
+  }
+}
+
+/* Choose the trial of the Pareto front with the best score.  The ratio and the speeds are
+ * taken relative to the best ones, and trials that do not compress are left out unless
+ * no trial does. */
+static const trial* choose_best(const trial* trials, int ntrials, const double* weights,
+                                double* best_score) {
+  double max_ratio = 0, max_cspeed = 0, max_dspeed = 0;
+  for (int i = 0; i < ntrials; i++) {
+    const trial* t = &trials[i];
+    if (t->pareto) {
+      max_ratio = t->ratio > max_ratio ? t->ratio : max_ratio;
+      max_cspeed = t->cspeed > max_cspeed ? t->cspeed : max_cspeed;
+      max_dspeed = t->dspeed > max_dspeed ? t->dspeed : max_dspeed;
+    }
+  }
+  const trial* best = NULL;
+  for (int i = 0; i < ntrials; i++) {
+    const trial* t = &trials[i];
+    if (!t->pareto || (t->ratio <= 1 && max_ratio > 1)) {
+      continue;
+    }
+    double score = weights[0] * log(t->ratio / max_ratio) + weights[1] * log(t->cspeed / max_cspeed) +
+                   weights[2] * log(t->dspeed / max_dspeed);
+    if (best == NULL || score > *best_score) {
+      best = t;
+      *best_score = score;
+    }
+  }
+  return best;
+}
+
+static int compare_ratio(const void* a, const void* b) {
+  double ra = ((const trial*)a)->ratio;
+  double rb = ((const trial*)b)->ratio;
+  return ra < rb ? 1 : ra > rb ? -1 : 0;
+}
+
+
+static const char* codec_name(int compcode) {
+  const char* name = "unknown";
+  blosc_compcode_to_compname(compcode, &name);
+  return name;
+}
+
+static void print_trial(const trial* t) {
+  printf("%-8s %6d %-18s %10d %8d %9.2fx %12.3f %12.3f %s\n", codec_name(t->compcode), t->clevel,
+         filter_chains[t->chain].name, t->blocksize, t->nthreads, t->ratio, t->cspeed, t->dspeed,
+         t->pareto ? "*" : "");
+}
+
+static void print_header(void) {
+  printf("%-8s %6s %-18s %10s %8s %10s %12s %12s\n", "codec", "clevel", "filters", "blocksize",
+         "nthreads", "ratio", "comp GB/s", "decomp GB/s");
+}
+
+
+static void print_cparams(const trial* t, const options* opts) {
+  printf("blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;\n");
+  printf("cparams.typesize = %d;\n", opts->typesize);
+  printf("cparams.compcode = %s;\n", codec_macros[t->compcode]);
+  printf("cparams.clevel = %d;\n", t->clevel);
+  printf("cparams.blocksize = %d;\n", t->blocksize);
+  printf("cparams.nthreads = %d;\n", t->nthreads);
+  printf("cparams.filters[BLOSC2_MAX_FILTERS - 2] = %s;\n", filter_names[filter_chains[t->chain].delta]);
+  printf("cparams.filters[BLOSC2_MAX_FILTERS - 1] = %s;\n", filter_names[filter_chains[t->chain].shuffle]);
+}
+
+static void write_json_trial(FILE* file, const trial* t) {
+  fprintf(file, "{\"codec\": \"%s\", \"clevel\": %d, \"filters\": \"%s\", \"blocksize\": %d, "
+                "\"nthreads\": %d, \"ratio\": %.4f, \"cspeed_gbps\": %.4f, \"dspeed_gbps\": %.4f}",
+          codec_name(t->compcode), t->clevel, filter_chains[t->chain].name, t->blocksize,
+          t->nthreads, t->ratio, t->cspeed, t->dspeed);
+}
+
+static int write_json(const char* path, const trial* trials, int ntrials, const trial* best,
+                      const options* opts, int64_t nbytes) {
+  FILE* file = fopen(path, "w");
+  if (file == NULL) {
+    printf("Cannot open %s for writing\n", path);
+    return -1;
+  }
+  fprintf(file, "{\n  \"nbytes\": %lld,\n  \"typesize\": %d,\n  \"chunksize\": %d,\n  \"pareto\": [\n",
+          (long long)nbytes, opts->typesize, opts->chunksize);
+  bool first = true;
+  for (int i = 0; i < ntrials; i++) {
+    if (!trials[i].pareto) {
+      continue;
+    }
+    fprintf(file, "%s    ", first ? "" : ",\n");
+    write_json_trial(file, &trials[i]);
+    first = false;
+  }
+  uint8_t filters[BLOSC2_MAX_FILTERS] = {0};
+  filters[BLOSC2_MAX_FILTERS - 2] = filter_chains[best->chain].delta;
+  filters[BLOSC2_MAX_FILTERS - 1] = filter_chains[best->chain].shuffle;
+  fprintf(file, "\n  ],\n  \"cparams\": {\"typesize\": %d, \"compcode\": %d, \"clevel\": %d, "
+                "\"blocksize\": %d, \"nthreads\": %d, \"filters\": [",
+          opts->typesize, best->compcode, best->clevel, best->blocksize, best->nthreads);
+  for (int i = 0; i < BLOSC2_MAX_FILTERS; i++) {
+    fprintf(file, "%s%d", i > 0 ? ", " : "", filters[i]);
+  }
+  fprintf(file, "]}\n}\n");
+  fclose(file);
+  return 0;
+}
+
+
+int main(int argc, char* argv[]) {
+  options opts = {0};
+  const char* path;
+  static const int all_codecs[] = {BLOSC_BLOSCLZ, BLOSC_LZ4, BLOSC_LZ4HC, BLOSC_ZLIB, BLOSC_ZSTD};
+  static const int default_clevels[] = {1, 3, 5, 7, 9};
+  static const int default_blocksizes[] = {0, 16 * KB, 64 * KB, 256 * KB, 1 * MB};
+
+  blosc_init();
+  opts.samplesize = DEFAULT_SAMPLESIZE;
+  opts.niter = 1;
+  opts.weights[0] = DEFAULT_RATIO_WEIGHT;
+  opts.weights[1] = opts.weights[2] = 1;
+  for (int i = 0; i < (int)(sizeof(all_codecs) / sizeof(all_codecs[0])); i++) {
+    const char* name;
+    if (blosc_compcode_to_compname(all_codecs[i], &name) >= 0 && blosc_compname_to_compcode(name) >= 0) {
+      opts.codecs[opts.ncodecs++] = all_codecs[i];
+    }
+  }
+  memcpy(opts.clevels, default_clevels, sizeof(default_clevels));
+  opts.nclevels = sizeof(default_clevels) / sizeof(default_clevels[0]);
+  for (int i = 0; i < NCHAINS; i++) {
+    opts.chains[opts.nchains++] = i;
+  }
+  memcpy(opts.blocksizes, default_blocksizes, sizeof(default_blocksizes));
+  opts.nblocksizes = sizeof(default_blocksizes) / sizeof(default_blocksizes[0]);
+  blosc2_cpu_caches caches;
+  blosc2_get_cpu_caches(&caches);
+  opts.nthreads[opts.nnthreads++] = 1;
+  if (caches.ncores > 1) {
+    opts.nthreads[opts.nnthreads++] = caches.ncores;
+  }
+
+  if (parse_options(argc, argv, &opts, &path) < 0) {
+    print_usage();
+    blosc_destroy();
+    return 1;
+  }
+
+  uint8_t* sample;
+  int64_t nbytes = read_sample(path, &opts, &sample);
+  if (nbytes <= 0) {
+    printf("No data to tune for in %s\n", path);
+    blosc_destroy();
+    return 1;
+  }
+  int64_t nchunks = (nbytes + opts.chunksize - 1) / opts.chunksize;
+  uint8_t* cbuffer = malloc(nchunks * (opts.chunksize + BLOSC_MAX_OVERHEAD));
+  uint8_t* dbuffer = malloc(nbytes);
+  int maxtrials = opts.ncodecs * opts.nclevels * opts.nchains * opts.nblocksizes * opts.nnthreads;
+  trial* trials = malloc(maxtrials * sizeof(trial));
+
+  printf("Blosc version info: %s (%s)\n", BLOSC_VERSION_STRING, BLOSC_VERSION_DATE);
+  printf("Tuning for %lld bytes of %s (typesize %d, chunksize %d) with %d combinations\n\n",
+         (long long)nbytes, path, opts.typesize, opts.chunksize, maxtrials);
+  if (opts.verbose) {
+    print_header();
+  }
+
+  int ntrials = 0;
+  int rc = 0;
+  for (int ic = 0; ic < opts.ncodecs && rc == 0; ic++) {
+    for (int il = 0; il < opts.nclevels && rc == 0; il++) {
+      for (int ich = 0; ich < opts.nchains && rc == 0; ich++) {
+        for (int ib = 0; ib < opts.nblocksizes && rc == 0; ib++) {
+          if (opts.blocksizes[ib] > opts.chunksize) {
+            continue;
+          }
+          for (int it = 0; it < opts.nnthreads && rc == 0; it++) {
+            trial* t = &trials[ntrials];
+            memset(t, 0, sizeof(trial));
+            t->compcode = opts.codecs[ic];
+            t->clevel = opts.clevels[il];
+            t->chain = opts.chains[ich];
+            t->blocksize = opts.blocksizes[ib];
+            t->nthreads = opts.nthreads[it];
+            rc = run_trial(t, &opts, sample, nbytes, cbuffer, dbuffer);
+            if (rc == 0) {
+              if (opts.verbose) {
+                print_trial(t);
+              }
+              ntrials++;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  if (rc == 0 && ntrials > 0) {
+    mark_pareto(trials, ntrials);
+    qsort(trials, ntrials, sizeof(trial), compare_ratio);
+    printf("%sPareto front (ratio against compression and decompression speeds):\n",
+           opts.verbose ? "\n" : "");
+    print_header();
+    for (int i = 0; i < ntrials; i++) {
+      const trial* t = &trials[i];
+      if (!t->pareto) {
+        continue;
+      }
+      print_trial(t);
+    }
+    double best_score = 0;
+    const trial* best = choose_best(trials, ntrials, opts.weights, &best_score);
+    printf("\nRecommended cparams (weights %g,%g,%g for ratio, comp and decomp speeds):\n\n",
+           opts.weights[0], opts.weights[1], opts.weights[2]);
+    print_cparams(best, &opts);
+    printf("\nExpected ratio: %.2fx, comp: %.3f GB/s, decomp: %.3f GB/s (score %.3f)\n",
+           best->ratio, best->cspeed, best->dspeed, best_score);
+    if (opts.json_path != NULL) {
+      rc = write_json(opts.json_path, trials, ntrials, best, &opts, nbytes);
+    }
+  }
+
+  free(trials);
+  free(sample);
+  free(cbuffer);
+  free(dbuffer);
+  blosc_destroy();
+
+  return rc == 0 ? 0 : 1;
+}
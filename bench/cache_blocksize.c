@@ -0,0 +1,175 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Benchmark comparing the automatic blocksizes derived from the caches
+  detected in the host against the ones derived from the fixed defaults
+  (BLOSC2_CPU_CACHES_DEFAULTS).
+
+  To compile this program:
+
+  $ gcc -O3 cache_blocksize.c -o cache_blocksize -lblosc2
+
+  To run:
+
+  $ ./cache_blocksize [niter] [nthreads]
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <blosc2.h>
+
+#define KB  1024
+#define MB  (1024*KB)
+#define GB  (1024*MB)
+
+#define NELEMS (8 * 1000 * 1000)
+#define NITER 5
+#define NTHREADS 4
+
+
+typedef struct {
+  const char* name;
+  int compcode;
+  int clevel;
+  int32_t typesize;
+  uint8_t filter;
+} setup;
+
+static const setup setups[] = {
+    {"blosclz", BLOSC_BLOSCLZ, 1, 4, BLOSC_SHUFFLE},
+    {"blosclz", BLOSC_BLOSCLZ, 5, 4, BLOSC_SHUFFLE},
+    {"lz4", BLOSC_LZ4, 1, 8, BLOSC_SHUFFLE},
+    {"lz4", BLOSC_LZ4, 5, 8, BLOSC_SHUFFLE},
+    {"lz4", BLOSC_LZ4, 9, 8, BLOSC_SHUFFLE},
+    {"lz4", BLOSC_LZ4, 5, 4, BLOSC_BITSHUFFLE},
+    {"zstd", BLOSC_ZSTD, 1, 8, BLOSC_SHUFFLE},
+    {"zstd", BLOSC_ZSTD, 5, 4, BLOSC_BITSHUFFLE},
+};
+
+
+static void fill_buffer(uint8_t* buffer, int32_t nelems, int32_t typesize) {
+  for (int32_t i = 0; i < nelems; i++) {
+    if (typesize == 4) {
+      // A slowly varying signal
+      ((float*)buffer)[i] = (float)i * 0.001f + (float)((i * 13) % 7) * 0.1f;
+    }
+    else {
+      // Timestamps with some jitter
+      ((int64_t*)buffer)[i] = 1600000000000LL + (int64_t)i * 1000 + (i * 7) % 13;
+    }
+  }
+}
+
+
+/* Compress and decompress `src` with the caches in use.  Returns 0 on success. */
+static int run(const setup* set, int niter, int nthreads, const char* caches_name,
+               uint8_t* src, uint8_t* dest, uint8_t* src2, int32_t isize) {
+  blosc_timestamp_t last, current;
+  int32_t osize = isize + BLOSC_MAX_OVERHEAD;
+  double totalsize = (double)isize * niter;
+
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = set->typesize;
+  cparams.compcode = set->compcode;
+  cparams.clevel = set->clevel;
+  cparams.nthreads = nthreads;
+  cparams.filters[BLOSC2_MAX_FILTERS - 1] = set->filter;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = nthreads;
+  blosc2_context* cctx = blosc2_create_cctx(cparams);
+  blosc2_context* dctx = blosc2_create_dctx(dparams);
+
+  int csize = 0;
+  blosc_set_timestamp(&last);
+  for (int i = 0; i < niter; i++) {
+    csize = blosc2_compress_ctx(cctx, src, isize, dest, osize);
+  }
+  blosc_set_timestamp(&current);
+  double ctime = blosc_elapsed_secs(last, current);
+  if (csize <= 0) {
+    printf("Compression error.  Error code: %d\n", csize);
+    return csize;
+  }
+
+  int dsize = 0;
+  blosc_set_timestamp(&last);
+  for (int i = 0; i < niter; i++) {
+    dsize = blosc2_decompress_ctx(dctx, dest, csize, src2, isize);
+  }
+  blosc_set_timestamp(&current);
+  double dtime = blosc_elapsed_secs(last, current);
+  if (dsize != isize) {
+    printf("Decompression error.  Error code: %d\n", dsize);
+    return dsize < 0 ? dsize : -1;
+  }
+  if (memcmp(src, src2, isize) != 0) {
+    printf("Decompressed data differs from original!\n");
+    return -1;
+  }
+
+  int32_t nbytes, cbytes, blocksize;
+  blosc2_cbuffer_sizes(dest, &nbytes, &cbytes, &blocksize);
+  printf("%-8s %6d %8d %-10s %-9s %10d %9.1fx %12.2f %12.2f\n", set->name, set->clevel,
+         set->typesize, set->filter == BLOSC_SHUFFLE ? "shuffle" : "bitshuffle", caches_name,
+         blocksize, (1. * isize) / csize, totalsize / (GB * ctime), totalsize / (GB * dtime));
+  blosc2_free_ctx(cctx);
+  blosc2_free_ctx(dctx);
+  return 0;
+}
+
+
+int main(int argc, char* argv[]) {
+  int niter = NITER;
+  int nthreads = NTHREADS;
+  blosc2_cpu_caches detected;
+
+  if (argc > 1) {
+    niter = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    nthreads = atoi(argv[2]);
+  }
+
+  printf("Blosc version info: %s (%s)\n", BLOSC_VERSION_STRING, BLOSC_VERSION_DATE);
+  blosc_init();
+  blosc2_get_cpu_caches(&detected);
+  printf("Detected caches: L1 %d KB, L2 %d KB, L3 %d KB shared by %d cores (%d cores)\n",
+         detected.l1_size / KB, detected.l2_size / KB, detected.l3_size / KB,
+         detected.l3_ncores, detected.ncores);
+  printf("Fixed caches:    L1 %d KB, L2 %d KB, L3 %d KB shared by %d cores\n",
+         BLOSC2_CPU_CACHES_DEFAULTS.l1_size / KB, BLOSC2_CPU_CACHES_DEFAULTS.l2_size / KB,
+         BLOSC2_CPU_CACHES_DEFAULTS.l3_size / KB, BLOSC2_CPU_CACHES_DEFAULTS.l3_ncores);
+  printf("Using %d threads and %d iterations\n\n", nthreads, niter);
+  printf("%-8s %6s %8s %-10s %-9s %10s %10s %12s %12s\n", "codec", "clevel", "typesize",
+         "filter", "caches", "blocksize", "ratio", "comp GB/s", "decomp GB/s");
+
+  int rc = 0;
+  for (int s = 0; s < (int)(sizeof(setups) / sizeof(setups[0])) && rc == 0; s++) {
+    const setup* set = &setups[s];
+    int32_t isize = NELEMS * set->typesize;
+    uint8_t* src = malloc(isize);
+    uint8_t* dest = malloc(isize + BLOSC_MAX_OVERHEAD);
+    uint8_t* src2 = malloc(isize);
+    fill_buffer(src, NELEMS, set->typesize);
+
+    blosc2_set_cpu_caches(&BLOSC2_CPU_CACHES_DEFAULTS);
+    rc = run(set, niter, nthreads, "fixed", src, dest, src2, isize);
+    if (rc == 0) {
+      blosc2_set_cpu_caches(&detected);
+      rc = run(set, niter, nthreads, "detected", src, dest, src2, isize);
+    }
+
+    free(src);
+    free(dest);
+    free(src2);
+  }
+
+  blosc_destroy();
+
+  return rc;
+}
@@ -0,0 +1,165 @@
+/*********************************************************************
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Benchmark for reading on-disk frames with the stdio vs the memory-mapped
+  vs the io_uring input/output backends.
+
+  Usage: mmap_bench [nchunks] [nthreads]
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <blosc2.h>
+
+#define KB  1024
+#define MB  (1024*KB)
+#define GB  (1024*MB)
+
+#define NCHUNKS 500
+#define CHUNKSIZE (200 * 1000)
+#define NITEMS 10000        /* number of single items read randomly */
+#define URLPATH "mmap_bench.b2frame"
+
+int nchunks = NCHUNKS;
+int nthreads = 1;
+
+
+static void read_frame(uint8_t io_id, const char* name) {
+  blosc_timestamp_t last, current;
+  size_t isize = CHUNKSIZE * sizeof(int32_t);
+  double totalsize = (double)isize * nchunks;
+  int32_t* data_dest = malloc(isize);
+  double ttime;
+
+  blosc2_io io = {.id = io_id, .params = NULL};
+  blosc2_schunk* schunk = blosc2_schunk_open_udio(URLPATH, &io);
+  if (schunk == NULL) {
+    printf("Cannot open the frame with the %s backend\n", name);
+    exit(1);
+  }
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = (int16_t)nthreads;
+  dparams.schunk = schunk;
+  blosc2_free_ctx(schunk->dctx);
+  schunk->dctx = blosc2_create_dctx(dparams);
+
+  // Decompress the whole frame several times; only the first pass may hit the disk
+  for (int pass = 0; pass < 3; pass++) {
+    blosc_set_timestamp(&last);
+    for (int nchunk = 0; nchunk < nchunks; nchunk++) {
+      int dsize = blosc2_schunk_decompress_chunk(schunk, nchunk, data_dest, isize);
+      if (dsize != (int)isize) {
+        printf("Decompression error.  Error code: %d\n", dsize);
+        exit(1);
+      }
+    }
+    blosc_set_timestamp(&current);
+    ttime = blosc_elapsed_secs(last, current);
+    printf("[%s Decompr #%d] Elapsed time:\t %6.3f s.  Processed data: %.3f GB (%.3f GB/s)\n",
+           name, pass, ttime, totalsize / GB, totalsize / (GB * ttime));
+  }
+
+  // Get the compressed chunks (views with mmap, copies with stdio)
+  blosc_set_timestamp(&last);
+  int64_t cbytes = 0;
+  for (int nchunk = 0; nchunk < nchunks; nchunk++) {
+    uint8_t* chunk;
+    bool needs_free;
+    int csize = blosc2_schunk_get_chunk(schunk, nchunk, &chunk, &needs_free);
+    if (csize < 0) {
+      printf("Cannot get the chunk %d\n", nchunk);
+      exit(1);
+    }
+    cbytes += csize;
+    if (needs_free) {
+      free(chunk);
+    }
+  }
+  blosc_set_timestamp(&current);
+  ttime = blosc_elapsed_secs(last, current);
+  printf("[%s Get chunks] Elapsed time:\t %6.3f s.  Processed data: %.3f GB (%.3f GB/s)\n",
+         name, ttime, (double)cbytes / GB, (double)cbytes / (GB * ttime));
+
+  // Random single items
+  srand(1);
+  blosc_set_timestamp(&last);
+  for (int i = 0; i < NITEMS; i++) {
+    int nchunk = rand() % nchunks;
+    int nitem = rand() % CHUNKSIZE;
+    uint8_t* chunk;
+    bool needs_free;
+    int csize = blosc2_schunk_get_lazychunk(schunk, nchunk, &chunk, &needs_free);
+    int32_t item;
+    if (csize < 0 || blosc2_getitem_ctx(schunk->dctx, chunk, csize, nitem, 1,
+                                        &item, sizeof(item)) != sizeof(item)) {
+      printf("Cannot get the item %d in chunk %d\n", nitem, nchunk);
+      exit(1);
+    }
+    if (needs_free) {
+      free(chunk);
+    }
+  }
+  blosc_set_timestamp(&current);
+  ttime = blosc_elapsed_secs(last, current);
+  printf("[%s Random items] Elapsed time:\t %6.3f s.  %.3f us per item\n",
+         name, ttime, ttime * 1e6 / NITEMS);
+
+  blosc2_schunk_free(schunk);
+  free(data_dest);
+}
+
+
+int main(int argc, char* argv[]) {
+  if (argc > 1) {
+    nchunks = (int)strtol(argv[1], NULL, 10);
+  }
+  if (argc > 2) {
+    nthreads = (int)strtol(argv[2], NULL, 10);
+  }
+  if (nchunks <= 0 || nthreads <= 0) {
+    printf("Usage: mmap_bench [nchunks] [nthreads]\n");
+    return 1;
+  }
+
+  blosc_init();
+#if defined(BLOSC2_HAVE_MMAP_IO)
+  size_t isize = CHUNKSIZE * sizeof(int32_t);
+  int32_t* data = malloc(isize);
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  cparams.nthreads = (int16_t)nthreads;
+  blosc2_storage storage = {.contiguous=true, .urlpath=URLPATH, .cparams=&cparams};
+  blosc2_remove_urlpath(storage.urlpath);
+  blosc2_schunk* schunk = blosc2_schunk_new(&storage);
+  printf("Creating a frame with %d chunks of %d KB\n", nchunks, (int)(isize / KB));
+  for (int nchunk = 0; nchunk < nchunks; nchunk++) {
+    for (int i = 0; i < CHUNKSIZE; i++) {
+      data[i] = i + nchunk * CHUNKSIZE;
+    }
+    if (blosc2_schunk_append_buffer(schunk, data, isize) != nchunk + 1) {
+      printf("Error appending the chunk %d\n", nchunk);
+      return 1;
+    }
+  }
+  printf("Compression super-chunk: %ld -> %ld (%.1fx)\n",
+         (long)schunk->nbytes, (long)schunk->cbytes, (1. * schunk->nbytes) / schunk->cbytes);
+  blosc2_schunk_free(schunk);
+  free(data);
+
+  read_frame(BLOSC2_IO_FILESYSTEM, "stdio");
+  read_frame(BLOSC2_IO_FILESYSTEM_MMAP, "mmap ");
+  read_frame(BLOSC2_IO_FILESYSTEM_URING, "uring");
+
+  blosc2_remove_urlpath(URLPATH);
+#else
+  printf("The memory-mapped backend is not available in this platform\n");
+#endif
+  blosc_destroy();
+
+  return 0;
+}
@@ -0,0 +1,160 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Benchmark showing the throughput of multi-filter pipelines against the
+  block size, with the filters run in tiles or as whole-block passes.
+
+  To compile this program:
+
+  $ gcc -O3 pipeline_tiles.c -o pipeline_tiles -lblosc2
+
+  To run:
+
+  $ ./pipeline_tiles [niter]
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <blosc2.h>
+
+#define KB  1024
+#define MB  (1024*KB)
+#define GB  (1024*MB)
+
+#define NELEMS (4 * 1000 * 1000)
+#define NITER 5
+#define NTHREADS 1
+
+
+typedef struct {
+  const char* name;
+  int32_t typesize;
+  uint8_t filters[2];
+  uint8_t filters_meta[2];
+} pipeline;
+
+static const pipeline pipelines[] = {
+    {"delta+shuffle", 8, {BLOSC_DELTA, BLOSC_SHUFFLE}, {0, 0}},
+    {"delta_sub+shuffle", 8, {BLOSC_DELTA_SUB, BLOSC_SHUFFLE}, {0, 0}},
+    {"trunc+bitshuffle", 4, {BLOSC_TRUNC_PREC, BLOSC_BITSHUFFLE}, {13, 0}},
+    {"delta_sub+bitshuffle", 4, {BLOSC_DELTA_SUB, BLOSC_BITSHUFFLE}, {0, 0}},
+};
+
+static const int32_t blocksizes[] = {32 * KB, 64 * KB, 128 * KB, 256 * KB, 512 * KB, 1 * MB};
+
+
+/* Tiled pipelines are enabled or disabled when the library is initialized */
+static void set_tiled_pipeline(int enabled) {
+  blosc_destroy();
+#if defined(_WIN32)
+  _putenv_s("BLOSC_TILED_PIPELINE", enabled ? "1" : "0");
+#else
+  setenv("BLOSC_TILED_PIPELINE", enabled ? "1" : "0", 1);
+#endif
+  blosc_init();
+}
+
+
+static void fill_buffer(uint8_t* buffer, int32_t nelems, int32_t typesize) {
+  for (int32_t i = 0; i < nelems; i++) {
+    if (typesize == 4) {
+      // A slowly varying signal
+      ((float*)buffer)[i] = (float)i * 0.001f + (float)((i * 13) % 7) * 0.1f;
+    }
+    else {
+      // Timestamps with some jitter
+      ((int64_t*)buffer)[i] = 1600000000000LL + (int64_t)i * 1000 + (i * 7) % 13;
+    }
+  }
+}
+
+
+int main(int argc, char* argv[]) {
+  int niter = NITER;
+  blosc_timestamp_t last, current;
+
+  if (argc > 1) {
+    niter = atoi(argv[1]);
+  }
+
+  printf("Blosc version info: %s (%s)\n", BLOSC_VERSION_STRING, BLOSC_VERSION_DATE);
+  blosc_init();
+
+  for (int p = 0; p < (int)(sizeof(pipelines) / sizeof(pipelines[0])); p++) {
+    const pipeline* pipe = &pipelines[p];
+    int32_t isize = NELEMS * pipe->typesize;
+    int32_t osize = isize + BLOSC_MAX_OVERHEAD;
+    uint8_t* src = malloc(isize);
+    uint8_t* dest = malloc(osize);
+    uint8_t* src2 = malloc(isize);
+    fill_buffer(src, NELEMS, pipe->typesize);
+    double totalsize = (double)isize * niter;
+
+    printf("\n*** Pipeline %s (typesize %d)\n", pipe->name, pipe->typesize);
+    printf("%10s %8s %10s %12s %12s\n", "blocksize", "tiled", "ratio", "comp GB/s", "decomp GB/s");
+    for (int b = 0; b < (int)(sizeof(blocksizes) / sizeof(blocksizes[0])); b++) {
+      for (int tiled = 0; tiled < 2; tiled++) {
+        set_tiled_pipeline(tiled);
+        blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+        cparams.typesize = pipe->typesize;
+        cparams.compcode = BLOSC_LZ4;
+        cparams.clevel = 5;
+        cparams.nthreads = NTHREADS;
+        cparams.blocksize = blocksizes[b];
+        cparams.filters[BLOSC2_MAX_FILTERS - 2] = pipe->filters[0];
+        cparams.filters_meta[BLOSC2_MAX_FILTERS - 2] = pipe->filters_meta[0];
+        cparams.filters[BLOSC2_MAX_FILTERS - 1] = pipe->filters[1];
+        cparams.filters_meta[BLOSC2_MAX_FILTERS - 1] = pipe->filters_meta[1];
+        blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+        dparams.nthreads = NTHREADS;
+        blosc2_context* cctx = blosc2_create_cctx(cparams);
+        blosc2_context* dctx = blosc2_create_dctx(dparams);
+
+        int csize = 0;
+        blosc_set_timestamp(&last);
+        for (int i = 0; i < niter; i++) {
+          csize = blosc2_compress_ctx(cctx, src, isize, dest, osize);
+        }
+        blosc_set_timestamp(&current);
+        double ctime = blosc_elapsed_secs(last, current);
+        if (csize <= 0) {
+          printf("Compression error.  Error code: %d\n", csize);
+          return csize;
+        }
+
+        int dsize = 0;
+        blosc_set_timestamp(&last);
+        for (int i = 0; i < niter; i++) {
+          dsize = blosc2_decompress_ctx(dctx, dest, csize, src2, isize);
+        }
+        blosc_set_timestamp(&current);
+        double dtime = blosc_elapsed_secs(last, current);
+        if (dsize != isize) {
+          printf("Decompression error.  Error code: %d\n", dsize);
+          return dsize < 0 ? dsize : -1;
+        }
+        if (pipe->filters[0] != BLOSC_TRUNC_PREC && memcmp(src, src2, isize) != 0) {
+          printf("Decompressed data differs from original!\n");
+          return -1;
+        }
+
+        printf("%10d %8s %9.1fx %12.2f %12.2f\n", blocksizes[b], tiled ? "yes" : "no",
+               (1. * isize) / csize, totalsize / (GB * ctime), totalsize / (GB * dtime));
+        blosc2_free_ctx(cctx);
+        blosc2_free_ctx(dctx);
+      }
+    }
+    free(src);
+    free(dest);
+    free(src2);
+  }
+
+  blosc_destroy();
+
+  return 0;
+}
@@ -0,0 +1,336 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "allocator.h"
+#include "context.h"
+
+#if defined(_WIN32)
+  #include <windows.h>
+  #include <malloc.h>
+#endif
+#if !defined(_WIN32) || defined(__GNUC__)
+  #include <pthread.h>
+#endif
+
+
+/* Number of buffers that the cache of a thread can keep */
+#define POOL_NSLOTS 8
+/* Slack allowed for reusing a buffer, on top of the requested size */
+#define POOL_SLACK 4096
+/* The header in front of every pooled buffer (a whole alignment unit) */
+#define POOL_HEADER_LEN BLOSC_ALLOC_ALIGNMENT
+/* Pool operations of a thread after which a buffer that has not been reused is released */
+#define POOL_MAXAGE 256
+
+typedef struct {
+  size_t capacity;          // usable bytes after the header
+  void (*dealloc)(void* block, void* user_data);  // the allocator that booked the buffer
+  void* user_data;
+} pool_header;
+
+typedef struct {
+  uint8_t* buffers[POOL_NSLOTS];  // the oldest first
+  uint32_t stamps[POOL_NSLOTS];   // the value of `clock` when every buffer was cached
+  int nbuffers;
+  size_t nbytes;                  // capacity of the cached buffers
+  uint32_t clock;                 // the pool operations of the thread
+  int32_t generation;             // the value of g_pool_generation when the cache was made
+  blosc2_allocator allocator;     // the allocator that booked the cache
+} pool_cache;
+
+
+static void* default_alloc(size_t size, size_t alignment, void* user_data) {
+  void* block = NULL;
+  (void)user_data;
+#if defined(_WIN32)
+  /* A (void *) cast needed for avoiding a warning with MINGW :-/ */
+  block = (void *)_aligned_malloc(size, alignment);
+#elif _POSIX_C_SOURCE >= 200112L || _XOPEN_SOURCE >= 600
+  /* Platform does have an implementation of posix_memalign */
+  if (posix_memalign(&block, alignment, size) != 0) {
+    block = NULL;
+  }
+#else
+  (void)alignment;
+  block = malloc(size);
+#endif  /* _WIN32 */
+  return block;
+}
+
+static void* default_resize(void* block, size_t size, size_t alignment, void* user_data) {
+  (void)user_data;
+#if defined(_WIN32)
+  return _aligned_realloc(block, size, alignment);
+#else
+  (void)alignment;
+  return realloc(block, size);
+#endif  /* _WIN32 */
+}
+
+static void default_dealloc(void* block, void* user_data) {
+  (void)user_data;
+#if defined(_WIN32)
+  _aligned_free(block);
+#else
+  free(block);
+#endif  /* _WIN32 */
+}
+
+static blosc2_allocator g_allocator = {default_alloc, default_resize, default_dealloc, NULL};
+static int64_t g_pool_maxbytes = BLOSC2_BLOCK_POOL_NBYTES;
+/* Bumped for the caches of all the threads to be released (at their next use of the pool) */
+static int32_t g_pool_generation = 0;
+
+
+void blosc_allocator_set(const blosc2_allocator* allocator) {
+  // The cached buffers are released with the allocator that booked them anyway,
+  // but do not keep them around (the previous allocator may go away)
+  blosc_pool_flush();
+  if (allocator == NULL) {
+    g_allocator.alloc = default_alloc;
+    g_allocator.resize = default_resize;
+    g_allocator.dealloc = default_dealloc;
+    g_allocator.user_data = NULL;
+  }
+  else {
+    g_allocator = *allocator;
+  }
+}
+
+
+void* blosc_malloc(size_t size) {
+  void* block = g_allocator.alloc(size, BLOSC_ALLOC_ALIGNMENT, g_allocator.user_data);
+  if (block == NULL) {
+    BLOSC_TRACE_ERROR("Error allocating memory!");
+  }
+  return block;
+}
+
+
+void* blosc_realloc(void* block, size_t size) {
+  if (block == NULL) {
+    return blosc_malloc(size);
+  }
+  void* new_block = g_allocator.resize(block, size, BLOSC_ALLOC_ALIGNMENT, g_allocator.user_data);
+  if (new_block == NULL) {
+    BLOSC_TRACE_ERROR("Error reallocating memory!");
+  }
+  return new_block;
+}
+
+
+void blosc_free(void* block) {
+  if (block != NULL) {
+    g_allocator.dealloc(block, g_allocator.user_data);
+  }
+}
+
+
+/*
+ * The caches of buffers live in thread-local storage, so that booking a
+ * buffer does not need any lock.  They are released when their thread exits.
+ */
+
+static void free_pooled(uint8_t* block) {
+  pool_header* header = (pool_header*)block;
+  header->dealloc(block, header->user_data);
+}
+
+static void free_cache(void* cache_) {
+  pool_cache* cache = (pool_cache*)cache_;
+  if (cache == NULL) {
+    return;
+  }
+  for (int i = 0; i < cache->nbuffers; i++) {
+    free_pooled(cache->buffers[i] - POOL_HEADER_LEN);
+  }
+  cache->allocator.dealloc(cache, cache->allocator.user_data);
+}
+
+#if defined(_WIN32) && !defined(__GNUC__)
+
+static INIT_ONCE pool_once = INIT_ONCE_STATIC_INIT;
+static DWORD pool_key = FLS_OUT_OF_INDEXES;
+
+static VOID WINAPI free_cache_fls(PVOID cache) {
+  free_cache(cache);
+}
+
+static BOOL CALLBACK init_pool_key(PINIT_ONCE once, PVOID param, PVOID* context) {
+  (void)once;
+  (void)param;
+  (void)context;
+  pool_key = FlsAlloc(free_cache_fls);
+  return TRUE;
+}
+
+static bool get_pool_key(void) {
+  InitOnceExecuteOnce(&pool_once, init_pool_key, NULL, NULL);
+  return pool_key != FLS_OUT_OF_INDEXES;
+}
+
+#define POOL_GET_CACHE() ((pool_cache*)FlsGetValue(pool_key))
+#define POOL_SET_CACHE(cache) FlsSetValue(pool_key, (cache))
+
+#else
+
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+static pthread_key_t pool_key;
+static bool pool_key_ok = false;
+
+static void init_pool_key(void) {
+  pool_key_ok = (pthread_key_create(&pool_key, free_cache) == 0);
+}
+
+static bool get_pool_key(void) {
+  pthread_once(&pool_once, init_pool_key);
+  return pool_key_ok;
+}
+
+#define POOL_GET_CACHE() ((pool_cache*)pthread_getspecific(pool_key))
+#define POOL_SET_CACHE(cache) pthread_setspecific(pool_key, (cache))
+
+#endif  /* _WIN32 && !__GNUC__ */
+
+
+static void remove_buffer(pool_cache* cache, int i) {
+  cache->nbytes -= ((pool_header*)(cache->buffers[i] - POOL_HEADER_LEN))->capacity;
+  cache->nbuffers--;
+  memmove(cache->buffers + i, cache->buffers + i + 1, (cache->nbuffers - i) * sizeof(uint8_t*));
+  memmove(cache->stamps + i, cache->stamps + i + 1, (cache->nbuffers - i) * sizeof(uint32_t));
+}
+
+
+static void evict_oldest(pool_cache* cache) {
+  uint8_t* buffer = cache->buffers[0];
+  remove_buffer(cache, 0);
+  free_pooled(buffer - POOL_HEADER_LEN);
+}
+
+
+static pool_cache* get_cache(bool create) {
+  if (!get_pool_key()) {
+    return NULL;
+  }
+  pool_cache* cache = POOL_GET_CACHE();
+  int32_t generation = BLOSC_ATOMIC_LOAD32(&g_pool_generation);
+  if (cache != NULL && cache->generation != generation) {
+    // The allocator or the size of the pool have changed since the cache was made
+    POOL_SET_CACHE(NULL);
+    free_cache(cache);
+    cache = NULL;
+  }
+  if (cache == NULL && create) {
+    cache = blosc_malloc(sizeof(pool_cache));
+    if (cache == NULL) {
+      return NULL;
+    }
+    memset(cache, 0, sizeof(pool_cache));
+    cache->generation = generation;
+    cache->allocator = g_allocator;
+    POOL_SET_CACHE(cache);
+  }
+  if (cache != NULL) {
+    // Release the buffers that the thread does not need anymore
+    cache->clock++;
+    while (cache->nbuffers > 0 && cache->clock - cache->stamps[0] > POOL_MAXAGE) {
+      evict_oldest(cache);
+    }
+  }
+  return cache;
+}
+
+
+void* blosc_pool_malloc(size_t size) {
+  pool_cache* cache = g_pool_maxbytes > 0 ? get_cache(false) : NULL;
+  if (cache != NULL) {
+    // The smallest buffer where `size` fits, unless it would be mostly wasted
+    int best = -1;
+    size_t best_capacity = 0;
+    for (int i = 0; i < cache->nbuffers; i++) {
+      size_t capacity = ((pool_header*)(cache->buffers[i] - POOL_HEADER_LEN))->capacity;
+      if (capacity >= size && capacity - size <= size + POOL_SLACK &&
+          (best < 0 || capacity < best_capacity)) {
+        best = i;
+        best_capacity = capacity;
+      }
+    }
+    if (best >= 0) {
+      uint8_t* buffer = cache->buffers[best];
+      remove_buffer(cache, best);
+      return buffer;
+    }
+  }
+
+  // Some headroom, so that the buffer can be reused for slightly larger sizes
+  size_t capacity = size + size / 8;
+  capacity = (capacity + BLOSC_ALLOC_ALIGNMENT - 1) & ~(size_t)(BLOSC_ALLOC_ALIGNMENT - 1);
+  uint8_t* block = blosc_malloc(POOL_HEADER_LEN + capacity);
+  if (block == NULL) {
+    return NULL;
+  }
+  pool_header* header = (pool_header*)block;
+  header->capacity = capacity;
+  header->dealloc = g_allocator.dealloc;
+  header->user_data = g_allocator.user_data;
+  return block + POOL_HEADER_LEN;
+}
+
+
+void blosc_pool_free(void* buffer) {
+  if (buffer == NULL) {
+    return;
+  }
+  uint8_t* block = (uint8_t*)buffer - POOL_HEADER_LEN;
+  size_t capacity = ((pool_header*)block)->capacity;
+  int64_t maxbytes = g_pool_maxbytes;
+  pool_cache* cache = NULL;
+  if (maxbytes > 0 && capacity <= (size_t)maxbytes) {
+    cache = get_cache(true);
+  }
+  if (cache == NULL) {
+    free_pooled(block);
+    return;
+  }
+  while (cache->nbuffers == POOL_NSLOTS || cache->nbytes + capacity > (size_t)maxbytes) {
+    evict_oldest(cache);
+  }
+  cache->buffers[cache->nbuffers] = (uint8_t*)buffer;
+  cache->stamps[cache->nbuffers] = cache->clock;
+  cache->nbuffers++;
+  cache->nbytes += capacity;
+}
+
+
+int64_t blosc_pool_set_maxbytes(int64_t maxbytes) {
+  int64_t old_maxbytes = g_pool_maxbytes;
+  g_pool_maxbytes = maxbytes;
+  // The caches of the other threads may be larger than the new maximum
+  blosc_pool_flush();
+  return old_maxbytes;
+}
+
+
+void blosc_pool_flush(void) {
+  // The other threads release their caches at their next use of the pool (or when they exit)
+  BLOSC_ATOMIC_FETCH_ADD32(&g_pool_generation, 1);
+  if (!get_pool_key()) {
+    return;
+  }
+  pool_cache* cache = POOL_GET_CACHE();
+  if (cache != NULL) {
+    POOL_SET_CACHE(NULL);
+    free_cache(cache);
+  }
+}
@@ -0,0 +1,52 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#ifndef BLOSC_ALLOCATOR_H
+#define BLOSC_ALLOCATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "blosc2.h"
+
+/* The alignment of the blocks booked by blosc_malloc (a cache line, so that
+ * AVX512 loads do not split lines) */
+#define BLOSC_ALLOC_ALIGNMENT 64
+
+/* Set the allocator for the memory used internally (NULL means the default one) */
+void blosc_allocator_set(const blosc2_allocator* allocator);
+
+/* Book `size` bytes aligned to BLOSC_ALLOC_ALIGNMENT with the current allocator */
+void* blosc_malloc(size_t size);
+
+/* Resize a block booked by blosc_malloc.  Only the natural alignment of malloc()
+ * is guaranteed for the resized block. */
+void* blosc_realloc(void* block, size_t size);
+
+/* Release a block booked by blosc_malloc or blosc_realloc */
+void blosc_free(void* block);
+
+/* Book a short-lived buffer of `size` bytes out of the cache of the calling thread,
+ * or with blosc_malloc if there is none that fits.  A buffer is always released with
+ * the allocator that booked it, even if the allocator has changed since then.  The buffer is aligned to
+ * BLOSC_ALLOC_ALIGNMENT and must be released with blosc_pool_free. */
+void* blosc_pool_malloc(size_t size);
+
+/* Give a buffer back to the cache of the calling thread (if it fits there) */
+void blosc_pool_free(void* buffer);
+
+/* Set the maximum number of bytes cached by every thread (0 disables the caches).
+ * Returns the previous maximum. */
+int64_t blosc_pool_set_maxbytes(int64_t maxbytes);
+
+/* Release the buffers cached by the calling thread.  The other threads release
+ * theirs at their next use of the pool, or when they exit. */
+void blosc_pool_flush(void);
+
+#endif  /* BLOSC_ALLOCATOR_H */
@@ -19,6 +19,14 @@
 extern "C" {
 #endif
 
+BLOSC_NO_EXPORT int64_t
+    bshuf_trans_byte_bitrow_avx2(void* in, void* out, const size_t size,
+                                 const size_t elem_size);
+
+BLOSC_NO_EXPORT int64_t
+    bshuf_shuffle_bit_eightelem_avx2(void* in, void* out, const size_t size,
+                                     const size_t elem_size);
+
 /**
   AVX2-accelerated bitshuffle routine.
 */
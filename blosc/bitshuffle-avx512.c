@@ -0,0 +1,141 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+/*********************************************************************
+  Bitshuffle - Filter for improving compression of typed binary data.
+
+  Author: Kiyoshi Masui <kiyo@physics.ubc.ca>
+  Website: http://www.github.com/kiyo-masui/bitshuffle
+
+  Note: Adapted for c-blosc by Francesc Alted.
+
+  See LICENSES/BITSHUFFLE.txt file for details about copyright and
+  rights to use.
+**********************************************************************/
+
+
+#include "bitshuffle-generic.h"
+#include "bitshuffle-avx2.h"
+#include "bitshuffle-avx512.h"
+#include "shuffle-avx512.h"
+
+
+/* Make sure AVX512BW is available for the compilation target and compiler. */
+#if !defined(__AVX512F__) || !defined(__AVX512BW__)
+  #error AVX512BW is not supported by the target architecture/platform and/or this compiler.
+#endif
+
+#include <immintrin.h>
+
+
+/* ---- Code that requires AVX512BW. Intel Skylake-SP (2017) and later. ---- */
+
+
+/* Transpose bits within bytes. */
+static int64_t bshuf_trans_bit_byte_avx512(void* in, void* out, const size_t size,
+                                           const size_t elem_size) {
+
+  char* in_b = (char*)in;
+  char* out_b = (char*)out;
+  uint64_t* out_u64;
+
+  size_t nbyte = elem_size * size;
+
+  int64_t count;
+
+  __m512i zmm;
+  uint64_t bt;
+  size_t ii, kk;
+
+  for (ii = 0; ii + 63 < nbyte; ii += 64) {
+    zmm = _mm512_loadu_si512(&in_b[ii]);
+    for (kk = 0; kk < 8; kk++) {
+      bt = _mm512_movepi8_mask(zmm);
+      zmm = _mm512_slli_epi16(zmm, 1);
+      out_u64 = (uint64_t*)&out_b[((7 - kk) * nbyte + ii) / 8];
+      *out_u64 = bt;
+    }
+  }
+  count = bshuf_trans_bit_byte_remainder(in, out, size, elem_size,
+                                         nbyte - nbyte % 64);
+  return count;
+}
+
+
+/* Transpose bits within elements. */
+int64_t bshuf_trans_bit_elem_avx512(void* in, void* out, const size_t size,
+                                    const size_t elem_size, void* tmp_buf) {
+
+  int64_t count;
+
+  CHECK_MULT_EIGHT(size);
+
+  /* Transposing bytes within elements is just a (byte) shuffle */
+  shuffle_avx512((int32_t)elem_size, (int32_t)(size * elem_size), in, out);
+  count = bshuf_trans_bit_byte_avx512(out, tmp_buf, size, elem_size);
+  CHECK_ERR(count);
+  count = bshuf_trans_bitrow_eight(tmp_buf, out, size, elem_size);
+
+  return count;
+}
+
+
+/* Shuffle bits within the bytes of eight element blocks. */
+static int64_t bshuf_shuffle_bit_eightelem_avx512(void* in, void* out, const size_t size,
+                                                  const size_t elem_size) {
+
+  CHECK_MULT_EIGHT(size);
+
+  /*  With a bit of care, this could be written such that such that it is */
+  /*  in_buf = out_buf safe. */
+  char* in_b = (char*)in;
+  char* out_b = (char*)out;
+
+  size_t nbyte = elem_size * size;
+  size_t ii, jj, kk, ind;
+
+  __m512i zmm;
+  uint64_t bt;
+
+  if (elem_size % 8) {
+    return bshuf_shuffle_bit_eightelem_avx2(in, out, size, elem_size);
+  } else {
+    for (jj = 0; jj + 63 < 8 * elem_size; jj += 64) {
+      for (ii = 0; ii + 8 * elem_size - 1 < nbyte;
+           ii += 8 * elem_size) {
+        zmm = _mm512_loadu_si512(&in_b[ii + jj]);
+        for (kk = 0; kk < 8; kk++) {
+          bt = _mm512_movepi8_mask(zmm);
+          zmm = _mm512_slli_epi16(zmm, 1);
+          ind = (ii + jj / 8 + (7 - kk) * elem_size);
+          *(uint64_t*)&out_b[ind] = bt;
+        }
+      }
+    }
+  }
+  return size * elem_size;
+}
+
+
+/* Untranspose bits within elements. */
+int64_t bshuf_untrans_bit_elem_avx512(void* in, void* out, const size_t size,
+                                      const size_t elem_size, void* tmp_buf) {
+
+  int64_t count;
+
+  CHECK_MULT_EIGHT(size);
+
+  /* Transposing the bytes of the bit rows is just a (byte) unshuffle of
+     elements with 8 * elem_size bytes */
+  unshuffle_avx512((int32_t)(8 * elem_size), (int32_t)(size * elem_size), in, tmp_buf);
+  count = bshuf_shuffle_bit_eightelem_avx512(tmp_buf, out, size, elem_size);
+
+  return count;
+}
@@ -61,7 +61,7 @@ static void endian_handler(bool little, void *dest, const void *pa, int size) {
   }
   else {
     uint8_t* pa_ = (uint8_t*)pa;
-    uint8_t* pa2_ = malloc((size_t)size);
+    uint8_t pa2_[8];
     switch (size) {
       case 8:
         pa2_[0] = pa_[7];
@@ -88,9 +88,9 @@ static void endian_handler(bool little, void *dest, const void *pa, int size) {
         break;
       default:
         BLOSC_TRACE_ERROR("Unhandled size: %d.", size);
+        return;
     }
     memcpy(dest, pa2_, size);
-    free(pa2_);
   }
 }
 
@@ -175,6 +175,48 @@ int register_filter_private(blosc2_filter *filter);
  */
 int register_codec_private(blosc2_codec *codec);
 
+/* The name of the vlmetalayer with the dictionary shared by the chunks of a super-chunk */
+#define BLOSC2_SHARED_DICT_NAME "_b2_dict"
+
+/* The name of the vlmetalayer with the filter pipeline of a super-chunk that has a
+   BLOSC_AUTO_FILTER (its frame header stores BLOSC_SHUFFLE instead, for older readers) */
+#define BLOSC2_AUTO_FILTER_NAME "_b2_auto_filter"
+
+/**
+ * @brief Digest the dictionary @p dict for the codec of @p context, and keep a copy
+ * of it for (de)compressing all the chunks that refer to it.
+ *
+ * @return The id of the dictionary (> 0) if succeeds. Else a negative code is returned.
+ */
+int set_shared_dict(blosc2_context *context, const void *dict, int32_t dict_size);
+
+/**
+ * @brief Train a dictionary out of the filtered @p samples (of @p nbytes), as a chunk
+ * would be compressed with @p context.
+ *
+ * The samples are filtered in pieces of @p chunksize bytes.  The dictionary is
+ * returned in @p dict (to be freed by the caller), and its size in @p dict_size.
+ *
+ * @return 0 if succeeds. Else a negative code is returned.
+ */
+int train_shared_dict(blosc2_context *context, const void *samples, int64_t nbytes,
+                      int32_t chunksize, void **dict, int32_t *dict_size);
+
+/**
+ * @brief Get the flags (BLOSC_DOSHUFFLE, BLOSC_DOBITSHUFFLE, BLOSC_DODELTA) for the
+ * filter pipeline @p filters.
+ */
+uint8_t filters_to_flags(const uint8_t* filters);
+
+/**
+ * @brief Execute `dojob(jobdata + i * jobdata_elsize)` for i in [0, numjobs) in parallel.
+ *
+ * The jobs go to the threads callback or the shared pool when they are set.  Else,
+ * a thread is started for every job (but the first one, which runs in the caller).
+ * This returns when all the jobs are done.
+ */
+void blosc_run_parallel_jobs(void (*dojob)(void *), int numjobs, size_t jobdata_elsize, void *jobdata);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,224 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+
+#include "blosc2/blosc2-mmap.h"
+
+#if defined(BLOSC2_HAVE_MMAP_IO)
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+/* Make the mapping cover the first `end` bytes of the file (it grows up to the whole file). */
+static int ensure_mapped(blosc2_mmap_file *my_fp, int64_t end) {
+  if (end <= my_fp->mapped) {
+    return 0;
+  }
+  if (end > my_fp->size) {
+    return -1;
+  }
+  if (my_fp->addr != NULL) {
+    munmap(my_fp->addr, (size_t) my_fp->mapped);
+    my_fp->addr = NULL;
+    my_fp->mapped = 0;
+  }
+  int prot = my_fp->writable ? PROT_READ | PROT_WRITE : PROT_READ;
+  void *addr = mmap(NULL, (size_t) my_fp->size, prot, MAP_SHARED, my_fp->fd, 0);
+  if (addr == MAP_FAILED) {
+    return -1;
+  }
+  my_fp->addr = addr;
+  my_fp->mapped = my_fp->size;
+  return 0;
+}
+
+
+/* Write at `offset`: in the mapping when possible, else in the file (which grows). */
+static int64_t write_at(blosc2_mmap_file *my_fp, const void *ptr, int64_t nbytes, int64_t offset) {
+  if (offset + nbytes <= my_fp->mapped) {
+    memcpy(my_fp->addr + offset, ptr, (size_t) nbytes);
+    return nbytes;
+  }
+  // The mapping is extended lazily, when this part of the file is accessed
+  int64_t wbytes = 0;
+  while (wbytes < nbytes) {
+    ssize_t nwritten = pwrite(my_fp->fd, (const char *) ptr + wbytes, (size_t) (nbytes - wbytes),
+                              (off_t) (offset + wbytes));
+    if (nwritten < 0 && errno == EINTR) {
+      continue;
+    }
+    if (nwritten <= 0) {
+      break;
+    }
+    wbytes += nwritten;
+  }
+  if (offset + wbytes > my_fp->size) {
+    my_fp->size = offset + wbytes;
+  }
+  return wbytes;
+}
+
+
+/* Read at `offset` out of the mapping. */
+static int64_t read_at(blosc2_mmap_file *my_fp, void *ptr, int64_t nbytes, int64_t offset) {
+  if (offset >= my_fp->size) {
+    return 0;
+  }
+  if (offset + nbytes > my_fp->size) {
+    nbytes = my_fp->size - offset;
+  }
+  if (ensure_mapped(my_fp, offset + nbytes) < 0) {
+    return 0;
+  }
+  memcpy(ptr, my_fp->addr + offset, (size_t) nbytes);
+  return nbytes;
+}
+
+
+void *blosc2_mmap_open(const char *urlpath, const char *mode, void *params) {
+  (void) params;
+  bool plus = strchr(mode, '+') != NULL;
+  int flags;
+  switch (mode[0]) {
+    case 'r':
+      flags = plus ? O_RDWR : O_RDONLY;
+      break;
+    case 'w':
+      flags = O_RDWR | O_CREAT | O_TRUNC;
+      break;
+    case 'a':
+      flags = O_RDWR | O_CREAT;
+      break;
+    default:
+      return NULL;
+  }
+  int fd = open(urlpath, flags, 0666);
+  if (fd < 0) {
+    return NULL;
+  }
+  struct stat st;
+  if (fstat(fd, &st) < 0) {
+    close(fd);
+    return NULL;
+  }
+
+  blosc2_mmap_file *my_fp = calloc(1, sizeof(blosc2_mmap_file));
+  my_fp->fd = fd;
+  my_fp->size = (int64_t) st.st_size;
+  my_fp->writable = (flags != O_RDONLY);
+  my_fp->append = (mode[0] == 'a');
+  // Read-only streams are mapped once, so that pointers into them stay valid until closed
+  if (my_fp->size > 0 && ensure_mapped(my_fp, my_fp->size) < 0) {
+    close(fd);
+    free(my_fp);
+    return NULL;
+  }
+  return my_fp;
+}
+
+int blosc2_mmap_close(void *stream) {
+  blosc2_mmap_file *my_fp = (blosc2_mmap_file *) stream;
+  if (my_fp->addr != NULL) {
+    munmap(my_fp->addr, (size_t) my_fp->mapped);
+  }
+  int err = close(my_fp->fd);
+  free(my_fp);
+  return err;
+}
+
+int64_t blosc2_mmap_tell(void *stream) {
+  blosc2_mmap_file *my_fp = (blosc2_mmap_file *) stream;
+  return my_fp->position;
+}
+
+int blosc2_mmap_seek(void *stream, int64_t offset, int whence) {
+  blosc2_mmap_file *my_fp = (blosc2_mmap_file *) stream;
+  int64_t position;
+  switch (whence) {
+    case SEEK_SET:
+      position = offset;
+      break;
+    case SEEK_CUR:
+      position = my_fp->position + offset;
+      break;
+    case SEEK_END:
+      position = my_fp->size + offset;
+      break;
+    default:
+      return -1;
+  }
+  if (position < 0) {
+    return -1;
+  }
+  my_fp->position = position;
+  return 0;
+}
+
+int64_t blosc2_mmap_write(const void *ptr, int64_t size, int64_t nitems, void *stream) {
+  blosc2_mmap_file *my_fp = (blosc2_mmap_file *) stream;
+  if (!my_fp->writable || size <= 0) {
+    return 0;
+  }
+  int64_t offset = my_fp->append ? my_fp->size : my_fp->position;
+  int64_t wbytes = write_at(my_fp, ptr, size * nitems, offset);
+  my_fp->position = offset + wbytes;
+  return wbytes / size;
+}
+
+int64_t blosc2_mmap_read(void *ptr, int64_t size, int64_t nitems, void *stream) {
+  blosc2_mmap_file *my_fp = (blosc2_mmap_file *) stream;
+  if (size <= 0) {
+    return 0;
+  }
+  int64_t rbytes = read_at(my_fp, ptr, size * nitems, my_fp->position);
+  my_fp->position += rbytes;
+  return rbytes / size;
+}
+
+int blosc2_mmap_truncate(void *stream, int64_t size) {
+  blosc2_mmap_file *my_fp = (blosc2_mmap_file *) stream;
+  if (size < my_fp->mapped) {
+    // Accessing the mapping past the end of the file would crash
+    munmap(my_fp->addr, (size_t) my_fp->mapped);
+    my_fp->addr = NULL;
+    my_fp->mapped = 0;
+  }
+  int rc = ftruncate(my_fp->fd, (off_t) size);
+  if (rc == 0) {
+    my_fp->size = size;
+  }
+  return rc;
+}
+
+int64_t blosc2_mmap_pread(void *ptr, int64_t size, int64_t nitems, int64_t offset, void *stream) {
+  blosc2_mmap_file *my_fp = (blosc2_mmap_file *) stream;
+  if (size <= 0) {
+    return 0;
+  }
+  return read_at(my_fp, ptr, size * nitems, offset) / size;
+}
+
+void *blosc2_mmap_map(void *stream, int64_t offset, int64_t nbytes) {
+  blosc2_mmap_file *my_fp = (blosc2_mmap_file *) stream;
+  if (offset < 0 || nbytes < 0 || offset + nbytes > my_fp->size) {
+    return NULL;
+  }
+  if (ensure_mapped(my_fp, offset + nbytes) < 0) {
+    return NULL;
+  }
+  return my_fp->addr + offset;
+}
+
+#endif  /* BLOSC2_HAVE_MMAP_IO */
@@ -11,6 +11,13 @@
 
 #include "blosc2/blosc2-stdio.h"
 
+#if defined(_WIN32)
+  #include <windows.h>
+  #include <io.h>
+#else
+  #include <errno.h>
+#endif
+
 void *blosc2_stdio_open(const char *urlpath, const char *mode, void *params) {
   FILE *file = fopen(urlpath, mode);
   if (file == NULL)
@@ -72,3 +79,37 @@ int blosc2_stdio_truncate(void *stream, int64_t size) {
 #endif
   return rc;
 }
+
+int64_t blosc2_stdio_pread(void *ptr, int64_t size, int64_t nitems, int64_t offset, void *stream) {
+  blosc2_stdio_file *my_fp = (blosc2_stdio_file *) stream;
+  int64_t nbytes = size * nitems;
+  int64_t rbytes = 0;
+#if defined(_WIN32)
+  HANDLE handle = (HANDLE) _get_osfhandle(_fileno(my_fp->file));
+  while (rbytes < nbytes) {
+    OVERLAPPED overlapped = {0};
+    int64_t pos = offset + rbytes;
+    overlapped.Offset = (DWORD) pos;
+    overlapped.OffsetHigh = (DWORD) (pos >> 32);
+    DWORD toread = (DWORD) (nbytes - rbytes > (1 << 30) ? (1 << 30) : nbytes - rbytes);
+    DWORD nread = 0;
+    if (!ReadFile(handle, (char *) ptr + rbytes, toread, &nread, &overlapped) || nread == 0) {
+      break;
+    }
+    rbytes += nread;
+  }
+#else
+  int fd = fileno(my_fp->file);
+  while (rbytes < nbytes) {
+    ssize_t nread = pread(fd, (char *) ptr + rbytes, (size_t) (nbytes - rbytes), (off_t) (offset + rbytes));
+    if (nread < 0 && errno == EINTR) {
+      continue;
+    }
+    if (nread <= 0) {
+      break;
+    }
+    rbytes += nread;
+  }
+#endif
+  return size > 0 ? rbytes / size : 0;
+}
@@ -0,0 +1,471 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+/*********************************************************************
+  An input/output backend that reads batches of (block) buffers with
+  io_uring, so that the reads can be in flight while the blocks that are
+  already there are being decompressed.  Everything else is done with
+  stdio.  When io_uring is not available, batches are not supported and
+  the backend is just the stdio one.
+**********************************************************************/
+
+#include "blosc2/blosc2-uring.h"
+
+#if defined(USING_CMAKE)
+  #include "config.h"
+#endif /*  USING_CMAKE */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+
+#if defined(HAVE_IO_URING)
+
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+/* The maximum number of reads in flight for a stream */
+#define URING_ENTRIES (64)
+
+/* Marks a read that has not completed yet */
+#define URING_PENDING INT64_MIN
+
+typedef struct {
+  int fd;
+  unsigned sq_entries;
+  unsigned* sq_head;
+  unsigned* sq_tail;
+  unsigned* sq_mask;
+  unsigned* sq_array;
+  struct io_uring_sqe* sqes;
+  unsigned* cq_head;
+  unsigned* cq_tail;
+  unsigned* cq_mask;
+  struct io_uring_cqe* cqes;
+  void* sq_ptr;
+  size_t sq_len;
+  void* cq_ptr;
+  size_t cq_len;
+  size_t sqes_len;
+  unsigned inflight;
+  pthread_mutex_t mutex;
+} uring;
+
+typedef struct {
+  blosc2_uring_file* file;
+  int32_t nreads;
+  int32_t nsubmitted;
+  void** ptrs;
+  int64_t* nbytes;
+  int64_t* offsets;
+  int64_t* results;
+} uring_batch;
+
+
+static uring* uring_new(void) {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int fd = (int)syscall(__NR_io_uring_setup, URING_ENTRIES, &params);
+  if (fd < 0) {
+    return NULL;
+  }
+
+  int err;
+  uring* ring = calloc(1, sizeof(uring));
+  if (ring == NULL) {
+    err = ENOMEM;
+    close(fd);
+    errno = err;
+    return NULL;
+  }
+  ring->fd = fd;
+  ring->sq_entries = params.sq_entries;
+  ring->sq_len = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  ring->cq_len = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    ring->sq_len = ring->cq_len = ring->sq_len > ring->cq_len ? ring->sq_len : ring->cq_len;
+  }
+  ring->sq_ptr = mmap(NULL, ring->sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      fd, IORING_OFF_SQ_RING);
+  if (ring->sq_ptr == MAP_FAILED) {
+    goto failed;
+  }
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    ring->cq_ptr = ring->sq_ptr;
+  }
+  else {
+    ring->cq_ptr = mmap(NULL, ring->cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        fd, IORING_OFF_CQ_RING);
+    if (ring->cq_ptr == MAP_FAILED) {
+      munmap(ring->sq_ptr, ring->sq_len);
+      goto failed;
+    }
+  }
+  ring->sqes_len = params.sq_entries * sizeof(struct io_uring_sqe);
+  ring->sqes = mmap(NULL, ring->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    fd, IORING_OFF_SQES);
+  if (ring->sqes == MAP_FAILED) {
+    if (ring->cq_ptr != ring->sq_ptr) {
+      munmap(ring->cq_ptr, ring->cq_len);
+    }
+    munmap(ring->sq_ptr, ring->sq_len);
+    goto failed;
+  }
+
+  uint8_t* sq = ring->sq_ptr;
+  ring->sq_head = (unsigned*)(sq + params.sq_off.head);
+  ring->sq_tail = (unsigned*)(sq + params.sq_off.tail);
+  ring->sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+  ring->sq_array = (unsigned*)(sq + params.sq_off.array);
+  uint8_t* cq = ring->cq_ptr;
+  ring->cq_head = (unsigned*)(cq + params.cq_off.head);
+  ring->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+  ring->cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+  pthread_mutex_init(&ring->mutex, NULL);
+  return ring;
+
+  failed:
+  // Keep the errno of the failure for the caller
+  err = errno;
+  close(fd);
+  free(ring);
+  errno = err;
+  return NULL;
+}
+
+
+static void uring_free(uring* ring) {
+  munmap(ring->sqes, ring->sqes_len);
+  if (ring->cq_ptr != ring->sq_ptr) {
+    munmap(ring->cq_ptr, ring->cq_len);
+  }
+  munmap(ring->sq_ptr, ring->sq_len);
+  close(ring->fd);
+  pthread_mutex_destroy(&ring->mutex);
+  free(ring);
+}
+
+
+/* Process the completions that have arrived (of any batch).  Needs the mutex. */
+static void uring_reap(uring* ring) {
+  unsigned head = *ring->cq_head;
+  unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+  while (head != tail) {
+    struct io_uring_cqe* cqe = &ring->cqes[head & *ring->cq_mask];
+    *(int64_t*)(uintptr_t)cqe->user_data = cqe->res;
+    ring->inflight--;
+    head++;
+  }
+  __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+}
+
+
+/* Queue as many reads of the batch as there is room for, and submit them.  The reads that
+ * the kernel does not take are marked as failed, so that they are done synchronously.  Needs
+ * the mutex.  Returns 0, or a negative errno if io_uring_enter() failed. */
+static int uring_push(uring* ring, uring_batch* batch) {
+  int fd = fileno(batch->file->stdio.file);
+  unsigned tail = *ring->sq_tail;
+  unsigned nqueued = 0;
+  while (batch->nsubmitted < batch->nreads && ring->inflight + nqueued < ring->sq_entries) {
+    int32_t i = batch->nsubmitted++;
+    unsigned index = tail & *ring->sq_mask;
+    struct io_uring_sqe* sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->off = (uint64_t)batch->offsets[i];
+    sqe->addr = (uint64_t)(uintptr_t)batch->ptrs[i];
+    sqe->len = (uint32_t)batch->nbytes[i];
+    sqe->user_data = (uint64_t)(uintptr_t)&batch->results[i];
+    ring->sq_array[index] = index;
+    tail++;
+    nqueued++;
+  }
+  if (nqueued == 0) {
+    return 0;
+  }
+  __atomic_store_n(ring->sq_tail, tail, __ATOMIC_RELEASE);
+  ring->inflight += nqueued;
+
+  int err = 0;
+  while (true) {
+    unsigned unconsumed = tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    if (unconsumed == 0) {
+      break;
+    }
+    int rc = (int)syscall(__NR_io_uring_enter, ring->fd, unconsumed, 0, 0, NULL, 0);
+    if (rc > 0) {
+      continue;
+    }
+    err = rc < 0 ? errno : EAGAIN;
+    if (err == EINTR) {
+      err = 0;
+      continue;
+    }
+    if ((err == EAGAIN || err == EBUSY) && ring->inflight > unconsumed) {
+      // The kernel is short of resources: wait for some reads in flight to make room
+      rc = (int)syscall(__NR_io_uring_enter, ring->fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+      if (rc >= 0 || errno == EINTR) {
+        uring_reap(ring);
+        err = 0;
+        continue;
+      }
+      err = errno;
+    }
+    break;
+  }
+  if (err != 0) {
+    // The submission queue is only read within io_uring_enter(), so the reads that the
+    // kernel has not taken can be taken back
+    unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    unsigned unconsumed = tail - head;
+    __atomic_store_n(ring->sq_tail, head, __ATOMIC_RELEASE);
+    ring->inflight -= unconsumed;
+    for (int32_t i = batch->nsubmitted - (int32_t)unconsumed; i < batch->nsubmitted; i++) {
+      batch->results[i] = -err;
+    }
+    return -err;
+  }
+  return 0;
+}
+
+
+/* Wait for a completion to arrive.  Returns 0, or a negative errno on a (non transient) error. */
+static int uring_wait(uring* ring) {
+  int rc = (int)syscall(__NR_io_uring_enter, ring->fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+  if (rc < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+    return -errno;
+  }
+  return 0;
+}
+
+
+
+#endif  /* HAVE_IO_URING */
+
+
+void *blosc2_uring_open(const char *urlpath, const char *mode, void *params) {
+  (void) params;
+  FILE *file = fopen(urlpath, mode);
+  if (file == NULL)
+    return NULL;
+  blosc2_uring_file *my_fp = malloc(sizeof(blosc2_uring_file));
+  if (my_fp == NULL) {
+    fclose(file);
+    return NULL;
+  }
+  my_fp->stdio.file = file;
+  my_fp->ring = NULL;
+  return my_fp;
+}
+
+int blosc2_uring_close(void *stream) {
+  blosc2_uring_file *my_fp = (blosc2_uring_file *) stream;
+#if defined(HAVE_IO_URING)
+  if (my_fp->ring != NULL) {
+    uring_free(my_fp->ring);
+  }
+#endif
+  int err = fclose(my_fp->stdio.file);
+  free(my_fp);
+  return err;
+}
+
+int64_t blosc2_uring_tell(void *stream) {
+  blosc2_uring_file *my_fp = (blosc2_uring_file *) stream;
+  return blosc2_stdio_tell(&my_fp->stdio);
+}
+
+int blosc2_uring_seek(void *stream, int64_t offset, int whence) {
+  blosc2_uring_file *my_fp = (blosc2_uring_file *) stream;
+  return blosc2_stdio_seek(&my_fp->stdio, offset, whence);
+}
+
+int64_t blosc2_uring_write(const void *ptr, int64_t size, int64_t nitems, void *stream) {
+  blosc2_uring_file *my_fp = (blosc2_uring_file *) stream;
+  return blosc2_stdio_write(ptr, size, nitems, &my_fp->stdio);
+}
+
+int64_t blosc2_uring_read(void *ptr, int64_t size, int64_t nitems, void *stream) {
+  blosc2_uring_file *my_fp = (blosc2_uring_file *) stream;
+  return blosc2_stdio_read(ptr, size, nitems, &my_fp->stdio);
+}
+
+int blosc2_uring_truncate(void *stream, int64_t size) {
+  blosc2_uring_file *my_fp = (blosc2_uring_file *) stream;
+  return blosc2_stdio_truncate(&my_fp->stdio, size);
+}
+
+int64_t blosc2_uring_pread(void *ptr, int64_t size, int64_t nitems, int64_t offset, void *stream) {
+  blosc2_uring_file *my_fp = (blosc2_uring_file *) stream;
+  return blosc2_stdio_pread(ptr, size, nitems, offset, &my_fp->stdio);
+}
+
+
+#if defined(HAVE_IO_URING)
+
+/* Protects the creation of the rings of the streams */
+static pthread_mutex_t uring_setup_mutex = PTHREAD_MUTEX_INITIALIZER;
+/* Whether io_uring is not available in the running kernel (or it is forbidden) */
+static bool uring_unavailable = false;
+
+void *blosc2_uring_submit(void *stream, int32_t nreads, void **ptrs,
+                          const int64_t *nbytes, const int64_t *offsets) {
+  blosc2_uring_file *my_fp = (blosc2_uring_file *) stream;
+  if (nreads <= 0) {
+    return NULL;
+  }
+  for (int32_t i = 0; i < nreads; i++) {
+    if (nbytes[i] < 0 || nbytes[i] > UINT32_MAX) {
+      return NULL;
+    }
+  }
+
+  pthread_mutex_lock(&uring_setup_mutex);
+  if (my_fp->ring == NULL && !uring_unavailable) {
+    my_fp->ring = uring_new();
+    // Other failures (e.g. running out of memory) may be transient, so the next batch tries again
+    uring_unavailable = my_fp->ring == NULL && (errno == ENOSYS || errno == EPERM);
+  }
+  pthread_mutex_unlock(&uring_setup_mutex);
+  uring* ring = my_fp->ring;
+  if (ring == NULL) {
+    return NULL;
+  }
+
+  uring_batch* batch = malloc(sizeof(uring_batch));
+  if (batch == NULL) {
+    return NULL;
+  }
+  batch->file = my_fp;
+  batch->nreads = nreads;
+  batch->nsubmitted = 0;
+  batch->ptrs = malloc(nreads * sizeof(void*));
+  batch->nbytes = malloc(nreads * sizeof(int64_t));
+  batch->offsets = malloc(nreads * sizeof(int64_t));
+  batch->results = malloc(nreads * sizeof(int64_t));
+  if (batch->ptrs == NULL || batch->nbytes == NULL || batch->offsets == NULL ||
+      batch->results == NULL) {
+    free(batch->ptrs);
+    free(batch->nbytes);
+    free(batch->offsets);
+    free(batch->results);
+    free(batch);
+    return NULL;
+  }
+  memcpy(batch->ptrs, ptrs, nreads * sizeof(void*));
+  memcpy(batch->nbytes, nbytes, nreads * sizeof(int64_t));
+  memcpy(batch->offsets, offsets, nreads * sizeof(int64_t));
+  for (int32_t i = 0; i < nreads; i++) {
+    batch->results[i] = URING_PENDING;
+  }
+
+  pthread_mutex_lock(&ring->mutex);
+  uring_push(ring, batch);
+  pthread_mutex_unlock(&ring->mutex);
+
+  return batch;
+}
+
+int64_t blosc2_uring_complete(void *batch_, int32_t nread) {
+  uring_batch* batch = (uring_batch*) batch_;
+  uring* ring = batch->file->ring;
+  if (nread < 0 || nread >= batch->nreads) {
+    return -1;
+  }
+
+  pthread_mutex_lock(&ring->mutex);
+  while (batch->results[nread] == URING_PENDING) {
+    // If the read cannot be submitted, it is marked as failed
+    uring_push(ring, batch);
+    uring_reap(ring);
+    if (batch->results[nread] != URING_PENDING) {
+      break;
+    }
+    if (uring_wait(ring) < 0) {
+      break;
+    }
+  }
+  int64_t result = batch->results[nread];
+  pthread_mutex_unlock(&ring->mutex);
+
+  // Short (or failed) reads are completed synchronously
+  if (result != batch->nbytes[nread]) {
+    int64_t done = result > 0 ? result : 0;
+    done += blosc2_stdio_pread((uint8_t*)batch->ptrs[nread] + done, 1, batch->nbytes[nread] - done,
+                               batch->offsets[nread] + done, &batch->file->stdio);
+    result = done;
+  }
+  return result;
+}
+
+void blosc2_uring_release(void *batch_) {
+  uring_batch* batch = (uring_batch*) batch_;
+  uring* ring = batch->file->ring;
+
+  // The kernel could still write into the buffers of the reads in flight
+  bool in_flight = false;
+  pthread_mutex_lock(&ring->mutex);
+  for (int32_t i = 0; i < batch->nsubmitted && !in_flight; i++) {
+    while (batch->results[i] == URING_PENDING) {
+      uring_reap(ring);
+      if (batch->results[i] != URING_PENDING) {
+        break;
+      }
+      if (uring_wait(ring) < 0) {
+        in_flight = true;
+        break;
+      }
+    }
+  }
+  pthread_mutex_unlock(&ring->mutex);
+
+  free(batch->ptrs);
+  free(batch->nbytes);
+  free(batch->offsets);
+  if (!in_flight) {
+    // Else, the completions of the reads that cannot be waited for would still land in
+    // the results, so they are leaked rather than freed
+    free(batch->results);
+  }
+  free(batch);
+}
+
+#else
+
+void *blosc2_uring_submit(void *stream, int32_t nreads, void **ptrs,
+                          const int64_t *nbytes, const int64_t *offsets) {
+  (void) stream;
+  (void) nreads;
+  (void) ptrs;
+  (void) nbytes;
+  (void) offsets;
+  // Batches are not supported, so reads are done synchronously by the caller
+  return NULL;
+}
+
+int64_t blosc2_uring_complete(void *batch, int32_t nread) {
+  (void) batch;
+  (void) nread;
+  return -1;
+}
+
+void blosc2_uring_release(void *batch) {
+  (void) batch;
+}
+
+#endif  /* HAVE_IO_URING */
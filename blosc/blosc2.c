@@ -33,6 +33,10 @@
 #include "trunc-prec.h"
 #include "blosclz.h"
 #include "stune.h"
+#include "threadpool.h"
+#include "allocator.h"
+#include "cpuinfo.h"
+#include "dctx-pool.h"
 #include "config.h"
 #include "blosc2/codecs-registry.h"
 #include "blosc2/filters-registry.h"
@@ -67,6 +71,10 @@
   #include "win32/pthread.c"
 #endif
 
+#if defined(__ARM_NEON)
+  #include <arm_neon.h>
+#endif
+
 /* Synchronization variables */
 
 /* Global context for non-contextual API */
@@ -79,6 +87,8 @@ static int32_t g_splitmode = BLOSC_FORWARD_COMPAT_SPLIT;
 /* the compressor to use by default */
 static int16_t g_nthreads = 1;
 static int32_t g_force_blocksize = 0;
+/* Whether filter pipelines can be run in tiles (see BLOSC_TILED_PIPELINE) */
+static bool g_tiled_pipeline = true;
 static int g_initlib = 0;
 static blosc2_schunk* g_schunk = NULL;   /* the pointer to super-chunk */
 
@@ -90,6 +100,8 @@ static uint64_t g_nfilters = 0;
 
 static blosc2_io_cb g_io[256] = {0};
 static uint64_t g_nio = 0;
+static blosc2_io_ext_cb g_io_ext[256] = {0};
+static uint64_t g_nio_ext = 0;
 
 
 // Forward declarations
@@ -142,6 +154,18 @@ int release_threadpool(blosc2_context *context);
   pthread_mutex_unlock(&(CONTEXT_PTR)->count_threads_mutex);
 #endif
 
+/* Macros for the performance counters (compiled out when HAVE_STATS is not defined) */
+#if defined(HAVE_STATS)
+#define STATS_TIMESTAMP(TS) blosc_set_timestamp(&(TS))
+#define STATS_ADD(STATS_PTR, FIELD, VALUE) ((STATS_PTR)->FIELD += (VALUE))
+#define STATS_ADD_TIME(STATS_PTR, FIELD, START, END) \
+  ((STATS_PTR)->FIELD += (int64_t)blosc_elapsed_nsecs((START), (END)))
+#else
+#define STATS_TIMESTAMP(TS) ((void)(TS))
+#define STATS_ADD(STATS_PTR, FIELD, VALUE) ((void)(STATS_PTR))
+#define STATS_ADD_TIME(STATS_PTR, FIELD, START, END) ((void)(STATS_PTR))
+#endif  /* HAVE_STATS */
+
 
 /* global variable to change threading backend from Blosc-managed to caller-managed */
 static blosc_threads_callback threads_callback = 0;
@@ -156,38 +180,104 @@ void blosc_set_threads_callback(blosc_threads_callback callback, void *callback_
 }
 
 
-/* A function for aligned malloc that is portable */
-static uint8_t* my_malloc(size_t size) {
-  void* block = NULL;
-  int res = 0;
+int16_t blosc2_set_shared_threadpool(int16_t nthreads) {
+  return blosc_shared_pool_set(nthreads);
+}
 
-/* Do an alignment to 32 bytes because AVX2 is supported */
-#if defined(_WIN32)
-  /* A (void *) cast needed for avoiding a warning with MINGW :-/ */
-  block = (void *)_aligned_malloc(size, 32);
-#elif _POSIX_C_SOURCE >= 200112L || _XOPEN_SOURCE >= 600
-  /* Platform does have an implementation of posix_memalign */
-  res = posix_memalign(&block, 32, size);
-#else
-  block = malloc(size);
-#endif  /* _WIN32 */
 
-  if (block == NULL || res != 0) {
-    BLOSC_TRACE_ERROR("Error allocating memory!");
-    return NULL;
+int16_t blosc2_get_shared_threadpool(void) {
+  return blosc_shared_pool_get();
+}
+
+
+int blosc2_set_allocator(const blosc2_allocator* allocator) {
+  if (allocator != NULL &&
+      (allocator->alloc == NULL || allocator->resize == NULL || allocator->dealloc == NULL)) {
+    BLOSC_TRACE_ERROR("All the hooks of the allocator must be set.");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  blosc_allocator_set(allocator);
+  return 0;
+}
+
+
+int64_t blosc2_set_block_pool(int64_t nbytes) {
+  if (nbytes < 0) {
+    BLOSC_TRACE_ERROR("The size of the block pool cannot be negative.");
+    return BLOSC2_ERROR_INVALID_PARAM;
   }
+  return blosc_pool_set_maxbytes(nbytes);
+}
+
 
-  return (uint8_t*)block;
+int blosc2_get_cpu_caches(blosc2_cpu_caches* caches) {
+  if (caches == NULL) {
+    BLOSC_TRACE_ERROR("`caches` cannot be NULL.");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  *caches = *blosc_cpu_caches_get();
+  return 0;
 }
 
 
-/* Release memory booked by my_malloc */
-static void my_free(void* block) {
-#if defined(_WIN32)
-  _aligned_free(block);
-#else
-  free(block);
-#endif  /* _WIN32 */
+int blosc2_set_cpu_caches(const blosc2_cpu_caches* caches) {
+  if (caches != NULL &&
+      (caches->l1_size <= 0 || caches->l2_size <= 0 || caches->l3_size <= 0 ||
+       caches->l3_ncores <= 0 || caches->ncores <= 0)) {
+    BLOSC_TRACE_ERROR("The sizes of the caches and the numbers of cores must be positive.");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  blosc_cpu_caches_set(caches, true);
+  return 0;
+}
+
+
+typedef struct {
+  void (*dojob)(void *);
+  void *jobdata;
+} parallel_job;
+
+static void* t_parallel_job(void *arg) {
+  parallel_job *job = (parallel_job *)arg;
+  job->dojob(job->jobdata);
+  return NULL;
+}
+
+void blosc_run_parallel_jobs(void (*dojob)(void *), int numjobs, size_t jobdata_elsize, void *jobdata) {
+  if (numjobs <= 0) {
+    return;
+  }
+  if (threads_callback) {
+    threads_callback(threads_callback_data, dojob, numjobs, jobdata_elsize, jobdata);
+    return;
+  }
+  if (blosc_shared_pool_active() || numjobs == 1) {
+    blosc_shared_pool_run(dojob, numjobs, jobdata_elsize, jobdata);
+    return;
+  }
+
+  /* No pool to use; start threads just for these jobs (the caller runs the first one) */
+  pthread_t *threads = malloc((numjobs - 1) * sizeof(pthread_t));
+  parallel_job *jobs = malloc((numjobs - 1) * sizeof(parallel_job));
+  bool *started = malloc((numjobs - 1) * sizeof(bool));
+  for (int i = 1; i < numjobs; i++) {
+    jobs[i - 1].dojob = dojob;
+    jobs[i - 1].jobdata = (uint8_t *)jobdata + (size_t)i * jobdata_elsize;
+    started[i - 1] = pthread_create(&threads[i - 1], NULL, t_parallel_job, &jobs[i - 1]) == 0;
+  }
+  dojob(jobdata);
+  for (int i = 1; i < numjobs; i++) {
+    if (started[i - 1]) {
+      pthread_join(threads[i - 1], NULL);
+    }
+    else {
+      /* The thread could not be started; run its job here */
+      dojob(jobs[i - 1].jobdata);
+    }
+  }
+  free(started);
+  free(jobs);
+  free(threads);
 }
 
 
@@ -394,6 +484,38 @@ static int lz4_wrap_compress(const char* input, size_t input_length,
 }
 
 
+/* Compress with the LZ4 (or LZ4HC) dictionary of the context.  The digested dictionary is
+ * copied into a working stream of the thread, as a stream can only compress one block. */
+static int lz4_wrap_compress_dict(struct thread_context* thread_context,
+                                  const char* input, size_t input_length,
+                                  char* output, size_t maxout) {
+  blosc2_context* context = thread_context->parent_context;
+  int cbytes;
+  if (input_length > (size_t)(UINT32_C(2) << 30))
+    return BLOSC2_ERROR_2GB_LIMIT;
+  if (context->dict_compcode == BLOSC_LZ4HC) {
+    if (thread_context->lz4hc_stream == NULL) {
+      thread_context->lz4hc_stream = LZ4_createStreamHC();
+      BLOSC_ERROR_NULL(thread_context->lz4hc_stream, BLOSC2_ERROR_MEMORY_ALLOC);
+    }
+    memcpy(thread_context->lz4hc_stream, context->dict_cdict, sizeof(LZ4_streamHC_t));
+    cbytes = LZ4_compress_HC_continue(thread_context->lz4hc_stream, input, output,
+                                      (int)input_length, (int)maxout);
+  }
+  else {
+    if (thread_context->lz4_stream == NULL) {
+      thread_context->lz4_stream = LZ4_createStream();
+      BLOSC_ERROR_NULL(thread_context->lz4_stream, BLOSC2_ERROR_MEMORY_ALLOC);
+    }
+    memcpy(thread_context->lz4_stream, context->dict_cdict, sizeof(LZ4_stream_t));
+    // No acceleration, like in lz4_wrap_compress
+    cbytes = LZ4_compress_fast_continue(thread_context->lz4_stream, input, output,
+                                        (int)input_length, (int)maxout, 1);
+  }
+  return cbytes;
+}
+
+
 static int lz4hc_wrap_compress(const char* input, size_t input_length,
                                char* output, size_t maxout, int clevel) {
   int cbytes;
@@ -408,8 +530,13 @@ static int lz4hc_wrap_compress(const char* input, size_t input_length,
 
 
 static int lz4_wrap_decompress(const char* input, size_t compressed_length,
-                               char* output, size_t maxout) {
+                               char* output, size_t maxout, const char* dict, int32_t dict_size) {
   int nbytes;
+  if (dict != NULL) {
+    nbytes = LZ4_decompress_safe_usingDict(input, output, (int)compressed_length, (int)maxout,
+                                           dict, dict_size);
+    return nbytes != (int)maxout ? 0 : (int)maxout;
+  }
 #ifdef HAVE_IPP
   int outlen = (int)maxout;
   int inlen = (int)compressed_length;
@@ -456,15 +583,21 @@ static int zlib_wrap_decompress(const char* input, size_t compressed_length,
 
 
 #if defined(HAVE_ZSTD)
+/* Map a Blosc compression level into a ZSTD one */
+static int zstd_clevel(int clevel) {
+  clevel = (clevel < 9) ? clevel * 2 - 1 : ZSTD_maxCLevel();
+  /* Make the level 8 close enough to maxCLevel */
+  if (clevel == 8) clevel = ZSTD_maxCLevel() - 2;
+  return clevel;
+}
+
 static int zstd_wrap_compress(struct thread_context* thread_context,
                               const char* input, size_t input_length,
                               char* output, size_t maxout, int clevel) {
   size_t code;
   blosc2_context* context = thread_context->parent_context;
 
-  clevel = (clevel < 9) ? clevel * 2 - 1 : ZSTD_maxCLevel();
-  /* Make the level 8 close enough to maxCLevel */
-  if (clevel == 8) clevel = ZSTD_maxCLevel() - 2;
+  clevel = zstd_clevel(clevel);
 
   if (thread_context->zstd_cctx == NULL) {
     thread_context->zstd_cctx = ZSTD_createCCtx();
@@ -562,7 +695,7 @@ int last_filter(const uint8_t* filters, char cmode) {
 
 
 /* Convert filter pipeline to filter flags */
-static uint8_t filters_to_flags(const uint8_t* filters) {
+uint8_t filters_to_flags(const uint8_t* filters) {
   uint8_t flags = 0;
 
   for (int i = 0; i < BLOSC2_MAX_FILTERS; i++) {
@@ -807,6 +940,236 @@ static int blosc2_intialize_header_from_context(blosc2_context* context, blosc_h
 }
 
 
+/* Size of the tiles in which the filter pipeline of a block is run (so
+   that the intermediate results of the filters stay in L1) */
+#define BLOSC_PIPELINE_TILESIZE (8 * 1024)
+
+/* Return the index of the (bit)shuffle filter ending a pipeline that can be
+   run in tiles, or -1 if the pipeline of the block cannot be run like that.
+   Only filters working element by element (plus the delta filters, which
+   carry the previous element across tiles) can precede the (bit)shuffle. */
+static int tiled_pipeline_filter(blosc2_context* context, int32_t bsize, char cmode) {
+  uint8_t* filters = context->filters;
+  int32_t typesize = context->typesize;
+  int shuffle_index = -1;
+  int nstages = 0;
+
+  if (!g_tiled_pipeline || bsize < 4 * BLOSC_PIPELINE_TILESIZE || typesize * 8 > BLOSC_PIPELINE_TILESIZE) {
+    return -1;
+  }
+  if ((cmode == 'c' && context->prefilter != NULL) || (cmode == 'd' && context->postfilter != NULL)) {
+    return -1;
+  }
+  for (int i = BLOSC2_MAX_FILTERS - 1; i >= 0; i--) {
+    if (filters[i] == BLOSC_NOFILTER) {
+      continue;
+    }
+    if (shuffle_index < 0) {
+      // The last filter in the pipeline
+      if (!((filters[i] == BLOSC_SHUFFLE && context->filters_meta[i] == 0) ||
+            filters[i] == BLOSC_BITSHUFFLE)) {
+        return -1;
+      }
+      if (cmode == 'd' && filters[i] == BLOSC_BITSHUFFLE && context->src[BLOSC2_CHUNK_VERSION] < 3) {
+        return -1;
+      }
+      shuffle_index = i;
+      continue;
+    }
+    switch (filters[i]) {
+      case BLOSC_DELTA:
+        // The XOR delta is decoded in place in the destination (see pipeline_backward)
+        if (cmode == 'd') {
+          return -1;
+        }
+        nstages++;
+        break;
+      case BLOSC_DELTA_SUB:
+        nstages++;
+        break;
+      case BLOSC_TRUNC_PREC:
+        if (typesize != 4 && typesize != 8) {
+          return -1;
+        }
+        // Nothing to do during decompression
+        nstages += (cmode == 'c');
+        break;
+      default:
+        return -1;
+    }
+  }
+  return nstages > 0 ? shuffle_index : -1;
+}
+
+
+/* Run the filter pipeline of a block in tiles, so that the block is read from src
+   and written to dest just once.  Intermediate results go to tiles in tmp. */
+static int pipeline_forward_tiled(blosc2_context* context, const int32_t bsize,
+                                  const uint8_t* src, const int32_t offset,
+                                  uint8_t* dest, uint8_t* tmp, int shuffle_index) {
+  int32_t typesize = context->typesize;
+  uint8_t* filters = context->filters;
+  uint8_t* filters_meta = context->filters_meta;
+  const uint8_t* block = src + offset;
+  int32_t nelems = bsize / typesize;
+  // A multiple of 8 elements, for bitshuffle
+  int32_t tile_nelems = (BLOSC_PIPELINE_TILESIZE / typesize) & ~7;
+  int32_t tile_bytes = tile_nelems * typesize;
+  uint8_t* stage_buf[2] = {tmp, tmp + tile_bytes};
+  uint8_t* shuffle_buf = tmp + 2 * tile_bytes;
+  uint8_t* bitshuffle_tmp = tmp + 3 * tile_bytes;
+  bool bitshuffled = filters[shuffle_index] == BLOSC_BITSHUFFLE;
+  // bitshuffle leaves the elements that are not a multiple of 8 as they are
+  int32_t nshuffled = bitshuffled ? nelems - nelems % 8 : nelems;
+  // The last element of the previous tile, for the subtractive delta
+  uint8_t prev[BLOSC2_MAX_FILTERS][256];
+  int32_t dtypesize = delta_typesize(typesize);
+
+  int32_t n;
+  for (int32_t e0 = 0; e0 < nelems; e0 += n) {
+    n = nelems - e0 < tile_nelems ? nelems - e0 : tile_nelems;
+    if (e0 < nshuffled && e0 + n > nshuffled) {
+      // The elements that are not bit-shuffled go in a tile of their own
+      n = nshuffled - e0;
+    }
+    int32_t nbytes = n * typesize;
+    const uint8_t* in = block + e0 * typesize;
+    int nbuf = 0;
+    for (int i = 0; i < shuffle_index; i++) {
+      uint8_t* out = stage_buf[nbuf];
+      switch (filters[i]) {
+        case BLOSC_NOFILTER:
+          continue;
+        case BLOSC_DELTA:
+          if (offset != 0) {
+            delta_encoder(src + e0 * typesize, offset, nbytes, typesize, in, out);
+          }
+          else if (e0 == 0) {
+            delta_encoder(src, 0, nbytes, typesize, in, out);
+          }
+          else {
+            // Past the first tile, the reference block is coded wrt its previous element
+            delta_encoder(src + e0 * typesize - dtypesize, 1, nbytes, typesize, in, out);
+          }
+          break;
+        case BLOSC_DELTA_SUB:
+          delta_sub_encoder(nbytes, typesize, in, out);
+          if (e0 > 0) {
+            delta_sub_element(typesize, in, prev[i], out, false);
+          }
+          memcpy(prev[i], in + nbytes - typesize, typesize);
+          break;
+        case BLOSC_TRUNC_PREC:
+          truncate_precision(filters_meta[i], typesize, nbytes, in, out);
+          break;
+        default:
+          BLOSC_TRACE_ERROR("Filter %d cannot be run in tiles\n", filters[i]);
+          return BLOSC2_ERROR_FILTER_PIPELINE;
+      }
+      in = out;
+      nbuf ^= 1;
+    }
+
+    if (e0 >= nshuffled) {
+      memcpy(dest + e0 * typesize, in, nbytes);
+    }
+    else if (!bitshuffled) {
+      // The byte j of the elements goes to dest + j * nelems
+      shuffle(typesize, nbytes, in, shuffle_buf);
+      for (int32_t j = 0; j < typesize; j++) {
+        memcpy(dest + j * nelems + e0, shuffle_buf + j * n, n);
+      }
+    }
+    else {
+      // The bit k of the elements goes to dest + k * nshuffled / 8
+      if (bitshuffle(typesize, nbytes, in, shuffle_buf, bitshuffle_tmp) < 0) {
+        return BLOSC2_ERROR_FILTER_PIPELINE;
+      }
+      for (int32_t k = 0; k < 8 * typesize; k++) {
+        memcpy(dest + k * (nshuffled / 8) + e0 / 8, shuffle_buf + k * (n / 8), n / 8);
+      }
+    }
+  }
+  // Copy the leftovers (not a whole element)
+  memcpy(dest + nelems * typesize, block + nelems * typesize, bsize - nelems * typesize);
+
+  return BLOSC2_ERROR_SUCCESS;
+}
+
+
+/* Undo the filter pipeline of a block in tiles (see pipeline_forward_tiled) */
+static int pipeline_backward_tiled(blosc2_context* context, const int32_t bsize,
+                                   uint8_t* dest, const uint8_t* src, uint8_t* tmp,
+                                   int shuffle_index) {
+  int32_t typesize = context->typesize;
+  uint8_t* filters = context->filters;
+  int32_t nelems = bsize / typesize;
+  int32_t tile_nelems = (BLOSC_PIPELINE_TILESIZE / typesize) & ~7;
+  int32_t tile_bytes = tile_nelems * typesize;
+  uint8_t* stage_buf[2] = {tmp, tmp + tile_bytes};
+  uint8_t* bitshuffle_tmp = tmp + 2 * tile_bytes;
+  bool bitshuffled = filters[shuffle_index] == BLOSC_BITSHUFFLE;
+  int32_t nshuffled = bitshuffled ? nelems - nelems % 8 : nelems;
+  uint8_t prev[BLOSC2_MAX_FILTERS][256];
+  int first_stage = 0;
+  while (filters[first_stage] != BLOSC_DELTA_SUB) {
+    first_stage++;
+  }
+
+  int32_t n;
+  for (int32_t e0 = 0; e0 < nelems; e0 += n) {
+    n = nelems - e0 < tile_nelems ? nelems - e0 : tile_nelems;
+    if (e0 < nshuffled && e0 + n > nshuffled) {
+      // The elements that are not bit-shuffled go in a tile of their own
+      n = nshuffled - e0;
+    }
+    int32_t nbytes = n * typesize;
+    uint8_t* gathered = stage_buf[0];
+    uint8_t* in = stage_buf[1];
+
+    if (e0 >= nshuffled) {
+      memcpy(in, src + e0 * typesize, nbytes);
+    }
+    else if (!bitshuffled) {
+      for (int32_t j = 0; j < typesize; j++) {
+        memcpy(gathered + j * n, src + j * nelems + e0, n);
+      }
+      unshuffle(typesize, nbytes, gathered, in);
+    }
+    else {
+      for (int32_t k = 0; k < 8 * typesize; k++) {
+        memcpy(gathered + k * (n / 8), src + k * (nshuffled / 8) + e0 / 8, n / 8);
+      }
+      if (bitunshuffle(typesize, nbytes, gathered, in, bitshuffle_tmp,
+                       context->src[BLOSC2_CHUNK_VERSION]) < 0) {
+        return BLOSC2_ERROR_FILTER_PIPELINE;
+      }
+    }
+
+    int nbuf = 0;
+    for (int i = shuffle_index - 1; i >= first_stage; i--) {
+      if (filters[i] != BLOSC_DELTA_SUB) {
+        // TRUNC_PREC does not have to be undone
+        continue;
+      }
+      uint8_t* out = (i == first_stage) ? dest + e0 * typesize : stage_buf[nbuf];
+      if (e0 > 0) {
+        // Start from the last element of the previous tile
+        delta_sub_element(typesize, in, prev[i], in, true);
+      }
+      delta_sub_decoder(nbytes, typesize, in, out);
+      memcpy(prev[i], out + nbytes - typesize, typesize);
+      in = out;
+      nbuf ^= 1;
+    }
+  }
+  // Copy the leftovers (not a whole element)
+  memcpy(dest + nelems * typesize, src + nelems * typesize, bsize - nelems * typesize);
+
+  return BLOSC2_ERROR_SUCCESS;
+}
+
+
 uint8_t* pipeline_forward(struct thread_context* thread_context, const int32_t bsize,
                           const uint8_t* src, const int32_t offset,
                           uint8_t* dest, uint8_t* tmp, uint8_t* tmp2) {
@@ -838,10 +1201,14 @@ uint8_t* pipeline_forward(struct thread_context* thread_context, const int32_t b
     preparams.ttmp_nbytes = thread_context->tmp_nbytes;
     preparams.ctx = context;
 
+    blosc_timestamp_t last, current;
+    STATS_TIMESTAMP(last);
     if (context->prefilter(&preparams) != 0) {
       BLOSC_TRACE_ERROR("Execution of prefilter function failed");
       return NULL;
     }
+    STATS_TIMESTAMP(current);
+    STATS_ADD_TIME(&thread_context->stats, prefilter_ns, last, current);
 
     if (memcpyed) {
       // No more filters are required
@@ -853,8 +1220,27 @@ uint8_t* pipeline_forward(struct thread_context* thread_context, const int32_t b
     _tmp = _src;
   }
 
+  blosc_timestamp_t start, end;
+  STATS_TIMESTAMP(start);
+
+  /* Run the whole pipeline in tiles when possible */
+  int shuffle_index = tiled_pipeline_filter(context, bsize, 'c');
+  if (shuffle_index >= 0) {
+    if (pipeline_forward_tiled(context, bsize, src, offset, _dest, _tmp, shuffle_index) < 0) {
+      return NULL;
+    }
+    STATS_TIMESTAMP(end);
+    STATS_ADD_TIME(&thread_context->stats, filter_ns, start, end);
+    return _dest;
+  }
+
   /* Process the filter pipeline */
+  int fused_filter = -1;
   for (int i = 0; i < BLOSC2_MAX_FILTERS; i++) {
+    if (i == fused_filter) {
+      // Already applied together with the previous filter
+      continue;
+    }
     int rc = BLOSC2_ERROR_SUCCESS;
     if (filters[i] <= BLOSC2_DEFINED_FILTERS_STOP) {
       switch (filters[i]) {
@@ -877,9 +1263,29 @@ uint8_t* pipeline_forward(struct thread_context* thread_context, const int32_t b
         case BLOSC_DELTA:
           delta_encoder(src, offset, bsize, typesize, _src, _dest);
           break;
-        case BLOSC_TRUNC_PREC:
-          truncate_precision(filters_meta[i], typesize, bsize, _src, _dest);
+        case BLOSC_DELTA_SUB:
+          delta_sub_encoder(bsize, typesize, _src, _dest);
+          break;
+        case BLOSC_TRUNC_PREC: {
+          // When a (bit)shuffle comes next, do both in a single sweep of the block
+          int next = i + 1;
+          while (next < BLOSC2_MAX_FILTERS && filters[next] == BLOSC_NOFILTER) {
+            next++;
+          }
+          if (next < BLOSC2_MAX_FILTERS && (typesize == 4 || typesize == 8) &&
+              ((filters[next] == BLOSC_SHUFFLE && filters_meta[next] == 0) ||
+               filters[next] == BLOSC_BITSHUFFLE)) {
+            if (truncate_precision_shuffle(filters_meta[i], filters[next], typesize, bsize,
+                                           _src, _dest, tmp2) < 0) {
+              return NULL;
+            }
+            fused_filter = next;
+          }
+          else {
+            truncate_precision(filters_meta[i], typesize, bsize, _src, _dest);
+          }
           break;
+        }
         default:
           if (filters[i] != BLOSC_NOFILTER) {
             BLOSC_TRACE_ERROR("Filter %d not handled during compression\n", filters[i]);
@@ -920,33 +1326,167 @@ uint8_t* pipeline_forward(struct thread_context* thread_context, const int32_t b
       _tmp = _src;
     }
   }
+  STATS_TIMESTAMP(end);
+  STATS_ADD_TIME(&thread_context->stats, filter_ns, start, end);
   return _src;
 }
 
 
-// Optimized version for detecting runs.  It compares 8 bytes values wherever possible.
-static bool get_run(const uint8_t* ip, const uint8_t* ip_bound) {
-  uint8_t x = *ip;
-  int64_t value, value2;
-  /* Broadcast the value for every byte in a 64-bit register */
-  memset(&value, x, 8);
-  while (ip < (ip_bound - 8)) {
-#if defined(BLOSC_STRICT_ALIGN)
-    memcpy(&value2, ip, 8);
-#else
-    value2 = *(int64_t*)ip;
+/* Return whether the nbytes in ip are made of a value of typesize bytes that
+   repeats.  Every byte is compared with the one a typesize before, a vector at a time. */
+static bool get_repeated_value(const uint8_t* ip, int32_t nbytes, int32_t typesize) {
+  const uint8_t* ip2 = ip + typesize;
+  int32_t n = nbytes - typesize;
+  int32_t i = 0;
+#if defined(__AVX2__)
+  for (; i + 4 * (int32_t)sizeof(__m256i) <= n; i += 4 * (int32_t)sizeof(__m256i)) {
+    __m256i diff = _mm256_setzero_si256();
+    for (int j = 0; j < 4; j++) {
+      __m256i a = _mm256_loadu_si256((const __m256i *)(ip + i) + j);
+      __m256i b = _mm256_loadu_si256((const __m256i *)(ip2 + i) + j);
+      diff = _mm256_or_si256(diff, _mm256_xor_si256(a, b));
+    }
+    if (!_mm256_testz_si256(diff, diff)) {
+      return false;
+    }
+  }
+#elif defined(__SSE2__)
+  for (; i + 4 * (int32_t)sizeof(__m128i) <= n; i += 4 * (int32_t)sizeof(__m128i)) {
+    __m128i diff = _mm_setzero_si128();
+    for (int j = 0; j < 4; j++) {
+      __m128i a = _mm_loadu_si128((const __m128i *)(ip + i) + j);
+      __m128i b = _mm_loadu_si128((const __m128i *)(ip2 + i) + j);
+      diff = _mm_or_si128(diff, _mm_xor_si128(a, b));
+    }
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(diff, _mm_setzero_si128())) != 0xFFFF) {
+      return false;
+    }
+  }
+#elif defined(__ARM_NEON)
+  for (; i + 64 <= n; i += 64) {
+    uint8x16_t diff = vdupq_n_u8(0);
+    for (int j = 0; j < 4; j++) {
+      diff = vorrq_u8(diff, veorq_u8(vld1q_u8(ip + i + 16 * j), vld1q_u8(ip2 + i + 16 * j)));
+    }
+    uint64x2_t diff64 = vreinterpretq_u64_u8(diff);
+    if ((vgetq_lane_u64(diff64, 0) | vgetq_lane_u64(diff64, 1)) != 0) {
+      return false;
+    }
+  }
 #endif
+  for (; i + 8 <= n; i += 8) {
+    int64_t value, value2;
+    memcpy(&value, ip + i, 8);
+    memcpy(&value2, ip2 + i, 8);
     if (value != value2) {
-      // Values differ.  We don't have a run.
       return false;
     }
+  }
+  for (; i < n; i++) {
+    if (ip[i] != ip2[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+// Detect runs of a single byte
+static bool get_run(const uint8_t* ip, const uint8_t* ip_bound) {
+  return get_repeated_value(ip, (int32_t)(ip_bound - ip), 1);
+}
+
+
+/* Number and size of the samples taken by the incompressibility probe */
+#define BLOSC_PROBE_NSAMPLES 8
+#define BLOSC_PROBE_SAMPLESIZE 512
+#define BLOSC_PROBE_HASHLOG 12
+
+/* Sample the nbytes in src and return whether they look incompressible: the
+   entropy of their bytes is at least min_entropy bits, and 4-byte sequences
+   hardly ever repeat.  This is much cheaper than running a codec. */
+static bool probe_incompressible(const uint8_t* src, int32_t nbytes, float min_entropy) {
+  uint32_t counts[256] = {0};
+  uint16_t htab[1U << BLOSC_PROBE_HASHLOG];
+  uint8_t samples[BLOSC_PROBE_NSAMPLES * BLOSC_PROBE_SAMPLESIZE];
+  int32_t nsamples = BLOSC_PROBE_NSAMPLES;
+  int32_t samplesize = BLOSC_PROBE_SAMPLESIZE;
+  int32_t nmatches = 0;
+
+  if (min_entropy <= 0 || nbytes < nsamples * samplesize) {
+    return false;
+  }
+  // Samples evenly spread over the buffer
+  for (int32_t i = 0; i < nsamples; i++) {
+    int64_t start = (int64_t)(nbytes - samplesize) * i / (nsamples - 1);
+    memcpy(samples + i * samplesize, src + start, samplesize);
+  }
+  int32_t size = nsamples * samplesize;
+  for (int32_t i = 0; i < size; i++) {
+    counts[samples[i]]++;
+  }
+  // Repeated sequences, as LZ codecs see them
+  memset(htab, 0xFF, sizeof(htab));
+  for (int32_t i = 0; i + 4 <= size; i++) {
+    uint32_t seq;
+    memcpy(&seq, samples + i, 4);
+    uint32_t hval = (seq * 2654435761U) >> (32 - BLOSC_PROBE_HASHLOG);
+    uint16_t ref = htab[hval];
+    if (ref != 0xFFFF && memcmp(samples + ref, samples + i, 4) == 0) {
+      nmatches++;
+    }
+    htab[hval] = (uint16_t)i;
+  }
+  if (nmatches * 256 > size) {
+    return false;
+  }
+  double entropy = 0;
+  for (int i = 0; i < 256; i++) {
+    if (counts[i] > 0) {
+      double p = (double)counts[i] / size;
+      entropy -= p * log2(p);
+    }
+  }
+  return entropy >= min_entropy;
+}
+
+
+/* Encode chunks made of a repeated value as special chunks (zeros, NaNs or a
+   value), without compressing their blocks.  Returns the size of the chunk, or
+   0 if the source is not made of a repeated value. */
+static int compress_special_run(blosc2_context* context) {
+  int32_t typesize = context->typesize;
+  int32_t nbytes = context->sourcesize;
+
+  if (context->header_overhead != BLOSC_EXTENDED_HEADER_LENGTH || context->prefilter != NULL ||
+      (context->blosc2_flags & BLOSC2_INSTR_CODEC) || nbytes == 0 || nbytes % typesize != 0 ||
+      context->destsize < BLOSC_EXTENDED_HEADER_LENGTH + typesize) {
+    return 0;
+  }
+  if (!get_repeated_value(context->src, nbytes, typesize)) {
+    return 0;
+  }
+
+  int special_type = BLOSC2_SPECIAL_VALUE;
+  int32_t cbytes = BLOSC_EXTENDED_HEADER_LENGTH;
+  if (get_run(context->src, context->src + typesize) && context->src[0] == 0) {
+    special_type = BLOSC2_SPECIAL_ZERO;
+  }
+  else {
+    // Only the NaNs that set_nans() produces can be encoded as such
+    float nan4 = nanf("");
+    double nan8 = nan("");
+    if ((typesize == 4 && memcmp(&nan4, context->src, 4) == 0) ||
+        (typesize == 8 && memcmp(&nan8, context->src, 8) == 0)) {
+      special_type = BLOSC2_SPECIAL_NAN;
+    }
     else {
-      ip += 8;
+      memcpy(context->dest + BLOSC_EXTENDED_HEADER_LENGTH, context->src, typesize);
+      cbytes += typesize;
     }
   }
-  /* Look into the remainder */
-  while ((ip < ip_bound) && (*ip == x)) ip++;
-  return ip == ip_bound ? true : false;
+  context->dest[BLOSC2_CHUNK_BLOSC2_FLAGS] |= (uint8_t)(special_type << 4);
+  return cbytes;
 }
 
 
@@ -974,6 +1514,7 @@ static int blosc_c(struct thread_context* thread_context, int32_t bsize,
   blosc_timestamp_t last, current;
   float filter_time = 0.f;
 
+  STATS_ADD(&thread_context->stats, nblocks, 1);
   if (instr_codec) {
     blosc_set_timestamp(&last);
   }
@@ -1003,6 +1544,8 @@ static int blosc_c(struct thread_context* thread_context, int32_t bsize,
     filter_time = (float) blosc_elapsed_secs(last, current);
     last = current;
   }
+  blosc_timestamp_t codec_start, codec_end;
+  STATS_TIMESTAMP(codec_start);
 
   assert(context->clevel > 0);
 
@@ -1010,7 +1553,8 @@ static int blosc_c(struct thread_context* thread_context, int32_t bsize,
   accel = get_accel(context);
 
   /* The number of compressed data streams for this block */
-  if (!dont_split && !leftoverblock && !dict_training) {
+  if (!dont_split && !leftoverblock && !context->use_dict) {
+    // We don't want to split when using dicts (the same as in blosc_d)
     nstreams = (int32_t)typesize;
   }
   else {
@@ -1076,6 +1620,21 @@ static int blosc_c(struct thread_context* thread_context, int32_t bsize,
       }
     }
 
+    if (context->probe_blocks && !dict_training && !instr_codec &&
+        probe_incompressible(_src + j * neblock, neblock, context->probe_entropy)) {
+      // Incompressible, go straight to the copy below
+      BLOSC_ATOMIC_FETCH_ADD32(&context->probe_nblocks, 1);
+      if (ntbytes + neblock > destsize) {
+        return 0;    /* Non-compressible data */
+      }
+      memcpy(dest, _src + j * neblock, (unsigned int)neblock);
+      _sw32(dest - 4, neblock);
+      dest += neblock;
+      ntbytes += neblock;
+      ctbytes += neblock;
+      continue;
+    }
+
     maxout = neblock;
     if (ntbytes + maxout > destsize) {
       /* avoid buffer * overrun */
@@ -1090,6 +1649,16 @@ static int blosc_c(struct thread_context* thread_context, int32_t bsize,
       memcpy(dest, _src + j * neblock, (unsigned int)neblock);
       cbytes = (int32_t)neblock;
     }
+    else if (context->compcode == BLOSC_BLOSCLZ && context->use_dict) {
+      cbytes = blosclz_compress_dict(context->clevel, _src + j * neblock, (int)neblock,
+                                     dest, (int)maxout, context->dict_buffer,
+                                     context->dict_size, context);
+    }
+    else if ((context->compcode == BLOSC_LZ4 || context->compcode == BLOSC_LZ4HC) &&
+             context->use_dict) {
+      cbytes = lz4_wrap_compress_dict(thread_context, (char*)_src + j * neblock,
+                                      (size_t)neblock, (char*)dest, (size_t)maxout);
+    }
     else if (context->compcode == BLOSC_BLOSCLZ) {
       cbytes = blosclz_compress(context->clevel, _src + j * neblock,
                                 (int)neblock, dest, (int)maxout, context);
@@ -1196,11 +1765,23 @@ static int blosc_c(struct thread_context* thread_context, int32_t bsize,
     ctbytes += cbytes;
   }  /* Closes j < nstreams */
 
+  STATS_TIMESTAMP(codec_end);
+  STATS_ADD_TIME(&thread_context->stats, codec_ns, codec_start, codec_end);
   //printf("c%d", ctbytes);
   return ctbytes;
 }
 
 
+/* The chunk passed to the postfilter.  The contexts of concurrent readers of a super-chunk
+ * carry their own chunk, as `schunk->current_nchunk` is shared. */
+static int32_t postfilter_nchunk(blosc2_context* context) {
+  if (context->nchunk >= 0) {
+    return context->nchunk;
+  }
+  return context->schunk != NULL ? context->schunk->current_nchunk : -1;
+}
+
+
 /* Process the filter pipeline (decompression mode) */
 int pipeline_backward(struct thread_context* thread_context, const int32_t bsize, uint8_t* dest,
                       const int32_t offset, uint8_t* src, uint8_t* tmp,
@@ -1215,6 +1796,18 @@ int pipeline_backward(struct thread_context* thread_context, const int32_t bsize
   uint8_t* _tmp = tmp2;
   int errcode = 0;
 
+  blosc_timestamp_t start, end;
+  STATS_TIMESTAMP(start);
+
+  /* Run the whole pipeline in tiles when possible */
+  int shuffle_index = tiled_pipeline_filter(context, bsize, 'd');
+  if (shuffle_index >= 0) {
+    errcode = pipeline_backward_tiled(context, bsize, dest + offset, src, tmp, shuffle_index);
+    STATS_TIMESTAMP(end);
+    STATS_ADD_TIME(&thread_context->stats, filter_ns, start, end);
+    return errcode;
+  }
+
   for (int i = BLOSC2_MAX_FILTERS - 1; i >= 0; i--) {
     // Delta filter requires the whole chunk ready
     int last_copy_filter = (last_filter_index == i) || (next_filter(filters, i, 'd') == BLOSC_DELTA);
@@ -1253,7 +1846,11 @@ int pipeline_backward(struct thread_context* thread_context, const int32_t bsize
             pthread_mutex_lock(&context->delta_mutex);
             if (context->dref_not_init) {
               if (offset != 0) {
+                blosc_timestamp_t last, current;
+                STATS_TIMESTAMP(last);
                 pthread_cond_wait(&context->delta_cv, &context->delta_mutex);
+                STATS_TIMESTAMP(current);
+                STATS_ADD_TIME(&thread_context->stats, wait_ns, last, current);
               } else {
                 delta_decoder(dest, offset, bsize, typesize, _dest);
                 context->dref_not_init = 0;
@@ -1266,6 +1863,10 @@ int pipeline_backward(struct thread_context* thread_context, const int32_t bsize
             }
           }
           break;
+        case BLOSC_DELTA_SUB:
+          // Unlike BLOSC_DELTA, this only depends on the data in the block
+          delta_sub_decoder(bsize, typesize, _src, _dest);
+          break;
         case BLOSC_TRUNC_PREC:
           // TRUNC_PREC filter does not need to be undone
           break;
@@ -1311,6 +1912,8 @@ int pipeline_backward(struct thread_context* thread_context, const int32_t bsize
       break;
     }
   }
+  STATS_TIMESTAMP(end);
+  STATS_ADD_TIME(&thread_context->stats, filter_ns, start, end);
 
   /* Postfilter function */
   if (context->postfilter != NULL) {
@@ -1322,17 +1925,21 @@ int pipeline_backward(struct thread_context* thread_context, const int32_t bsize
     postparams.size = bsize;
     postparams.typesize = typesize;
     postparams.offset = nblock * context->blocksize;
-    postparams.nchunk = context->schunk != NULL ? context->schunk->current_nchunk : -1;
+    postparams.nchunk = postfilter_nchunk(context);
     postparams.nblock = nblock;
     postparams.tid = thread_context->tid;
     postparams.ttmp = thread_context->tmp;
     postparams.ttmp_nbytes = thread_context->tmp_nbytes;
     postparams.ctx = context;
 
+    blosc_timestamp_t last, current;
+    STATS_TIMESTAMP(last);
     if (context->postfilter(&postparams) != 0) {
       BLOSC_TRACE_ERROR("Execution of postfilter function failed");
       return BLOSC2_ERROR_POSTFILTER;
     }
+    STATS_TIMESTAMP(current);
+    STATS_ADD_TIME(&thread_context->stats, postfilter_ns, last, current);
   }
 
   return errcode;
@@ -1462,6 +2069,8 @@ static int blosc_d(
     // Do not decompress, but act as if we successfully decompressed everything
     return bsize;
   }
+  STATS_ADD(&thread_context->stats, nblocks, 1);
+  blosc_timestamp_t start, end;
 
   // In some situations (lazychunks) the context can arrive uninitialized
   // (but BITSHUFFLE needs it for accessing the format of the chunk)
@@ -1483,7 +2092,6 @@ static int blosc_d(
       return BLOSC2_ERROR_INVALID_PARAM;
     }
     blosc2_frame_s* frame = (blosc2_frame_s*)context->schunk->frame;
-    char* urlpath = frame->urlpath;
     int32_t trailer_len = sizeof(int32_t) + sizeof(int64_t) + context->nblocks * sizeof(int32_t);
     size_t trailer_offset = BLOSC_EXTENDED_HEADER_LENGTH + context->nblocks * sizeof(int32_t);
     int32_t nchunk;
@@ -1494,37 +2102,25 @@ static int blosc_d(
     // Get the csize of the nblock
     int32_t *block_csizes = (int32_t *)(src + trailer_offset + sizeof(int32_t) + sizeof(int64_t));
     int32_t block_csize = block_csizes[nblock];
-    // Read the lazy block on disk
-    void* fp = NULL;
-    blosc2_io_cb *io_cb = blosc2_get_io_cb(context->schunk->storage->io->id);
-    if (io_cb == NULL) {
-      BLOSC_TRACE_ERROR("Error getting the input/output API");
-      return BLOSC2_ERROR_PLUGIN_IO;
-    }
-
-    if (frame->sframe) {
-      // The chunk is not in the frame
-      char* chunkpath = malloc(strlen(frame->urlpath) + 1 + 8 + strlen(".chunk") + 1);
-      BLOSC_ERROR_NULL(chunkpath, BLOSC2_ERROR_MEMORY_ALLOC);
-      sprintf(chunkpath, "%s/%08X.chunk", frame->urlpath, nchunk);
-      fp = io_cb->open(chunkpath, "rb", context->schunk->storage->io->params);
-      free(chunkpath);
-      // The offset of the block is src_offset
-      io_cb->seek(fp, src_offset, SEEK_SET);
+    int64_t rbytes;
+    if (context->lazy_batch != NULL && context->lazy_nreads[nblock] >= 0) {
+      // The block has been read in the background already (or it is about to)
+      rbytes = frame_complete_read(context->lazy_batch, context->lazy_nreads[nblock]);
+      src = context->lazy_buffer + context->lazy_boffsets[nblock];
     }
     else {
-      fp = io_cb->open(urlpath, "rb", context->schunk->storage->io->params);
-      // The offset of the block is src_offset
-      io_cb->seek(fp, chunk_offset + src_offset, SEEK_SET);
+      // Read the lazy block on disk (the offset of the block in the chunk is src_offset)
+      int64_t block_offset = frame->sframe ? src_offset : chunk_offset + src_offset;
+      // We can make use of tmp3 because it will be used after src is not needed anymore
+      rbytes = frame_read(frame, nchunk, block_offset, tmp3, block_csize);
+      src = tmp3;
+      STATS_ADD(&thread_context->stats, lazy_nreads, 1);
+      STATS_ADD(&thread_context->stats, lazy_nbytes, rbytes > 0 ? rbytes : 0);
     }
-    // We can make use of tmp3 because it will be used after src is not needed anymore
-    int64_t rbytes = io_cb->read(tmp3, 1, block_csize, fp);
-    io_cb->close(fp);
     if ((int32_t)rbytes != block_csize) {
       BLOSC_TRACE_ERROR("Cannot read the (lazy) block out of the fileframe.");
       return BLOSC2_ERROR_READ_BUFFER;
     }
-    src = tmp3;
     src_offset = 0;
     srcsize = block_csize;
   }
@@ -1550,6 +2146,7 @@ static int blosc_d(
       _dest = tmp;
     }
     rc = 0;
+    STATS_TIMESTAMP(start);
     switch (context->special_type) {
       case BLOSC2_SPECIAL_VALUE:
         // All repeated values
@@ -1575,6 +2172,8 @@ static int blosc_d(
       default:
         memcpy(_dest, src, bsize_);
     }
+    STATS_TIMESTAMP(end);
+    STATS_ADD_TIME(&thread_context->stats, memcpy_ns, start, end);
     if (context->postfilter != NULL) {
       // Create new postfilter parameters for this block (must be private for each thread)
       blosc2_postfilter_params postparams;
@@ -1584,7 +2183,7 @@ static int blosc_d(
       postparams.size = bsize;
       postparams.typesize = typesize;
       postparams.offset = nblock * context->blocksize;
-      postparams.nchunk = context->schunk != NULL ? context->schunk->current_nchunk : -1;
+      postparams.nchunk = postfilter_nchunk(context);
       postparams.nblock = nblock;
       postparams.tid = thread_context->tid;
       postparams.ttmp = thread_context->tmp;
@@ -1596,6 +2195,8 @@ static int blosc_d(
         BLOSC_TRACE_ERROR("Execution of postfilter function failed");
         return BLOSC2_ERROR_POSTFILTER;
       }
+      STATS_TIMESTAMP(start);
+      STATS_ADD_TIME(&thread_context->stats, postfilter_ns, end, start);
     }
     context->zfp_cell_nitems = 0;
     return bsize_;
@@ -1639,6 +2240,7 @@ static int blosc_d(
     /* Not enough space to output bytes */
     return -1;
   }
+  STATS_TIMESTAMP(start);
   for (int j = 0; j < nstreams; j++) {
     if (srcsize < (signed)sizeof(int32_t)) {
       /* Not enough input to read compressed size */
@@ -1697,11 +2299,19 @@ static int blosc_d(
     }
     else {
       if (compformat == BLOSC_BLOSCLZ_FORMAT) {
-        nbytes = blosclz_decompress(src, cbytes, _dest, (int)neblock);
+        if (context->use_dict) {
+          nbytes = blosclz_decompress_dict(src, cbytes, _dest, (int)neblock,
+                                           context->dict_buffer, context->dict_size);
+        }
+        else {
+          nbytes = blosclz_decompress(src, cbytes, _dest, (int)neblock);
+        }
       }
       else if (compformat == BLOSC_LZ4_FORMAT) {
         nbytes = lz4_wrap_decompress((char*)src, (size_t)cbytes,
-                                     (char*)_dest, (size_t)neblock);
+                                     (char*)_dest, (size_t)neblock,
+                                     context->use_dict ? context->dict_buffer : NULL,
+                                     context->dict_size);
       }
   #if defined(HAVE_ZLIB)
       else if (compformat == BLOSC_ZLIB_FORMAT) {
@@ -1772,6 +2382,8 @@ static int blosc_d(
     _dest += nbytes;
     ntbytes += nbytes;
   } /* Closes j < nstreams */
+  STATS_TIMESTAMP(end);
+  STATS_ADD_TIME(&thread_context->stats, codec_ns, start, end);
 
   if (!instr_codec) {
     if (last_filter_index >= 0 || context->postfilter != NULL) {
@@ -1788,6 +2400,36 @@ static int blosc_d(
 }
 
 
+/* Copy a block of a chunk that is stored without compression */
+static void memcpy_block(struct thread_context* thread_context, uint8_t* dest,
+                         const uint8_t* src, int32_t bsize) {
+  blosc_timestamp_t start, end;
+  STATS_TIMESTAMP(start);
+  memcpy(dest, src, (unsigned int)bsize);
+  STATS_TIMESTAMP(end);
+  STATS_ADD_TIME(&thread_context->stats, memcpy_ns, start, end);
+  STATS_ADD(&thread_context->stats, nblocks, 1);
+}
+
+
+/* Add the counters of a thread to the ones of its context, and reset them */
+static void flush_stats(struct thread_context* thread_context) {
+#if defined(HAVE_STATS)
+  // All the counters are int64_t
+  int64_t* counters = (int64_t*)&thread_context->stats;
+  int64_t* context_counters = (int64_t*)&thread_context->parent_context->stats;
+  for (size_t i = 0; i < sizeof(blosc_stats) / sizeof(int64_t); i++) {
+    if (counters[i] != 0) {
+      BLOSC_ATOMIC_FETCH_ADD64(context_counters + i, counters[i]);
+      counters[i] = 0;
+    }
+  }
+#else
+  (void)thread_context;
+#endif  /* HAVE_STATS */
+}
+
+
 /* Serial version for compression/decompression */
 static int serial_blosc(struct thread_context* thread_context) {
   blosc2_context* context = thread_context->parent_context;
@@ -1817,8 +2459,8 @@ static int serial_blosc(struct thread_context* thread_context) {
     if (context->do_compress) {
       if (memcpyed && !context->prefilter) {
         /* We want to memcpy only */
-        memcpy(context->dest + context->header_overhead + j * context->blocksize,
-               context->src + j * context->blocksize, (unsigned int)bsize);
+        memcpy_block(thread_context, context->dest + context->header_overhead + j * context->blocksize,
+                     context->src + j * context->blocksize, bsize);
         cbytes = (int32_t)bsize;
       }
       else {
@@ -1848,25 +2490,33 @@ static int serial_blosc(struct thread_context* thread_context) {
     }
     ntbytes += cbytes;
   }
+  flush_stats(thread_context);
 
   return ntbytes;
 }
 
 static void t_blosc_do_job(void *ctxt);
 
-/* Threaded version for compression/decompression */
-static int parallel_blosc(blosc2_context* context) {
+/* Run t_blosc_do_job() in every thread and wait for all of them to finish */
+static int run_thread_jobs(blosc2_context* context) {
 #ifdef BLOSC_POSIX_BARRIERS
   int rc;
 #endif
-  /* Set sentinels */
-  context->thread_giveup_code = 1;
-  context->thread_nblock = -1;
+#if defined(HAVE_STATS)
+  blosc_timestamp_t start, end;
+  int64_t busy_ns = context->stats.busy_ns;
+  blosc_set_timestamp(&start);
+#endif  /* HAVE_STATS */
 
   if (threads_callback) {
     threads_callback(threads_callback_data, t_blosc_do_job,
                      context->nthreads, sizeof(struct thread_context), (void*) context->thread_contexts);
   }
+  else if (context->thread_contexts != NULL) {
+    /* The jobs go to the process-wide shared pool */
+    blosc_shared_pool_run(t_blosc_do_job, context->nthreads,
+                          sizeof(struct thread_context), (void*) context->thread_contexts);
+  }
   else {
     /* Synchronization point for all threads (wait for initialization) */
     WAIT_INIT(-1, context);
@@ -1875,11 +2525,107 @@ static int parallel_blosc(blosc2_context* context) {
     WAIT_FINISH(-1, context);
   }
 
+#if defined(HAVE_STATS)
+  /* The threads have been waiting for the others while not busy */
+  blosc_set_timestamp(&end);
+  int64_t wait_ns = context->nthreads * (int64_t)blosc_elapsed_nsecs(start, end) -
+                    (context->stats.busy_ns - busy_ns);
+  if (wait_ns > 0) {
+    context->stats.wait_ns += wait_ns;
+  }
+#endif  /* HAVE_STATS */
+
+  return 0;
+}
+
+/* Make room for a slot per block where threads can compress independently */
+static int prepare_block_slots(blosc2_context* context) {
+  int32_t ebsize = context->blocksize + context->typesize * (signed)sizeof(int32_t);
+  size_t slots_nbytes = (size_t)context->nblocks * ebsize;
+
+  if (slots_nbytes > context->block_slots_nbytes) {
+    blosc_free(context->block_slots);
+    context->block_slots = blosc_malloc(slots_nbytes);
+    BLOSC_ERROR_NULL(context->block_slots, BLOSC2_ERROR_MEMORY_ALLOC);
+    context->block_slots_nbytes = slots_nbytes;
+  }
+  if (context->nblocks + 1 > context->block_offsets_nitems) {
+    blosc_free(context->block_offsets);
+    context->block_offsets = (int32_t*)blosc_malloc((context->nblocks + 1) * sizeof(int32_t));
+    BLOSC_ERROR_NULL(context->block_offsets, BLOSC2_ERROR_MEMORY_ALLOC);
+    context->block_offsets_nitems = context->nblocks + 1;
+  }
+
+  return 0;
+}
+
+/* Copy the compressed blocks in [first, last) from their slots to dest */
+static void compact_blocks(blosc2_context* context, int32_t first, int32_t last) {
+  int32_t ebsize = context->blocksize + context->typesize * (signed)sizeof(int32_t);
+  int32_t* offsets = context->block_offsets;
+  bool dict_training = context->use_dict && context->dict_cdict == NULL;
+
+  for (int32_t nblock = first; nblock < last; nblock++) {
+    if (!dict_training) {
+      _sw32(context->bstarts + nblock, offsets[nblock]);
+    }
+    memcpy(context->dest + offsets[nblock], context->block_slots + (size_t)nblock * ebsize,
+           (unsigned int)(offsets[nblock + 1] - offsets[nblock]));
+  }
+}
+
+/* Threaded version for compression/decompression */
+static int parallel_blosc(blosc2_context* context) {
+  bool memcpyed = context->header_flags & (uint8_t)BLOSC_MEMCPYED;
+  /* Compressed blocks go to their own slot and are compacted at the end */
+  bool use_slots = context->do_compress && !memcpyed;
+  int32_t start_bytes = context->output_bytes;
+
+  if (use_slots) {
+    int rc = prepare_block_slots(context);
+    if (rc < 0) {
+      return rc;
+    }
+  }
+
+  /* Set sentinels */
+  context->thread_giveup_code = 1;
+  context->thread_nblock = -1;
+  context->block_compaction = 0;
+
+  if (run_thread_jobs(context) < 0) {
+    return -1;
+  }
+
   if (context->thread_giveup_code <= 0) {
     /* Compression/decompression gave up.  Return error code. */
     return context->thread_giveup_code;
   }
 
+  if (use_slots) {
+    /* Turn the sizes of the compressed blocks into offsets in dest */
+    int32_t* offsets = context->block_offsets;
+    int32_t ntbytes = start_bytes;
+    for (int32_t nblock = 0; nblock < context->nblocks; nblock++) {
+      int32_t cbytes = offsets[nblock];
+      offsets[nblock] = ntbytes;
+      ntbytes += cbytes;
+    }
+    offsets[context->nblocks] = ntbytes;
+
+    if (ntbytes - start_bytes >= BLOSC_MIN_PARALLEL_COMPACTION) {
+      context->block_compaction = 1;
+      int rc = run_thread_jobs(context);
+      context->block_compaction = 0;
+      if (rc < 0) {
+        return -1;
+      }
+    }
+    else {
+      compact_blocks(context, 0, context->nblocks);
+    }
+  }
+
   /* Return the total bytes (de-)compressed in threads */
   return (int)context->output_bytes;
 }
@@ -1891,10 +2637,11 @@ static int init_thread_context(struct thread_context* thread_context, blosc2_con
 
   thread_context->parent_context = context;
   thread_context->tid = tid;
+  memset(&thread_context->stats, 0, sizeof(blosc_stats));
 
   ebsize = context->blocksize + context->typesize * (signed)sizeof(int32_t);
   thread_context->tmp_nbytes = (size_t)4 * ebsize;
-  thread_context->tmp = my_malloc(thread_context->tmp_nbytes);
+  thread_context->tmp = blosc_malloc(thread_context->tmp_nbytes);
   BLOSC_ERROR_NULL(thread_context->tmp, BLOSC2_ERROR_MEMORY_ALLOC);
   thread_context->tmp2 = thread_context->tmp + ebsize;
   thread_context->tmp3 = thread_context->tmp2 + ebsize;
@@ -1904,6 +2651,8 @@ static int init_thread_context(struct thread_context* thread_context, blosc2_con
   thread_context->zstd_cctx = NULL;
   thread_context->zstd_dctx = NULL;
   #endif
+  thread_context->lz4_stream = NULL;
+  thread_context->lz4hc_stream = NULL;
 
   /* Create the hash table for LZ4 in case we are using IPP */
 #ifdef HAVE_IPP
@@ -1927,7 +2676,7 @@ static int init_thread_context(struct thread_context* thread_context, blosc2_con
 static struct thread_context*
 create_thread_context(blosc2_context* context, int32_t tid) {
   struct thread_context* thread_context;
-  thread_context = (struct thread_context*)my_malloc(sizeof(struct thread_context));
+  thread_context = (struct thread_context*)blosc_malloc(sizeof(struct thread_context));
   BLOSC_ERROR_NULL(thread_context, NULL);
   int rc = init_thread_context(thread_context, context, tid);
   if (rc < 0) {
@@ -1938,7 +2687,7 @@ create_thread_context(blosc2_context* context, int32_t tid) {
 
 /* free members of thread_context, but not thread_context itself */
 static void destroy_thread_context(struct thread_context* thread_context) {
-  my_free(thread_context->tmp);
+  blosc_free(thread_context->tmp);
 #if defined(HAVE_ZSTD)
   if (thread_context->zstd_cctx != NULL) {
     ZSTD_freeCCtx(thread_context->zstd_cctx);
@@ -1952,11 +2701,17 @@ static void destroy_thread_context(struct thread_context* thread_context) {
     ippsFree(thread_context->lz4_hash_table);
   }
 #endif
+  if (thread_context->lz4_stream != NULL) {
+    LZ4_freeStream(thread_context->lz4_stream);
+  }
+  if (thread_context->lz4hc_stream != NULL) {
+    LZ4_freeStreamHC(thread_context->lz4hc_stream);
+  }
 }
 
 void free_thread_context(struct thread_context* thread_context) {
   destroy_thread_context(thread_context);
-  my_free(thread_context);
+  blosc_free(thread_context);
 }
 
 
@@ -2012,6 +2767,116 @@ static int do_job(blosc2_context* context) {
 }
 
 
+/* Number and size of the blocks sampled for choosing the filters of a chunk */
+#define BLOSC_AUTO_FILTER_NSAMPLES 4
+#define BLOSC_AUTO_FILTER_SAMPLESIZE (16 * 1024)
+/* The fraction of bytes that a filter chain has to save for being preferred
+   over a cheaper one */
+#define BLOSC_AUTO_FILTER_MIN_GAIN 0.03
+
+/* The filter chains that BLOSC_AUTO_FILTER chooses from, the cheapest first */
+static const uint8_t auto_filter_chains[][2] = {
+    {BLOSC_NOFILTER, BLOSC_NOFILTER},
+    {BLOSC_NOFILTER, BLOSC_SHUFFLE},
+    {BLOSC_NOFILTER, BLOSC_BITSHUFFLE},
+    {BLOSC_DELTA, BLOSC_SHUFFLE},
+};
+
+/* Replace the BLOSC_AUTO_FILTER in the pipeline of context with the filter
+   chain that compresses a few samples of its source the best.  The chain
+   takes the slot of the BLOSC_AUTO_FILTER, plus the previous one for the
+   delta filter (if free). */
+static int choose_filters(blosc2_context* context) {
+  uint8_t* filters = context->filters;
+  int slot = -1;
+  for (int i = 0; i < BLOSC2_MAX_FILTERS; i++) {
+    if (filters[i] == BLOSC_AUTO_FILTER) {
+      slot = i;
+    }
+  }
+  if (slot < 0) {
+    return 0;
+  }
+  bool delta_slot = slot > 0 && filters[slot - 1] == BLOSC_NOFILTER;
+
+  int32_t typesize = context->typesize > BLOSC_MAX_TYPESIZE ? 1 : context->typesize;
+  int32_t nbytes = context->sourcesize;
+  int32_t samplesize = BLOSC_AUTO_FILTER_SAMPLESIZE / typesize * typesize;
+  int32_t nsamples = BLOSC_AUTO_FILTER_NSAMPLES;
+  if (nbytes < nsamples * samplesize) {
+    nsamples = nbytes / samplesize > 0 ? nbytes / samplesize : 1;
+    samplesize = nbytes / nsamples / typesize * typesize;
+  }
+  // Sources that cannot be sampled (or that a prefilter makes up) get the default shuffle
+  filters[slot] = BLOSC_SHUFFLE;
+  if (context->src == NULL || context->prefilter != NULL || samplesize < BLOSC_MIN_BUFFERSIZE) {
+    return 0;
+  }
+
+  if (context->auto_cctx == NULL) {
+    blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+    cparams.compcode = BLOSC_LZ4;
+    cparams.clevel = 1;
+    cparams.nthreads = 1;
+    context->auto_cctx = blosc2_create_cctx(cparams);
+    BLOSC_ERROR_NULL(context->auto_cctx, BLOSC2_ERROR_MEMORY_ALLOC);
+  }
+  blosc2_context* cctx = context->auto_cctx;
+  int32_t size = nsamples * samplesize;
+  int32_t csize = size + BLOSC_MAX_OVERHEAD;
+  uint8_t* samples = blosc_pool_malloc(size);
+  uint8_t* cbuffer = blosc_pool_malloc(csize);
+  if (samples == NULL || cbuffer == NULL) {
+    blosc_pool_free(samples);
+    blosc_pool_free(cbuffer);
+    return BLOSC2_ERROR_MEMORY_ALLOC;
+  }
+  // Samples evenly spread over the source, the first one at its start (the reference of delta)
+  for (int32_t i = 0; i < nsamples; i++) {
+    int64_t start = nsamples > 1 ? (int64_t)(nbytes - samplesize) * i / (nsamples - 1) : 0;
+    start = start / typesize * typesize;
+    memcpy(samples + i * samplesize, context->src + start, samplesize);
+  }
+
+  int best = 0;
+  double best_cbytes = (double)INT32_MAX;
+  int rc = 0;
+  for (int c = 0; c < (int)(sizeof(auto_filter_chains) / sizeof(auto_filter_chains[0])); c++) {
+    if (auto_filter_chains[c][0] != BLOSC_NOFILTER && !delta_slot) {
+      continue;
+    }
+    memcpy(cctx->filters, filters, BLOSC2_MAX_FILTERS);
+    memcpy(cctx->filters_meta, context->filters_meta, BLOSC2_MAX_FILTERS);
+    cctx->filters[slot] = auto_filter_chains[c][1];
+    if (delta_slot) {
+      cctx->filters[slot - 1] = auto_filter_chains[c][0];
+    }
+    cctx->typesize = typesize;
+    cctx->blocksize = samplesize;
+    rc = blosc2_compress_ctx(cctx, samples, size, cbuffer, csize);
+    if (rc < 0) {
+      break;
+    }
+    if (rc < best_cbytes * (1 - BLOSC_AUTO_FILTER_MIN_GAIN)) {
+      best = c;
+      best_cbytes = rc;
+    }
+  }
+  blosc_pool_free(samples);
+  blosc_pool_free(cbuffer);
+  if (rc < 0) {
+    BLOSC_TRACE_ERROR("Cannot compress the samples for choosing the filters.");
+    return rc;
+  }
+
+  filters[slot] = auto_filter_chains[best][1];
+  if (delta_slot) {
+    filters[slot - 1] = auto_filter_chains[best][0];
+  }
+  return 0;
+}
+
+
 static int initialize_context_compression(
     blosc2_context* context, const void* src, int32_t srcsize, void* dest,
     int32_t destsize, int clevel, uint8_t const *filters,
@@ -2021,6 +2886,12 @@ static int initialize_context_compression(
     blosc2_btune *udbtune, void *btune_config,
     blosc2_schunk* schunk) {
 
+  /* The filters of a pipeline with BLOSC_AUTO_FILTER are chosen for every chunk
+     again, so the ones chosen for the previous chunk are not to be reused */
+  if (context->auto_filter && filters == context->filters) {
+    filters = context->auto_filters;
+  }
+
   /* Set parameters */
   context->do_compress = 1;
   context->src = (const uint8_t*)src;
@@ -2044,6 +2915,11 @@ static int initialize_context_compression(
   context->btune = btune_config;
   context->udbtune = udbtune;
   context->splitmode = splitmode;
+  int rc = choose_filters(context);
+  if (rc < 0) {
+    return rc;
+  }
+  context->filter_flags = filters_to_flags(context->filters);
   /* Tune some compression parameters */
   context->blocksize = (int32_t)blocksize;
   if (context->btune != NULL) {
@@ -2094,6 +2970,316 @@ static int initialize_context_compression(
 }
 
 
+/* Whether `compcode` can compress with dictionaries */
+static bool dict_codec(int compcode) {
+  switch (compcode) {
+    case BLOSC_BLOSCLZ:
+    case BLOSC_LZ4:
+    case BLOSC_LZ4HC:
+#if defined(HAVE_ZSTD)
+    case BLOSC_ZSTD:
+#endif
+      return true;
+    default:
+      return false;
+  }
+}
+
+
+/* Digest `dict` for compressing with the codec of `context`.  `dict` is not copied, so it
+ * has to outlive the digested form. */
+static int create_cdict(blosc2_context* context, const void* dict, int32_t dict_size) {
+  if (!dict_codec(context->compcode)) {
+    BLOSC_TRACE_ERROR("Codec %s does not support dicts.  Giving up.",
+                      clibcode_to_clibname(context->compcode));
+    return BLOSC2_ERROR_CODEC_DICT;
+  }
+  void* cdict = NULL;
+  switch (context->compcode) {
+    case BLOSC_BLOSCLZ:
+      // BloscLZ just uses the dictionary as a prefix
+      cdict = (void*)dict;
+      break;
+    case BLOSC_LZ4:
+      cdict = LZ4_createStream();
+      BLOSC_ERROR_NULL(cdict, BLOSC2_ERROR_MEMORY_ALLOC);
+      LZ4_loadDict(cdict, dict, dict_size);
+      break;
+    case BLOSC_LZ4HC:
+      cdict = LZ4_createStreamHC();
+      BLOSC_ERROR_NULL(cdict, BLOSC2_ERROR_MEMORY_ALLOC);
+      LZ4_resetStreamHC_fast(cdict, context->clevel);
+      LZ4_loadDictHC(cdict, dict, dict_size);
+      break;
+#if defined(HAVE_ZSTD)
+    case BLOSC_ZSTD:
+      cdict = ZSTD_createCDict(dict, dict_size, zstd_clevel(context->clevel));
+      BLOSC_ERROR_NULL(cdict, BLOSC2_ERROR_CODEC_DICT);
+      break;
+#endif
+    default:
+      break;
+  }
+  context->dict_cdict = cdict;
+  context->dict_compcode = context->compcode;
+  return 0;
+}
+
+
+static void free_cdict(blosc2_context* context) {
+  if (context->dict_cdict == NULL) {
+    return;
+  }
+  switch (context->dict_compcode) {
+    case BLOSC_LZ4:
+      LZ4_freeStream(context->dict_cdict);
+      break;
+    case BLOSC_LZ4HC:
+      LZ4_freeStreamHC(context->dict_cdict);
+      break;
+#if defined(HAVE_ZSTD)
+    case BLOSC_ZSTD:
+      ZSTD_freeCDict(context->dict_cdict);
+      break;
+#endif
+    default:
+      break;
+  }
+  context->dict_cdict = NULL;
+}
+
+
+/* Forget the dictionary of the context */
+static void free_dict(blosc2_context* context) {
+  free_cdict(context);
+  if (context->dict_borrowed) {
+    // The dictionary (and its digested form) belongs to the super-chunk
+    context->dict_buffer = NULL;
+    context->dict_ddict = NULL;
+    context->dict_borrowed = false;
+  }
+#if defined(HAVE_ZSTD)
+  if (context->dict_ddict != NULL) {
+    ZSTD_freeDDict(context->dict_ddict);
+    context->dict_ddict = NULL;
+  }
+#endif
+  if (context->dict_id > 0) {
+    // Shared dictionaries are owned by the context
+    free(context->dict_buffer);
+  }
+  context->dict_buffer = NULL;
+  context->dict_size = 0;
+  context->dict_id = 0;
+}
+
+
+/* A (31-bit, non-zero) id for a dictionary */
+static int32_t get_dict_id(const void* dict, int32_t dict_size) {
+  uint32_t dict_id = 0;
+#if defined(HAVE_ZSTD)
+  dict_id = ZDICT_getDictID(dict, dict_size);
+#endif
+  if (dict_id == 0) {
+    // Not a ZSTD dictionary: use a FNV-1a hash of its contents
+    const uint8_t* dict_ = dict;
+    dict_id = 2166136261U;
+    for (int32_t i = 0; i < dict_size; i++) {
+      dict_id = (dict_id ^ dict_[i]) * 16777619U;
+    }
+  }
+  // The id goes in the chunks as a negative dictionary size, so it cannot use the sign bit
+  dict_id &= 0x7FFFFFFFU;
+  return dict_id == 0 ? 1 : (int32_t)dict_id;
+}
+
+
+int set_shared_dict(blosc2_context* context, const void* dict, int32_t dict_size) {
+  if (dict_size <= 0 || dict_size > BLOSC2_MAXDICTSIZE) {
+    BLOSC_TRACE_ERROR("Dictionary size is smaller than minimum or larger than maximum allowed.");
+    return BLOSC2_ERROR_CODEC_DICT;
+  }
+  if (context->do_compress && !dict_codec(context->compcode)) {
+    BLOSC_TRACE_ERROR("Codec %s does not support dicts.  Giving up.",
+                      clibcode_to_clibname(context->compcode));
+    return BLOSC2_ERROR_CODEC_DICT;
+  }
+
+  free_dict(context);
+  void* dict_buffer = malloc(dict_size);
+  BLOSC_ERROR_NULL(dict_buffer, BLOSC2_ERROR_MEMORY_ALLOC);
+  memcpy(dict_buffer, dict, dict_size);
+  context->dict_buffer = dict_buffer;
+  context->dict_size = dict_size;
+  context->dict_id = get_dict_id(dict, dict_size);
+
+  if (context->do_compress) {
+    int rc = create_cdict(context, dict_buffer, dict_size);
+    if (rc < 0) {
+      free_dict(context);
+      return rc;
+    }
+    context->use_dict = 1;
+  }
+  // For decompressing, ZSTD dictionaries are digested on demand (see read_chunk_dict)
+
+  return context->dict_id;
+}
+
+
+/* Read the dictionary shared by the chunks of `schunk` (to be freed by the caller).
+ * Returns 0 if the super-chunk does not have one, and 1 if it does. */
+static int read_shared_dict(blosc2_schunk* schunk, uint8_t** dict, int32_t* dict_size) {
+  if (blosc2_vlmeta_exists(schunk, BLOSC2_SHARED_DICT_NAME) < 0) {
+    return 0;
+  }
+  int rc = blosc2_vlmeta_get(schunk, BLOSC2_SHARED_DICT_NAME, dict, dict_size);
+  if (rc < 0) {
+    BLOSC_TRACE_ERROR("Cannot get the shared dictionary of the super-chunk.");
+    return rc;
+  }
+  if (*dict_size <= 0 || *dict_size > BLOSC2_MAXDICTSIZE) {
+    BLOSC_TRACE_ERROR("The shared dictionary of the super-chunk has a wrong size (%d).", *dict_size);
+    free(*dict);
+    return BLOSC2_ERROR_CODEC_DICT;
+  }
+  return 1;
+}
+
+
+/* Digest the dictionary shared by the chunks of the super-chunk of `context`.
+ * Returns 0 if the super-chunk does not have one. */
+static int load_shared_dict(blosc2_context* context) {
+  if (context->schunk == NULL) {
+    return 0;
+  }
+  uint8_t* dict;
+  int32_t dict_size;
+  int rc = read_shared_dict(context->schunk, &dict, &dict_size);
+  if (rc <= 0) {
+    return rc;
+  }
+  rc = set_shared_dict(context, dict, dict_size);
+  free(dict);
+  return rc;
+}
+
+
+void free_shared_dict(blosc2_shared_dict* dict) {
+#if defined(HAVE_ZSTD)
+  if (dict->ddict != NULL) {
+    ZSTD_freeDDict(dict->ddict);
+  }
+#endif
+  free(dict->buffer);
+  memset(dict, 0, sizeof(blosc2_shared_dict));
+}
+
+
+/* Decompress with the dictionary shared by the chunks of the super-chunk of `context`,
+ * as kept by its pool of decompression contexts, so that it is read (and digested for
+ * `zstd`) just once for all of them.  Returns 0 if the super-chunk does not have one. */
+static int borrow_shared_dict(blosc2_context* context, bool zstd) {
+  if (context->schunk == NULL || context->schunk->dctx_pool == NULL) {
+    return load_shared_dict(context);
+  }
+  blosc2_dctx_pool* pool = context->schunk->dctx_pool;
+  blosc2_shared_dict* shared = dctx_pool_lock_dict(pool);
+  int rc;
+  if (shared->buffer == NULL) {
+    uint8_t* dict;
+    int32_t dict_size;
+    rc = read_shared_dict(context->schunk, &dict, &dict_size);
+    if (rc <= 0) {
+      goto end;
+    }
+    shared->buffer = dict;
+    shared->size = dict_size;
+    shared->id = get_dict_id(dict, dict_size);
+  }
+#if defined(HAVE_ZSTD)
+  if (zstd && shared->ddict == NULL) {
+    shared->ddict = ZSTD_createDDict(shared->buffer, shared->size);
+    if (shared->ddict == NULL) {
+      BLOSC_TRACE_ERROR("Cannot digest the shared dictionary of the super-chunk.");
+      rc = BLOSC2_ERROR_CODEC_DICT;
+      goto end;
+    }
+  }
+#endif   // HAVE_ZSTD
+
+  free_dict(context);
+  context->dict_buffer = shared->buffer;
+  context->dict_size = shared->size;
+  context->dict_id = shared->id;
+  context->dict_ddict = shared->ddict;
+  context->dict_borrowed = true;
+  rc = shared->id;
+
+  end:
+  dctx_pool_unlock_dict(pool);
+  return rc;
+}
+
+
+/* Read the dictionary section of a chunk (of `srcsize` bytes from `dict_offset` on).
+ * Returns the size of the section. */
+static int read_chunk_dict(blosc2_context* context, int32_t dict_offset, int32_t srcsize) {
+  context->use_dict = 1;
+  // The trained dictionary is after the bstarts block
+  if (srcsize < (signed)sizeof(int32_t)) {
+    BLOSC_TRACE_ERROR("Not enough space to read size of dictionary.");
+    return BLOSC2_ERROR_READ_BUFFER;
+  }
+  srcsize -= sizeof(int32_t);
+  // Read dictionary size
+  int32_t dict_size = sw32_(context->src + dict_offset);
+  if (dict_size < 0) {
+    // A reference to the dictionary shared by the chunks of the super-chunk
+    // The other codecs just use the dictionary as it is
+    bool zstd = context->compcode == BLOSC_ZSTD_FORMAT;
+    if (context->dict_id != -dict_size || (zstd && context->dict_ddict == NULL)) {
+      int rc = borrow_shared_dict(context, zstd);
+      if (rc < 0) {
+        return rc;
+      }
+      if (rc == 0 || context->dict_id != -dict_size) {
+        BLOSC_TRACE_ERROR("Cannot find the shared dictionary %d of the chunk.", -dict_size);
+        return BLOSC2_ERROR_CODEC_DICT;
+      }
+    }
+#if defined(HAVE_ZSTD)
+    if (zstd && context->dict_ddict == NULL) {
+      // Not borrowed from the super-chunk
+      context->dict_ddict = ZSTD_createDDict(context->dict_buffer, context->dict_size);
+      BLOSC_ERROR_NULL(context->dict_ddict, BLOSC2_ERROR_CODEC_DICT);
+    }
+#endif   // HAVE_ZSTD
+    return sizeof(int32_t);
+  }
+
+  // Free the existing dictionary (probably from another chunk)
+  free_dict(context);
+  if (dict_size <= 0 || dict_size > BLOSC2_MAXDICTSIZE) {
+    BLOSC_TRACE_ERROR("Dictionary size is smaller than minimum or larger than maximum allowed.");
+    return BLOSC2_ERROR_CODEC_DICT;
+  }
+  if (srcsize < dict_size) {
+    BLOSC_TRACE_ERROR("Not enough space to read entire dictionary.");
+    return BLOSC2_ERROR_READ_BUFFER;
+  }
+  // Read dictionary
+  context->dict_size = dict_size;
+  context->dict_buffer = (void*)(context->src + dict_offset + sizeof(int32_t));
+#if defined(HAVE_ZSTD)
+  if (context->compcode == BLOSC_ZSTD_FORMAT) {
+    context->dict_ddict = ZSTD_createDDict(context->dict_buffer, context->dict_size);
+  }
+#endif   // HAVE_ZSTD
+  return (int)sizeof(int32_t) + context->dict_size;
+}
+
+
 static int initialize_context_decompression(blosc2_context* context, blosc_header* header, const void* src,
                                             int32_t srcsize, void* dest, int32_t destsize) {
   int32_t bstarts_end;
@@ -2155,35 +3341,13 @@ static int initialize_context_decompression(blosc2_context* context, blosc_heade
   }
   srcsize -= bstarts_end;
 
-  /* Read optional dictionary if flag set */
-  if (context->blosc2_flags & BLOSC2_USEDICT) {
-#if defined(HAVE_ZSTD)
-    context->use_dict = 1;
-    if (context->dict_ddict != NULL) {
-      // Free the existing dictionary (probably from another chunk)
-      ZSTD_freeDDict(context->dict_ddict);
-    }
-    // The trained dictionary is after the bstarts block
-    if (srcsize < (signed)sizeof(int32_t)) {
-      BLOSC_TRACE_ERROR("Not enough space to read size of dictionary.");
-      return BLOSC2_ERROR_READ_BUFFER;
-    }
-    srcsize -= sizeof(int32_t);
-    // Read dictionary size
-    context->dict_size = (size_t)sw32_(context->src + bstarts_end);
-    if (context->dict_size <= 0 || context->dict_size > BLOSC2_MAXDICTSIZE) {
-      BLOSC_TRACE_ERROR("Dictionary size is smaller than minimum or larger than maximum allowed.");
-      return BLOSC2_ERROR_CODEC_DICT;
+  /* Read optional dictionary if flag set (memcpyed chunks do not use it) */
+  context->use_dict = 0;
+  if ((context->blosc2_flags & BLOSC2_USEDICT) && !memcpyed && !context->special_type) {
+    rc = read_chunk_dict(context, bstarts_end, srcsize);
+    if (rc < 0) {
+      return rc;
     }
-    if (srcsize < (int32_t)context->dict_size) {
-      BLOSC_TRACE_ERROR("Not enough space to read entire dictionary.");
-      return BLOSC2_ERROR_READ_BUFFER;
-    }
-    srcsize -= context->dict_size;
-    // Read dictionary
-    context->dict_buffer = (void*)(context->src + bstarts_end + sizeof(int32_t));
-    context->dict_ddict = ZSTD_createDDict(context->dict_buffer, context->dict_size);
-#endif   // HAVE_ZSTD
   }
 
   return 0;
@@ -2217,6 +3381,10 @@ static int write_compression_header(blosc2_context* context, bool extended_heade
     } else {
       context->bstarts = (int32_t*)(context->dest + context->header_overhead);
       context->output_bytes = context->header_overhead + sizeof(int32_t) * context->nblocks;
+      if (context->dict_id > 0) {
+        // Room for the reference to the shared dictionary (written after compressing)
+        context->output_bytes += sizeof(int32_t);
+      }
     }
   } else {
     // Regular header
@@ -2267,13 +3435,30 @@ static int write_compression_header(blosc2_context* context, bool extended_heade
 }
 
 
-int blosc_compress_context(blosc2_context* context) {
+static int compress_context(blosc2_context* context) {
   int ntbytes = 0;
   blosc_timestamp_t last, current;
   bool memcpyed = context->header_flags & (uint8_t)BLOSC_MEMCPYED;
+  bool shared_dict = context->dict_id > 0 && context->header_overhead == BLOSC_EXTENDED_HEADER_LENGTH;
 
   blosc_set_timestamp(&last);
 
+  if (!memcpyed) {
+    /* Chunks made of a repeated value do not need compressing */
+    ntbytes = compress_special_run(context);
+    if (ntbytes > 0) {
+      _sw32(context->dest + BLOSC2_CHUNK_CBYTES, ntbytes);
+      return ntbytes;
+    }
+    /* Incompressible chunks are just copied */
+    if (context->prefilter == NULL && !(context->blosc2_flags & BLOSC2_INSTR_CODEC) &&
+        probe_incompressible(context->src, context->sourcesize, context->probe_entropy)) {
+      context->probe_nchunks++;
+      context->header_flags |= (uint8_t)BLOSC_MEMCPYED;
+      memcpyed = true;
+    }
+  }
+
   if (!memcpyed) {
     /* Do the actual compression */
     ntbytes = do_job(context);
@@ -2285,11 +3470,15 @@ int blosc_compress_context(blosc2_context* context) {
       context->header_flags |= (uint8_t)BLOSC_MEMCPYED;
       memcpyed = true;
     }
+    else if (shared_dict) {
+      /* The reference to the dictionary shared by the chunks goes after the bstarts */
+      _sw32(context->dest + context->header_overhead + 4 * context->nblocks, -context->dict_id);
+    }
   }
 
   int dont_split = (context->header_flags & 0x10) >> 4;
   int nstreams = context->nblocks;
-  if (!dont_split) {
+  if (!dont_split && !context->use_dict) {
     // When splitting, the number of streams is computed differently
     if (context->leftover) {
       nstreams = (context->nblocks - 1) * context->typesize + 1;
@@ -2319,6 +3508,9 @@ int blosc_compress_context(blosc2_context* context) {
   else {
     // Check whether we have a run for the whole chunk
     int start_csizes = context->header_overhead + 4 * context->nblocks;
+    if (shared_dict) {
+      start_csizes += sizeof(int32_t);
+    }
     if (ntbytes == start_csizes + nstreams * sizeof(int32_t)) {
       // The streams are all zero runs (by construction).  Encode it...
       context->dest[BLOSC2_CHUNK_BLOSC2_FLAGS] |= BLOSC2_SPECIAL_ZERO << 4;
@@ -2349,6 +3541,83 @@ int blosc_compress_context(blosc2_context* context) {
 }
 
 
+int blosc_compress_context(blosc2_context* context) {
+  int ntbytes = compress_context(context);
+  if (ntbytes > 0) {
+    STATS_ADD(&context->stats, nchunks, 1);
+    STATS_ADD(&context->stats, nbytes, context->sourcesize);
+    STATS_ADD(&context->stats, cbytes, ntbytes);
+    if (context->dest[BLOSC2_CHUNK_FLAGS] & (uint8_t)BLOSC_MEMCPYED) {
+      STATS_ADD(&context->stats, nmemcpyed, 1);
+    }
+  }
+  return ntbytes;
+}
+
+
+/* Build a dictionary of (at most) `dict_maxsize` bytes out of `nsamples` equally sized
+ * samples in `samples`.  Returns the size of the dictionary. */
+static int32_t build_dict(blosc2_context* context, const uint8_t* samples, int64_t nbytes,
+                          unsigned nsamples, void* dict_buffer, int32_t dict_maxsize) {
+  if (!dict_codec(context->compcode)) {
+    BLOSC_TRACE_ERROR("Codec %s does not support dicts.  Giving up.",
+                      clibcode_to_clibname(context->compcode));
+    return BLOSC2_ERROR_CODEC_DICT;
+  }
+  size_t sample_size = (size_t)(nbytes / nsamples);
+
+#if defined(HAVE_ZSTD)
+  if (context->compcode == BLOSC_ZSTD) {
+    // Populate the samples sizes for training the dictionary
+    size_t* samples_sizes = malloc(nsamples * sizeof(size_t));
+    BLOSC_ERROR_NULL(samples_sizes, BLOSC2_ERROR_MEMORY_ALLOC);
+    for (unsigned i = 0; i < nsamples; i++) {
+      samples_sizes[i] = sample_size;
+    }
+    size_t dict_actual_size = ZDICT_trainFromBuffer(dict_buffer, dict_maxsize, samples,
+                                                    samples_sizes, nsamples);
+
+    // TODO: experiment with parameters of low-level fast cover algorithm
+    // Note that this API is still unstable.  See: https://github.com/facebook/zstd/issues/1599
+    // ZDICT_fastCover_params_t fast_cover_params;
+    // memset(&fast_cover_params, 0, sizeof(fast_cover_params));
+    // fast_cover_params.d = nblocks;
+    // fast_cover_params.steps = 4;
+    // fast_cover_params.zParams.compressionLevel = context->clevel;
+    //size_t dict_actual_size = ZDICT_optimizeTrainFromBuffer_fastCover(dict_buffer, dict_maxsize, samples_buffer, samples_sizes, nblocks, &fast_cover_params);
+
+    free(samples_sizes);
+    if (ZDICT_isError(dict_actual_size)) {
+      BLOSC_TRACE_ERROR("Error in ZDICT_trainFromBuffer(): '%s'."
+                        "  Giving up.", ZDICT_getErrorName(dict_actual_size));
+      return BLOSC2_ERROR_CODEC_DICT;
+    }
+    assert(dict_actual_size > 0);
+    return (int32_t)dict_actual_size;
+  }
+#endif  // HAVE_ZSTD
+
+  // LZ4 and BloscLZ just look for matches in the dictionary content, and these cannot be
+  // farther than 64 KB away.  So make a raw dictionary with a piece of every sample.
+  if (dict_maxsize > 64 * 1024) {
+    dict_maxsize = 64 * 1024;
+  }
+  size_t piece_size = (size_t)dict_maxsize / nsamples;
+  if (piece_size > sample_size) {
+    piece_size = sample_size;
+  }
+  if (piece_size == 0) {
+    BLOSC_TRACE_ERROR("Samples are too small for building a dictionary.");
+    return BLOSC2_ERROR_CODEC_DICT;
+  }
+  uint8_t* dict = dict_buffer;
+  for (unsigned i = 0; i < nsamples; i++) {
+    memcpy(dict + i * piece_size, samples + i * sample_size, piece_size);
+  }
+  return (int32_t)(nsamples * piece_size);
+}
+
+
 /* The public secure routine for compression with context. */
 int blosc2_compress_ctx(blosc2_context* context, const void* src, int32_t srcsize,
                         void* dest, int32_t destsize) {
@@ -2359,6 +3628,14 @@ int blosc2_compress_ctx(blosc2_context* context, const void* src, int32_t srcsiz
     return BLOSC2_ERROR_INVALID_PARAM;
   }
 
+  if (context->use_dict && context->dict_cdict == NULL) {
+    // Use the dictionary shared by the chunks of the super-chunk (if any) instead of training one
+    error = load_shared_dict(context);
+    if (error < 0) {
+      return error;
+    }
+  }
+
   error = initialize_context_compression(
     context, src, srcsize, dest, destsize,
     context->clevel, context->filters, context->filters_meta,
@@ -2380,17 +3657,9 @@ int blosc2_compress_ctx(blosc2_context* context, const void* src, int32_t srcsiz
     return cbytes;
   }
 
-  if (context->use_dict && context->dict_cdict == NULL) {
-
-    if (context->compcode != BLOSC_ZSTD) {
-      const char* compname;
-      compname = clibcode_to_clibname(context->compcode);
-      BLOSC_TRACE_ERROR("Codec %s does not support dicts.  Giving up.",
-                        compname);
-      return BLOSC2_ERROR_CODEC_DICT;
-    }
-
-#ifdef HAVE_ZSTD
+  // Special chunks (runs of a value) have no blocks to train a dictionary from
+  bool special_chunk = ((context->dest[BLOSC2_CHUNK_BLOSC2_FLAGS] >> 4) & BLOSC2_SPECIAL_MASK) != 0;
+  if (context->use_dict && context->dict_cdict == NULL && !special_chunk) {
     // Build the dictionary out of the filters outcome and compress with it
     int32_t dict_maxsize = BLOSC2_MAXDICTSIZE;
     // Do not make the dict more than 5% larger than uncompressed buffer
@@ -2399,37 +3668,14 @@ int blosc2_compress_ctx(blosc2_context* context, const void* src, int32_t srcsiz
     }
     void* samples_buffer = context->dest + context->header_overhead;
     unsigned nblocks = 8;  // the minimum that accepts zstd as of 1.4.0
-    unsigned sample_fraction = 1;  // 1 allows to use most of the chunk for training
-    size_t sample_size = context->sourcesize / nblocks / sample_fraction;
-
-    // Populate the samples sizes for training the dictionary
-    size_t* samples_sizes = malloc(nblocks * sizeof(void*));
-    BLOSC_ERROR_NULL(samples_sizes, BLOSC2_ERROR_MEMORY_ALLOC);
-    for (size_t i = 0; i < nblocks; i++) {
-      samples_sizes[i] = sample_size;
-    }
-
-    // Train from samples
     void* dict_buffer = malloc(dict_maxsize);
     BLOSC_ERROR_NULL(dict_buffer, BLOSC2_ERROR_MEMORY_ALLOC);
-    int32_t dict_actual_size = (int32_t)ZDICT_trainFromBuffer(dict_buffer, dict_maxsize, samples_buffer, samples_sizes, nblocks);
-
-    // TODO: experiment with parameters of low-level fast cover algorithm
-    // Note that this API is still unstable.  See: https://github.com/facebook/zstd/issues/1599
-    // ZDICT_fastCover_params_t fast_cover_params;
-    // memset(&fast_cover_params, 0, sizeof(fast_cover_params));
-    // fast_cover_params.d = nblocks;
-    // fast_cover_params.steps = 4;
-    // fast_cover_params.zParams.compressionLevel = context->clevel;
-    //size_t dict_actual_size = ZDICT_optimizeTrainFromBuffer_fastCover(dict_buffer, dict_maxsize, samples_buffer, samples_sizes, nblocks, &fast_cover_params);
-
-    if (ZDICT_isError(dict_actual_size) != ZSTD_error_no_error) {
-      BLOSC_TRACE_ERROR("Error in ZDICT_trainFromBuffer(): '%s'."
-                        "  Giving up.", ZDICT_getErrorName(dict_actual_size));
-      return BLOSC2_ERROR_CODEC_DICT;
+    int32_t dict_actual_size = build_dict(context, samples_buffer, context->sourcesize, nblocks,
+                                          dict_buffer, dict_maxsize);
+    if (dict_actual_size < 0) {
+      free(dict_buffer);
+      return dict_actual_size;
     }
-    assert(dict_actual_size > 0);
-    free(samples_sizes);
 
     // Update bytes counter and pointers to bstarts for the new compressed buffer
     context->bstarts = (int32_t*)(context->dest + context->header_overhead);
@@ -2440,25 +3686,135 @@ int blosc2_compress_ctx(blosc2_context* context, const void* src, int32_t srcsiz
     /* Write the trained dict afterwards */
     context->dict_buffer = context->dest + context->output_bytes;
     memcpy(context->dict_buffer, dict_buffer, (unsigned int)dict_actual_size);
-    context->dict_cdict = ZSTD_createCDict(dict_buffer, dict_actual_size, 1);  // TODO: use get_accel()
     free(dict_buffer);      // the dictionary is copied in the header now
     context->output_bytes += (int32_t)dict_actual_size;
     context->dict_size = dict_actual_size;
+    error = create_cdict(context, context->dict_buffer, dict_actual_size);
+    if (error < 0) {
+      context->dict_buffer = NULL;
+      return error;
+    }
 
     /* Compress with dict */
     cbytes = blosc_compress_context(context);
 
     // Invalidate the dictionary for compressing other chunks using the same context
+    free_cdict(context);
     context->dict_buffer = NULL;
-    ZSTD_freeCDict(context->dict_cdict);
-    context->dict_cdict = NULL;
-#endif  // HAVE_ZSTD
   }
 
   return cbytes;
 }
 
 
+int train_shared_dict(blosc2_context* context, const void* samples, int64_t nbytes,
+                      int32_t chunksize, void** dict, int32_t* dict_size) {
+  if (context->do_compress != 1) {
+    BLOSC_TRACE_ERROR("Context is not meant for compression.  Giving up.");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  if (!dict_codec(context->compcode)) {
+    BLOSC_TRACE_ERROR("Codec %s does not support dicts.  Giving up.",
+                      clibcode_to_clibname(context->compcode));
+    return BLOSC2_ERROR_CODEC_DICT;
+  }
+  if (chunksize <= 0 || chunksize > nbytes) {
+    chunksize = nbytes > BLOSC_MAX_BUFFERSIZE ? BLOSC_MAX_BUFFERSIZE : (int32_t)nbytes;
+  }
+  // Do not make the dict more than 5% larger than the samples
+  int32_t dict_maxsize = BLOSC2_MAXDICTSIZE;
+  if (dict_maxsize > nbytes / 20) {
+    dict_maxsize = (int32_t)(nbytes / 20);
+  }
+  if (dict_maxsize < 256) {
+    BLOSC_TRACE_ERROR("Not enough samples (%d bytes) for training a dictionary.", (int)nbytes);
+    return BLOSC2_ERROR_CODEC_DICT;
+  }
+
+  uint8_t* filtered = malloc((size_t)nbytes);
+  BLOSC_ERROR_NULL(filtered, BLOSC2_ERROR_MEMORY_ALLOC);
+  int32_t cbuffer_size = chunksize + BLOSC_EXTENDED_HEADER_LENGTH;
+  uint8_t* cbuffer = malloc(cbuffer_size);
+  if (cbuffer == NULL) {
+    free(filtered);
+    BLOSC_TRACE_ERROR("Error allocating memory!");
+    return BLOSC2_ERROR_MEMORY_ALLOC;
+  }
+
+  // A dictionary training pass just stores the outcome of the filters, as the compression does
+  void* cdict = context->dict_cdict;
+  int use_dict = context->use_dict;
+  int32_t dict_id = context->dict_id;
+  context->dict_cdict = NULL;
+  context->use_dict = 1;
+  context->dict_id = 0;
+  int rc = 0;
+  int64_t nfiltered = 0;
+  int32_t blocksize = 0;
+  for (int64_t start = 0; start < nbytes; start += chunksize) {
+    int32_t size = (int32_t)(nbytes - start < chunksize ? nbytes - start : chunksize);
+    rc = initialize_context_compression(
+      context, (const uint8_t*)samples + start, size, cbuffer, cbuffer_size,
+      context->clevel, context->filters, context->filters_meta,
+      context->typesize, context->compcode, context->blocksize,
+      context->new_nthreads, context->nthreads, context->splitmode,
+      context->udbtune, context->btune, context->schunk);
+    if (rc <= 0) {
+      break;
+    }
+    rc = write_compression_header(context, true);
+    if (rc < 0) {
+      break;
+    }
+    rc = blosc_compress_context(context);
+    if (rc < 0) {
+      break;
+    }
+    if (rc < context->header_overhead + size) {
+      BLOSC_TRACE_ERROR("Cannot run the filters over the samples.");
+      rc = BLOSC2_ERROR_CODEC_DICT;
+      break;
+    }
+    memcpy(filtered + nfiltered, cbuffer + context->header_overhead, size);
+    nfiltered += size;
+    if (blocksize == 0) {
+      blocksize = context->blocksize;
+    }
+  }
+  context->dict_cdict = cdict;
+  context->use_dict = use_dict;
+  context->dict_id = dict_id;
+  free(cbuffer);
+  if (rc < 0) {
+    free(filtered);
+    return rc;
+  }
+
+  // Every block is a sample (at least 8, the minimum that accepts zstd as of 1.4.0)
+  unsigned nsamples = (unsigned)(nfiltered / blocksize);
+  if (nsamples < 8) {
+    nsamples = 8;
+  }
+  void* dict_buffer = malloc(dict_maxsize);
+  if (dict_buffer == NULL) {
+    free(filtered);
+    BLOSC_TRACE_ERROR("Error allocating memory!");
+    return BLOSC2_ERROR_MEMORY_ALLOC;
+  }
+  int32_t dict_actual_size = build_dict(context, filtered, nfiltered, nsamples,
+                                        dict_buffer, dict_maxsize);
+  free(filtered);
+  if (dict_actual_size < 0) {
+    free(dict_buffer);
+    return dict_actual_size;
+  }
+
+  *dict = dict_buffer;
+  *dict_size = dict_actual_size;
+  return 0;
+}
+
+
 void build_filters(const int doshuffle, const int delta,
                    const size_t typesize, uint8_t* filters) {
 
@@ -2584,17 +3940,13 @@ int blosc2_compress(int clevel, int doshuffle, int32_t typesize,
   pthread_mutex_lock(&global_comp_mutex);
 
   /* Initialize a context compression */
-  uint8_t* filters = calloc(1, BLOSC2_MAX_FILTERS);
-  BLOSC_ERROR_NULL(filters, BLOSC2_ERROR_MEMORY_ALLOC);
-  uint8_t* filters_meta = calloc(1, BLOSC2_MAX_FILTERS);
-  BLOSC_ERROR_NULL(filters_meta, BLOSC2_ERROR_MEMORY_ALLOC);
+  uint8_t filters[BLOSC2_MAX_FILTERS] = {0};
+  uint8_t filters_meta[BLOSC2_MAX_FILTERS] = {0};
   build_filters(doshuffle, g_delta, typesize, filters);
   error = initialize_context_compression(
     g_global_context, src, srcsize, dest, destsize, clevel, filters,
     filters_meta, (int32_t)typesize, g_compressor, g_force_blocksize, g_nthreads, g_nthreads,
     g_splitmode, &BTUNE_DEFAULTS, NULL, g_schunk);
-  free(filters);
-  free(filters_meta);
   if (error <= 0) {
     pthread_mutex_unlock(&global_comp_mutex);
     return error;
@@ -2629,6 +3981,108 @@ int blosc_compress(int clevel, int doshuffle, size_t typesize, size_t nbytes,
 
 
 
+/* Start reading all the (not masked out) blocks of a lazy chunk in the background,
+   when the IO backend of its frame supports it. */
+static void submit_lazy_reads(blosc2_context* context) {
+  context->lazy_batch = NULL;
+  bool is_lazy = ((context->header_overhead == BLOSC_EXTENDED_HEADER_LENGTH) &&
+                  (context->blosc2_flags & 0x08u) && !context->special_type);
+  if (!is_lazy || context->schunk == NULL || context->schunk->frame == NULL) {
+    return;
+  }
+  blosc2_frame_s* frame = (blosc2_frame_s*)context->schunk->frame;
+  if (frame->cframe != NULL || context->nblocks <= 0) {
+    return;
+  }
+  const blosc2_io_ext_cb* io_ext = blosc2_get_io_ext_cb(context->schunk->storage->io->id);
+  if (io_ext == NULL || io_ext->submit == NULL) {
+    return;
+  }
+
+  const uint8_t* src = context->src;
+  int32_t nblocks = context->nblocks;
+  bool memcpyed = context->header_flags & (uint8_t)BLOSC_MEMCPYED;
+  size_t trailer_offset = BLOSC_EXTENDED_HEADER_LENGTH + nblocks * sizeof(int32_t);
+  if ((int64_t)trailer_offset + sizeof(int32_t) + sizeof(int64_t) + nblocks * sizeof(int32_t) >
+      (size_t)context->srcsize) {
+    return;
+  }
+  int32_t nchunk = *(int32_t*)(src + trailer_offset);
+  int64_t chunk_offset = *(int64_t*)(src + trailer_offset + sizeof(int32_t));
+  int32_t* block_csizes = (int32_t *)(src + trailer_offset + sizeof(int32_t) + sizeof(int64_t));
+
+  context->lazy_boffsets = blosc_pool_malloc(nblocks * sizeof(int64_t));
+  context->lazy_nreads = blosc_pool_malloc(nblocks * sizeof(int32_t));
+  int64_t* offsets = blosc_pool_malloc(nblocks * sizeof(int64_t));
+  int64_t* nbytes = blosc_pool_malloc(nblocks * sizeof(int64_t));
+  void** ptrs = blosc_pool_malloc(nblocks * sizeof(void*));
+  int32_t nreads = 0;
+  int64_t buffer_size = 0;
+  context->lazy_buffer = NULL;
+  if (context->lazy_boffsets == NULL || context->lazy_nreads == NULL || offsets == NULL ||
+      nbytes == NULL || ptrs == NULL) {
+    // Without memory for the batch, the blocks are read synchronously
+    nblocks = 0;
+  }
+  for (int32_t j = 0; j < nblocks; j++) {
+    context->lazy_nreads[j] = -1;
+    if (context->block_maskout != NULL && context->block_maskout[j]) {
+      continue;
+    }
+    int32_t src_offset = memcpyed ?
+        context->header_overhead + j * context->blocksize : sw32_(context->bstarts + j);
+    context->lazy_nreads[j] = nreads;
+    context->lazy_boffsets[j] = buffer_size;
+    offsets[nreads] = frame->sframe ? src_offset : chunk_offset + src_offset;
+    nbytes[nreads] = block_csizes[j];
+    buffer_size += block_csizes[j];
+    nreads++;
+  }
+  if (nreads > 0) {
+    context->lazy_buffer = blosc_pool_malloc((size_t)buffer_size);
+  }
+  if (context->lazy_buffer != NULL) {
+    for (int32_t j = 0; j < nblocks; j++) {
+      if (context->lazy_nreads[j] >= 0) {
+        ptrs[context->lazy_nreads[j]] = context->lazy_buffer + context->lazy_boffsets[j];
+      }
+    }
+    context->lazy_batch = frame_submit_reads(frame, nchunk, nreads, ptrs, nbytes, offsets);
+  }
+  if (context->lazy_batch != NULL) {
+    STATS_ADD(&context->stats, lazy_nreads, nreads);
+    STATS_ADD(&context->stats, lazy_nbytes, buffer_size);
+  }
+  blosc_pool_free(ptrs);
+  blosc_pool_free(nbytes);
+  blosc_pool_free(offsets);
+  if (context->lazy_batch == NULL) {
+    // The blocks will be read synchronously
+    blosc_pool_free(context->lazy_buffer);
+    blosc_pool_free(context->lazy_boffsets);
+    blosc_pool_free(context->lazy_nreads);
+    context->lazy_buffer = NULL;
+    context->lazy_boffsets = NULL;
+    context->lazy_nreads = NULL;
+  }
+}
+
+
+static void release_lazy_reads(blosc2_context* context) {
+  if (context->lazy_batch == NULL) {
+    return;
+  }
+  frame_release_reads(context->lazy_batch);
+  blosc_pool_free(context->lazy_buffer);
+  blosc_pool_free(context->lazy_boffsets);
+  blosc_pool_free(context->lazy_nreads);
+  context->lazy_batch = NULL;
+  context->lazy_buffer = NULL;
+  context->lazy_boffsets = NULL;
+  context->lazy_nreads = NULL;
+}
+
+
 int blosc_run_decompression_with_context(blosc2_context* context, const void* src, int32_t srcsize,
                                          void* dest, int32_t destsize) {
   blosc_header header;
@@ -2652,10 +4106,15 @@ int blosc_run_decompression_with_context(blosc2_context* context, const void* sr
   }
 
   /* Do the actual decompression */
+  submit_lazy_reads(context);
   ntbytes = do_job(context);
+  release_lazy_reads(context);
   if (ntbytes < 0) {
     return ntbytes;
   }
+  STATS_ADD(&context->stats, nchunks, 1);
+  STATS_ADD(&context->stats, nbytes, ntbytes);
+  STATS_ADD(&context->stats, cbytes, header.cbytes);
 
   assert(ntbytes <= (int32_t)destsize);
   return ntbytes;
@@ -2784,6 +4243,15 @@ int _blosc_getitem(blosc2_context* context, blosc_header* header, const void* sr
     memcpyed = true;
   }
 
+  context->use_dict = 0;
+  if (!memcpyed && (context->blosc2_flags & BLOSC2_USEDICT)) {
+    int32_t bstarts_end = context->header_overhead + context->nblocks * (int32_t)sizeof(int32_t);
+    rc = read_chunk_dict(context, bstarts_end, srcsize - bstarts_end);
+    if (rc < 0) {
+      return rc;
+    }
+  }
+
   bool is_lazy = ((context->header_overhead == BLOSC_EXTENDED_HEADER_LENGTH) &&
                   (context->blosc2_flags & 0x08u) && !context->special_type);
   if (memcpyed && !is_lazy && !context->postfilter) {
@@ -2826,9 +4294,9 @@ int _blosc_getitem(blosc2_context* context, blosc_header* header, const void* sr
   struct thread_context* scontext = context->serial_context;
   /* Resize the temporaries in serial context if needed */
   if (header->blocksize > scontext->tmp_blocksize) {
-    my_free(scontext->tmp);
+    blosc_free(scontext->tmp);
     scontext->tmp_nbytes = (size_t)4 * ebsize;
-    scontext->tmp = my_malloc(scontext->tmp_nbytes);
+    scontext->tmp = blosc_malloc(scontext->tmp_nbytes);
     BLOSC_ERROR_NULL(scontext->tmp, BLOSC2_ERROR_MEMORY_ALLOC);
     scontext->tmp2 = scontext->tmp + ebsize;
     scontext->tmp3 = scontext->tmp2 + ebsize;
@@ -2922,6 +4390,7 @@ int blosc2_getitem(const void* src, int32_t srcsize, int start, int nitems, void
   if (context.serial_context != NULL) {
     free_thread_context(context.serial_context);
   }
+  free_dict(&context);
   return result;
 }
 
@@ -2958,6 +4427,7 @@ int blosc2_getitem_ctx(blosc2_context* context, const void* src, int32_t srcsize
   BLOSC_ERROR_NULL(context->serial_context, BLOSC2_ERROR_THREAD_CREATE);
   /* Call the actual getitem function */
   result = _blosc_getitem(context, &header, src, srcsize, start, nitems, dest, destsize);
+  flush_stats(context->serial_context);
 
   return result;
 }
@@ -2989,6 +4459,9 @@ static void t_blosc_do_job(void *ctxt)
   uint8_t* tmp;
   uint8_t* tmp2;
   uint8_t* tmp3;
+  blosc_timestamp_t start, end;
+
+  STATS_TIMESTAMP(start);
 
   /* Get parameters for this thread before entering the main loop */
   blocksize = context->blocksize;
@@ -3001,11 +4474,29 @@ static void t_blosc_do_job(void *ctxt)
   srcsize = context->srcsize;
   dest = context->dest;
 
+  if (context->block_compaction) {
+    /* Copy the compressed blocks to dest using a static schedule */
+    tblocks = nblocks / context->nthreads;
+    tblocks = (nblocks % context->nthreads > 0) ? tblocks + 1 : tblocks;
+    nblock_ = thcontext->tid * tblocks;
+    tblock = nblock_ + tblocks;
+    if (tblock > nblocks) {
+      tblock = nblocks;
+    }
+    if (nblock_ < tblock) {
+      compact_blocks(context, nblock_, tblock);
+    }
+    STATS_TIMESTAMP(end);
+    STATS_ADD_TIME(&thcontext->stats, busy_ns, start, end);
+    flush_stats(thcontext);
+    return;
+  }
+
   /* Resize the temporaries if needed */
   if (blocksize > thcontext->tmp_blocksize) {
-    my_free(thcontext->tmp);
+    blosc_free(thcontext->tmp);
     thcontext->tmp_nbytes = (size_t) 4 * ebsize;
-    thcontext->tmp = my_malloc(thcontext->tmp_nbytes);
+    thcontext->tmp = blosc_malloc(thcontext->tmp_nbytes);
     thcontext->tmp2 = thcontext->tmp + ebsize;
     thcontext->tmp3 = thcontext->tmp2 + ebsize;
     thcontext->tmp4 = thcontext->tmp3 + ebsize;
@@ -3036,17 +4527,14 @@ static void t_blosc_do_job(void *ctxt)
       }
   }
   else {
-    // Use dynamic schedule via a queue.  Get the next block.
-    pthread_mutex_lock(&context->count_mutex);
-    context->thread_nblock++;
-    nblock_ = context->thread_nblock;
-    pthread_mutex_unlock(&context->count_mutex);
+    // Use dynamic schedule via an atomic counter.  Get the next block.
+    nblock_ = BLOSC_ATOMIC_FETCH_ADD32(&context->thread_nblock, 1) + 1;
     tblock = nblocks;
   }
 
   /* Loop over blocks */
   leftoverblock = 0;
-  while ((nblock_ < tblock) && (context->thread_giveup_code > 0)) {
+  while ((nblock_ < tblock) && (BLOSC_ATOMIC_LOAD32(&context->thread_giveup_code) > 0)) {
     bsize = blocksize;
     if (nblock_ == (nblocks - 1) && (leftover > 0)) {
       bsize = leftover;
@@ -3056,8 +4544,8 @@ static void t_blosc_do_job(void *ctxt)
       if (memcpyed) {
         if (!context->prefilter) {
           /* We want to memcpy only */
-          memcpy(dest + context->header_overhead + nblock_ * blocksize,
-                 src + nblock_ * blocksize, (unsigned int) bsize);
+          memcpy_block(thcontext, dest + context->header_overhead + nblock_ * blocksize,
+                       src + nblock_ * blocksize, bsize);
           cbytes = (int32_t) bsize;
         }
         else {
@@ -3071,9 +4559,10 @@ static void t_blosc_do_job(void *ctxt)
         }
       }
       else {
-        /* Regular compression */
+        /* Regular compression (into the slot for this block) */
         cbytes = blosc_c(thcontext, bsize, leftoverblock, 0,
-                          ebsize, src, nblock_ * blocksize, tmp2, tmp, tmp3);
+                         ebsize, src, nblock_ * blocksize,
+                         context->block_slots + (size_t)nblock_ * ebsize, tmp, tmp3);
       }
     }
     else {
@@ -3094,53 +4583,33 @@ static void t_blosc_do_job(void *ctxt)
     }
 
     /* Check whether current thread has to giveup */
-    if (context->thread_giveup_code <= 0) {
+    if (BLOSC_ATOMIC_LOAD32(&context->thread_giveup_code) <= 0) {
       break;
     }
 
     /* Check results for the compressed/decompressed block */
     if (cbytes < 0) {            /* compr/decompr failure */
       /* Set giveup_code error */
-      pthread_mutex_lock(&context->count_mutex);
-      context->thread_giveup_code = cbytes;
-      pthread_mutex_unlock(&context->count_mutex);
+      BLOSC_ATOMIC_STORE32(&context->thread_giveup_code, cbytes);
       break;
     }
 
     if (compress && !memcpyed) {
-      /* Start critical section */
-      pthread_mutex_lock(&context->count_mutex);
-      ntdest = context->output_bytes;
-      // Note: do not use a typical local dict_training variable here
-      // because it is probably cached from previous calls if the number of
-      // threads does not change (the usual thing).
-      if (!(context->use_dict && context->dict_cdict == NULL)) {
-        _sw32(bstarts + nblock_, (int32_t) ntdest);
-      }
-
-      if ((cbytes == 0) || (ntdest + cbytes > maxbytes)) {
-        context->thread_giveup_code = 0;  /* uncompressible buf */
-        pthread_mutex_unlock(&context->count_mutex);
+      /* Reserve the output space; the block is placed in dest at the end */
+      context->block_offsets[nblock_] = cbytes;
+      ntdest = BLOSC_ATOMIC_FETCH_ADD32(&context->output_bytes, cbytes);
+      if ((cbytes == 0) || ((int64_t)ntdest + cbytes > maxbytes)) {
+        BLOSC_ATOMIC_STORE32(&context->thread_giveup_code, 0);  /* uncompressible buf */
         break;
       }
-      context->thread_nblock++;
-      nblock_ = context->thread_nblock;
-      context->output_bytes += cbytes;
-      pthread_mutex_unlock(&context->count_mutex);
-      /* End of critical section */
-
-      /* Copy the compressed buffer to destination */
-      memcpy(dest + ntdest, tmp2, (unsigned int) cbytes);
+      nblock_ = BLOSC_ATOMIC_FETCH_ADD32(&context->thread_nblock, 1) + 1;
     }
     else if (static_schedule) {
       nblock_++;
     }
     else {
-      pthread_mutex_lock(&context->count_mutex);
-      context->thread_nblock++;
-      nblock_ = context->thread_nblock;
-      context->output_bytes += cbytes;
-      pthread_mutex_unlock(&context->count_mutex);
+      BLOSC_ATOMIC_FETCH_ADD32(&context->output_bytes, cbytes);
+      nblock_ = BLOSC_ATOMIC_FETCH_ADD32(&context->thread_nblock, 1) + 1;
     }
 
   } /* closes while (nblock_) */
@@ -3152,6 +4621,10 @@ static void t_blosc_do_job(void *ctxt)
     }
   }
 
+  STATS_TIMESTAMP(end);
+  STATS_ADD_TIME(&thcontext->stats, busy_ns, start, end);
+  flush_stats(thcontext);
+
 }
 
 /* Decompress & unshuffle several blocks in a single thread */
@@ -3188,7 +4661,6 @@ int init_threadpool(blosc2_context *context) {
   int rc2;
 
   /* Initialize mutex and condition variable objects */
-  pthread_mutex_init(&context->count_mutex, NULL);
   pthread_mutex_init(&context->delta_mutex, NULL);
   pthread_cond_init(&context->delta_cv, NULL);
 
@@ -3206,9 +4678,9 @@ int init_threadpool(blosc2_context *context) {
   context->count_threads = 0;      /* Reset threads counter */
 #endif
 
-  if (threads_callback) {
-      /* Create thread contexts to store data for callback threads */
-    context->thread_contexts = (struct thread_context *)my_malloc(
+  if (threads_callback || blosc_shared_pool_active()) {
+      /* Create thread contexts to store data for callback (or shared pool) threads */
+    context->thread_contexts = (struct thread_context *)blosc_malloc(
             context->nthreads * sizeof(struct thread_context));
     BLOSC_ERROR_NULL(context->thread_contexts, BLOSC2_ERROR_MEMORY_ALLOC);
     for (tid = 0; tid < context->nthreads; tid++)
@@ -3222,7 +4694,7 @@ int init_threadpool(blosc2_context *context) {
     #endif
 
     /* Make space for thread handlers */
-    context->threads = (pthread_t*)my_malloc(
+    context->threads = (pthread_t*)blosc_malloc(
             context->nthreads * sizeof(pthread_t));
     BLOSC_ERROR_NULL(context->threads, BLOSC2_ERROR_MEMORY_ALLOC);
     /* Finally, create the threads */
@@ -3506,6 +4978,15 @@ void blosc_init(void) {
   g_ncodecs = 0;
   g_nfilters = 0;
 
+  /* Detect the caches that automatic blocksizes are derived from */
+  blosc_cpu_caches_init();
+
+  /* Check for a BLOSC_TILED_PIPELINE environment variable */
+  char* envvar = getenv("BLOSC_TILED_PIPELINE");
+  if (envvar != NULL) {
+    g_tiled_pipeline = (strtol(envvar, NULL, 10) != 0);
+  }
+
 #if defined(HAVE_PLUGINS)
   #include "blosc2/blosc2-common.h"
   #include "blosc2/blosc2-stdio.h"
@@ -3514,8 +4995,9 @@ void blosc_init(void) {
 #endif
   pthread_mutex_init(&global_comp_mutex, NULL);
   /* Create a global context */
-  g_global_context = (blosc2_context*)my_malloc(sizeof(blosc2_context));
+  g_global_context = (blosc2_context*)blosc_malloc(sizeof(blosc2_context));
   memset(g_global_context, 0, sizeof(blosc2_context));
+  g_global_context->probe_entropy = BLOSC2_PROBE_MIN_ENTROPY;
   g_global_context->nthreads = g_nthreads;
   g_global_context->new_nthreads = g_nthreads;
   g_initlib = 1;
@@ -3529,6 +5011,12 @@ void blosc_destroy(void) {
   g_initlib = 0;
   blosc2_free_ctx(g_global_context);
 
+  /* Stop the shared pool, if any */
+  blosc_shared_pool_set(0);
+
+  /* Release the buffers cached by this thread */
+  blosc_pool_flush();
+
   pthread_mutex_destroy(&global_comp_mutex);
 
 }
@@ -3540,11 +5028,12 @@ int release_threadpool(blosc2_context *context) {
   int rc;
 
   if (context->threads_started > 0) {
-    if (threads_callback) {
-      /* free context data for user-managed threads */
+    if (context->thread_contexts != NULL) {
+      /* free context data for user-managed (or shared pool) threads */
       for (t=0; t<context->threads_started; t++)
         destroy_thread_context(context->thread_contexts + t);
-      my_free(context->thread_contexts);
+      blosc_free(context->thread_contexts);
+      context->thread_contexts = NULL;
     }
     else {
       /* Tell all existing threads to finish */
@@ -3566,11 +5055,10 @@ int release_threadpool(blosc2_context *context) {
       #endif
 
       /* Release thread handlers */
-      my_free(context->threads);
+      blosc_free(context->threads);
     }
 
     /* Release mutex and condition variable objects */
-    pthread_mutex_destroy(&context->count_mutex);
     pthread_mutex_destroy(&context->delta_mutex);
     pthread_cond_destroy(&context->delta_cv);
 
@@ -3605,7 +5093,7 @@ int blosc_free_resources(void) {
 
 /* Create a context for compression */
 blosc2_context* blosc2_create_cctx(blosc2_cparams cparams) {
-  blosc2_context* context = (blosc2_context*)my_malloc(sizeof(blosc2_context));
+  blosc2_context* context = (blosc2_context*)blosc_malloc(sizeof(blosc2_context));
   BLOSC_ERROR_NULL(context, NULL);
 
   /* Populate the context, using zeros as default values */
@@ -3623,22 +5111,35 @@ blosc2_context* blosc2_create_cctx(blosc2_cparams cparams) {
     context->filters[i] = cparams.filters[i];
     context->filters_meta[i] = cparams.filters_meta[i];
 
+    if (context->filters[i] == BLOSC_AUTO_FILTER) {
+      if (context->auto_filter) {
+        BLOSC_TRACE_ERROR("There can only be one automatic filter in the pipeline.");
+        blosc_free(context);
+        return NULL;
+      }
+      context->auto_filter = true;
+      continue;
+    }
     if (context->filters[i] >= BLOSC_LAST_FILTER && context->filters[i] <= BLOSC2_DEFINED_FILTERS_STOP) {
       BLOSC_TRACE_ERROR("filter (%d) is not yet defined",
                         context->filters[i]);
-      free(context);
+      blosc_free(context);
       return NULL;
     }
     if (context->filters[i] > BLOSC_LAST_REGISTERED_FILTER && context->filters[i] <= BLOSC2_GLOBAL_REGISTERED_FILTERS_STOP) {
       BLOSC_TRACE_ERROR("filter (%d) is not yet defined",
                         context->filters[i]);
-      free(context);
+      blosc_free(context);
       return NULL;
     }
   }
+  if (context->auto_filter) {
+    memcpy(context->auto_filters, cparams.filters, BLOSC2_MAX_FILTERS);
+  }
 
   context->nthreads = cparams.nthreads;
   context->new_nthreads = context->nthreads;
+  context->probe_entropy = BLOSC2_PROBE_MIN_ENTROPY;
   context->blocksize = cparams.blocksize;
   context->splitmode = cparams.splitmode;
   context->threads_started = 0;
@@ -3646,7 +5147,7 @@ blosc2_context* blosc2_create_cctx(blosc2_cparams cparams) {
 
   if (cparams.prefilter != NULL) {
     context->prefilter = cparams.prefilter;
-    context->preparams = (blosc2_prefilter_params*)my_malloc(sizeof(blosc2_prefilter_params));
+    context->preparams = (blosc2_prefilter_params*)blosc_malloc(sizeof(blosc2_prefilter_params));
     BLOSC_ERROR_NULL(context->preparams, NULL);
     memcpy(context->preparams, cparams.preparams, sizeof(blosc2_prefilter_params));
   }
@@ -3662,7 +5163,7 @@ blosc2_context* blosc2_create_cctx(blosc2_cparams cparams) {
 
 /* Create a context for decompression */
 blosc2_context* blosc2_create_dctx(blosc2_dparams dparams) {
-  blosc2_context* context = (blosc2_context*)my_malloc(sizeof(blosc2_context));
+  blosc2_context* context = (blosc2_context*)blosc_malloc(sizeof(blosc2_context));
   BLOSC_ERROR_NULL(context, NULL);
 
   /* Populate the context, using zeros as default values */
@@ -3674,12 +5175,13 @@ blosc2_context* blosc2_create_dctx(blosc2_dparams dparams) {
   context->block_maskout = NULL;
   context->block_maskout_nitems = 0;
   context->schunk = dparams.schunk;
+  context->nchunk = -1;
   context->zfp_cell_nitems = 0;
   context->zfp_cell_start = 0;
 
   if (dparams.postfilter != NULL) {
     context->postfilter = dparams.postfilter;
-    context->postparams = (blosc2_postfilter_params*)my_malloc(sizeof(blosc2_postfilter_params));
+    context->postparams = (blosc2_postfilter_params*)blosc_malloc(sizeof(blosc2_postfilter_params));
     BLOSC_ERROR_NULL(context->postparams, NULL);
     memcpy(context->postparams, dparams.postparams, sizeof(blosc2_postfilter_params));
   }
@@ -3693,30 +5195,26 @@ void blosc2_free_ctx(blosc2_context* context) {
   if (context->serial_context != NULL) {
     free_thread_context(context->serial_context);
   }
-  if (context->dict_cdict != NULL) {
-#ifdef HAVE_ZSTD
-    ZSTD_freeCDict(context->dict_cdict);
-#endif
-  }
-  if (context->dict_ddict != NULL) {
-#ifdef HAVE_ZSTD
-    ZSTD_freeDDict(context->dict_ddict);
-#endif
+  free_dict(context);
+  if (context->auto_cctx != NULL) {
+    blosc2_free_ctx(context->auto_cctx);
   }
   if (context->btune != NULL) {
     context->udbtune->btune_free(context);
   }
   if (context->prefilter != NULL) {
-    my_free(context->preparams);
+    blosc_free(context->preparams);
   }
   if (context->postfilter != NULL) {
-    my_free(context->postparams);
+    blosc_free(context->postparams);
   }
 
   if (context->block_maskout != NULL) {
     free(context->block_maskout);
   }
-  my_free(context);
+  blosc_free(context->block_slots);
+  blosc_free(context->block_offsets);
+  blosc_free(context);
 }
 
 
@@ -3732,7 +5230,7 @@ int blosc2_ctx_get_cparams(blosc2_context *ctx, blosc2_cparams *cparams) {
   cparams->splitmode = ctx->splitmode;
   cparams->schunk = ctx->schunk;
   for (int i = 0; i < BLOSC2_MAX_FILTERS; ++i) {
-    cparams->filters[i] = ctx->filters[i];
+    cparams->filters[i] = ctx->auto_filter ? ctx->auto_filters[i] : ctx->filters[i];
     cparams->filters_meta[i] = ctx->filters_meta[i];
   }
   cparams->prefilter = ctx->prefilter;
@@ -3771,6 +5269,68 @@ int blosc2_set_maskout(blosc2_context *ctx, bool *maskout, int nblocks) {
 }
 
 
+int blosc2_set_probe(blosc2_context *ctx, float min_entropy, bool probe_blocks) {
+  if (!ctx->do_compress) {
+    BLOSC_TRACE_ERROR("The incompressibility probe can only be set in compression contexts.");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  if (min_entropy < 0 || min_entropy > 8) {
+    BLOSC_TRACE_ERROR("The minimum entropy must be between 0 and 8 bits.");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  ctx->probe_entropy = min_entropy;
+  ctx->probe_blocks = probe_blocks;
+
+  return 0;
+}
+
+
+int blosc2_get_probe_stats(blosc2_context *ctx, int64_t *nchunks, int64_t *nblocks) {
+  if (nchunks != NULL) {
+    *nchunks = ctx->probe_nchunks;
+  }
+  if (nblocks != NULL) {
+    *nblocks = BLOSC_ATOMIC_LOAD32(&ctx->probe_nblocks);
+  }
+
+  return 0;
+}
+
+
+int blosc2_ctx_get_stats(blosc2_context *ctx, blosc2_stats *stats) {
+  memset(stats, 0, sizeof(blosc2_stats));
+#if defined(HAVE_STATS)
+  blosc_stats* counters = &ctx->stats;
+  stats->nchunks = counters->nchunks;
+  stats->nblocks = counters->nblocks;
+  stats->nbytes = counters->nbytes;
+  stats->cbytes = counters->cbytes;
+  stats->nmemcpyed = counters->nmemcpyed;
+  stats->lazy_nbytes = counters->lazy_nbytes;
+  stats->lazy_nreads = counters->lazy_nreads;
+  stats->prefilter_time = (double)counters->prefilter_ns / 1e9;
+  stats->filter_time = (double)counters->filter_ns / 1e9;
+  stats->codec_time = (double)counters->codec_ns / 1e9;
+  stats->memcpy_time = (double)counters->memcpy_ns / 1e9;
+  stats->postfilter_time = (double)counters->postfilter_ns / 1e9;
+  stats->wait_time = (double)counters->wait_ns / 1e9;
+
+  return 0;
+#else
+  (void)ctx;
+  BLOSC_TRACE_ERROR("Blosc has been compiled without support for stats.");
+  return BLOSC2_ERROR_FAILURE;
+#endif  /* HAVE_STATS */
+}
+
+
+int blosc2_ctx_reset_stats(blosc2_context *ctx) {
+  memset(&ctx->stats, 0, sizeof(blosc_stats));
+
+  return 0;
+}
+
+
 /* Create a chunk made of zeros */
 int blosc2_chunk_zeros(blosc2_cparams cparams, const size_t nbytes, void* dest, size_t destsize) {
   if (destsize < BLOSC_EXTENDED_HEADER_LENGTH) {
@@ -4060,6 +5620,44 @@ int blosc2_register_io_cb(const blosc2_io_cb *io) {
   return _blosc2_register_io_cb(io);
 }
 
+#if defined(BLOSC2_HAVE_MMAP_IO)
+static const blosc2_io_cb BLOSC2_IO_CB_MMAP = {
+  .id = BLOSC2_IO_FILESYSTEM_MMAP,
+  .open = (blosc2_open_cb) blosc2_mmap_open,
+  .close = (blosc2_close_cb) blosc2_mmap_close,
+  .tell = (blosc2_tell_cb) blosc2_mmap_tell,
+  .seek = (blosc2_seek_cb) blosc2_mmap_seek,
+  .write = (blosc2_write_cb) blosc2_mmap_write,
+  .read = (blosc2_read_cb) blosc2_mmap_read,
+  .truncate = (blosc2_truncate_cb) blosc2_mmap_truncate,
+};
+
+static const blosc2_io_ext_cb BLOSC2_IO_EXT_CB_MMAP = {
+  .id = BLOSC2_IO_FILESYSTEM_MMAP,
+  .pread = (blosc2_pread_cb) blosc2_mmap_pread,
+  .map = (blosc2_map_cb) blosc2_mmap_map,
+};
+#endif
+
+static const blosc2_io_cb BLOSC2_IO_CB_URING = {
+  .id = BLOSC2_IO_FILESYSTEM_URING,
+  .open = (blosc2_open_cb) blosc2_uring_open,
+  .close = (blosc2_close_cb) blosc2_uring_close,
+  .tell = (blosc2_tell_cb) blosc2_uring_tell,
+  .seek = (blosc2_seek_cb) blosc2_uring_seek,
+  .write = (blosc2_write_cb) blosc2_uring_write,
+  .read = (blosc2_read_cb) blosc2_uring_read,
+  .truncate = (blosc2_truncate_cb) blosc2_uring_truncate,
+};
+
+static const blosc2_io_ext_cb BLOSC2_IO_EXT_CB_URING = {
+  .id = BLOSC2_IO_FILESYSTEM_URING,
+  .pread = (blosc2_pread_cb) blosc2_uring_pread,
+  .submit = (blosc2_submit_cb) blosc2_uring_submit,
+  .complete = (blosc2_complete_cb) blosc2_uring_complete,
+  .release = (blosc2_release_cb) blosc2_uring_release,
+};
+
 blosc2_io_cb *blosc2_get_io_cb(uint8_t id) {
   for (int i = 0; i < g_nio; ++i) {
     if (g_io[i].id == id) {
@@ -4073,5 +5671,73 @@ blosc2_io_cb *blosc2_get_io_cb(uint8_t id) {
     }
     return blosc2_get_io_cb(id);
   }
+  if (id == BLOSC2_IO_FILESYSTEM_URING) {
+    if (_blosc2_register_io_cb(&BLOSC2_IO_CB_URING) < 0) {
+      BLOSC_TRACE_ERROR("Error registering the io_uring IO API");
+      return NULL;
+    }
+    return blosc2_get_io_cb(id);
+  }
+#if defined(BLOSC2_HAVE_MMAP_IO)
+  if (id == BLOSC2_IO_FILESYSTEM_MMAP) {
+    if (_blosc2_register_io_cb(&BLOSC2_IO_CB_MMAP) < 0) {
+      BLOSC_TRACE_ERROR("Error registering the memory-mapped IO API");
+      return NULL;
+    }
+    return blosc2_get_io_cb(id);
+  }
+#endif
+  return NULL;
+}
+
+static const blosc2_io_ext_cb BLOSC2_IO_EXT_CB_DEFAULTS = {
+  .id = BLOSC2_IO_FILESYSTEM,
+  .pread = (blosc2_pread_cb) blosc2_stdio_pread,
+};
+
+int blosc2_register_io_ext_cb(const blosc2_io_ext_cb *io_ext) {
+  BLOSC_ERROR_NULL(io_ext, BLOSC2_ERROR_INVALID_PARAM);
+  if (io_ext->id < BLOSC2_IO_REGISTERED) {
+    BLOSC_TRACE_ERROR("The IO id must be greater or equal than %d", BLOSC2_IO_REGISTERED);
+    return BLOSC2_ERROR_PLUGIN_IO;
+  }
+  if (blosc2_get_io_cb(io_ext->id) == NULL) {
+    BLOSC_TRACE_ERROR("The IO %d must be registered before its optional callbacks", io_ext->id);
+    return BLOSC2_ERROR_PLUGIN_IO;
+  }
+  if ((io_ext->submit != NULL) && (io_ext->complete == NULL || io_ext->release == NULL)) {
+    BLOSC_TRACE_ERROR("The submit callback needs the complete and release ones too");
+    return BLOSC2_ERROR_PLUGIN_IO;
+  }
+  for (int i = 0; i < g_nio_ext; ++i) {
+    if (g_io_ext[i].id == io_ext->id) {
+      BLOSC_TRACE_ERROR("The optional callbacks of the IO are already registered!");
+      return BLOSC2_ERROR_PLUGIN_IO;
+    }
+  }
+
+  memcpy(&g_io_ext[g_nio_ext++], io_ext, sizeof(blosc2_io_ext_cb));
+
+  return BLOSC2_ERROR_SUCCESS;
+}
+
+const blosc2_io_ext_cb *blosc2_get_io_ext_cb(uint8_t id) {
+  switch (id) {
+    case BLOSC2_IO_FILESYSTEM:
+      return &BLOSC2_IO_EXT_CB_DEFAULTS;
+    case BLOSC2_IO_FILESYSTEM_URING:
+      return &BLOSC2_IO_EXT_CB_URING;
+#if defined(BLOSC2_HAVE_MMAP_IO)
+    case BLOSC2_IO_FILESYSTEM_MMAP:
+      return &BLOSC2_IO_EXT_CB_MMAP;
+#endif
+    default:
+      break;
+  }
+  for (int i = 0; i < g_nio_ext; ++i) {
+    if (g_io_ext[i].id == id) {
+      return &g_io_ext[i];
+    }
+  }
   return NULL;
 }
@@ -420,8 +420,11 @@ out:
 }
 
 
-int blosclz_compress(const int clevel, const void* input, int length,
-                     void* output, int maxout, blosc2_context* ctx) {
+/* `dict` (if not NULL) is used as if it were right before `input`.  Positions in the hash
+ * table are relative to the start of the dictionary. */
+static int compress_(const int clevel, const void* input, int length,
+                     void* output, int maxout, const uint8_t* dict, uint32_t dict_size,
+                     blosc2_context* ctx) {
   uint8_t* ibase = (uint8_t*)input;
 
   // Experiments say that checking 1/4 of the buffer is enough to figure out approx cratio
@@ -480,6 +483,15 @@ int blosclz_compress(const int clevel, const void* input, int length,
   // Initialize the hash table
   uint32_t htab[1U << (uint8_t)HASH_LOG];
   memset(htab, 0, (1U << hashlog) * sizeof(uint32_t));
+  if (dict_size > 0) {
+    // Only the end of the dictionary is reachable.  Like LZ4_loadDict, hash every 3 bytes.
+    uint32_t start = dict_size > MAX_FARDISTANCE ? dict_size - MAX_FARDISTANCE : 0;
+    for (uint32_t pos = start; pos + 4 <= dict_size; pos += 3) {
+      seq = BLOSCLZ_READU32(dict + pos);
+      HASH_FUNCTION(hval, seq, hashlog)
+      htab[hval] = pos;
+    }
+  }
 
   /* we start with literal copy */
   copy = 4;
@@ -494,17 +506,28 @@ int blosclz_compress(const int clevel, const void* input, int length,
     const uint8_t* ref;
     unsigned distance;
     uint8_t* anchor = ip;    /* comparison starting-point */
+    uint8_t* match_bound = ip_bound;
 
     /* find potential match */
     seq = BLOSCLZ_READU32(ip);
     HASH_FUNCTION(hval, seq, hashlog)
-    ref = ibase + htab[hval];
+    uint32_t pos = htab[hval];
+    if (BLOSCLZ_UNLIKELY(pos < dict_size)) {
+      /* the match is in the dictionary, and cannot go beyond its end */
+      ref = dict + pos;
+      if (anchor + (dict_size - pos) < match_bound) {
+        match_bound = anchor + (dict_size - pos);
+      }
+    }
+    else {
+      ref = ibase + (pos - dict_size);
+    }
 
     /* calculate distance to the match */
-    distance = (unsigned int)(anchor - ref);
+    distance = (unsigned int)(anchor - ibase) + dict_size - pos;
 
     /* update hash table */
-    htab[hval] = (uint32_t) (anchor - ibase);
+    htab[hval] = (uint32_t) (anchor - ibase) + dict_size;
 
     if (distance == 0 || (distance >= MAX_FARDISTANCE)) {
       LITERAL(ip, op, op_limit, anchor, copy)
@@ -527,7 +550,7 @@ int blosclz_compress(const int clevel, const void* input, int length,
     distance--;
 
     /* get runs or matches; zero distance means a run */
-    ip = get_run_or_match(ip, ip_bound, ref, !distance);
+    ip = get_run_or_match(ip, match_bound, ref, !distance);
 
     /* length is biased, '1' means a match of 3 bytes */
     ip -= ipshift;
@@ -570,13 +593,13 @@ int blosclz_compress(const int clevel, const void* input, int length,
     /* update the hash at match boundary */
     seq = BLOSCLZ_READU32(ip);
     HASH_FUNCTION(hval, seq, hashlog)
-    htab[hval] = (uint32_t) (ip++ - ibase);
+    htab[hval] = (uint32_t) (ip++ - ibase) + dict_size;
     if (ctx->clevel == 9) {
       // In some situations, including a second hash proves to be useful,
       // but not in others.  Activating here in max clevel only.
       seq >>= 8U;
       HASH_FUNCTION(hval, seq, hashlog)
-      htab[hval] = (uint32_t) (ip++ - ibase);
+      htab[hval] = (uint32_t) (ip++ - ibase) + dict_size;
     }
     else {
       ip++;
@@ -615,6 +638,23 @@ int blosclz_compress(const int clevel, const void* input, int length,
   return 0;
 }
 
+
+int blosclz_compress(const int clevel, const void* input, int length,
+                     void* output, int maxout, blosc2_context* ctx) {
+  return compress_(clevel, input, length, output, maxout, NULL, 0, ctx);
+}
+
+
+int blosclz_compress_dict(const int clevel, const void* input, int length,
+                          void* output, int maxout, const void* dict, int dict_size,
+                          blosc2_context* ctx) {
+  if (dict == NULL || dict_size < 16) {
+    return compress_(clevel, input, length, output, maxout, NULL, 0, ctx);
+  }
+  return compress_(clevel, input, length, output, maxout,
+                   (const uint8_t*)dict, (uint32_t)dict_size, ctx);
+}
+
 // See https://habr.com/en/company/yandex/blog/457612/
 #if defined(__AVX2__)
 
@@ -679,7 +719,21 @@ static inline void wild_copy(uint8_t *out, const uint8_t* from, uint8_t* end) {
   do { memcpy(d,s,8); d+=8; s+=8; } while (d<e);
 }
 
-int blosclz_decompress(const void* input, int length, void* output, int maxout) {
+/* Copy a match that starts in `dict` (right before `output`), `back` bytes before `output` */
+static uint8_t* copy_match_dict(uint8_t* op, const uint8_t* output, size_t back, int32_t len,
+                                const uint8_t* dict, int dict_size) {
+  int32_t dict_len = len < (int32_t)back ? len : (int32_t)back;
+  memcpy(op, dict + dict_size - back, dict_len);
+  op += dict_len;
+  // The rest of the match continues at the start of output
+  for (int32_t i = 0; i < len - dict_len; i++) {
+    *op++ = output[i];
+  }
+  return op;
+}
+
+static int decompress_(const void* input, int length, void* output, int maxout,
+                       const uint8_t* dict, int dict_size) {
   const uint8_t* ip = (const uint8_t*)input;
   const uint8_t* ip_limit = ip + length;
   uint8_t* op = (uint8_t*)output;
@@ -733,7 +787,14 @@ int blosclz_decompress(const void* input, int length, void* output, int maxout)
       }
 
       if (BLOSCLZ_UNLIKELY(ref - 1 < (uint8_t*)output)) {
-        return 0;
+        size_t back = (size_t)((uint8_t*)output - (ref - 1));
+        if (back > (size_t)dict_size) {
+          return 0;
+        }
+        if (BLOSCLZ_UNLIKELY(ip >= ip_limit)) break;
+        ctrl = *ip++;
+        op = copy_match_dict(op, (uint8_t*)output, back, len, dict, dict_size);
+        continue;
       }
 
       if (BLOSCLZ_UNLIKELY(ip >= ip_limit)) break;
@@ -790,3 +851,17 @@ int blosclz_decompress(const void* input, int length, void* output, int maxout)
 
   return (int)(op - (uint8_t*)output);
 }
+
+
+int blosclz_decompress(const void* input, int length, void* output, int maxout) {
+  return decompress_(input, length, output, maxout, NULL, 0);
+}
+
+
+int blosclz_decompress_dict(const void* input, int length, void* output, int maxout,
+                            const void* dict, int dict_size) {
+  if (dict == NULL || dict_size < 16) {
+    return decompress_(input, length, output, maxout, NULL, 0);
+  }
+  return decompress_(input, length, output, maxout, (const uint8_t*)dict, dict_size);
+}
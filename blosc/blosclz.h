@@ -49,6 +49,16 @@ extern "C" {
 int blosclz_compress(int opt_level, const void* input, int length,
                      void* output, int maxout, blosc2_context* ctx);
 
+/**
+  The same than blosclz_compress(), but matches can also refer to the
+  (last 72 KB of) `dict`, as if it were right before the input buffer.
+  Dictionaries smaller than 16 bytes are ignored.
+*/
+
+int blosclz_compress_dict(int opt_level, const void* input, int length,
+                          void* output, int maxout, const void* dict, int dict_size,
+                          blosc2_context* ctx);
+
 /**
   Decompress a block of compressed data and returns the size of the
   decompressed block. If error occurs, e.g. the compressed data is
@@ -63,6 +73,14 @@ int blosclz_compress(int opt_level, const void* input, int length,
 
 int blosclz_decompress(const void* input, int length, void* output, int maxout);
 
+/**
+  Decompress a block of data compressed with blosclz_compress_dict() and
+  the same `dict`.
+ */
+
+int blosclz_decompress_dict(const void* input, int length, void* output, int maxout,
+                            const void* dict, int dict_size);
+
 #if defined (__cplusplus)
 }
 #endif
@@ -0,0 +1,320 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "chunk-cache.h"
+
+#if defined(_WIN32) && !defined(__GNUC__)
+  #include "win32/pthread.h"
+#else
+  #include <pthread.h>
+#endif
+
+
+typedef struct cache_entry {
+  int64_t nchunk;
+  uint8_t* data;
+  int32_t nbytes;
+  int32_t nreaders;          // copies out of `data` in progress
+  bool linked;               // whether the entry is still in the cache
+  struct cache_entry* prev;  // more recently used
+  struct cache_entry* next;  // less recently used
+  struct cache_entry* hnext; // the next entry in the same bucket
+} cache_entry;
+
+// The initial number of buckets of the index (a power of 2)
+#define CACHE_MIN_BUCKETS 16
+
+struct blosc2_chunk_cache_s {
+  int64_t maxbytes;
+  int64_t nbytes;            // bytes of the chunks in the cache
+  int64_t hits;
+  int64_t misses;
+  cache_entry* head;         // the most recently used chunk
+  cache_entry* tail;         // the least recently used chunk
+  cache_entry** buckets;     // the index of the chunks, by nchunk
+  int64_t nbuckets;
+  int64_t nentries;
+  pthread_mutex_t mutex;
+};
+
+
+static void free_entry(cache_entry* entry) {
+  free(entry->data);
+  free(entry);
+}
+
+
+static cache_entry** bucket(blosc2_chunk_cache* cache, int64_t nchunk) {
+  // Fibonacci hashing, so that consecutive chunks spread over the buckets
+  uint64_t hash = (uint64_t)nchunk * UINT64_C(0x9E3779B97F4A7C15);
+  return &cache->buckets[(hash >> 32) & (cache->nbuckets - 1)];
+}
+
+
+/* Rebuild the index out of the LRU list, growing it to `nbuckets` buckets if they can be allocated */
+static void reindex(blosc2_chunk_cache* cache, int64_t nbuckets) {
+  cache_entry** buckets = NULL;
+  if (nbuckets != cache->nbuckets) {
+    buckets = calloc(nbuckets, sizeof(cache_entry*));
+  }
+  if (buckets != NULL) {
+    free(cache->buckets);
+    cache->buckets = buckets;
+    cache->nbuckets = nbuckets;
+  }
+  else {
+    memset(cache->buckets, 0, cache->nbuckets * sizeof(cache_entry*));
+  }
+  for (cache_entry* entry = cache->head; entry != NULL; entry = entry->next) {
+    cache_entry** head = bucket(cache, entry->nchunk);
+    entry->hnext = *head;
+    *head = entry;
+  }
+}
+
+
+static void index_add(blosc2_chunk_cache* cache, cache_entry* entry) {
+  cache_entry** head = bucket(cache, entry->nchunk);
+  entry->hnext = *head;
+  *head = entry;
+  cache->nentries++;
+}
+
+
+static void index_remove(blosc2_chunk_cache* cache, cache_entry* entry) {
+  cache_entry** link = bucket(cache, entry->nchunk);
+  while (*link != entry) {
+    link = &(*link)->hnext;
+  }
+  *link = entry->hnext;
+  entry->hnext = NULL;
+  cache->nentries--;
+}
+
+
+static void link_head(blosc2_chunk_cache* cache, cache_entry* entry) {
+  entry->prev = NULL;
+  entry->next = cache->head;
+  if (cache->head != NULL) {
+    cache->head->prev = entry;
+  }
+  cache->head = entry;
+  if (cache->tail == NULL) {
+    cache->tail = entry;
+  }
+}
+
+
+static void detach(blosc2_chunk_cache* cache, cache_entry* entry) {
+  if (entry->prev != NULL) {
+    entry->prev->next = entry->next;
+  } else {
+    cache->head = entry->next;
+  }
+  if (entry->next != NULL) {
+    entry->next->prev = entry->prev;
+  } else {
+    cache->tail = entry->prev;
+  }
+  entry->prev = entry->next = NULL;
+}
+
+
+/* Take the entry out of the cache.  Its data is freed as soon as nobody is copying from it. */
+static void unlink_entry(blosc2_chunk_cache* cache, cache_entry* entry) {
+  index_remove(cache, entry);
+  detach(cache, entry);
+  cache->nbytes -= entry->nbytes;
+  entry->linked = false;
+  if (entry->nreaders == 0) {
+    free_entry(entry);
+  }
+}
+
+
+static void evict(blosc2_chunk_cache* cache, int64_t maxbytes) {
+  while (cache->nbytes > maxbytes && cache->tail != NULL) {
+    unlink_entry(cache, cache->tail);
+  }
+}
+
+
+static cache_entry* find(blosc2_chunk_cache* cache, int64_t nchunk) {
+  for (cache_entry* entry = *bucket(cache, nchunk); entry != NULL; entry = entry->hnext) {
+    if (entry->nchunk == nchunk) {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+
+blosc2_chunk_cache* chunk_cache_new(int64_t maxbytes) {
+  blosc2_chunk_cache* cache = calloc(1, sizeof(blosc2_chunk_cache));
+  if (cache == NULL) {
+    return NULL;
+  }
+  cache->buckets = calloc(CACHE_MIN_BUCKETS, sizeof(cache_entry*));
+  if (cache->buckets == NULL) {
+    free(cache);
+    return NULL;
+  }
+  cache->nbuckets = CACHE_MIN_BUCKETS;
+  cache->maxbytes = maxbytes;
+  pthread_mutex_init(&cache->mutex, NULL);
+  return cache;
+}
+
+
+void chunk_cache_free(blosc2_chunk_cache* cache) {
+  chunk_cache_clear(cache);
+  pthread_mutex_destroy(&cache->mutex);
+  free(cache->buckets);
+  free(cache);
+}
+
+
+void chunk_cache_resize(blosc2_chunk_cache* cache, int64_t maxbytes) {
+  pthread_mutex_lock(&cache->mutex);
+  cache->maxbytes = maxbytes;
+  evict(cache, maxbytes);
+  pthread_mutex_unlock(&cache->mutex);
+}
+
+
+int32_t chunk_cache_get(blosc2_chunk_cache* cache, int64_t nchunk, void* dest, int32_t nbytes) {
+  pthread_mutex_lock(&cache->mutex);
+  cache_entry* entry = find(cache, nchunk);
+  if (entry == NULL || entry->nbytes > nbytes) {
+    cache->misses++;
+    pthread_mutex_unlock(&cache->mutex);
+    return -1;
+  }
+  cache->hits++;
+  detach(cache, entry);
+  link_head(cache, entry);
+  entry->nreaders++;
+  pthread_mutex_unlock(&cache->mutex);
+
+  // Do not block other readers while copying
+  memcpy(dest, entry->data, entry->nbytes);
+  int32_t cbytes = entry->nbytes;
+
+  pthread_mutex_lock(&cache->mutex);
+  entry->nreaders--;
+  if (!entry->linked && entry->nreaders == 0) {
+    free_entry(entry);
+  }
+  pthread_mutex_unlock(&cache->mutex);
+  return cbytes;
+}
+
+
+void chunk_cache_put(blosc2_chunk_cache* cache, int64_t nchunk, const void* src, int32_t nbytes) {
+  pthread_mutex_lock(&cache->mutex);
+  int64_t maxbytes = cache->maxbytes;
+  pthread_mutex_unlock(&cache->mutex);
+  if (nbytes <= 0 || nbytes > maxbytes) {
+    return;
+  }
+  cache_entry* entry = malloc(sizeof(cache_entry));
+  if (entry == NULL) {
+    return;
+  }
+  entry->data = malloc(nbytes);
+  if (entry->data == NULL) {
+    free(entry);
+    return;
+  }
+  memcpy(entry->data, src, nbytes);
+  entry->nchunk = nchunk;
+  entry->nbytes = nbytes;
+  entry->nreaders = 0;
+  entry->linked = true;
+
+  pthread_mutex_lock(&cache->mutex);
+  if (nbytes > cache->maxbytes || find(cache, nchunk) != NULL) {
+    // The cache has shrunk, or another reader has stored the chunk already
+    pthread_mutex_unlock(&cache->mutex);
+    free_entry(entry);
+    return;
+  }
+  evict(cache, cache->maxbytes - nbytes);
+  link_head(cache, entry);
+  index_add(cache, entry);
+  cache->nbytes += nbytes;
+  if (cache->nentries > cache->nbuckets) {
+    reindex(cache, cache->nbuckets * 2);
+  }
+  pthread_mutex_unlock(&cache->mutex);
+}
+
+
+void chunk_cache_invalidate(blosc2_chunk_cache* cache, int64_t nchunk) {
+  pthread_mutex_lock(&cache->mutex);
+  cache_entry* entry = find(cache, nchunk);
+  if (entry != NULL) {
+    unlink_entry(cache, entry);
+  }
+  pthread_mutex_unlock(&cache->mutex);
+}
+
+
+void chunk_cache_insert(blosc2_chunk_cache* cache, int64_t nchunk) {
+  pthread_mutex_lock(&cache->mutex);
+  for (cache_entry* entry = cache->head; entry != NULL; entry = entry->next) {
+    if (entry->nchunk >= nchunk) {
+      entry->nchunk++;
+    }
+  }
+  reindex(cache, cache->nbuckets);
+  pthread_mutex_unlock(&cache->mutex);
+}
+
+
+void chunk_cache_delete(blosc2_chunk_cache* cache, int64_t nchunk) {
+  pthread_mutex_lock(&cache->mutex);
+  cache_entry* entry = cache->head;
+  while (entry != NULL) {
+    cache_entry* next = entry->next;
+    if (entry->nchunk == nchunk) {
+      unlink_entry(cache, entry);
+    }
+    else if (entry->nchunk > nchunk) {
+      entry->nchunk--;
+    }
+    entry = next;
+  }
+  reindex(cache, cache->nbuckets);
+  pthread_mutex_unlock(&cache->mutex);
+}
+
+
+void chunk_cache_clear(blosc2_chunk_cache* cache) {
+  pthread_mutex_lock(&cache->mutex);
+  evict(cache, -1);
+  pthread_mutex_unlock(&cache->mutex);
+}
+
+
+void chunk_cache_stats(blosc2_chunk_cache* cache, int64_t* hits, int64_t* misses) {
+  pthread_mutex_lock(&cache->mutex);
+  if (hits != NULL) {
+    *hits = cache->hits;
+  }
+  if (misses != NULL) {
+    *misses = cache->misses;
+  }
+  pthread_mutex_unlock(&cache->mutex);
+}
@@ -0,0 +1,51 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#ifndef BLOSC_CHUNK_CACHE_H
+#define BLOSC_CHUNK_CACHE_H
+
+#include <stdint.h>
+#include "blosc2.h"
+
+/* A size-bounded, least-recently-used cache of decompressed chunks of a super-chunk.
+ * All the functions are thread-safe. */
+
+/* Create a cache of (at most) `maxbytes` decompressed bytes */
+blosc2_chunk_cache* chunk_cache_new(int64_t maxbytes);
+
+/* Free the cache and all its chunks */
+void chunk_cache_free(blosc2_chunk_cache* cache);
+
+/* Change the maximum size of the cache, evicting chunks if needed */
+void chunk_cache_resize(blosc2_chunk_cache* cache, int64_t maxbytes);
+
+/* Copy the chunk `nchunk` into `dest` (of `nbytes`).  Returns the number of bytes copied,
+ * or a negative value if the chunk is not in the cache (or it does not fit in `dest`). */
+int32_t chunk_cache_get(blosc2_chunk_cache* cache, int64_t nchunk, void* dest, int32_t nbytes);
+
+/* Store a copy of the decompressed chunk `nchunk` (of `nbytes`) */
+void chunk_cache_put(blosc2_chunk_cache* cache, int64_t nchunk, const void* src, int32_t nbytes);
+
+/* Forget the chunk `nchunk` (because it has been updated) */
+void chunk_cache_invalidate(blosc2_chunk_cache* cache, int64_t nchunk);
+
+/* Renumber the chunks after inserting a chunk at `nchunk` */
+void chunk_cache_insert(blosc2_chunk_cache* cache, int64_t nchunk);
+
+/* Forget the chunk `nchunk` and renumber the next ones after deleting it */
+void chunk_cache_delete(blosc2_chunk_cache* cache, int64_t nchunk);
+
+/* Forget all the chunks */
+void chunk_cache_clear(blosc2_chunk_cache* cache);
+
+/* Get the number of hits and misses of `chunk_cache_get` */
+void chunk_cache_stats(blosc2_chunk_cache* cache, int64_t* hits, int64_t* misses);
+
+#endif  /* BLOSC_CHUNK_CACHE_H */
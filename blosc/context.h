@@ -33,6 +33,59 @@
   #include <ipps.h>
 #endif /* HAVE_IPP */
 
+/* Atomic operations on 32-bit integers shared among threads */
+#if defined(_MSC_VER) && !defined(__clang__)
+  #include <intrin.h>
+  #define BLOSC_ATOMIC_FETCH_ADD32(ptr, val) \
+    _InterlockedExchangeAdd((volatile long*)(ptr), (long)(val))
+  #define BLOSC_ATOMIC_LOAD32(ptr) _InterlockedOr((volatile long*)(ptr), 0)
+  #define BLOSC_ATOMIC_STORE32(ptr, val) \
+    _InterlockedExchange((volatile long*)(ptr), (long)(val))
+  #define BLOSC_ATOMIC_FETCH_ADD64(ptr, val) \
+    _InterlockedExchangeAdd64((volatile __int64*)(ptr), (__int64)(val))
+#else
+  #define BLOSC_ATOMIC_FETCH_ADD32(ptr, val) __atomic_fetch_add((ptr), (val), __ATOMIC_ACQ_REL)
+  #define BLOSC_ATOMIC_LOAD32(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+  #define BLOSC_ATOMIC_STORE32(ptr, val) __atomic_store_n((ptr), (val), __ATOMIC_RELEASE)
+  #define BLOSC_ATOMIC_FETCH_ADD64(ptr, val) __atomic_fetch_add((ptr), (val), __ATOMIC_ACQ_REL)
+#endif
+
+/* Performance counters (times in nanoseconds).  Every thread keeps its own ones,
+ * and adds them to the ones of the context at the end of a job. */
+typedef struct {
+  int64_t nchunks;
+  int64_t nblocks;
+  int64_t nbytes;
+  int64_t cbytes;
+  int64_t nmemcpyed;
+  int64_t lazy_nbytes;
+  int64_t lazy_nreads;
+  int64_t prefilter_ns;
+  int64_t filter_ns;
+  int64_t codec_ns;
+  int64_t memcpy_ns;
+  int64_t postfilter_ns;
+  int64_t wait_ns;
+  int64_t busy_ns;      // the time threads are running a job (for computing wait_ns)
+} blosc_stats;
+
+/* Minimum compressed size for compacting the blocks in parallel */
+#define BLOSC_MIN_PARALLEL_COMPACTION (1024 * 1024)
+
+/* The dictionary shared by the chunks of a super-chunk.  The pool of decompression
+ * contexts of the super-chunk keeps it, so that it is read (and digested) just once for
+ * all of them. */
+typedef struct {
+  void* buffer;
+  /* The dictionary (NULL until read) */
+  int32_t size;
+  /* The size of the dictionary */
+  int32_t id;
+  /* The id of the dictionary */
+  void* ddict;
+  /* The dictionary in digested form for decompression (a ZSTD_DDict, created on demand) */
+} blosc2_shared_dict;
+
 struct blosc2_context_s {
   const uint8_t* src;
   /* The source buffer */
@@ -79,19 +132,42 @@ struct blosc2_context_s {
   int use_dict;
   /* Whether to use dicts or not */
   void* dict_buffer;
-  /* The buffer to keep the trained dictionary */
+  /* The buffer to keep the trained dictionary (owned by the context if shared) */
   int32_t dict_size;
   /* The size of the trained dictionary */
   void* dict_cdict;
-  /* The dictionary in digested form for compression */
+  /* The dictionary in digested form for compression (a ZSTD_CDict, a LZ4_stream_t,
+   * a LZ4_streamHC_t, or just dict_buffer for BloscLZ) */
+  int dict_compcode;
+  /* The codec that dict_cdict is meant for */
   void* dict_ddict;
-  /* The dictionary in digested form for decompression */
+  /* The dictionary in digested form for decompression (ZSTD only) */
+  int32_t dict_id;
+  /* The id of the dictionary shared by the chunks of a super-chunk.  0 if none. */
+  bool dict_borrowed;
+  /* Whether dict_buffer and dict_ddict belong to the super-chunk (see blosc2_shared_dict) */
+  float probe_entropy;
+  /* Minimum entropy (bits per byte) for data to be taken as incompressible.  0 if no probe. */
+  bool probe_blocks;
+  /* Whether every block is probed too (not only the whole chunk) */
+  int32_t probe_nchunks;
+  /* The number of chunks that the probe found incompressible */
+  int32_t probe_nblocks;
+  /* The number of blocks (streams, actually) that the probe found incompressible */
+  blosc_stats stats;
+  /* The performance counters */
   uint8_t filter_flags;
   /* The filter flags in the filter pipeline */
   uint8_t filters[BLOSC2_MAX_FILTERS];
   /* the (sequence of) filters */
   uint8_t filters_meta[BLOSC2_MAX_FILTERS];
   /* the metainfo for filters */
+  bool auto_filter;
+  /* Whether the pipeline has a BLOSC_AUTO_FILTER (then `filters` are the ones of the last chunk) */
+  uint8_t auto_filters[BLOSC2_MAX_FILTERS];
+  /* The pipeline with the BLOSC_AUTO_FILTER that the filters of every chunk are chosen for */
+  struct blosc2_context_s* auto_cctx;
+  /* The context for the trials that choose the filters of a chunk */
   blosc2_filter urfilters[BLOSC2_MAX_UDFILTERS];
   /* The user-defined filters */
   blosc2_prefilter_fn prefilter;
@@ -110,6 +186,16 @@ struct blosc2_context_s {
    * the number of blocks in chunk) */
   blosc2_schunk* schunk;
   /* Associated super-chunk (if available) */
+  int32_t nchunk;
+  /* The chunk of @p schunk being decompressed; -1 means `schunk->current_nchunk` */
+  void* lazy_batch;
+  /* The reads in flight of the blocks of a lazy chunk (a frame_batch); NULL if none */
+  uint8_t* lazy_buffer;
+  /* Where the blocks of @p lazy_batch are read */
+  int64_t* lazy_boffsets;
+  /* The offset of every block in @p lazy_buffer */
+  int32_t* lazy_nreads;
+  /* The index of the read of every block in @p lazy_batch; -1 if it is not read */
   struct thread_context* serial_context;
   /* Cache for temporaries for serial operation */
   int do_compress;
@@ -125,7 +211,6 @@ struct blosc2_context_s {
   int16_t end_threads;
   pthread_t *threads;
   struct thread_context *thread_contexts; /* only for user-managed threads */
-  pthread_mutex_t count_mutex;
 #ifdef BLOSC_POSIX_BARRIERS
   pthread_barrier_t barr_init;
   pthread_barrier_t barr_finish;
@@ -140,6 +225,11 @@ struct blosc2_context_s {
   int thread_giveup_code;
   /* error code when give up */
   int thread_nblock;       /* block counter */
+  uint8_t* block_slots;    /* a slot per block for compressing in parallel */
+  size_t block_slots_nbytes;
+  int32_t* block_offsets;  /* sizes (then offsets in dest) of compressed blocks */
+  int32_t block_offsets_nitems;
+  int block_compaction;    /* 1 when threads are compacting the block slots */
   int dref_not_init;       /* data ref in delta not initialized */
   pthread_mutex_t delta_mutex;
   pthread_cond_t delta_cv;
@@ -162,6 +252,11 @@ struct thread_context {
 #ifdef HAVE_IPP
   Ipp8u* lz4_hash_table;
 #endif
+  /* The working streams for compressing with LZ4 and LZ4HC dictionaries */
+  void* lz4_stream;
+  void* lz4hc_stream;
+  /* The performance counters of the job being run */
+  blosc_stats stats;
 };
 
 
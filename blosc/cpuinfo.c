@@ -0,0 +1,407 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "cpuinfo.h"
+#include "allocator.h"
+#include "threadpool.h"
+
+#if defined(_WIN32)
+  #include <windows.h>
+#elif defined(__APPLE__)
+  #include <sys/types.h>
+  #include <sys/sysctl.h>
+#endif
+#if defined(_MSC_VER) && !defined(__clang__)
+  #include <intrin.h>     /* Needed for __cpuidex */
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+  #define HAVE_CPUID
+#endif
+
+
+/* The caches that automatic blocksizes are derived from */
+static blosc2_cpu_caches g_cpu_caches = {32 * 1024, 256 * 1024, 4 * 1024 * 1024, 1, 1};
+/* Whether g_cpu_caches has been detected or set by the user already */
+static bool g_cpu_caches_set = false;
+/* Whether g_cpu_caches has been set by the user */
+static bool g_cpu_caches_user = false;
+
+
+/* Keep the sizes of the caches of a `level`, shared by `ncores` cores */
+static void set_cache(blosc2_cpu_caches* caches, int level, int64_t size, int ncores) {
+  if (size <= 0 || size > INT32_MAX) {
+    return;
+  }
+  if (ncores < 1) {
+    ncores = 1;
+  }
+  switch (level) {
+    case 1:
+      caches->l1_size = (int32_t)(size / ncores);
+      break;
+    case 2:
+      caches->l2_size = (int32_t)(size / ncores);
+      break;
+    case 3:
+      caches->l3_size = (int32_t)size;
+      caches->l3_ncores = (int16_t)(ncores < INT16_MAX ? ncores : INT16_MAX);
+      break;
+    default:
+      break;
+  }
+}
+
+
+#if defined(__linux__)
+
+/* Read the first line of a sysfs file.  Returns false if it cannot be read. */
+static bool read_sysfs(const char* path, char* line, int maxlen) {
+  FILE* file = fopen(path, "r");
+  if (file == NULL) {
+    return false;
+  }
+  bool ok = fgets(line, maxlen, file) != NULL;
+  fclose(file);
+  if (ok) {
+    line[strcspn(line, "\n")] = '\0';
+  }
+  return ok;
+}
+
+/* Count the cpus in a list like "0-7,64-71" */
+static int count_cpu_list(const char* list) {
+  int ncpus = 0;
+  const char* p = list;
+  while (*p != '\0') {
+    char* end;
+    long first = strtol(p, &end, 10);
+    if (end == p) {
+      break;
+    }
+    long last = first;
+    if (*end == '-') {
+      p = end + 1;
+      last = strtol(p, &end, 10);
+    }
+    ncpus += (int)(last - first + 1);
+    p = (*end == ',') ? end + 1 : end;
+  }
+  return ncpus;
+}
+
+static bool detect_os(blosc2_cpu_caches* caches, bool* has_l3) {
+  char path[128];
+  char line[256];
+  int nthreads_core = 1;
+
+  if (read_sysfs("/sys/devices/system/cpu/cpu0/topology/thread_siblings_list", line, sizeof(line))) {
+    nthreads_core = count_cpu_list(line);
+    if (nthreads_core < 1) {
+      nthreads_core = 1;
+    }
+  }
+  int ncores = blosc_get_ncores() / nthreads_core;
+  caches->ncores = (int16_t)(ncores < 1 ? 1 : ncores);
+
+  bool found = false;
+  for (int index = 0; index < 16; index++) {
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/type", index);
+    if (!read_sysfs(path, line, sizeof(line))) {
+      break;
+    }
+    if (strcmp(line, "Instruction") == 0) {
+      continue;
+    }
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/level", index);
+    if (!read_sysfs(path, line, sizeof(line))) {
+      continue;
+    }
+    int level = (int)strtol(line, NULL, 10);
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/size", index);
+    if (!read_sysfs(path, line, sizeof(line))) {
+      continue;
+    }
+    char* unit;
+    int64_t size = strtol(line, &unit, 10);
+    switch (*unit) {
+      case 'K':
+        size *= 1024;
+        break;
+      case 'M':
+        size *= 1024 * 1024;
+        break;
+      case 'G':
+        size *= 1024 * 1024 * 1024;
+        break;
+      default:
+        break;
+    }
+    int ncores = 1;
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/shared_cpu_list", index);
+    if (read_sysfs(path, line, sizeof(line))) {
+      ncores = count_cpu_list(line) / nthreads_core;
+    }
+    set_cache(caches, level, size, ncores);
+    found = true;
+    if (level == 3) {
+      *has_l3 = true;
+    }
+    else if (level == 2 && !*has_l3) {
+      // The last-level cache, until an L3 shows up
+      set_cache(caches, 3, size, ncores);
+    }
+  }
+  return found;
+}
+
+#elif defined(__APPLE__)
+
+static int64_t read_sysctl(const char* name) {
+  int64_t value = 0;
+  size_t len = sizeof(value);
+  if (sysctlbyname(name, &value, &len, NULL, 0) != 0) {
+    return 0;
+  }
+  // Some of the values are 32-bit wide
+  if (len == sizeof(int32_t)) {
+    int32_t value32;
+    memcpy(&value32, &value, sizeof(value32));
+    value = value32;
+  }
+  return value;
+}
+
+static bool detect_os(blosc2_cpu_caches* caches, bool* has_l3) {
+  // The performance cores of hybrid CPUs come first
+  int64_t l1_size = read_sysctl("hw.perflevel0.l1dcachesize");
+  int64_t l2_size = read_sysctl("hw.perflevel0.l2cachesize");
+  int64_t l2_ncores = read_sysctl("hw.perflevel0.cpusperl2");
+  int64_t ncores = read_sysctl("hw.physicalcpu");
+  if (l1_size <= 0) {
+    l1_size = read_sysctl("hw.l1dcachesize");
+  }
+  if (l2_size <= 0) {
+    l2_size = read_sysctl("hw.l2cachesize");
+    l2_ncores = 1;
+  }
+  int64_t l3_size = read_sysctl("hw.l3cachesize");
+
+  if (ncores > 0) {
+    caches->ncores = (int16_t)(ncores < INT16_MAX ? ncores : INT16_MAX);
+  }
+  set_cache(caches, 1, l1_size, 1);
+  set_cache(caches, 2, l2_size, (int)l2_ncores);
+  if (l3_size > 0) {
+    // Tell the cores sharing it apart from the packages
+    int64_t npackages = read_sysctl("hw.packages");
+    set_cache(caches, 3, l3_size, (int)(npackages > 0 ? caches->ncores / npackages : caches->ncores));
+    *has_l3 = true;
+  }
+  else {
+    set_cache(caches, 3, l2_size, (int)l2_ncores);
+  }
+  return l1_size > 0 || l2_size > 0;
+}
+
+#elif defined(_WIN32)
+
+static int count_bits(ULONG_PTR mask) {
+  int n = 0;
+  for (; mask != 0; mask &= mask - 1) {
+    n++;
+  }
+  return n;
+}
+
+static bool detect_os(blosc2_cpu_caches* caches, bool* has_l3) {
+  DWORD len = 0;
+  GetLogicalProcessorInformation(NULL, &len);
+  if (len == 0) {
+    return false;
+  }
+  SYSTEM_LOGICAL_PROCESSOR_INFORMATION* infos = blosc_malloc(len);
+  if (infos == NULL) {
+    return false;
+  }
+  if (!GetLogicalProcessorInformation(infos, &len)) {
+    blosc_free(infos);
+    return false;
+  }
+  int ninfos = (int)(len / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+  int ncores = 0;
+  int nthreads_core = 1;
+  for (int i = 0; i < ninfos; i++) {
+    if (infos[i].Relationship == RelationProcessorCore) {
+      if (ncores == 0) {
+        nthreads_core = count_bits(infos[i].ProcessorMask);
+      }
+      ncores++;
+    }
+  }
+  if (ncores > 0) {
+    caches->ncores = (int16_t)(ncores < INT16_MAX ? ncores : INT16_MAX);
+  }
+  // Keep the first cache of every level
+  bool seen[4] = {false, false, false, false};
+  bool found = false;
+  for (int i = 0; i < ninfos; i++) {
+    CACHE_DESCRIPTOR* cache = &infos[i].Cache;
+    if (infos[i].Relationship != RelationCache || cache->Type == CacheInstruction ||
+        cache->Type == CacheTrace || cache->Level < 1 || cache->Level > 3 || seen[cache->Level]) {
+      continue;
+    }
+    seen[cache->Level] = true;
+    int sharing = count_bits(infos[i].ProcessorMask) / nthreads_core;
+    set_cache(caches, cache->Level, cache->Size, sharing);
+    if (cache->Level == 3) {
+      *has_l3 = true;
+    }
+    else if (cache->Level == 2 && !*has_l3) {
+      set_cache(caches, 3, cache->Size, sharing);
+    }
+    found = true;
+  }
+  blosc_free(infos);
+  return found;
+}
+
+#else
+
+static bool detect_os(blosc2_cpu_caches* caches, bool* has_l3) {
+  (void)caches;
+  (void)has_l3;
+  return false;
+}
+
+#endif
+
+
+#if defined(HAVE_CPUID)
+
+static void cpuid(int32_t regs[4], int32_t leaf, int32_t subleaf) {
+#if defined(_MSC_VER) && !defined(__clang__)
+  __cpuidex(regs, leaf, subleaf);
+#elif defined(__i386__) && defined(__PIC__)
+  /* ebx cannot be clobbered with PIC under 32-bit */
+  __asm__ __volatile__ ("movl %%ebx, %%edi\n\tcpuid\n\txchgl %%ebx, %%edi"
+                        : "=D" (regs[1]), "=a" (regs[0]), "=c" (regs[2]), "=d" (regs[3])
+                        : "a" (leaf), "c" (subleaf));
+#else
+  __asm__ __volatile__ ("cpuid"
+                        : "=b" (regs[1]), "=a" (regs[0]), "=c" (regs[2]), "=d" (regs[3])
+                        : "a" (leaf), "c" (subleaf));
+#endif
+}
+
+/* The deterministic cache parameters of Intel (leaf 4) and AMD (leaf 0x8000001D) */
+static bool detect_cpuid(blosc2_cpu_caches* caches, bool* has_l3) {
+  int32_t regs[4];
+  int32_t leaf;
+
+  cpuid(regs, 0, 0);
+  int32_t max_leaf = regs[0];
+  cpuid(regs, (int32_t)0x80000000, 0);
+  int32_t max_ext_leaf = regs[0];
+  if (max_leaf >= 4) {
+    leaf = 4;
+  }
+  else if ((uint32_t)max_ext_leaf >= 0x8000001D) {
+    leaf = (int32_t)0x8000001D;
+  }
+  else {
+    return false;
+  }
+
+  bool found = false;
+  int nthreads_core = 1;
+  for (int32_t index = 0; index < 16; index++) {
+    cpuid(regs, leaf, index);
+    int type = regs[0] & 0x1F;
+    if (type == 0) {
+      break;
+    }
+    if (type == 2) {
+      // Instruction cache
+      continue;
+    }
+    int level = (regs[0] >> 5) & 0x7;
+    int nthreads = ((regs[0] >> 14) & 0xFFF) + 1;
+    int64_t ways = ((regs[1] >> 22) & 0x3FF) + 1;
+    int64_t partitions = ((regs[1] >> 12) & 0x3FF) + 1;
+    int64_t line_size = (regs[1] & 0xFFF) + 1;
+    int64_t sets = (int64_t)(uint32_t)regs[2] + 1;
+    if (level == 1) {
+      // The L1 is shared by the threads of a core only
+      nthreads_core = nthreads;
+    }
+    int sharing = nthreads / nthreads_core;
+    set_cache(caches, level, ways * partitions * line_size * sets, sharing);
+    if (level == 3) {
+      *has_l3 = true;
+    }
+    else if (level == 2 && !*has_l3) {
+      set_cache(caches, 3, ways * partitions * line_size * sets, sharing);
+    }
+    found = true;
+  }
+  return found;
+}
+
+#endif  /* HAVE_CPUID */
+
+
+void blosc_cpu_caches_detect(blosc2_cpu_caches* caches) {
+  *caches = BLOSC2_CPU_CACHES_DEFAULTS;
+  bool has_l3 = false;
+  if (!detect_os(caches, &has_l3)) {
+#if defined(HAVE_CPUID)
+    detect_cpuid(caches, &has_l3);
+#endif
+    if (caches->ncores == 1) {
+      caches->ncores = (int16_t)blosc_get_ncores();
+    }
+  }
+}
+
+
+void blosc_cpu_caches_init(void) {
+  if (!g_cpu_caches_set) {
+    blosc_cpu_caches_detect(&g_cpu_caches);
+    g_cpu_caches_set = true;
+  }
+}
+
+
+void blosc_cpu_caches_set(const blosc2_cpu_caches* caches, bool user) {
+  if (caches == NULL) {
+    blosc_cpu_caches_detect(&g_cpu_caches);
+  }
+  else {
+    g_cpu_caches = *caches;
+  }
+  g_cpu_caches_set = true;
+  g_cpu_caches_user = caches != NULL && user;
+}
+
+
+const blosc2_cpu_caches* blosc_cpu_caches_get(void) {
+  return &g_cpu_caches;
+}
+
+
+bool blosc_cpu_caches_user(void) {
+  return g_cpu_caches_user;
+}
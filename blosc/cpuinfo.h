@@ -0,0 +1,36 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#ifndef BLOSC_CPUINFO_H
+#define BLOSC_CPUINFO_H
+
+#include "blosc2.h"
+
+#include <stdbool.h>
+
+/* Fill `caches` with the caches of the host, as told by the OS (sysfs, sysctl or
+ * GetLogicalProcessorInformation) or by CPUID.  The sizes that cannot be detected
+ * are left to BLOSC2_CPU_CACHES_DEFAULTS. */
+void blosc_cpu_caches_detect(blosc2_cpu_caches* caches);
+
+/* Detect the caches of the host, unless they have been set by the user already */
+void blosc_cpu_caches_init(void);
+
+/* Set the caches that automatic blocksizes are derived from (NULL means the detected ones).
+ * Unless `user` is true, they are taken as if they were detected (e.g. for faking a host). */
+void blosc_cpu_caches_set(const blosc2_cpu_caches* caches, bool user);
+
+/* The caches that automatic blocksizes are derived from */
+const blosc2_cpu_caches* blosc_cpu_caches_get(void);
+
+/* Whether the caches have been set by the user (instead of detected) */
+bool blosc_cpu_caches_user(void);
+
+#endif  /* BLOSC_CPUINFO_H */
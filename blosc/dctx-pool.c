@@ -0,0 +1,108 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#include <stdlib.h>
+
+#include "dctx-pool.h"
+#include "context.h"
+
+#if defined(_WIN32) && !defined(__GNUC__)
+  #include "win32/pthread.h"
+#else
+  #include <pthread.h>
+#endif
+
+/* The contexts beyond this are freed when given back, instead of being kept idle */
+#define DCTX_POOL_MAX 16
+
+
+struct blosc2_dctx_pool_s {
+  blosc2_context* idle[DCTX_POOL_MAX];
+  int nidle;
+  pthread_mutex_t mutex;
+  blosc2_shared_dict dict;
+  pthread_mutex_t dict_mutex;
+};
+
+
+blosc2_dctx_pool* dctx_pool_new(void) {
+  blosc2_dctx_pool* pool = calloc(1, sizeof(blosc2_dctx_pool));
+  if (pool == NULL) {
+    return NULL;
+  }
+  pthread_mutex_init(&pool->mutex, NULL);
+  pthread_mutex_init(&pool->dict_mutex, NULL);
+  return pool;
+}
+
+
+void dctx_pool_free(blosc2_dctx_pool* pool) {
+  dctx_pool_clear(pool);
+  free_shared_dict(&pool->dict);
+  pthread_mutex_destroy(&pool->mutex);
+  pthread_mutex_destroy(&pool->dict_mutex);
+  free(pool);
+}
+
+
+blosc2_context* dctx_pool_take(blosc2_dctx_pool* pool, blosc2_dparams dparams) {
+  pthread_mutex_lock(&pool->mutex);
+  for (int i = pool->nidle - 1; i >= 0; i--) {
+    blosc2_context* dctx = pool->idle[i];
+    if (dctx->nthreads == dparams.nthreads) {
+      pool->idle[i] = pool->idle[--pool->nidle];
+      pthread_mutex_unlock(&pool->mutex);
+      return dctx;
+    }
+  }
+  pthread_mutex_unlock(&pool->mutex);
+
+  return blosc2_create_dctx(dparams);
+}
+
+
+void dctx_pool_give(blosc2_dctx_pool* pool, blosc2_context* dctx) {
+  pthread_mutex_lock(&pool->mutex);
+  if (pool->nidle < DCTX_POOL_MAX) {
+    pool->idle[pool->nidle++] = dctx;
+    dctx = NULL;
+  }
+  pthread_mutex_unlock(&pool->mutex);
+  if (dctx != NULL) {
+    blosc2_free_ctx(dctx);
+  }
+}
+
+
+void dctx_pool_clear(blosc2_dctx_pool* pool) {
+  pthread_mutex_lock(&pool->mutex);
+  int nidle = pool->nidle;
+  blosc2_context* idle[DCTX_POOL_MAX];
+  for (int i = 0; i < nidle; i++) {
+    idle[i] = pool->idle[i];
+  }
+  pool->nidle = 0;
+  pthread_mutex_unlock(&pool->mutex);
+
+  for (int i = 0; i < nidle; i++) {
+    blosc2_free_ctx(idle[i]);
+  }
+}
+
+
+blosc2_shared_dict* dctx_pool_lock_dict(blosc2_dctx_pool* pool) {
+  pthread_mutex_lock(&pool->dict_mutex);
+  return &pool->dict;
+}
+
+
+void dctx_pool_unlock_dict(blosc2_dctx_pool* pool) {
+  pthread_mutex_unlock(&pool->dict_mutex);
+}
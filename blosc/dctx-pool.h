@@ -0,0 +1,47 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#ifndef BLOSC_DCTX_POOL_H
+#define BLOSC_DCTX_POOL_H
+
+#include "blosc2.h"
+#include "context.h"
+
+/* A pool of idle decompression contexts of a super-chunk, so that concurrent readers
+ * do not share (nor create at every call) a context.  All the functions are thread-safe. */
+
+/* Create an empty pool */
+blosc2_dctx_pool* dctx_pool_new(void);
+
+/* Free the pool and all its idle contexts */
+void dctx_pool_free(blosc2_dctx_pool* pool);
+
+/* Get an idle context with `dparams.nthreads` threads, or create a new one from `dparams`.
+ * Returns NULL if the context cannot be created. */
+blosc2_context* dctx_pool_take(blosc2_dctx_pool* pool, blosc2_dparams dparams);
+
+/* Return a context got with `dctx_pool_take` to the pool */
+void dctx_pool_give(blosc2_dctx_pool* pool, blosc2_context* dctx);
+
+/* Free all the idle contexts (because the decompression parameters have changed) */
+void dctx_pool_clear(blosc2_dctx_pool* pool);
+
+/* Lock the dictionary shared by the chunks of the super-chunk, for reading or loading it.
+ * It stays in the pool until this is freed. */
+blosc2_shared_dict* dctx_pool_lock_dict(blosc2_dctx_pool* pool);
+
+/* Unlock the dictionary locked with `dctx_pool_lock_dict` */
+void dctx_pool_unlock_dict(blosc2_dctx_pool* pool);
+
+/* Free a dictionary shared by the chunks of a super-chunk (implemented in blosc2.c,
+ * next to the other dictionary functions) */
+void free_shared_dict(blosc2_shared_dict* dict);
+
+#endif  /* BLOSC_DCTX_POOL_H */
@@ -0,0 +1,201 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#include "delta-generic.h"
+#include "delta-avx2.h"
+
+/* Make sure AVX2 is available for the compilation target and compiler. */
+#if !defined(__AVX2__)
+  #error AVX2 is not supported by the target architecture/platform and/or this compiler.
+#endif
+
+#include <immintrin.h>
+
+
+/* Combine the elements in a and b (XOR or wrapping addition). */
+static inline __m256i delta_op(const __m256i a, const __m256i b,
+                               const int32_t typesize, const bool xor_op) {
+  if (xor_op) {
+    return _mm256_xor_si256(a, b);
+  }
+  switch (typesize) {
+    case 1:
+      return _mm256_add_epi8(a, b);
+    case 2:
+      return _mm256_add_epi16(a, b);
+    case 4:
+      return _mm256_add_epi32(a, b);
+    default:
+      return _mm256_add_epi64(a, b);
+  }
+}
+
+/* Subtract the elements in b from the ones in a (wrapping around). */
+static inline __m256i delta_sub_op(const __m256i a, const __m256i b, const int32_t typesize) {
+  switch (typesize) {
+    case 1:
+      return _mm256_sub_epi8(a, b);
+    case 2:
+      return _mm256_sub_epi16(a, b);
+    case 4:
+      return _mm256_sub_epi32(a, b);
+    default:
+      return _mm256_sub_epi64(a, b);
+  }
+}
+
+/* Broadcast the last element of each 128-bit lane inside the lane. */
+static inline __m256i delta_bcast_lane_last(__m256i x, const int32_t typesize) {
+  switch (typesize) {
+    case 1:
+      return _mm256_shuffle_epi8(x, _mm256_set1_epi8(15));
+    case 2:
+      x = _mm256_shufflehi_epi16(x, 0xFF);
+      return _mm256_unpackhi_epi64(x, x);
+    case 4:
+      return _mm256_shuffle_epi32(x, 0xFF);
+    default:
+      return _mm256_unpackhi_epi64(x, x);
+  }
+}
+
+/* Inclusive scan of the elements inside a vector (log-step). */
+static inline __m256i delta_scan_vector(__m256i x, const int32_t typesize, const bool xor_op) {
+  /* Shifts in AVX2 work inside each 128-bit lane, so scan the lanes first... */
+  switch (typesize) {
+    case 1:
+      x = delta_op(x, _mm256_slli_si256(x, 1), typesize, xor_op);
+      /* fall through */
+    case 2:
+      x = delta_op(x, _mm256_slli_si256(x, 2), typesize, xor_op);
+      /* fall through */
+    case 4:
+      x = delta_op(x, _mm256_slli_si256(x, 4), typesize, xor_op);
+      /* fall through */
+    default:
+      x = delta_op(x, _mm256_slli_si256(x, 8), typesize, xor_op);
+  }
+  /* ...and then carry the last element of the low lane into the high one */
+  __m256i low = delta_bcast_lane_last(x, typesize);
+  low = _mm256_permute2x128_si256(low, low, 0x08);
+  return delta_op(x, low, typesize, xor_op);
+}
+
+/* Broadcast the last element in a vector. */
+static inline __m256i delta_bcast_last(__m256i x, const int32_t typesize) {
+  x = _mm256_permute2x128_si256(x, x, 0x11);
+  return delta_bcast_lane_last(x, typesize);
+}
+
+static inline void delta_scan_avx2_inline(const int32_t typesize, const bool xor_op,
+                                          const int32_t nelems,
+                                          const uint8_t *src, uint8_t *dest) {
+  const int32_t nbytes = nelems * typesize;
+  __m256i carry = _mm256_setzero_si256();
+  int32_t j;
+
+  for (j = 0; j + (int32_t)sizeof(__m256i) <= nbytes; j += (int32_t)sizeof(__m256i)) {
+    __m256i x = _mm256_loadu_si256((const __m256i *)(src + j));
+    x = delta_scan_vector(x, typesize, xor_op);
+    x = delta_op(x, carry, typesize, xor_op);
+    _mm256_storeu_si256((__m256i *)(dest + j), x);
+    carry = delta_bcast_last(x, typesize);
+  }
+  delta_scan_generic_inline(typesize, xor_op, j / typesize, nelems, src, dest);
+}
+
+static inline void delta_sub_avx2_inline(const int32_t typesize, const int32_t nelems,
+                                         const uint8_t *src, uint8_t *dest) {
+  const int32_t nbytes = nelems * typesize;
+  int32_t j;
+
+  if (nelems <= 0) {
+    return;
+  }
+  memcpy(dest, src, typesize);
+  for (j = typesize; j + (int32_t)sizeof(__m256i) <= nbytes; j += (int32_t)sizeof(__m256i)) {
+    __m256i a = _mm256_loadu_si256((const __m256i *)(src + j));
+    __m256i b = _mm256_loadu_si256((const __m256i *)(src + j - typesize));
+    _mm256_storeu_si256((__m256i *)(dest + j), delta_sub_op(a, b, typesize));
+  }
+  delta_sub_generic_inline(typesize, j / typesize, nelems, src, dest);
+}
+
+
+/* XOR of two buffers */
+void delta_xor_avx2(const int32_t nbytes, const uint8_t *src,
+                    const uint8_t *ref, uint8_t *dest) {
+  int32_t j;
+  for (j = 0; j + (int32_t)sizeof(__m256i) <= nbytes; j += (int32_t)sizeof(__m256i)) {
+    __m256i a = _mm256_loadu_si256((const __m256i *)(src + j));
+    __m256i b = _mm256_loadu_si256((const __m256i *)(ref + j));
+    _mm256_storeu_si256((__m256i *)(dest + j), _mm256_xor_si256(a, b));
+  }
+  delta_xor_generic_inline(j, nbytes, src, ref, dest);
+}
+
+/* Inclusive prefix scan of the elements in src */
+void delta_scan_avx2(const int32_t typesize, const bool xor_op, const int32_t nelems,
+                     const uint8_t *src, uint8_t *dest) {
+  /* Dispatch with constant arguments so that the inlined kernels get specialized */
+  switch (typesize) {
+    case 1:
+      if (xor_op) {
+        delta_scan_avx2_inline(1, true, nelems, src, dest);
+      } else {
+        delta_scan_avx2_inline(1, false, nelems, src, dest);
+      }
+      break;
+    case 2:
+      if (xor_op) {
+        delta_scan_avx2_inline(2, true, nelems, src, dest);
+      } else {
+        delta_scan_avx2_inline(2, false, nelems, src, dest);
+      }
+      break;
+    case 4:
+      if (xor_op) {
+        delta_scan_avx2_inline(4, true, nelems, src, dest);
+      } else {
+        delta_scan_avx2_inline(4, false, nelems, src, dest);
+      }
+      break;
+    case 8:
+      if (xor_op) {
+        delta_scan_avx2_inline(8, true, nelems, src, dest);
+      } else {
+        delta_scan_avx2_inline(8, false, nelems, src, dest);
+      }
+      break;
+    default:
+      delta_scan_generic_inline(typesize, xor_op, 0, nelems, src, dest);
+  }
+}
+
+/* Subtraction of the preceding element */
+void delta_sub_avx2(const int32_t typesize, const int32_t nelems,
+                    const uint8_t *src, uint8_t *dest) {
+  switch (typesize) {
+    case 1:
+      delta_sub_avx2_inline(1, nelems, src, dest);
+      break;
+    case 2:
+      delta_sub_avx2_inline(2, nelems, src, dest);
+      break;
+    case 4:
+      delta_sub_avx2_inline(4, nelems, src, dest);
+      break;
+    case 8:
+      delta_sub_avx2_inline(8, nelems, src, dest);
+      break;
+    default:
+      delta_sub_generic_inline(typesize, 0, nelems, src, dest);
+  }
+}
@@ -0,0 +1,140 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+/*********************************************************************
+  Generic (non-hardware-accelerated) delta routines.
+  These are used when hardware-accelerated functions aren't available
+  for a particular platform; they are also used by the hardware-
+  accelerated functions to handle any remaining elements in a block
+  which isn't a multiple of the hardware's vector size.
+
+  All the routines work on elements of 1, 2, 4 or 8 bytes
+  (`typesize`); the caller is in charge of mapping other type sizes.
+**********************************************************************/
+
+
+#ifndef BLOSC_DELTA_GENERIC_H
+#define BLOSC_DELTA_GENERIC_H
+
+#include "blosc2/blosc2-common.h"
+#include <stdbool.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+  XOR the bytes of `src` and `ref` into `dest`, starting at byte `start`.
+  `dest` can be the same buffer than `src` or `ref`.
+*/
+inline static void delta_xor_generic_inline(const int32_t start, const int32_t nbytes,
+                                            const uint8_t *src, const uint8_t *ref, uint8_t *dest) {
+  for (int32_t i = start; i < nbytes; i++) {
+    dest[i] = src[i] ^ ref[i];
+  }
+}
+
+/**
+  Inclusive prefix scan (XOR when `xor_op` is true, wrapping addition
+  otherwise) of the `nelems` elements in `src`, starting at element `start`.
+  The elements before `start` in `dest` must be already scanned.
+  `dest` can be the same buffer than `src`.
+*/
+inline static void delta_scan_generic_inline(const int32_t typesize, const bool xor_op,
+                                             int32_t start, const int32_t nelems,
+                                             const uint8_t *src, uint8_t *dest) {
+  int32_t i;
+  if (nelems <= 0) {
+    return;
+  }
+  if (start == 0) {
+    memcpy(dest, src, typesize);
+    start = 1;
+  }
+  switch (typesize) {
+    case 1:
+      for (i = start; i < nelems; i++) {
+        dest[i] = xor_op ? src[i] ^ dest[i-1] : (uint8_t)(src[i] + dest[i-1]);
+      }
+      break;
+    case 2:
+      for (i = start; i < nelems; i++) {
+        ((uint16_t *)dest)[i] = xor_op ?
+                ((uint16_t *)src)[i] ^ ((uint16_t *)dest)[i-1] :
+                (uint16_t)(((uint16_t *)src)[i] + ((uint16_t *)dest)[i-1]);
+      }
+      break;
+    case 4:
+      for (i = start; i < nelems; i++) {
+        ((uint32_t *)dest)[i] = xor_op ?
+                ((uint32_t *)src)[i] ^ ((uint32_t *)dest)[i-1] :
+                ((uint32_t *)src)[i] + ((uint32_t *)dest)[i-1];
+      }
+      break;
+    case 8:
+      for (i = start; i < nelems; i++) {
+        ((uint64_t *)dest)[i] = xor_op ?
+                ((uint64_t *)src)[i] ^ ((uint64_t *)dest)[i-1] :
+                ((uint64_t *)src)[i] + ((uint64_t *)dest)[i-1];
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+  Subtract from each of the `nelems` elements in `src` its preceding element
+  (wrapping around), starting at element `start`.  The first element in the
+  block is copied verbatim.  `dest` cannot be the same buffer than `src`.
+*/
+inline static void delta_sub_generic_inline(const int32_t typesize, int32_t start,
+                                            const int32_t nelems,
+                                            const uint8_t *src, uint8_t *dest) {
+  int32_t i;
+  if (nelems <= 0) {
+    return;
+  }
+  if (start == 0) {
+    memcpy(dest, src, typesize);
+    start = 1;
+  }
+  switch (typesize) {
+    case 1:
+      for (i = start; i < nelems; i++) {
+        dest[i] = (uint8_t)(src[i] - src[i-1]);
+      }
+      break;
+    case 2:
+      for (i = start; i < nelems; i++) {
+        ((uint16_t *)dest)[i] = (uint16_t)(((uint16_t *)src)[i] - ((uint16_t *)src)[i-1]);
+      }
+      break;
+    case 4:
+      for (i = start; i < nelems; i++) {
+        ((uint32_t *)dest)[i] = ((uint32_t *)src)[i] - ((uint32_t *)src)[i-1];
+      }
+      break;
+    case 8:
+      for (i = start; i < nelems; i++) {
+        ((uint64_t *)dest)[i] = ((uint64_t *)src)[i] - ((uint64_t *)src)[i-1];
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLOSC_DELTA_GENERIC_H */
@@ -0,0 +1,190 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#include "delta-generic.h"
+#include "delta-neon.h"
+
+/* Make sure NEON is available for the compilation target and compiler. */
+#if !defined(__ARM_NEON)
+#error NEON is not supported by the target architecture/platform and/or this compiler.
+#endif
+
+#include <arm_neon.h>
+
+
+/* Combine the elements in a and b (XOR or wrapping addition). */
+static inline uint8x16_t delta_op(const uint8x16_t a, const uint8x16_t b,
+                                  const int32_t typesize, const bool xor_op) {
+  if (xor_op) {
+    return veorq_u8(a, b);
+  }
+  switch (typesize) {
+    case 1:
+      return vaddq_u8(a, b);
+    case 2:
+      return vreinterpretq_u8_u16(vaddq_u16(vreinterpretq_u16_u8(a), vreinterpretq_u16_u8(b)));
+    case 4:
+      return vreinterpretq_u8_u32(vaddq_u32(vreinterpretq_u32_u8(a), vreinterpretq_u32_u8(b)));
+    default:
+      return vreinterpretq_u8_u64(vaddq_u64(vreinterpretq_u64_u8(a), vreinterpretq_u64_u8(b)));
+  }
+}
+
+/* Subtract the elements in b from the ones in a (wrapping around). */
+static inline uint8x16_t delta_sub_op(const uint8x16_t a, const uint8x16_t b, const int32_t typesize) {
+  switch (typesize) {
+    case 1:
+      return vsubq_u8(a, b);
+    case 2:
+      return vreinterpretq_u8_u16(vsubq_u16(vreinterpretq_u16_u8(a), vreinterpretq_u16_u8(b)));
+    case 4:
+      return vreinterpretq_u8_u32(vsubq_u32(vreinterpretq_u32_u8(a), vreinterpretq_u32_u8(b)));
+    default:
+      return vreinterpretq_u8_u64(vsubq_u64(vreinterpretq_u64_u8(a), vreinterpretq_u64_u8(b)));
+  }
+}
+
+/* Inclusive scan of the elements inside a vector (log-step). */
+static inline uint8x16_t delta_scan_vector(uint8x16_t x, const int32_t typesize, const bool xor_op) {
+  const uint8x16_t zero = vdupq_n_u8(0);
+  /* vextq_u8(zero, x, 16 - n) shifts x by n bytes towards the higher addresses */
+  switch (typesize) {
+    case 1:
+      x = delta_op(x, vextq_u8(zero, x, 15), typesize, xor_op);
+      /* fall through */
+    case 2:
+      x = delta_op(x, vextq_u8(zero, x, 14), typesize, xor_op);
+      /* fall through */
+    case 4:
+      x = delta_op(x, vextq_u8(zero, x, 12), typesize, xor_op);
+      /* fall through */
+    default:
+      x = delta_op(x, vextq_u8(zero, x, 8), typesize, xor_op);
+  }
+  return x;
+}
+
+/* Broadcast the last element in a vector. */
+static inline uint8x16_t delta_bcast_last(const uint8x16_t x, const int32_t typesize) {
+  switch (typesize) {
+    case 1:
+      return vdupq_n_u8(vgetq_lane_u8(x, 15));
+    case 2:
+      return vreinterpretq_u8_u16(vdupq_n_u16(vgetq_lane_u16(vreinterpretq_u16_u8(x), 7)));
+    case 4:
+      return vreinterpretq_u8_u32(vdupq_n_u32(vgetq_lane_u32(vreinterpretq_u32_u8(x), 3)));
+    default:
+      return vreinterpretq_u8_u64(vdupq_n_u64(vgetq_lane_u64(vreinterpretq_u64_u8(x), 1)));
+  }
+}
+
+static inline void delta_scan_neon_inline(const int32_t typesize, const bool xor_op,
+                                          const int32_t nelems,
+                                          const uint8_t *src, uint8_t *dest) {
+  const int32_t nbytes = nelems * typesize;
+  uint8x16_t carry = vdupq_n_u8(0);
+  int32_t j;
+
+  for (j = 0; j + 16 <= nbytes; j += 16) {
+    uint8x16_t x = vld1q_u8(src + j);
+    x = delta_scan_vector(x, typesize, xor_op);
+    x = delta_op(x, carry, typesize, xor_op);
+    vst1q_u8(dest + j, x);
+    carry = delta_bcast_last(x, typesize);
+  }
+  delta_scan_generic_inline(typesize, xor_op, j / typesize, nelems, src, dest);
+}
+
+static inline void delta_sub_neon_inline(const int32_t typesize, const int32_t nelems,
+                                         const uint8_t *src, uint8_t *dest) {
+  const int32_t nbytes = nelems * typesize;
+  int32_t j;
+
+  if (nelems <= 0) {
+    return;
+  }
+  memcpy(dest, src, typesize);
+  for (j = typesize; j + 16 <= nbytes; j += 16) {
+    uint8x16_t a = vld1q_u8(src + j);
+    uint8x16_t b = vld1q_u8(src + j - typesize);
+    vst1q_u8(dest + j, delta_sub_op(a, b, typesize));
+  }
+  delta_sub_generic_inline(typesize, j / typesize, nelems, src, dest);
+}
+
+
+/* XOR of two buffers */
+void delta_xor_neon(const int32_t nbytes, const uint8_t *src,
+                    const uint8_t *ref, uint8_t *dest) {
+  int32_t j;
+  for (j = 0; j + 16 <= nbytes; j += 16) {
+    vst1q_u8(dest + j, veorq_u8(vld1q_u8(src + j), vld1q_u8(ref + j)));
+  }
+  delta_xor_generic_inline(j, nbytes, src, ref, dest);
+}
+
+/* Inclusive prefix scan of the elements in src */
+void delta_scan_neon(const int32_t typesize, const bool xor_op, const int32_t nelems,
+                     const uint8_t *src, uint8_t *dest) {
+  /* Dispatch with constant arguments so that the inlined kernels get specialized */
+  switch (typesize) {
+    case 1:
+      if (xor_op) {
+        delta_scan_neon_inline(1, true, nelems, src, dest);
+      } else {
+        delta_scan_neon_inline(1, false, nelems, src, dest);
+      }
+      break;
+    case 2:
+      if (xor_op) {
+        delta_scan_neon_inline(2, true, nelems, src, dest);
+      } else {
+        delta_scan_neon_inline(2, false, nelems, src, dest);
+      }
+      break;
+    case 4:
+      if (xor_op) {
+        delta_scan_neon_inline(4, true, nelems, src, dest);
+      } else {
+        delta_scan_neon_inline(4, false, nelems, src, dest);
+      }
+      break;
+    case 8:
+      if (xor_op) {
+        delta_scan_neon_inline(8, true, nelems, src, dest);
+      } else {
+        delta_scan_neon_inline(8, false, nelems, src, dest);
+      }
+      break;
+    default:
+      delta_scan_generic_inline(typesize, xor_op, 0, nelems, src, dest);
+  }
+}
+
+/* Subtraction of the preceding element */
+void delta_sub_neon(const int32_t typesize, const int32_t nelems,
+                    const uint8_t *src, uint8_t *dest) {
+  switch (typesize) {
+    case 1:
+      delta_sub_neon_inline(1, nelems, src, dest);
+      break;
+    case 2:
+      delta_sub_neon_inline(2, nelems, src, dest);
+      break;
+    case 4:
+      delta_sub_neon_inline(4, nelems, src, dest);
+      break;
+    case 8:
+      delta_sub_neon_inline(8, nelems, src, dest);
+      break;
+    default:
+      delta_sub_generic_inline(typesize, 0, nelems, src, dest);
+  }
+}
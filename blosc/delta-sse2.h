@@ -0,0 +1,45 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+/* SSE2-accelerated delta routines. */
+
+#ifndef BLOSC_DELTA_SSE2_H
+#define BLOSC_DELTA_SSE2_H
+
+#include "blosc2/blosc2-common.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+  SSE2-accelerated XOR of two buffers.
+*/
+BLOSC_NO_EXPORT void delta_xor_sse2(const int32_t nbytes, const uint8_t *src,
+                                    const uint8_t *ref, uint8_t *dest);
+
+/**
+  SSE2-accelerated inclusive prefix scan (XOR or wrapping addition).
+*/
+BLOSC_NO_EXPORT void delta_scan_sse2(const int32_t typesize, const bool xor_op, const int32_t nelems,
+                                     const uint8_t *src, uint8_t *dest);
+
+/**
+  SSE2-accelerated subtraction of the preceding element.
+*/
+BLOSC_NO_EXPORT void delta_sub_sse2(const int32_t typesize, const int32_t nelems,
+                                    const uint8_t *src, uint8_t *dest);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLOSC_DELTA_SSE2_H */
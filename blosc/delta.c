@@ -11,82 +11,154 @@
 #include <stdio.h>
 #include "blosc2.h"
 #include "delta.h"
+#include "delta-generic.h"
+#include "shuffle.h"
+
+#if defined(DELTA_AVX2_ENABLED)
+  #include "delta-avx2.h"
+#endif  /* defined(DELTA_AVX2_ENABLED) */
+
+#if defined(DELTA_SSE2_ENABLED)
+  #include "delta-sse2.h"
+#endif  /* defined(DELTA_SSE2_ENABLED) */
+
+#if defined(DELTA_NEON_ENABLED)
+  #include "delta-neon.h"
+#endif  /* defined(DELTA_NEON_ENABLED) */
+
+
+/*  Define function pointer types for the delta routines. */
+typedef void(* delta_xor_func)(const int32_t, const uint8_t*, const uint8_t*, uint8_t*);
+typedef void(* delta_scan_func)(const int32_t, const bool, const int32_t, const uint8_t*, uint8_t*);
+typedef void(* delta_sub_func)(const int32_t, const int32_t, const uint8_t*, uint8_t*);
+
+/* An implementation of the delta routines. */
+typedef struct delta_implementation {
+  /* Name of this implementation. */
+  const char* name;
+  /* Function pointer to the XOR of two buffers. */
+  delta_xor_func xor_buffers;
+  /* Function pointer to the inclusive (XOR or addition) prefix scan. */
+  delta_scan_func scan;
+  /* Function pointer to the subtraction of the preceding element. */
+  delta_sub_func sub;
+} delta_implementation_t;
+
+
+static void delta_xor_generic(const int32_t nbytes, const uint8_t* src,
+                              const uint8_t* ref, uint8_t* dest) {
+  delta_xor_generic_inline(0, nbytes, src, ref, dest);
+}
+
+static void delta_scan_generic(const int32_t typesize, const bool xor_op, const int32_t nelems,
+                               const uint8_t* src, uint8_t* dest) {
+  delta_scan_generic_inline(typesize, xor_op, 0, nelems, src, dest);
+}
+
+static void delta_sub_generic(const int32_t typesize, const int32_t nelems,
+                              const uint8_t* src, uint8_t* dest) {
+  delta_sub_generic_inline(typesize, 0, nelems, src, dest);
+}
+
+
+static delta_implementation_t get_delta_implementation(void) {
+  blosc_cpu_features cpu_features = blosc_get_cpu_features();
+#if defined(DELTA_AVX2_ENABLED)
+  if (cpu_features & BLOSC_HAVE_AVX2) {
+    delta_implementation_t impl_avx2;
+    impl_avx2.name = "avx2";
+    impl_avx2.xor_buffers = delta_xor_avx2;
+    impl_avx2.scan = delta_scan_avx2;
+    impl_avx2.sub = delta_sub_avx2;
+    return impl_avx2;
+  }
+#endif  /* defined(DELTA_AVX2_ENABLED) */
+
+#if defined(DELTA_SSE2_ENABLED)
+  if (cpu_features & BLOSC_HAVE_SSE2) {
+    delta_implementation_t impl_sse2;
+    impl_sse2.name = "sse2";
+    impl_sse2.xor_buffers = delta_xor_sse2;
+    impl_sse2.scan = delta_scan_sse2;
+    impl_sse2.sub = delta_sub_sse2;
+    return impl_sse2;
+  }
+#endif  /* defined(DELTA_SSE2_ENABLED) */
+
+#if defined(DELTA_NEON_ENABLED)
+  if (cpu_features & BLOSC_HAVE_NEON) {
+    delta_implementation_t impl_neon;
+    impl_neon.name = "neon";
+    impl_neon.xor_buffers = delta_xor_neon;
+    impl_neon.scan = delta_scan_neon;
+    impl_neon.sub = delta_sub_neon;
+    return impl_neon;
+  }
+#endif  /* defined(DELTA_NEON_ENABLED) */
+
+  /* Processor doesn't have any of the SIMD instruction sets above,
+     so use the generic implementation. */
+  (void)cpu_features;
+  delta_implementation_t impl_generic;
+  impl_generic.name = "generic";
+  impl_generic.xor_buffers = delta_xor_generic;
+  impl_generic.scan = delta_scan_generic;
+  impl_generic.sub = delta_sub_generic;
+  return impl_generic;
+}
+
+
+/* Flag indicating whether the implementation has been initialized.
+   Zero means it hasn't been initialized, non-zero means it has. */
+static int32_t implementation_initialized;
+
+/* The dynamically-chosen delta implementation.
+   This is only safe to use once `implementation_initialized` is set. */
+static delta_implementation_t host_implementation;
+
+/* Initialize the delta implementation, if necessary.  See the notes in
+   `init_shuffle_implementation` about (the lack of) synchronization. */
+static void init_delta_implementation(void) {
+  if (!implementation_initialized) {
+    host_implementation = get_delta_implementation();
+    implementation_initialized = 1;
+  }
+}
+
+
+/* The XOR delta works on elements of 1, 2, 4 or 8 bytes */
+int32_t delta_typesize(int32_t typesize) {
+  switch (typesize) {
+    case 1:
+    case 2:
+    case 4:
+    case 8:
+      return typesize;
+    default:
+      return (typesize % 8) == 0 ? 8 : 1;
+  }
+}
 
 
 /* Apply the delta filters to src.  This can never fail. */
 void delta_encoder(const uint8_t* dref, int32_t offset, int32_t nbytes, int32_t typesize,
                    const uint8_t* src, uint8_t* dest) {
-  int32_t i;
+  init_delta_implementation();
+  typesize = delta_typesize(typesize);
+  /* Only whole elements are coded, the leftover bytes are copied verbatim */
+  int32_t vbytes = nbytes / typesize * typesize;
+  memcpy(dest + vbytes, src + vbytes, nbytes - vbytes);
+
   if (offset == 0) {
     /* This is the reference block, use delta coding in elements */
-    switch (typesize) {
-      case 1:
-        dest[0] = dref[0];
-        for (i = 1; i < nbytes; i++) {
-          dest[i] = src[i] ^ dref[i-1];
-        }
-        break;
-      case 2:
-        ((uint16_t *)dest)[0] = ((uint16_t *)dref)[0];
-        for (i = 1; i < nbytes / 2; i++) {
-          ((uint16_t *)dest)[i] =
-                  ((uint16_t *)src)[i] ^ ((uint16_t *)dref)[i-1];
-        }
-        break;
-      case 4:
-        ((uint32_t *)dest)[0] = ((uint32_t *)dref)[0];
-        for (i = 1; i < nbytes / 4; i++) {
-          ((uint32_t *)dest)[i] =
-                  ((uint32_t *)src)[i] ^ ((uint32_t *)dref)[i-1];
-        }
-        break;
-      case 8:
-        ((uint64_t *)dest)[0] = ((uint64_t *)dref)[0];
-        for (i = 1; i < nbytes / 8; i++) {
-          ((uint64_t *)dest)[i] =
-                  ((uint64_t *)src)[i] ^ ((uint64_t *)dref)[i-1];
-        }
-        break;
-      default:
-        if ((typesize % 8) == 0) {
-          delta_encoder(dref, offset, nbytes, 8, src, dest);
-        } else {
-          delta_encoder(dref, offset, nbytes, 1, src, dest);
-        }
+    if (vbytes == 0) {
+      return;
     }
+    memcpy(dest, dref, typesize);
+    host_implementation.xor_buffers(vbytes - typesize, src + typesize, dref, dest + typesize);
   } else {
     /* Use delta coding wrt reference block */
-    switch (typesize) {
-      case 1:
-        for (i = 0; i < nbytes; i++) {
-          dest[i] = src[i] ^ dref[i];
-        }
-        break;
-      case 2:
-        for (i = 0; i < nbytes / 2; i++) {
-          ((uint16_t *) dest)[i] =
-                  ((uint16_t *) src)[i] ^ ((uint16_t *) dref)[i];
-        }
-        break;
-      case 4:
-        for (i = 0; i < nbytes / 4; i++) {
-          ((uint32_t *) dest)[i] =
-                  ((uint32_t *) src)[i] ^ ((uint32_t *) dref)[i];
-        }
-        break;
-      case 8:
-        for (i = 0; i < nbytes / 8; i++) {
-          ((uint64_t *) dest)[i] =
-                  ((uint64_t *) src)[i] ^ ((uint64_t *) dref)[i];
-        }
-        break;
-      default:
-        if ((typesize % 8) == 0) {
-          delta_encoder(dref, offset, nbytes, 8, src, dest);
-        } else {
-          delta_encoder(dref, offset, nbytes, 1, src, dest);
-        }
-    }
+    host_implementation.xor_buffers(vbytes, src, dref, dest);
   }
 }
 
@@ -94,67 +166,117 @@ void delta_encoder(const uint8_t* dref, int32_t offset, int32_t nbytes, int32_t
 /* Undo the delta filter in dest.  This can never fail. */
 void delta_decoder(const uint8_t* dref, int32_t offset, int32_t nbytes,
                    int32_t typesize, uint8_t* dest) {
-  int32_t i;
+  init_delta_implementation();
+  typesize = delta_typesize(typesize);
+  /* Only whole elements are coded */
+  int32_t vbytes = nbytes / typesize * typesize;
 
   if (offset == 0) {
     /* Decode delta for the reference block */
-    switch (typesize) {
-      case 1:
-        for (i = 1; i < nbytes; i++) {
-          dest[i] ^= dref[i-1];
-        }
-        break;
-      case 2:
-        for (i = 1; i < nbytes / 2; i++) {
-          ((uint16_t *)dest)[i] ^= ((uint16_t *)dref)[i-1];
-        }
-        break;
-      case 4:
-        for (i = 1; i < nbytes / 4; i++) {
-          ((uint32_t *)dest)[i] ^= ((uint32_t *)dref)[i-1];
-        }
-        break;
-      case 8:
-        for (i = 1; i < nbytes / 8; i++) {
-          ((uint64_t *)dest)[i] ^= ((uint64_t *)dref)[i-1];
-        }
-        break;
-      default:
-        if ((typesize % 8) == 0) {
-          delta_decoder(dref, offset, nbytes, 8, dest);
-        } else {
-          delta_decoder(dref, offset, nbytes, 1, dest);
-        }
+    if (vbytes == 0) {
+      return;
+    }
+    if (dref == dest) {
+      /* Every element depends on the already decoded previous one */
+      host_implementation.scan(typesize, true, vbytes / typesize, dest, dest);
+    } else {
+      host_implementation.xor_buffers(vbytes - typesize, dest + typesize, dref, dest + typesize);
     }
   } else {
     /* Decode delta for the non-reference blocks */
-    switch (typesize) {
-      case 1:
-        for (i = 0; i < nbytes; i++) {
-          dest[i] ^= dref[i];
-        }
-        break;
-      case 2:
-        for (i = 0; i < nbytes / 2; i++) {
-          ((uint16_t *)dest)[i] ^= ((uint16_t *)dref)[i];
-        }
-        break;
-      case 4:
-        for (i = 0; i < nbytes / 4; i++) {
-          ((uint32_t *)dest)[i] ^= ((uint32_t *)dref)[i];
-        }
+    host_implementation.xor_buffers(vbytes, dest, dref, dest);
+  }
+}
+
+
+/* Apply the subtractive delta filter to src.  This can never fail. */
+void delta_sub_encoder(int32_t nbytes, int32_t typesize, const uint8_t* src, uint8_t* dest) {
+  init_delta_implementation();
+  switch (typesize) {
+    case 1:
+    case 2:
+    case 4:
+    case 8: {
+      /* Integers of native size; leftover bytes are copied verbatim */
+      int32_t nelems = nbytes / typesize;
+      host_implementation.sub(typesize, nelems, src, dest);
+      memcpy(dest + nelems * typesize, src + nelems * typesize, nbytes % typesize);
+      break;
+    }
+    default:
+      /* Bytewise subtraction of the same byte in the preceding element */
+      if (nbytes < typesize) {
+        memcpy(dest, src, nbytes);
         break;
-      case 8:
-        for (i = 0; i < nbytes / 8; i++) {
-          ((uint64_t *)dest)[i] ^= ((uint64_t *)dref)[i];
-        }
+      }
+      memcpy(dest, src, typesize);
+      for (int32_t i = typesize; i < nbytes; i++) {
+        dest[i] = (uint8_t)(src[i] - src[i - typesize]);
+      }
+  }
+}
+
+
+/* Undo the subtractive delta filter.  This can never fail. */
+void delta_sub_decoder(int32_t nbytes, int32_t typesize, const uint8_t* src, uint8_t* dest) {
+  init_delta_implementation();
+  switch (typesize) {
+    case 1:
+    case 2:
+    case 4:
+    case 8: {
+      int32_t nelems = nbytes / typesize;
+      host_implementation.scan(typesize, false, nelems, src, dest);
+      memcpy(dest + nelems * typesize, src + nelems * typesize, nbytes % typesize);
+      break;
+    }
+    default:
+      if (nbytes < typesize) {
+        memcpy(dest, src, nbytes);
         break;
-      default:
-        if ((typesize % 8) == 0) {
-          delta_decoder(dref, offset, nbytes, 8, dest);
-        } else {
-          delta_decoder(dref, offset, nbytes, 1, dest);
-        }
+      }
+      memcpy(dest, src, typesize);
+      for (int32_t i = typesize; i < nbytes; i++) {
+        dest[i] = (uint8_t)(src[i] + dest[i - typesize]);
+      }
+  }
+}
+
+
+/* Add (or subtract) the elements in a and b into dest, like the subtractive
+   delta filter does.  This is used for carrying the previous element across
+   the tiles of a block. */
+void delta_sub_element(int32_t typesize, const uint8_t* a, const uint8_t* b, uint8_t* dest,
+                       bool add) {
+  switch (typesize) {
+    case 2: {
+      uint16_t x, y;
+      memcpy(&x, a, sizeof(x));
+      memcpy(&y, b, sizeof(y));
+      x = (uint16_t)(add ? x + y : x - y);
+      memcpy(dest, &x, sizeof(x));
+      break;
+    }
+    case 4: {
+      uint32_t x, y;
+      memcpy(&x, a, sizeof(x));
+      memcpy(&y, b, sizeof(y));
+      x = add ? x + y : x - y;
+      memcpy(dest, &x, sizeof(x));
+      break;
+    }
+    case 8: {
+      uint64_t x, y;
+      memcpy(&x, a, sizeof(x));
+      memcpy(&y, b, sizeof(y));
+      x = add ? x + y : x - y;
+      memcpy(dest, &x, sizeof(x));
+      break;
     }
+    default:
+      /* Bytewise (this also covers typesize 1) */
+      for (int32_t i = 0; i < typesize; i++) {
+        dest[i] = (uint8_t)(add ? a[i] + b[i] : a[i] - b[i]);
+      }
   }
 }
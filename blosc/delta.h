@@ -13,6 +13,7 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <stdbool.h>
 
 void delta_encoder(const uint8_t* dref, int32_t offset, int32_t nbytes,
                    int32_t typesize, const uint8_t* src, uint8_t* dest);
@@ -20,4 +21,13 @@ void delta_encoder(const uint8_t* dref, int32_t offset, int32_t nbytes,
 void delta_decoder(const uint8_t* dref, int32_t offset, int32_t nbytes,
                    int32_t typesize, uint8_t* dest);
 
+void delta_sub_encoder(int32_t nbytes, int32_t typesize, const uint8_t* src, uint8_t* dest);
+
+void delta_sub_decoder(int32_t nbytes, int32_t typesize, const uint8_t* src, uint8_t* dest);
+
+int32_t delta_typesize(int32_t typesize);
+
+void delta_sub_element(int32_t typesize, const uint8_t* a, const uint8_t* b, uint8_t* dest,
+                       bool add);
+
 #endif //BLOSC_DELTA_H
@@ -18,6 +18,8 @@
 #include "context.h"
 #include "frame.h"
 #include "sframe.h"
+#include "allocator.h"
+#include "dctx-pool.h"
 #include <inttypes.h>
 
 #if defined(_WIN32)
@@ -45,7 +47,11 @@ blosc2_frame_s* frame_new(const char* urlpath) {
   if (urlpath != NULL) {
     char* new_urlpath = malloc(strlen(urlpath) + 1);  // + 1 for the trailing NULL
     new_frame->urlpath = strcpy(new_urlpath, urlpath);
+    // Keep on-disk frames readable by others after every append
+    new_frame->offsets_maxpending = 1;
   }
+  pthread_mutex_init(&new_frame->handles_mutex, NULL);
+  pthread_mutex_init(&new_frame->cache_mutex, NULL);
   return new_frame;
 }
 
@@ -53,6 +59,10 @@ blosc2_frame_s* frame_new(const char* urlpath) {
 /* Free memory from a frame. */
 int frame_free(blosc2_frame_s* frame) {
 
+  frame_close_handles(frame);
+  pthread_mutex_destroy(&frame->handles_mutex);
+  pthread_mutex_destroy(&frame->cache_mutex);
+
   if (frame->cframe != NULL && !frame->avoid_cframe_free) {
     free(frame->cframe);
   }
@@ -61,6 +71,10 @@ int frame_free(blosc2_frame_s* frame) {
     free(frame->coffsets);
   }
 
+  if (frame->offsets != NULL) {
+    blosc_free(frame->offsets);
+  }
+
   if (frame->urlpath != NULL) {
     free(frame->urlpath);
   }
@@ -71,11 +85,230 @@ int frame_free(blosc2_frame_s* frame) {
 }
 
 
+/* Make room for `len` bytes in the in-memory frame.  It grows geometrically, so that
+ * appending chunks does not need a realloc() every time. */
+static uint8_t* reserve_cframe(blosc2_frame_s* frame, int64_t len) {
+  if (len <= frame->cframe_capacity) {
+    return frame->cframe;
+  }
+  int64_t capacity = frame->cframe_capacity + frame->cframe_capacity / 2;
+  if (capacity < len) {
+    capacity = len;
+  }
+  uint8_t* cframe = realloc(frame->cframe, (size_t)capacity);
+  if (cframe == NULL) {
+    return NULL;
+  }
+  frame->cframe = cframe;
+  frame->cframe_capacity = capacity;
+  return cframe;
+}
+
+
+/* Close the file handles kept open for reading. */
+void frame_close_handles(blosc2_frame_s* frame) {
+  pthread_mutex_lock(&frame->handles_mutex);
+  for (int i = 0; i < FRAME_NHANDLES; i++) {
+    frame_handle* handle = &frame->handles[i];
+    if (handle->fp != NULL && handle->nreaders == 0) {
+      handle->io_cb->close(handle->fp);
+      handle->fp = NULL;
+    }
+  }
+  pthread_mutex_unlock(&frame->handles_mutex);
+}
+
+
+/* Get a handle for reading the file `id` of an on-disk frame, reusing (or populating) a slot
+ * of the handles kept open.  If all the slots are in use by other threads, `*handle` is NULL and
+ * the returned handle must be closed by the caller. */
+static void* acquire_handle(blosc2_frame_s* frame, blosc2_io_cb* io_cb, int64_t id,
+                            frame_handle** handle, bool* reuse) {
+  blosc2_io* io = frame->schunk->storage->io;
+  // With positional reads, a handle can be shared by all the threads
+  const blosc2_io_ext_cb* io_ext = blosc2_get_io_ext_cb(io->id);
+  bool shared = io_ext != NULL && io_ext->pread != NULL;
+
+  // Prefer a handle for the same file, then an empty slot, then any idle one
+  *handle = NULL;
+  *reuse = false;
+  pthread_mutex_lock(&frame->handles_mutex);
+  for (int i = 0; i < FRAME_NHANDLES; i++) {
+    frame_handle* h = &frame->handles[i];
+    if (h->fp != NULL && h->id == id && h->io_cb == io_cb && (shared || h->nreaders == 0)) {
+      *handle = h;
+      *reuse = true;
+      break;
+    }
+    if (h->nreaders == 0 && (*handle == NULL || ((*handle)->fp != NULL && h->fp == NULL))) {
+      *handle = h;
+    }
+  }
+  if (*handle != NULL) {
+    (*handle)->nreaders++;
+    if (!*reuse && (*handle)->fp != NULL) {
+      (*handle)->io_cb->close((*handle)->fp);
+      (*handle)->fp = NULL;
+    }
+  }
+  pthread_mutex_unlock(&frame->handles_mutex);
+
+  if (*reuse) {
+    return (*handle)->fp;
+  }
+  if (frame->sframe) {
+    return sframe_open_chunk(frame->urlpath, id, "rb", io);
+  }
+  return io_cb->open(frame->urlpath, "rb", io->params);
+}
+
+
+/* Return a handle got with acquire_handle(), keeping it open in its slot if possible. */
+static void release_handle(blosc2_frame_s* frame, blosc2_io_cb* io_cb, int64_t id,
+                           frame_handle* handle, bool reuse, void* fp) {
+  if (handle != NULL) {
+    pthread_mutex_lock(&frame->handles_mutex);
+    if (!reuse && fp != NULL) {
+      handle->fp = fp;
+      handle->id = id;
+      handle->io_cb = io_cb;
+      fp = NULL;
+    }
+    handle->nreaders--;
+    pthread_mutex_unlock(&frame->handles_mutex);
+  }
+  if (!reuse && fp != NULL) {
+    // All the slots are in use by other threads, so this handle is not kept
+    io_cb->close(fp);
+  }
+}
+
+
+int64_t frame_read(blosc2_frame_s* frame, int64_t id, int64_t offset, void* dest, int64_t nbytes) {
+  blosc2_io_cb* io_cb = blosc2_get_io_cb(frame->schunk->storage->io->id);
+  if (io_cb == NULL) {
+    BLOSC_TRACE_ERROR("Error getting the input/output API");
+    return BLOSC2_ERROR_PLUGIN_IO;
+  }
+  if (!frame->sframe) {
+    id = -1;
+  }
+
+  const blosc2_io_ext_cb* io_ext = blosc2_get_io_ext_cb(frame->schunk->storage->io->id);
+
+  frame_handle* handle;
+  bool reuse;
+  void* fp = acquire_handle(frame, io_cb, id, &handle, &reuse);
+  int64_t rbytes = BLOSC2_ERROR_FILE_OPEN;
+  if (fp == NULL) {
+    BLOSC_TRACE_ERROR("Cannot open the file for reading the frame.");
+  }
+  else if (io_ext != NULL && io_ext->pread != NULL) {
+    rbytes = io_ext->pread(dest, 1, nbytes, offset, fp);
+  }
+  else {
+    io_cb->seek(fp, offset, SEEK_SET);
+    rbytes = io_cb->read(dest, 1, nbytes, fp);
+  }
+  release_handle(frame, io_cb, id, handle, reuse, fp);
+
+  return rbytes;
+}
+
+
+frame_batch* frame_submit_reads(blosc2_frame_s* frame, int64_t id, int32_t nreads, void** ptrs,
+                                const int64_t* nbytes, const int64_t* offsets) {
+  if (frame->cframe != NULL) {
+    return NULL;
+  }
+  blosc2_io_cb* io_cb = blosc2_get_io_cb(frame->schunk->storage->io->id);
+  const blosc2_io_ext_cb* io_ext = blosc2_get_io_ext_cb(frame->schunk->storage->io->id);
+  if (io_cb == NULL || io_ext == NULL || io_ext->submit == NULL) {
+    return NULL;
+  }
+  if (!frame->sframe) {
+    id = -1;
+  }
+
+  frame_batch* batch = malloc(sizeof(frame_batch));
+  if (batch == NULL) {
+    return NULL;
+  }
+  batch->frame = frame;
+  batch->io_cb = io_cb;
+  batch->io_ext = io_ext;
+  batch->id = id;
+  // The handle cannot be closed while the batch is alive
+  batch->fp = acquire_handle(frame, io_cb, id, &batch->handle, &batch->reuse);
+  batch->batch = NULL;
+  if (batch->fp != NULL) {
+    batch->batch = io_ext->submit(batch->fp, nreads, ptrs, nbytes, offsets);
+  }
+  if (batch->batch == NULL) {
+    release_handle(frame, io_cb, id, batch->handle, batch->reuse, batch->fp);
+    free(batch);
+    return NULL;
+  }
+  return batch;
+}
+
+
+int64_t frame_complete_read(frame_batch* batch, int32_t nread) {
+  return batch->io_ext->complete(batch->batch, nread);
+}
+
+
+void frame_release_reads(frame_batch* batch) {
+  batch->io_ext->release(batch->batch);
+  release_handle(batch->frame, batch->io_cb, batch->id, batch->handle, batch->reuse, batch->fp);
+  free(batch);
+}
+
+
+uint8_t* frame_map(blosc2_frame_s* frame, int64_t offset, int64_t nbytes) {
+  if (frame->sframe || frame->cframe != NULL) {
+    return NULL;
+  }
+  blosc2_io_cb* io_cb = blosc2_get_io_cb(frame->schunk->storage->io->id);
+  const blosc2_io_ext_cb* io_ext = blosc2_get_io_ext_cb(frame->schunk->storage->io->id);
+  if (io_cb == NULL || io_ext == NULL || io_ext->map == NULL) {
+    return NULL;
+  }
+
+  // Contiguous frames only use handles for the same file, so they are never evicted
+  frame_handle* handle;
+  bool reuse;
+  void* fp = acquire_handle(frame, io_cb, -1, &handle, &reuse);
+  uint8_t* ptr = NULL;
+  if (fp != NULL && handle != NULL) {
+    ptr = io_ext->map(fp, offset, nbytes);
+  }
+  release_handle(frame, io_cb, -1, handle, reuse, fp);
+
+  return ptr;
+}
+
+
 void *new_header_frame(blosc2_schunk *schunk, blosc2_frame_s *frame) {
   if (frame == NULL) {
     return NULL;
   }
-  uint8_t* h2 = calloc(FRAME_HEADER_MINLEN, 1);
+  uint16_t nmetalayers = schunk->nmetalayers;
+  if (nmetalayers < 0 || nmetalayers > BLOSC2_MAX_METALAYERS) {
+    return NULL;
+  }
+
+  // Compute the length of the whole header, so that it is built in a single buffer
+  size_t h2len = FRAME_HEADER_MINLEN + 1 + 1 + 2 + 1 + 2 + 2 + 1 + 2;
+  for (int nmetalayer = 0; nmetalayer < nmetalayers; nmetalayer++) {
+    blosc2_metalayer *metalayer = schunk->metalayers[nmetalayer];
+    h2len += 1 + strlen(metalayer->name) + 1 + 4 + 1 + 4 + metalayer->content_len;
+  }
+  uint8_t* h2 = blosc_pool_malloc(h2len);
+  if (h2 == NULL) {
+    return NULL;
+  }
+  memset(h2, 0, FRAME_HEADER_MINLEN);
   uint8_t* h2p = h2;
 
   // The msgpack header starts here
@@ -257,14 +490,6 @@ void *new_header_frame(blosc2_schunk *schunk, blosc2_frame_s *frame) {
   int32_t hsize = FRAME_HEADER_MINLEN;
 
   // Now, deal with metalayers
-  uint16_t nmetalayers = schunk->nmetalayers;
-  if (nmetalayers < 0 || nmetalayers > BLOSC2_MAX_METALAYERS) {
-    return NULL;
-  }
-
-  // Make space for the header of metalayers (array marker, size, map of offsets)
-  h2 = realloc(h2, (size_t)hsize + 1 + 1 + 2 + 1 + 2);
-  h2p = h2 + hsize;
 
   // The msgpack header for the metalayers (array_marker, size, map of offsets, list of metalayers)
   *h2p = 0x90 + 3;  // array with 3 elements
@@ -280,18 +505,13 @@ void *new_header_frame(blosc2_schunk *schunk, blosc2_frame_s *frame) {
   to_big(h2p, &nmetalayers, sizeof(nmetalayers));
   h2p += sizeof(nmetalayers);
   int32_t current_header_len = (int32_t)(h2p - h2);
-  int32_t *offtooff = malloc(nmetalayers * sizeof(int32_t));
+  int32_t offtooff[BLOSC2_MAX_METALAYERS];
   for (int nmetalayer = 0; nmetalayer < nmetalayers; nmetalayer++) {
-    if (frame == NULL) {
-      return NULL;
-    }
     blosc2_metalayer *metalayer = schunk->metalayers[nmetalayer];
     uint8_t namelen = (uint8_t) strlen(metalayer->name);
-    h2 = realloc(h2, (size_t)current_header_len + 1 + namelen + 1 + 4);
-    h2p = h2 + current_header_len;
     // Store the metalayer
     if (namelen >= (1U << 5U)) {  // metalayer strings cannot be longer than 32 bytes
-      free(offtooff);
+      blosc_pool_free(h2);
       return NULL;
     }
     *h2p = (uint8_t)0xa0 + namelen;  // str
@@ -317,10 +537,8 @@ void *new_header_frame(blosc2_schunk *schunk, blosc2_frame_s *frame) {
   uint16_t map_size = (uint16_t) (hsize2 - hsize);
   to_big(h2 + FRAME_IDX_SIZE, &map_size, sizeof(map_size));
 
-  // Make space for an (empty) array
+  // Now, an (empty) array
   hsize = (int32_t)(h2p - h2);
-  h2 = realloc(h2, (size_t)hsize + 2 + 1 + 2);
-  h2p = h2 + hsize;
 
   // Now, store the values in an array
   *h2p = 0xdc;  // array 16 with N elements
@@ -329,12 +547,7 @@ void *new_header_frame(blosc2_schunk *schunk, blosc2_frame_s *frame) {
   h2p += sizeof(nmetalayers);
   current_header_len = (int32_t)(h2p - h2);
   for (int nmetalayer = 0; nmetalayer < nmetalayers; nmetalayer++) {
-    if (frame == NULL) {
-      return NULL;
-    }
     blosc2_metalayer *metalayer = schunk->metalayers[nmetalayer];
-    h2 = realloc(h2, (size_t)current_header_len + 1 + 4 + metalayer->content_len);
-    h2p = h2 + current_header_len;
     // Store the serialized contents for this metalayer
     *h2p = 0xc6;  // bin32
     h2p += 1;
@@ -346,7 +559,6 @@ void *new_header_frame(blosc2_schunk *schunk, blosc2_frame_s *frame) {
     to_big(h2 + offtooff[nmetalayer], &current_header_len, sizeof(current_header_len));
     current_header_len += 1 + 4 + metalayer->content_len;
   }
-  free(offtooff);
   hsize = (int32_t)(h2p - h2);
   if (hsize != current_header_len) {  // sanity check
     return NULL;
@@ -359,23 +571,99 @@ void *new_header_frame(blosc2_schunk *schunk, blosc2_frame_s *frame) {
 }
 
 
-int get_header_info(blosc2_frame_s *frame, int32_t *header_len, int64_t *frame_len, int64_t *nbytes, int64_t *cbytes,
-                    int32_t *blocksize, int32_t *chunksize, int32_t *nchunks, int32_t *typesize, uint8_t *compcode,
-                    uint8_t *compcode_meta, uint8_t *clevel, uint8_t *filters, uint8_t *filters_meta, const blosc2_io *io) {
-  uint8_t* framep = frame->cframe;
-  uint8_t header[FRAME_HEADER_MINLEN];
+// Parse (and check) the fixed part of a frame header
+static int parse_header(blosc2_frame_s *frame, const uint8_t *framep, frame_header *header) {
+  // Consistency check for frame type
+  uint8_t frame_type = framep[FRAME_TYPE];
+  if (frame->sframe) {
+    if (frame_type != FRAME_DIRECTORY_TYPE) {
+      return BLOSC2_ERROR_FRAME_TYPE;
+    }
+  } else {
+    if (frame_type != FRAME_CONTIGUOUS_TYPE) {
+      return BLOSC2_ERROR_FRAME_TYPE;
+    }
+  }
 
-  blosc2_io_cb *io_cb = blosc2_get_io_cb(io->id);
-  if (io_cb == NULL) {
-    BLOSC_TRACE_ERROR("Error getting the input/output API");
-    return BLOSC2_ERROR_PLUGIN_IO;
+  // Fetch some internal lengths
+  from_big(&header->header_len, framep + FRAME_HEADER_LEN, sizeof(header->header_len));
+  if (header->header_len < FRAME_HEADER_MINLEN) {
+    BLOSC_TRACE_ERROR("Header length is zero or smaller than min allowed.");
+    return BLOSC2_ERROR_INVALID_HEADER;
+  }
+  from_big(&header->frame_len, framep + FRAME_LEN, sizeof(header->frame_len));
+  if (header->header_len > header->frame_len) {
+    BLOSC_TRACE_ERROR("Header length exceeds length of the frame.");
+    return BLOSC2_ERROR_INVALID_HEADER;
+  }
+  from_big(&header->nbytes, framep + FRAME_NBYTES, sizeof(header->nbytes));
+  from_big(&header->cbytes, framep + FRAME_CBYTES, sizeof(header->cbytes));
+  from_big(&header->blocksize, framep + FRAME_BLOCKSIZE, sizeof(header->blocksize));
+  from_big(&header->chunksize, framep + FRAME_CHUNKSIZE, sizeof(header->chunksize));
+  from_big(&header->typesize, framep + FRAME_TYPESIZE, sizeof(header->typesize));
+  if (header->typesize <= 0 || header->typesize > BLOSC_MAX_TYPESIZE) {
+    BLOSC_TRACE_ERROR("`typesize` is zero or greater than max allowed.");
+    return BLOSC2_ERROR_INVALID_HEADER;
   }
 
-  if (frame->len <= 0) {
-    return BLOSC2_ERROR_READ_BUFFER;
+  // Codecs
+  uint8_t frame_codecs = framep[FRAME_CODECS];
+  header->clevel = frame_codecs >> 4u;
+  header->compcode = frame_codecs & 0xFu;
+  if (header->compcode == BLOSC_UDCODEC_FORMAT) {
+    from_big(&header->compcode, framep + FRAME_UDCODEC, sizeof(header->compcode));
+  }
+  from_big(&header->compcode_meta, framep + FRAME_CODEC_META, sizeof(header->compcode_meta));
+
+  // Filters
+  header->nfilters = framep[FRAME_FILTER_PIPELINE];
+  if (header->nfilters > BLOSC2_MAX_FILTERS) {
+    BLOSC_TRACE_ERROR("The number of filters in frame header are too large for Blosc2.");
+    return BLOSC2_ERROR_INVALID_HEADER;
+  }
+  const uint8_t *filters_ = framep + FRAME_FILTER_PIPELINE + 1;
+  const uint8_t *filters_meta_ = framep + FRAME_FILTER_PIPELINE + 1 + FRAME_FILTER_PIPELINE_MAX;
+  for (int i = 0; i < header->nfilters; i++) {
+    header->filters[i] = filters_[i];
+    header->filters_meta[i] = filters_meta_[i];
+  }
+
+  if (header->nbytes > 0 && header->chunksize > 0) {
+    // We can compute the number of chunks only when the frame has actual data
+    header->nchunks = (int32_t) (header->nbytes / header->chunksize);
+    if (header->nbytes % header->chunksize > 0) {
+      if (header->nchunks == INT32_MAX) {
+        BLOSC_TRACE_ERROR("Number of chunks exceeds maximum allowed.");
+        return BLOSC2_ERROR_INVALID_HEADER;
+      }
+      header->nchunks += 1;
+    }
+
+    // Sanity check for compressed sizes
+    if ((header->cbytes < 0) || ((int64_t)header->nchunks * header->chunksize < header->nbytes)) {
+      BLOSC_TRACE_ERROR("Invalid compressed size in frame header.");
+      return BLOSC2_ERROR_INVALID_HEADER;
+    }
+  } else {
+    header->nchunks = 0;
   }
 
+  return 0;
+}
+
+
+// Read and parse the header of a frame into `frame->header` (with `frame->cache_mutex` held)
+static int load_header(blosc2_frame_s *frame, const blosc2_io *io) {
+  uint8_t* framep = frame->cframe;
+  uint8_t header[FRAME_HEADER_MINLEN];
+
   if (frame->cframe == NULL) {
+    blosc2_io_cb *io_cb = blosc2_get_io_cb(io->id);
+    if (io_cb == NULL) {
+      BLOSC_TRACE_ERROR("Error getting the input/output API");
+      return BLOSC2_ERROR_PLUGIN_IO;
+    }
+
     int64_t rbytes = 0;
     void* fp = NULL;
     if (frame->sframe) {
@@ -396,94 +684,62 @@ int get_header_info(blosc2_frame_s *frame, int32_t *header_len, int64_t *frame_l
     framep = header;
   }
 
-  // Consistency check for frame type
-  uint8_t frame_type = framep[FRAME_TYPE];
-  if (frame->sframe) {
-    if (frame_type != FRAME_DIRECTORY_TYPE) {
-      return BLOSC2_ERROR_FRAME_TYPE;
-    }
-  } else {
-    if (frame_type != FRAME_CONTIGUOUS_TYPE) {
-      return BLOSC2_ERROR_FRAME_TYPE;
-    }
+  int rc = parse_header(frame, framep, &frame->header);
+  if (rc < 0) {
+    return rc;
   }
+  BLOSC_ATOMIC_STORE32(&frame->header_ready, 1);
 
-  // Fetch some internal lengths
-  from_big(header_len, framep + FRAME_HEADER_LEN, sizeof(*header_len));
-  if (*header_len < FRAME_HEADER_MINLEN) {
-    BLOSC_TRACE_ERROR("Header length is zero or smaller than min allowed.");
-    return BLOSC2_ERROR_INVALID_HEADER;
+  return 0;
+}
+
+
+// Get the (parsed) header of a frame.  It is read only once, and kept until the header changes.
+int get_header_info(blosc2_frame_s *frame, int32_t *header_len, int64_t *frame_len, int64_t *nbytes, int64_t *cbytes,
+                    int32_t *blocksize, int32_t *chunksize, int32_t *nchunks, int32_t *typesize, uint8_t *compcode,
+                    uint8_t *compcode_meta, uint8_t *clevel, uint8_t *filters, uint8_t *filters_meta, const blosc2_io *io) {
+  if (frame->len <= 0) {
+    return BLOSC2_ERROR_READ_BUFFER;
   }
-  from_big(frame_len, framep + FRAME_LEN, sizeof(*frame_len));
-  if (*header_len > *frame_len) {
-    BLOSC_TRACE_ERROR("Header length exceeds length of the frame.");
-    return BLOSC2_ERROR_INVALID_HEADER;
+
+  // Readers in several threads may get here at once, so the header is read just once
+  if (!BLOSC_ATOMIC_LOAD32(&frame->header_ready)) {
+    pthread_mutex_lock(&frame->cache_mutex);
+    int rc = frame->header_ready ? 0 : load_header(frame, io);
+    pthread_mutex_unlock(&frame->cache_mutex);
+    if (rc < 0) {
+      return rc;
+    }
   }
-  from_big(nbytes, framep + FRAME_NBYTES, sizeof(*nbytes));
-  from_big(cbytes, framep + FRAME_CBYTES, sizeof(*cbytes));
-  from_big(blocksize, framep + FRAME_BLOCKSIZE, sizeof(*blocksize));
+
+  frame_header *fh = &frame->header;
+  *header_len = fh->header_len;
+  *frame_len = fh->frame_len;
+  *nbytes = fh->nbytes;
+  *cbytes = fh->cbytes;
+  *blocksize = fh->blocksize;
   if (chunksize != NULL) {
-    from_big(chunksize, framep + FRAME_CHUNKSIZE, sizeof(*chunksize));
+    *chunksize = fh->chunksize;
   }
   if (typesize != NULL) {
-    from_big(typesize, framep + FRAME_TYPESIZE, sizeof(*typesize));
-    if (*typesize <= 0 || *typesize > BLOSC_MAX_TYPESIZE) {
-      BLOSC_TRACE_ERROR("`typesize` is zero or greater than max allowed.");
-      return BLOSC2_ERROR_INVALID_HEADER;
-    }
+    *typesize = fh->typesize;
   }
-
-  // Codecs
-  uint8_t frame_codecs = framep[FRAME_CODECS];
   if (clevel != NULL) {
-    *clevel = frame_codecs >> 4u;
+    *clevel = fh->clevel;
   }
   if (compcode != NULL) {
-    *compcode = frame_codecs & 0xFu;
-    if (*compcode == BLOSC_UDCODEC_FORMAT) {
-      from_big(compcode, framep + FRAME_UDCODEC, sizeof(*compcode));
-    }
+    *compcode = fh->compcode;
   }
-
-
   if (compcode_meta != NULL) {
-    from_big(compcode_meta, framep + FRAME_CODEC_META, sizeof(*compcode_meta));
+    *compcode_meta = fh->compcode_meta;
   }
-
-  // Filters
   if (filters != NULL && filters_meta != NULL) {
-    uint8_t nfilters = framep[FRAME_FILTER_PIPELINE];
-    if (nfilters > BLOSC2_MAX_FILTERS) {
-      BLOSC_TRACE_ERROR("The number of filters in frame header are too large for Blosc2.");
-      return BLOSC2_ERROR_INVALID_HEADER;
-    }
-    uint8_t *filters_ = framep + FRAME_FILTER_PIPELINE + 1;
-    uint8_t *filters_meta_ = framep + FRAME_FILTER_PIPELINE + 1 + FRAME_FILTER_PIPELINE_MAX;
-    for (int i = 0; i < nfilters; i++) {
-      filters[i] = filters_[i];
-      filters_meta[i] = filters_meta_[i];
+    for (int i = 0; i < fh->nfilters; i++) {
+      filters[i] = fh->filters[i];
+      filters_meta[i] = fh->filters_meta[i];
     }
   }
-
-  if (*nbytes > 0 && *chunksize > 0) {
-    // We can compute the number of chunks only when the frame has actual data
-    *nchunks = (int32_t) (*nbytes / *chunksize);
-    if (*nbytes % *chunksize > 0) {
-      if (*nchunks == INT32_MAX) {
-        BLOSC_TRACE_ERROR("Number of chunks exceeds maximum allowed.");
-        return BLOSC2_ERROR_INVALID_HEADER;
-      }
-      *nchunks += 1;
-    }
-
-    // Sanity check for compressed sizes
-    if ((*cbytes < 0) || ((int64_t)*nchunks * *chunksize < *nbytes)) {
-      BLOSC_TRACE_ERROR("Invalid compressed size in frame header.");
-      return BLOSC2_ERROR_INVALID_HEADER;
-    }
-  } else {
-    *nchunks = 0;
-  }
+  *nchunks = fh->nchunks;
 
   return 0;
 }
@@ -507,6 +763,9 @@ int update_frame_len(blosc2_frame_s* frame, int64_t len) {
     return BLOSC2_ERROR_PLUGIN_IO;
   }
 
+  // The cached header and the read handles are outdated now
+  BLOSC_ATOMIC_STORE32(&frame->header_ready, 0);
+  frame_close_handles(frame);
   if (frame->cframe != NULL) {
     to_big(frame->cframe + FRAME_LEN, &len, sizeof(int64_t));
   }
@@ -538,6 +797,15 @@ int frame_update_trailer(blosc2_frame_s* frame, blosc2_schunk* schunk) {
     BLOSC_TRACE_ERROR("The trailer cannot be updated on empty frames.");
   }
 
+  if (frame != NULL && frame->offsets_pending > 0) {
+    // The trailer goes after the offsets, so write them first (this updates the trailer too)
+    int rc = frame_flush_offsets(frame);
+    return rc < 0 ? rc : 1;
+  }
+  if (frame != NULL) {
+    frame_close_handles(frame);
+  }
+
   // Create the trailer in msgpack (see the frame format document)
   uint32_t trailer_len = FRAME_TRAILER_MINLEN;
   uint8_t* trailer = (uint8_t*)calloc((size_t)trailer_len, 1);
@@ -707,8 +975,7 @@ int frame_update_trailer(blosc2_frame_s* frame, blosc2_schunk* schunk) {
   // and it is always at the end of the frame, we can just write (or overwrite) it
   // at the end of the frame.
   if (frame->cframe != NULL) {
-    frame->cframe = realloc(frame->cframe, (size_t)(trailer_offset + trailer_len));
-    if (frame->cframe == NULL) {
+    if (reserve_cframe(frame, trailer_offset + trailer_len) == NULL) {
       BLOSC_TRACE_ERROR("Cannot realloc space for the frame.");
       return BLOSC2_ERROR_MEMORY_ALLOC;
     }
@@ -823,6 +1090,9 @@ blosc2_frame_s* frame_from_file(const char* urlpath, const blosc2_io *io) {
   frame->urlpath = urlpath_cpy;
   frame->len = frame_len;
   frame->sframe = sframe;
+  frame->offsets_maxpending = 1;
+  pthread_mutex_init(&frame->handles_mutex, NULL);
+  pthread_mutex_init(&frame->cache_mutex, NULL);
 
   // Now, the trailer length
   io_cb->seek(fp, frame_len - FRAME_TRAILER_MINLEN, SEEK_SET);
@@ -830,14 +1100,12 @@ blosc2_frame_s* frame_from_file(const char* urlpath, const blosc2_io *io) {
   io_cb->close(fp);
   if (rbytes != FRAME_TRAILER_MINLEN) {
     BLOSC_TRACE_ERROR("Cannot read from file '%s'.", urlpath);
-    free(urlpath_cpy);
-    free(frame);
+    frame_free(frame);
     return NULL;
   }
   int trailer_offset = FRAME_TRAILER_MINLEN - FRAME_TRAILER_LEN_OFFSET;
   if (trailer[trailer_offset - 1] != 0xce) {
-    free(urlpath_cpy);
-    free(frame);
+    frame_free(frame);
     return NULL;
   }
   uint32_t trailer_len;
@@ -864,12 +1132,14 @@ blosc2_frame_s* frame_from_cframe(uint8_t *cframe, int64_t len, bool copy) {
 
   blosc2_frame_s* frame = calloc(1, sizeof(blosc2_frame_s));
   frame->len = frame_len;
+  pthread_mutex_init(&frame->handles_mutex, NULL);
+  pthread_mutex_init(&frame->cache_mutex, NULL);
 
   // Now, the trailer length
   const uint8_t* trailer = cframe + frame_len - FRAME_TRAILER_MINLEN;
   int trailer_offset = FRAME_TRAILER_MINLEN - FRAME_TRAILER_LEN_OFFSET;
   if (trailer[trailer_offset - 1] != 0xce) {
-    free(frame);
+    frame_free(frame);
     return NULL;
   }
   uint32_t trailer_len;
@@ -898,6 +1168,8 @@ int64_t frame_from_schunk(blosc2_schunk *schunk, blosc2_frame_s *frame) {
   void* fp = NULL;
   int rc;
 
+  BLOSC_ATOMIC_STORE32(&frame->header_ready, 0);
+  frame_close_handles(frame);
   uint8_t* h2 = new_header_frame(schunk, frame);
   if (h2 == NULL) {
     return BLOSC2_ERROR_DATA;
@@ -947,7 +1219,7 @@ int64_t frame_from_schunk(blosc2_schunk *schunk, blosc2_frame_s *frame) {
     blosc2_free_ctx(cctx);
     if (off_cbytes < 0) {
       free(off_chunk);
-      free(h2);
+      blosc_pool_free(h2);
       return off_cbytes;
     }
   }
@@ -986,7 +1258,7 @@ int64_t frame_from_schunk(blosc2_schunk *schunk, blosc2_frame_s *frame) {
     }
     io_cb->write(h2, h2len, 1, fp);
   }
-  free(h2);
+  blosc_pool_free(h2);
 
   // Fill the frame with the actual data chunks
   if (!frame->sframe) {
@@ -1027,12 +1299,146 @@ int64_t frame_from_schunk(blosc2_schunk *schunk, blosc2_frame_s *frame) {
 }
 
 
+// Compress the offsets of a frame
+static int32_t compress_offsets(const int64_t* offsets, int32_t nchunks, uint8_t** off_chunk) {
+  int32_t off_nbytes = nchunks * (int32_t)sizeof(int64_t);
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.splitmode = BLOSC_NEVER_SPLIT;
+  cparams.typesize = sizeof(int64_t);
+  cparams.blocksize = 16 * 1024;  // based on experiments with create_frame.c bench
+  cparams.nthreads = 4;  // 4 threads seems a decent default for nowadays CPUs
+  cparams.compcode = BLOSC_BLOSCLZ;
+  blosc2_context* cctx = blosc2_create_cctx(cparams);
+  *off_chunk = malloc((size_t)off_nbytes + BLOSC_MAX_OVERHEAD);
+  int32_t off_cbytes = blosc2_compress_ctx(cctx, offsets, off_nbytes,
+                                           *off_chunk, off_nbytes + BLOSC_MAX_OVERHEAD);
+  blosc2_free_ctx(cctx);
+  if (off_cbytes < 0) {
+    free(*off_chunk);
+    *off_chunk = NULL;
+  }
+  return off_cbytes;
+}
+
+
+// Drop the caches for the chunk offsets (the frame must have been flushed before)
+static void invalidate_offsets(blosc2_frame_s* frame) {
+  if (frame->coffsets != NULL) {
+    free(frame->coffsets);
+    frame->coffsets = NULL;
+  }
+  if (frame->offsets != NULL) {
+    blosc_free(frame->offsets);
+    frame->offsets = NULL;
+  }
+  frame->noffsets = 0;
+  frame->offsets_maxitems = 0;
+  BLOSC_ATOMIC_STORE32(&frame->offsets_ready, 0);
+  frame_close_handles(frame);
+}
+
+
+int frame_flush_offsets(blosc2_frame_s* frame) {
+  if (frame->offsets_pending == 0) {
+    return 0;
+  }
+
+  int32_t header_len;
+  int64_t frame_len;
+  int64_t nbytes;
+  int64_t cbytes;
+  int32_t blocksize;
+  int32_t chunksize;
+  int32_t nchunks;
+  int rc = get_header_info(frame, &header_len, &frame_len, &nbytes, &cbytes, &blocksize, &chunksize,
+                           &nchunks, NULL, NULL, NULL, NULL, NULL, NULL,
+                           frame->schunk->storage->io);
+  if (rc < 0) {
+    BLOSC_TRACE_ERROR("Unable to get meta info from frame.");
+    return rc;
+  }
+  if (nchunks != frame->noffsets) {
+    BLOSC_TRACE_ERROR("The number of chunks in the offsets (%d) does not match the ones "
+                      "in the header frame (%d).", frame->noffsets, nchunks);
+    return BLOSC2_ERROR_DATA;
+  }
+
+  uint8_t* off_chunk;
+  int32_t off_cbytes = compress_offsets(frame->offsets, nchunks, &off_chunk);
+  if (off_cbytes < 0) {
+    BLOSC_TRACE_ERROR("Cannot compress the offsets chunk.");
+    return off_cbytes;
+  }
+
+  int64_t off_pos = frame->sframe ? header_len : header_len + cbytes;
+  if (frame->cframe != NULL) {
+    uint8_t* framep = reserve_cframe(frame, off_pos + off_cbytes);
+    if (framep == NULL) {
+      free(off_chunk);
+      BLOSC_TRACE_ERROR("Cannot realloc space for the frame.");
+      return BLOSC2_ERROR_MEMORY_ALLOC;
+    }
+    memcpy(framep + off_pos, off_chunk, (size_t)off_cbytes);
+  }
+  else {
+    blosc2_io_cb *io_cb = blosc2_get_io_cb(frame->schunk->storage->io->id);
+    if (io_cb == NULL) {
+      free(off_chunk);
+      BLOSC_TRACE_ERROR("Error getting the input/output API");
+      return BLOSC2_ERROR_PLUGIN_IO;
+    }
+    void* fp;
+    if (frame->sframe) {
+      fp = sframe_open_index(frame->urlpath, "rb+",
+                             frame->schunk->storage->io);
+    }
+    else {
+      fp = io_cb->open(frame->urlpath, "rb+", frame->schunk->storage->io->params);
+    }
+    if (fp == NULL) {
+      free(off_chunk);
+      BLOSC_TRACE_ERROR("Cannot open the frame for reading and writing.");
+      return BLOSC2_ERROR_FILE_OPEN;
+    }
+    io_cb->seek(fp, off_pos, SEEK_SET);
+    int64_t wbytes = io_cb->write(off_chunk, 1, off_cbytes, fp);
+    io_cb->close(fp);
+    if (wbytes != (size_t)off_cbytes) {
+      free(off_chunk);
+      BLOSC_TRACE_ERROR("Cannot write the offsets to frame.");
+      return BLOSC2_ERROR_FILE_WRITE;
+    }
+  }
+  free(off_chunk);
+  if (frame->coffsets != NULL) {
+    free(frame->coffsets);
+    frame->coffsets = NULL;
+  }
+
+  // The trailer goes right after the offsets
+  frame->len = off_pos + off_cbytes + frame->trailer_len;
+  frame->offsets_pending = 0;
+  rc = frame_update_trailer(frame, frame->schunk);
+  if (rc < 0) {
+    return rc;
+  }
+
+  return 0;
+}
+
+
 // Get the compressed data offsets
 uint8_t* get_coffsets(blosc2_frame_s *frame, int32_t header_len, int64_t cbytes,
                       int32_t nchunks, int32_t *off_cbytes) {
   int32_t chunk_cbytes;
   int rc;
 
+  // The offsets of the chunks appended lately may not be in the frame yet
+  rc = frame_flush_offsets(frame);
+  if (rc < 0) {
+    return NULL;
+  }
+
   if (frame->coffsets != NULL) {
     if (off_cbytes != NULL) {
       rc = blosc2_cbuffer_sizes(frame->coffsets, NULL, &chunk_cbytes, NULL);
@@ -1155,7 +1561,10 @@ int64_t* blosc2_frame_get_offsets(blosc2_schunk *schunk) {
   int64_t* offsets = (int64_t *) malloc((size_t)off_nbytes);
 
   int32_t coffsets_cbytes = 0;
+  // The compressed offsets are read lazily, so do not race with the readers of chunks
+  pthread_mutex_lock(&frame->cache_mutex);
   uint8_t *coffsets = get_coffsets(frame, header_len, cbytes, nchunks, &coffsets_cbytes);
+  pthread_mutex_unlock(&frame->cache_mutex);
   // Decompress offsets
   blosc2_dparams off_dparams = BLOSC2_DPARAMS_DEFAULTS;
   blosc2_context *dctx = blosc2_create_dctx(off_dparams);
@@ -1215,7 +1624,12 @@ int frame_update_header(blosc2_frame_s* frame, blosc2_schunk* schunk, bool new)
   from_big(&prev_h2len, framep + FRAME_HEADER_LEN, sizeof(prev_h2len));
 
   // Build a new header
+  BLOSC_ATOMIC_STORE32(&frame->header_ready, 0);
+  frame_close_handles(frame);
   uint8_t* h2 = new_header_frame(schunk, frame);
+  if (h2 == NULL) {
+    return BLOSC2_ERROR_DATA;
+  }
   uint32_t h2len;
   from_big(&h2len, h2 + FRAME_HEADER_LEN, sizeof(h2len));
 
@@ -1228,6 +1642,7 @@ int frame_update_header(blosc2_frame_s* frame, blosc2_schunk* schunk, bool new)
 
   if (!new && prev_h2len != h2len) {
     BLOSC_TRACE_ERROR("The new metalayer sizes should be equal the existing ones.");
+    blosc_pool_free(h2);
     return BLOSC2_ERROR_DATA;
   }
 
@@ -1247,12 +1662,14 @@ int frame_update_header(blosc2_frame_s* frame, blosc2_schunk* schunk, bool new)
     }
   }
   else {
-    if (new) {
-      frame->cframe = realloc(frame->cframe, h2len);
+    if (new && reserve_cframe(frame, h2len) == NULL) {
+      BLOSC_TRACE_ERROR("Cannot realloc space for the frame.");
+      blosc_pool_free(h2);
+      return BLOSC2_ERROR_MEMORY_ALLOC;
     }
     memcpy(frame->cframe, h2, h2len);
   }
-  free(h2);
+  blosc_pool_free(h2);
 
   return 1;
 }
@@ -1684,6 +2101,7 @@ blosc2_schunk* frame_to_schunk(blosc2_frame_s* frame, bool copy, const blosc2_io
   blosc2_dparams *dparams;
   blosc2_schunk_get_dparams(schunk, &dparams);
   schunk->dctx = blosc2_create_dctx(*dparams);
+  schunk->dctx_pool = dctx_pool_new();
   blosc2_storage storage = {.contiguous = copy ? false : true};
   schunk->storage = get_new_storage(&storage, cparams, dparams, udio);
   free(cparams);
@@ -1815,40 +2233,135 @@ blosc2_schunk* frame_to_schunk(blosc2_frame_s* frame, bool copy, const blosc2_io
     }
   }
 
-  end:
-  if (needs_free) {
-    free(data_chunk);
-  }
-  if (frame->cframe == NULL) {
-    if (!frame->sframe) {
-      io_cb->close(fp);
+  end:
+  if (needs_free) {
+    free(data_chunk);
+  }
+  if (frame->cframe == NULL) {
+    if (!frame->sframe) {
+      io_cb->close(fp);
+    }
+  }
+  free(offsets);
+
+  if (rc < 0 || acc_nbytes != nbytes || acc_cbytes != cbytes) {
+    blosc2_schunk_free(schunk);
+    return NULL;
+  }
+
+  schunk->blocksize = blocksize;
+
+  out:
+  rc = frame_get_metalayers(frame, schunk);
+  if (rc < 0) {
+    blosc2_schunk_free(schunk);
+    BLOSC_TRACE_ERROR("Cannot access the metalayers.");
+    return NULL;
+  }
+
+  rc = frame_get_vlmetalayers(frame, schunk);
+  if (rc < 0) {
+    blosc2_schunk_free(schunk);
+    BLOSC_TRACE_ERROR("Cannot access the vlmetalayers.");
+    return NULL;
+  }
+
+  if (blosc2_vlmeta_exists(schunk, BLOSC2_SHARED_DICT_NAME) >= 0) {
+    // Keep compressing with the dictionary shared by the chunks (it is digested on demand)
+    schunk->cctx->use_dict = 1;
+    schunk->storage->cparams->use_dict = 1;
+  }
+
+  if (blosc2_vlmeta_exists(schunk, BLOSC2_AUTO_FILTER_NAME) >= 0) {
+    // The header has BLOSC_SHUFFLE in place of the automatic filter
+    uint8_t *auto_filters;
+    int32_t auto_filters_len;
+    rc = blosc2_vlmeta_get(schunk, BLOSC2_AUTO_FILTER_NAME, &auto_filters, &auto_filters_len);
+    if (rc < 0 || auto_filters_len != BLOSC2_MAX_FILTERS) {
+      if (rc >= 0) {
+        free(auto_filters);
+      }
+      blosc2_schunk_free(schunk);
+      BLOSC_TRACE_ERROR("Cannot get the automatic filter of the super-chunk.");
+      return NULL;
+    }
+    memcpy(schunk->storage->cparams->filters, auto_filters, BLOSC2_MAX_FILTERS);
+    free(auto_filters);
+    blosc2_free_ctx(schunk->cctx);
+    schunk->cctx = blosc2_create_cctx(*schunk->storage->cparams);
+    if (schunk->cctx == NULL) {
+      blosc2_schunk_free(schunk);
+      BLOSC_TRACE_ERROR("Cannot create the compression context of the super-chunk.");
+      return NULL;
+    }
+  }
+
+  return schunk;
+}
+
+
+// Load the decompressed offsets of the (flushed) frame into `frame->offsets` (with `frame->cache_mutex` held)
+static int load_offsets(blosc2_frame_s* frame, int32_t header_len, int64_t cbytes, int32_t nchunks) {
+  int32_t maxitems = nchunks < FRAME_OFFSETS_FLUSH_MIN ? FRAME_OFFSETS_FLUSH_MIN : nchunks;
+  int64_t* offsets = blosc_malloc((size_t)maxitems * sizeof(int64_t));
+  if (offsets == NULL) {
+    BLOSC_TRACE_ERROR("Cannot allocate space for the offsets.");
+    return BLOSC2_ERROR_MEMORY_ALLOC;
+  }
+  if (nchunks > 0) {
+    int32_t coffsets_cbytes;
+    uint8_t *coffsets = get_coffsets(frame, header_len, cbytes, nchunks, &coffsets_cbytes);
+    if (coffsets == NULL) {
+      BLOSC_TRACE_ERROR("Cannot get the offsets for the frame.");
+      blosc_free(offsets);
+      return BLOSC2_ERROR_DATA;
+    }
+    if (coffsets_cbytes == 0) {
+      coffsets_cbytes = (int32_t)cbytes;
+    }
+
+    // Decompress offsets
+    blosc2_dparams off_dparams = BLOSC2_DPARAMS_DEFAULTS;
+    blosc2_context *dctx = blosc2_create_dctx(off_dparams);
+    int32_t prev_nbytes = blosc2_decompress_ctx(dctx, coffsets, coffsets_cbytes, offsets,
+                                                nchunks * sizeof(int64_t));
+    blosc2_free_ctx(dctx);
+    if (prev_nbytes != nchunks * (int32_t)sizeof(int64_t)) {
+      blosc_free(offsets);
+      BLOSC_TRACE_ERROR("Cannot decompress the offsets chunk.");
+      return prev_nbytes < 0 ? prev_nbytes : BLOSC2_ERROR_DATA;
+    }
+  }
+
+  // Compute the id for the next chunk in sparse frames (special chunks have negative offsets)
+  int64_t sframe_chunk_id = -1;
+  if (frame->sframe) {
+    for (int i = 0; i < nchunks; ++i) {
+      if (offsets[i] > sframe_chunk_id) {
+        sframe_chunk_id = offsets[i];
+      }
     }
   }
-  free(offsets);
-
-  if (rc < 0 || acc_nbytes != nbytes || acc_cbytes != cbytes) {
-    blosc2_schunk_free(schunk);
-    return NULL;
-  }
+  frame->offsets = offsets;
+  frame->noffsets = nchunks;
+  frame->offsets_maxitems = maxitems;
+  frame->sframe_nextid = sframe_chunk_id + 1;
+  BLOSC_ATOMIC_STORE32(&frame->offsets_ready, 1);
 
-  schunk->blocksize = blocksize;
+  return 0;
+}
 
-  out:
-  rc = frame_get_metalayers(frame, schunk);
-  if (rc < 0) {
-    blosc2_schunk_free(schunk);
-    BLOSC_TRACE_ERROR("Cannot access the metalayers.");
-    return NULL;
-  }
 
-  rc = frame_get_vlmetalayers(frame, schunk);
-  if (rc < 0) {
-    blosc2_schunk_free(schunk);
-    BLOSC_TRACE_ERROR("Cannot access the vlmetalayers.");
-    return NULL;
+// Load the decompressed offsets unless they are already.  Readers in several threads may get here
+// at once, so they are loaded just once.
+static int ensure_offsets(blosc2_frame_s* frame, int32_t header_len, int64_t cbytes, int32_t nchunks) {
+  if (BLOSC_ATOMIC_LOAD32(&frame->offsets_ready)) {
+    return 0;
   }
-
-  return schunk;
+  pthread_mutex_lock(&frame->cache_mutex);
+  int rc = frame->offsets_ready ? 0 : load_offsets(frame, header_len, cbytes, nchunks);
+  pthread_mutex_unlock(&frame->cache_mutex);
+  return rc;
 }
 
 
@@ -1867,33 +2380,59 @@ int sort_offset(const void* a, const void* b) {
 
 int get_coffset(blosc2_frame_s* frame, int32_t header_len, int64_t cbytes,
                 int32_t nchunk, int32_t nchunks, int64_t *offset) {
-  int32_t off_cbytes;
-  // Get the offset to nchunk
-  uint8_t *coffsets = get_coffsets(frame, header_len, cbytes, nchunks, &off_cbytes);
-  if (coffsets == NULL) {
+  // Decompress the offsets once, so that locating a chunk is just an array lookup
+  int rc = ensure_offsets(frame, header_len, cbytes, nchunks);
+  if (rc < 0) {
+    BLOSC_TRACE_ERROR("Cannot get the offset for chunk %d for the frame.", nchunk);
+    return rc;
+  }
+  if (nchunk < 0 || nchunk >= frame->noffsets) {
     BLOSC_TRACE_ERROR("Cannot get the offset for chunk %d for the frame.", nchunk);
     return BLOSC2_ERROR_DATA;
   }
 
-  // Get the 64-bit offset
-  int rc = blosc2_getitem(coffsets, off_cbytes, nchunk, 1, offset, (int32_t)sizeof(int64_t));
-  if (rc < 0) {
-    BLOSC_TRACE_ERROR("Problems retrieving a chunk offset.");
-  } else if (!frame->sframe && *offset > frame->len) {
+  *offset = frame->offsets[nchunk];
+  if (!frame->sframe && *offset > frame->len) {
     BLOSC_TRACE_ERROR("Cannot read chunk %d outside of frame boundary.", nchunk);
-    rc = BLOSC2_ERROR_READ_BUFFER;
+    return BLOSC2_ERROR_READ_BUFFER;
   }
 
-  return rc;
+  return 0;
+}
+
+
+// Cache the header and the chunk offsets, so that readers in several threads only have to look them up
+int frame_cache_offsets(blosc2_frame_s* frame) {
+  int32_t header_len;
+  int64_t frame_len;
+  int64_t nbytes;
+  int64_t cbytes;
+  int32_t blocksize;
+  int32_t nchunks;
+  int32_t typesize;
+
+  int rc = get_header_info(frame, &header_len, &frame_len, &nbytes, &cbytes,
+                           &blocksize, NULL, &nchunks,
+                           &typesize, NULL, NULL, NULL, NULL, NULL,
+                           frame->schunk->storage->io);
+  if (rc < 0) {
+    BLOSC_TRACE_ERROR("Unable to get meta info from frame.");
+    return rc;
+  }
+  rc = ensure_offsets(frame, header_len, cbytes, nchunks);
+  if (rc < 0) {
+    return rc;
+  }
+
+  return 0;
 }
 
 
 // Detect and return a chunk with special values in offsets (only zeros, NaNs and non initialized)
-int frame_special_chunk(int64_t special_value, int32_t nbytes, int32_t typesize, int32_t blocksize,
-                        uint8_t** chunk, int32_t cbytes, bool *needs_free) {
+// Build the chunk for a special value in `chunk` (of `cbytes`)
+static int fill_special_chunk(int64_t special_value, int32_t nbytes, int32_t typesize,
+                              int32_t blocksize, uint8_t* chunk, int32_t cbytes) {
   int rc = 0;
-  *chunk = malloc(cbytes);
-  *needs_free = true;
 
   // Detect the kind of special value
   uint64_t zeros_mask = (uint64_t) BLOSC2_SPECIAL_ZERO << (8 * 7);  // chunk of zeros
@@ -1904,19 +2443,19 @@ int frame_special_chunk(int64_t special_value, int32_t nbytes, int32_t typesize,
   cparams.typesize = typesize;
   cparams.blocksize = blocksize;
   if (special_value & zeros_mask) {
-    rc = blosc2_chunk_zeros(cparams, nbytes, *chunk, cbytes);
+    rc = blosc2_chunk_zeros(cparams, nbytes, chunk, cbytes);
     if (rc < 0) {
       BLOSC_TRACE_ERROR("Error creating a zero chunk");
     }
   }
   else if (special_value & uninit_mask) {
-    rc = blosc2_chunk_uninit(cparams, nbytes, *chunk, cbytes);
+    rc = blosc2_chunk_uninit(cparams, nbytes, chunk, cbytes);
     if (rc < 0) {
       BLOSC_TRACE_ERROR("Error creating a non initialized chunk");
     }
   }
   else if (special_value & nans_mask) {
-    rc = blosc2_chunk_nans(cparams, nbytes, *chunk, cbytes);
+    rc = blosc2_chunk_nans(cparams, nbytes, chunk, cbytes);
     if (rc < 0) {
       BLOSC_TRACE_ERROR("Error creating a nan chunk");
     }
@@ -1926,6 +2465,16 @@ int frame_special_chunk(int64_t special_value, int32_t nbytes, int32_t typesize,
     rc = BLOSC2_ERROR_DATA;
   }
 
+  return rc;
+}
+
+
+int frame_special_chunk(int64_t special_value, int32_t nbytes, int32_t typesize, int32_t blocksize,
+                        uint8_t** chunk, int32_t cbytes, bool *needs_free) {
+  *chunk = malloc(cbytes);
+  *needs_free = true;
+
+  int rc = fill_special_chunk(special_value, nbytes, typesize, blocksize, *chunk, cbytes);
   if (rc < 0) {
     free(*chunk);
     *needs_free = false;
@@ -2004,34 +2553,37 @@ int frame_get_chunk(blosc2_frame_s *frame, int nchunk, uint8_t **chunk, bool *ne
     return sframe_get_chunk(frame, nchunk, chunk, needs_free);
   }
 
-  blosc2_io_cb *io_cb = blosc2_get_io_cb(frame->schunk->storage->io->id);
-  if (io_cb == NULL) {
-    BLOSC_TRACE_ERROR("Error getting the input/output API");
-    return BLOSC2_ERROR_PLUGIN_IO;
+  uint8_t* view = frame_map(frame, header_len + offset, BLOSC_EXTENDED_HEADER_LENGTH);
+  if (view != NULL) {
+    // The chunk can be returned straight from the mapping of the file
+    rc = blosc2_cbuffer_sizes(view, NULL, &chunk_cbytes, NULL);
+    if (rc < 0) {
+      return rc;
+    }
+    *chunk = frame_map(frame, header_len + offset, chunk_cbytes);
+    if (*chunk == NULL) {
+      BLOSC_TRACE_ERROR("Compressed bytes exceed beyond frame length.");
+      return BLOSC2_ERROR_READ_BUFFER;
+    }
   }
-
-  if (frame->cframe == NULL) {
+  else if (frame->cframe == NULL) {
     uint8_t header[BLOSC_EXTENDED_HEADER_LENGTH];
-    void* fp = io_cb->open(frame->urlpath, "rb", frame->schunk->storage->io->params);
-    io_cb->seek(fp, header_len + offset, SEEK_SET);
-    int64_t rbytes = io_cb->read(header, 1, sizeof(header), fp);
+    int64_t rbytes = frame_read(frame, -1, header_len + offset, header, sizeof(header));
     if (rbytes != sizeof(header)) {
       BLOSC_TRACE_ERROR("Cannot read the cbytes for chunk in the frame.");
-      io_cb->close(fp);
       return BLOSC2_ERROR_FILE_READ;
     }
     rc = blosc2_cbuffer_sizes(header, NULL, &chunk_cbytes, NULL);
     if (rc < 0) {
       BLOSC_TRACE_ERROR("Cannot read the cbytes for chunk in the frame.");
-      io_cb->close(fp);
       return rc;
     }
     *chunk = malloc(chunk_cbytes);
-    io_cb->seek(fp, header_len + offset, SEEK_SET);
-    rbytes = io_cb->read(*chunk, 1, chunk_cbytes, fp);
-    io_cb->close(fp);
+    rbytes = frame_read(frame, -1, header_len + offset, *chunk, chunk_cbytes);
     if (rbytes != chunk_cbytes) {
       BLOSC_TRACE_ERROR("Cannot read the chunk out of the frame.");
+      free(*chunk);
+      *chunk = NULL;
       return BLOSC2_ERROR_FILE_READ;
     }
     *needs_free = true;
@@ -2059,7 +2611,8 @@ int frame_get_chunk(blosc2_frame_s *frame, int nchunk, uint8_t **chunk, bool *ne
  * The size of the (compressed, potentially lazy) chunk is returned.  If some problem is detected,
  * a negative code is returned instead.
 */
-int frame_get_lazychunk(blosc2_frame_s *frame, int nchunk, uint8_t **chunk, bool *needs_free) {
+static int get_lazychunk(blosc2_frame_s *frame, int nchunk, uint8_t **chunk, bool *needs_free,
+                         bool pooled) {
   int32_t header_len;
   int64_t frame_len;
   int64_t nbytes;
@@ -2070,7 +2623,6 @@ int frame_get_lazychunk(blosc2_frame_s *frame, int nchunk, uint8_t **chunk, bool
   int32_t typesize;
   int32_t lazychunk_cbytes;
   int64_t offset;
-  void* fp = NULL;
 
   *chunk = NULL;
   *needs_free = false;
@@ -2104,35 +2656,41 @@ int frame_get_lazychunk(blosc2_frame_s *frame, int nchunk, uint8_t **chunk, bool
       // Last chunk is incomplete.  Compute its actual size.
       chunksize_ = nbytes % chunksize;
     }
-    rc = frame_special_chunk(offset, chunksize_, typesize, blocksize, chunk,
-                             (int32_t)lazychunk_cbytes, needs_free);
+    if (pooled) {
+      *chunk = blosc_pool_malloc(lazychunk_cbytes);
+      *needs_free = true;
+      rc = fill_special_chunk(offset, chunksize_, typesize, blocksize, *chunk, lazychunk_cbytes);
+    }
+    else {
+      rc = frame_special_chunk(offset, chunksize_, typesize, blocksize, chunk,
+                               (int32_t)lazychunk_cbytes, needs_free);
+    }
     goto end;
   }
 
-  blosc2_io_cb *io_cb = blosc2_get_io_cb(frame->schunk->storage->io->id);
-  if (io_cb == NULL) {
-    BLOSC_TRACE_ERROR("Error getting the input/output API");
-    rc = BLOSC2_ERROR_PLUGIN_IO;
-    goto end;
+  uint8_t* view = frame_map(frame, header_len + offset, BLOSC_EXTENDED_HEADER_LENGTH);
+  if (view != NULL) {
+    // The whole chunk can be returned straight from the mapping of the file (no need to be lazy)
+    rc = blosc2_cbuffer_sizes(view, NULL, &lazychunk_cbytes, NULL);
+    if (rc < 0) {
+      goto end;
+    }
+    *chunk = frame_map(frame, header_len + offset, lazychunk_cbytes);
+    if (*chunk == NULL) {
+      BLOSC_TRACE_ERROR("Compressed bytes exceed beyond frame length.");
+      rc = BLOSC2_ERROR_READ_BUFFER;
+    }
   }
-
-  if (frame->cframe == NULL) {
+  else if (frame->cframe == NULL) {
     // TODO: make this portable across different endianness
     // Get info for building a lazy chunk
     int32_t chunk_nbytes;
     int32_t chunk_cbytes;
     int32_t chunk_blocksize;
     uint8_t header[BLOSC_EXTENDED_HEADER_LENGTH];
-    if (frame->sframe) {
-      // The chunk is not in the frame
-      fp = sframe_open_chunk(frame->urlpath, offset, "rb",
-                             frame->schunk->storage->io);
-    }
-    else {
-      fp = io_cb->open(frame->urlpath, "rb", frame->schunk->storage->io->params);
-      io_cb->seek(fp, header_len + offset, SEEK_SET);
-    }
-    int64_t rbytes = io_cb->read(header, 1, BLOSC_EXTENDED_HEADER_LENGTH, fp);
+    // For sparse frames the chunk is not in the frame, and offset is the id of its file
+    int64_t chunk_start = frame->sframe ? 0 : header_len + offset;
+    int64_t rbytes = frame_read(frame, offset, chunk_start, header, BLOSC_EXTENDED_HEADER_LENGTH);
     if (rbytes != BLOSC_EXTENDED_HEADER_LENGTH) {
       BLOSC_TRACE_ERROR("Cannot read the header for chunk in the frame.");
       rc = BLOSC2_ERROR_FILE_READ;
@@ -2150,6 +2708,19 @@ int frame_get_lazychunk(blosc2_frame_s *frame, int nchunk, uint8_t **chunk, bool
     int32_t special_type = (header[BLOSC2_CHUNK_BLOSC2_FLAGS] >> 4) & BLOSC2_SPECIAL_MASK;
     int memcpyed = header[BLOSC2_CHUNK_FLAGS] & (uint8_t) BLOSC_MEMCPYED;
 
+    if (special_type == 0 && !memcpyed && (header[BLOSC2_CHUNK_BLOSC2_FLAGS] & BLOSC2_USEDICT)) {
+      // The dictionary section goes where the lazy trailer would be, so read the whole chunk
+      lazychunk_cbytes = chunk_cbytes;
+      *chunk = pooled ? blosc_pool_malloc(lazychunk_cbytes) : malloc(lazychunk_cbytes);
+      *needs_free = true;
+      rbytes = frame_read(frame, offset, chunk_start, *chunk, lazychunk_cbytes);
+      if (rbytes != lazychunk_cbytes) {
+        BLOSC_TRACE_ERROR("Cannot read the chunk out of the frame.");
+        rc = BLOSC2_ERROR_FILE_READ;
+      }
+      goto end;
+    }
+
     size_t trailer_offset = BLOSC_EXTENDED_HEADER_LENGTH;
     size_t streams_offset = BLOSC_EXTENDED_HEADER_LENGTH;
     if (special_type == 0) {
@@ -2173,18 +2744,11 @@ int frame_get_lazychunk(blosc2_frame_s *frame, int nchunk, uint8_t **chunk, bool
       rc = BLOSC2_ERROR_INVALID_HEADER;
       goto end;
     }
-    *chunk = malloc(lazychunk_cbytes);
+    *chunk = pooled ? blosc_pool_malloc(lazychunk_cbytes) : malloc(lazychunk_cbytes);
     *needs_free = true;
 
     // Read just the full header and bstarts section too (lazy partial length)
-    if (frame->sframe) {
-      io_cb->seek(fp, 0, SEEK_SET);
-    }
-    else {
-      io_cb->seek(fp, header_len + offset, SEEK_SET);
-    }
-
-    rbytes = io_cb->read(*chunk, 1, streams_offset, fp);
+    rbytes = frame_read(frame, offset, chunk_start, *chunk, (int64_t)streams_offset);
     if (rbytes != streams_offset) {
       BLOSC_TRACE_ERROR("Cannot read the (lazy) chunk out of the frame.");
       rc = BLOSC2_ERROR_FILE_READ;
@@ -2209,7 +2773,7 @@ int frame_get_lazychunk(blosc2_frame_s *frame, int nchunk, uint8_t **chunk, bool
       *(int64_t*)(*chunk + trailer_offset + sizeof(int32_t)) = header_len + offset;
     }
 
-    int32_t* block_csizes = malloc(nblocks * sizeof(int32_t));
+    int32_t* block_csizes = blosc_pool_malloc(nblocks * sizeof(int32_t));
 
     if (memcpyed) {
       // When memcpyed the blocksizes are trivial to compute
@@ -2225,7 +2789,7 @@ int frame_get_lazychunk(blosc2_frame_s *frame, int nchunk, uint8_t **chunk, bool
       // of order because of multi-threading), and get a reverse index too.
       memcpy(block_csizes, *chunk + BLOSC_EXTENDED_HEADER_LENGTH, nblocks * sizeof(int32_t));
       // Helper structure to keep track of original indexes
-      struct csize_idx *csize_idx = malloc(nblocks * sizeof(struct csize_idx));
+      struct csize_idx *csize_idx = blosc_pool_malloc(nblocks * sizeof(struct csize_idx));
       for (int n = 0; n < (int)nblocks; n++) {
         csize_idx[n].val = block_csizes[n];
         csize_idx[n].idx = n;
@@ -2239,12 +2803,12 @@ int frame_get_lazychunk(blosc2_frame_s *frame, int nchunk, uint8_t **chunk, bool
       }
       idx = csize_idx[nblocks - 1].idx;
       block_csizes[idx] = (int)chunk_cbytes - csize_idx[nblocks - 1].val;
-      free(csize_idx);
+      blosc_pool_free(csize_idx);
     }
     // Copy the csizes at the end of the trailer
     void *trailer_csizes = *chunk + lazychunk_cbytes - nblocks * sizeof(int32_t);
     memcpy(trailer_csizes, block_csizes, nblocks * sizeof(int32_t));
-    free(block_csizes);
+    blosc_pool_free(block_csizes);
   } else {
     // The chunk is in memory and just one pointer away
     int64_t chunk_header_offset = header_len + offset;
@@ -2265,12 +2829,14 @@ int frame_get_lazychunk(blosc2_frame_s *frame, int nchunk, uint8_t **chunk, bool
   }
 
   end:
-  if (fp != NULL) {
-    io_cb->close(fp);
-  }
   if (rc < 0) {
     if (*needs_free) {
-      free(*chunk);
+      if (pooled) {
+        blosc_pool_free(*chunk);
+      }
+      else {
+        free(*chunk);
+      }
       *chunk = NULL;
       *needs_free = false;
     }
@@ -2281,6 +2847,11 @@ int frame_get_lazychunk(blosc2_frame_s *frame, int nchunk, uint8_t **chunk, bool
 }
 
 
+int frame_get_lazychunk(blosc2_frame_s *frame, int nchunk, uint8_t **chunk, bool *needs_free) {
+  return get_lazychunk(frame, nchunk, chunk, needs_free, false);
+}
+
+
 /* Fill an empty frame with special values (fast path). */
 int frame_fill_special(blosc2_frame_s* frame, int64_t nitems, int special_value,
                        int32_t chunksize, blosc2_schunk* schunk) {
@@ -2384,7 +2955,7 @@ int frame_fill_special(blosc2_frame_s* frame, int64_t nitems, int special_value,
   if (frame->cframe != NULL) {
     uint8_t* framep = frame->cframe;
     /* Make space for the new chunk and copy it */
-    frame->cframe = framep = realloc(framep, (size_t)new_frame_len);
+    framep = reserve_cframe(frame, new_frame_len);
     if (framep == NULL) {
       BLOSC_TRACE_ERROR("Cannot realloc space for the frame.");
       return BLOSC2_ERROR_FRAME_SPECIAL;
@@ -2412,11 +2983,8 @@ int frame_fill_special(blosc2_frame_s* frame, int64_t nitems, int special_value,
     }
   }
 
-  // Invalidate the cache for chunk offsets
-  if (frame->coffsets != NULL) {
-    free(frame->coffsets);
-    frame->coffsets = NULL;
-  }
+  // Invalidate the caches for chunk offsets
+  invalidate_offsets(frame);
   free(off_chunk);
 
   frame->len = new_frame_len;
@@ -2491,33 +3059,27 @@ void* frame_append_chunk(blosc2_frame_s* frame, void* chunk, blosc2_schunk* schu
     }
   }
 
-  // Get the current offsets and add one more
-  int32_t off_nbytes = (nchunks + 1) * sizeof(int64_t);
-  int64_t* offsets = (int64_t *) malloc((size_t)off_nbytes);
-  if (nchunks > 0) {
-    int32_t coffsets_cbytes;
-    uint8_t *coffsets = get_coffsets(frame, header_len, cbytes, nchunks, &coffsets_cbytes);
-    if (coffsets == NULL) {
-      BLOSC_TRACE_ERROR("Cannot get the offsets for the frame.");
-      free(offsets);
-      return NULL;
-    }
-    if (coffsets_cbytes == 0) {
-      coffsets_cbytes = (int32_t)cbytes;
-    }
-
-    // Decompress offsets
-    blosc2_dparams off_dparams = BLOSC2_DPARAMS_DEFAULTS;
-    blosc2_context *dctx = blosc2_create_dctx(off_dparams);
-    int32_t prev_nbytes = blosc2_decompress_ctx(dctx, coffsets, coffsets_cbytes, offsets,
-                                                nchunks * sizeof(int64_t));
-    blosc2_free_ctx(dctx);
-    if (prev_nbytes < 0) {
-      free(offsets);
-      BLOSC_TRACE_ERROR("Cannot decompress the offsets chunk.");
+  // Get the current offsets and make room for one more
+  rc = ensure_offsets(frame, header_len, cbytes, nchunks);
+  if (rc < 0) {
+    return NULL;
+  }
+  if (frame->noffsets != nchunks) {
+    BLOSC_TRACE_ERROR("The number of chunks in the offsets (%d) does not match the ones "
+                      "in the header frame (%d).", frame->noffsets, nchunks);
+    return NULL;
+  }
+  if (nchunks == frame->offsets_maxitems) {
+    int32_t maxitems = frame->offsets_maxitems * 2;
+    int64_t* offsets = blosc_realloc(frame->offsets, (size_t)maxitems * sizeof(int64_t));
+    if (offsets == NULL) {
+      BLOSC_TRACE_ERROR("Cannot realloc space for the offsets.");
       return NULL;
     }
+    frame->offsets = offsets;
+    frame->offsets_maxitems = maxitems;
   }
+  int64_t* offsets = frame->offsets;
 
   // Add the new offset
   int64_t sframe_chunk_id = -1;
@@ -2544,120 +3106,100 @@ void* frame_append_chunk(blosc2_frame_s* frame, void* chunk, blosc2_schunk* schu
       break;
     default:
       if (frame->sframe) {
-        // Compute the sframe_chunk_id value
-        for (int i = 0; i < nchunks; ++i) {
-          if (offsets[i] > sframe_chunk_id) {
-            sframe_chunk_id = offsets[i];
-          }
-        }
-        offsets[nchunks] = ++sframe_chunk_id;
+        sframe_chunk_id = frame->sframe_nextid;
+        offsets[nchunks] = sframe_chunk_id;
       }
       else {
         offsets[nchunks] = cbytes;
       }
   }
 
-  // Re-compress the offsets again
-  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
-  cparams.splitmode = BLOSC_NEVER_SPLIT;
-  cparams.typesize = sizeof(int64_t);
-  cparams.blocksize = 16 * 1024;  // based on experiments with create_frame.c bench
-  cparams.nthreads = 4;  // 4 threads seems a decent default for nowadays CPUs
-  cparams.compcode = BLOSC_BLOSCLZ;
-  blosc2_context* cctx = blosc2_create_cctx(cparams);
-  void* off_chunk = malloc((size_t)off_nbytes + BLOSC_MAX_OVERHEAD);
-  int32_t new_off_cbytes = blosc2_compress_ctx(cctx, offsets, off_nbytes,
-                                               off_chunk, off_nbytes + BLOSC_MAX_OVERHEAD);
-  blosc2_free_ctx(cctx);
-  free(offsets);
-  if (new_off_cbytes < 0) {
-    free(off_chunk);
-    return NULL;
-  }
-  // printf("%f\n", (double) off_nbytes / new_off_cbytes);
-
+  // Only the chunk is written here; the offsets chunk (and the trailer after it) are
+  // written by frame_flush_offsets(), so that appending is not O(nchunks).
   int64_t new_cbytes = cbytes + chunk_cbytes;
   int64_t new_frame_len;
   if (frame->sframe) {
-    new_frame_len = header_len + 0 + new_off_cbytes + frame->trailer_len;
+    new_frame_len = header_len + 0;
   }
   else {
-    new_frame_len = header_len + new_cbytes + new_off_cbytes + frame->trailer_len;
+    new_frame_len = header_len + new_cbytes;
   }
 
   void* fp = NULL;
   if (frame->cframe != NULL) {
     uint8_t* framep = frame->cframe;
     /* Make space for the new chunk and copy it */
-    frame->cframe = framep = realloc(framep, (size_t)new_frame_len);
+    framep = reserve_cframe(frame, new_frame_len);
     if (framep == NULL) {
       BLOSC_TRACE_ERROR("Cannot realloc space for the frame.");
       return NULL;
     }
     /* Copy the chunk */
     memcpy(framep + header_len + cbytes, chunk, (size_t)chunk_cbytes);
-    /* Copy the offsets */
-    memcpy(framep + header_len + new_cbytes, off_chunk, (size_t)new_off_cbytes);
+  }
+  else if (frame->sframe) {
+    if (chunk_cbytes != 0) {
+      if (sframe_chunk_id < 0) {
+        BLOSC_TRACE_ERROR("The chunk id (%" PRId64 ") is not correct", sframe_chunk_id);
+        return NULL;
+      }
+      if (sframe_create_chunk(frame, chunk, sframe_chunk_id, chunk_cbytes) == NULL) {
+        BLOSC_TRACE_ERROR("Cannot write the full chunk.");
+        return NULL;
+      }
+    }
   }
   else {
-    int64_t wbytes;
     blosc2_io_cb *io_cb = blosc2_get_io_cb(frame->schunk->storage->io->id);
     if (io_cb == NULL) {
       BLOSC_TRACE_ERROR("Error getting the input/output API");
       return NULL;
     }
-
-    if (frame->sframe) {
-      // Update the offsets chunk in the chunks frame
-      if (chunk_cbytes != 0) {
-        if (sframe_chunk_id < 0) {
-          BLOSC_TRACE_ERROR("The chunk id (%" PRId64 ") is not correct", sframe_chunk_id);
-          return NULL;
-        }
-        if (sframe_create_chunk(frame, chunk, sframe_chunk_id, chunk_cbytes) == NULL) {
-          BLOSC_TRACE_ERROR("Cannot write the full chunk.");
-          return NULL;
-        }
-      }
-      fp = sframe_open_index(frame->urlpath, "rb+",
-                             frame->schunk->storage->io);
-      io_cb->seek(fp, header_len, SEEK_SET);
-    }
-    else {
-      // Regular frame
-      fp = io_cb->open(frame->urlpath, "rb+", frame->schunk->storage->io->params);
-      io_cb->seek(fp, header_len + cbytes, SEEK_SET);
-      wbytes = io_cb->write(chunk, 1, chunk_cbytes, fp);  // the new chunk
-      if (wbytes != (size_t)chunk_cbytes) {
-        BLOSC_TRACE_ERROR("Cannot write the full chunk to frame.");
-        io_cb->close(fp);
-        return NULL;
-      }
+    // Regular frame
+    fp = io_cb->open(frame->urlpath, "rb+", frame->schunk->storage->io->params);
+    if (fp == NULL) {
+      BLOSC_TRACE_ERROR("Cannot open the frame for reading and writing.");
+      return NULL;
     }
-    wbytes = io_cb->write(off_chunk, 1, new_off_cbytes, fp);  // the new offsets
+    io_cb->seek(fp, header_len + cbytes, SEEK_SET);
+    int64_t wbytes = io_cb->write(chunk, 1, chunk_cbytes, fp);  // the new chunk
     io_cb->close(fp);
-    if (wbytes != (size_t)new_off_cbytes) {
-      BLOSC_TRACE_ERROR("Cannot write the offsets to frame.");
+    if (wbytes != (size_t)chunk_cbytes) {
+      BLOSC_TRACE_ERROR("Cannot write the full chunk to frame.");
       return NULL;
     }
   }
-  // Invalidate the cache for chunk offsets
+  // The compressed offsets in the frame are outdated now
   if (frame->coffsets != NULL) {
     free(frame->coffsets);
     frame->coffsets = NULL;
   }
-  free(chunk);  // chunk has always to be a copy when reaching here...
-  free(off_chunk);
 
+  frame->noffsets = nchunks + 1;
+  frame->offsets_pending++;
+  if (sframe_chunk_id >= 0) {
+    frame->sframe_nextid = sframe_chunk_id + 1;
+  }
   frame->len = new_frame_len;
   rc = frame_update_header(frame, schunk, false);
   if (rc < 0) {
     return NULL;
   }
 
-  rc = frame_update_trailer(frame, schunk);
-  if (rc < 0) {
-    return NULL;
+  int32_t maxpending = frame->offsets_maxpending;
+  if (maxpending == 0) {
+    // Re-write the offsets when the pending ones are a fraction of them, so that the
+    // cost of appending is O(1) amortized
+    maxpending = frame->noffsets / FRAME_OFFSETS_FLUSH_RATIO;
+    if (maxpending < FRAME_OFFSETS_FLUSH_MIN) {
+      maxpending = FRAME_OFFSETS_FLUSH_MIN;
+    }
+  }
+  if (frame->offsets_pending >= maxpending) {
+    rc = frame_flush_offsets(frame);
+    if (rc < 0) {
+      return NULL;
+    }
   }
 
   return frame;
@@ -2753,7 +3295,8 @@ void* frame_insert_chunk(blosc2_frame_s* frame, int nchunk, void* chunk, blosc2_
         offsets[i] = offsets[i - 1];
       }
       if (frame->sframe) {
-        for (int i = 0; i < nchunks; ++i) {
+        // The offsets have been shifted already, so the last one is at nchunks
+        for (int i = 0; i <= nchunks; ++i) {
           if (offsets[i] > sframe_chunk_id) {
             sframe_chunk_id = offsets[i];
           }
@@ -2799,7 +3342,7 @@ void* frame_insert_chunk(blosc2_frame_s* frame, int nchunk, void* chunk, blosc2_
   if (frame->cframe != NULL) {
     uint8_t* framep = frame->cframe;
     /* Make space for the new chunk and copy it */
-    frame->cframe = framep = realloc(framep, (size_t)new_frame_len);
+    framep = reserve_cframe(frame, new_frame_len);
     if (framep == NULL) {
       BLOSC_TRACE_ERROR("Cannot realloc space for the frame.");
       return NULL;
@@ -2850,12 +3393,9 @@ void* frame_insert_chunk(blosc2_frame_s* frame, int nchunk, void* chunk, blosc2_
       BLOSC_TRACE_ERROR("Cannot write the offsets to frame.");
       return NULL;
     }
-    // Invalidate the cache for chunk offsets
-    if (frame->coffsets != NULL) {
-      free(frame->coffsets);
-      frame->coffsets = NULL;
-    }
   }
+  // Invalidate the caches for chunk offsets
+  invalidate_offsets(frame);
   free(chunk);  // chunk has always to be a copy when reaching here...
   free(off_chunk);
 
@@ -3024,7 +3564,7 @@ void* frame_update_chunk(blosc2_frame_s* frame, int nchunk, void* chunk, blosc2_
   if (frame->cframe != NULL) {
     uint8_t* framep = frame->cframe;
     /* Make space for the new chunk and copy it */
-    frame->cframe = framep = realloc(framep, (size_t)new_frame_len);
+    framep = reserve_cframe(frame, new_frame_len);
     if (framep == NULL) {
       BLOSC_TRACE_ERROR("Cannot realloc space for the frame.");
       return NULL;
@@ -3072,12 +3612,9 @@ void* frame_update_chunk(blosc2_frame_s* frame, int nchunk, void* chunk, blosc2_
       BLOSC_TRACE_ERROR("Cannot write the offsets to frame.");
       return NULL;
     }
-    // Invalidate the cache for chunk offsets
-    if (frame->coffsets != NULL) {
-      free(frame->coffsets);
-      frame->coffsets = NULL;
-    }
   }
+  // Invalidate the caches for chunk offsets
+  invalidate_offsets(frame);
   free(chunk);  // chunk has always to be a copy when reaching here...
   free(off_chunk);
 
@@ -3178,7 +3715,7 @@ void* frame_delete_chunk(blosc2_frame_s* frame, int nchunk, blosc2_schunk* schun
   if (frame->cframe != NULL) {
     uint8_t* framep = frame->cframe;
     /* Make space for the new chunk and copy it */
-    frame->cframe = framep = realloc(framep, (size_t)new_frame_len);
+    framep = reserve_cframe(frame, new_frame_len);
     if (framep == NULL) {
       BLOSC_TRACE_ERROR("Cannot realloc space for the frame.");
       return NULL;
@@ -3223,12 +3760,9 @@ void* frame_delete_chunk(blosc2_frame_s* frame, int nchunk, blosc2_schunk* schun
       BLOSC_TRACE_ERROR("Cannot write the offsets to frame.");
       return NULL;
     }
-    // Invalidate the cache for chunk offsets
-    if (frame->coffsets != NULL) {
-      free(frame->coffsets);
-      frame->coffsets = NULL;
-    }
   }
+  // Invalidate the caches for chunk offsets
+  invalidate_offsets(frame);
   free(off_chunk);
 
   frame->len = new_frame_len;
@@ -3328,7 +3862,7 @@ int frame_reorder_offsets(blosc2_frame_s* frame, const int* offsets_order, blosc
   if (frame->cframe != NULL) {
     uint8_t* framep = frame->cframe;
     /* Make space for the new chunk and copy it */
-    frame->cframe = framep = realloc(framep, (size_t)new_frame_len);
+    framep = reserve_cframe(frame, new_frame_len);
     if (framep == NULL) {
       BLOSC_TRACE_ERROR("Cannot realloc space for the frame.");
       return BLOSC2_ERROR_MEMORY_ALLOC;
@@ -3364,11 +3898,8 @@ int frame_reorder_offsets(blosc2_frame_s* frame, const int* offsets_order, blosc
     }
   }
 
-  // Invalidate the cache for chunk offsets
-  if (frame->coffsets != NULL) {
-    free(frame->coffsets);
-    frame->coffsets = NULL;
-  }
+  // Invalidate the caches for chunk offsets
+  invalidate_offsets(frame);
   free(off_chunk);
 
   frame->len = new_frame_len;
@@ -3394,8 +3925,9 @@ int frame_decompress_chunk(blosc2_context *dctx, blosc2_frame_s* frame, int nchu
   int32_t chunk_cbytes;
   int rc;
 
-  // Use a lazychunk here in order to do a potential parallel read.
-  rc = frame_get_lazychunk(frame, nchunk, &src, &needs_free);
+  // Use a lazychunk here in order to do a potential parallel read.  It is only needed
+  // here, so its buffer (if any) comes from the pool.
+  rc = get_lazychunk(frame, nchunk, &src, &needs_free, true);
   if (rc < 0) {
     BLOSC_TRACE_ERROR("Cannot get the chunk in position %d.", nchunk);
     goto end;
@@ -3427,7 +3959,7 @@ int frame_decompress_chunk(blosc2_context *dctx, blosc2_frame_s* frame, int nchu
   }
   end:
   if (needs_free) {
-    free(src);
+    blosc_pool_free(src);
   }
   return rc;
 }
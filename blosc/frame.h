@@ -14,6 +14,12 @@
 #include <stdio.h>
 #include <stdint.h>
 
+#if defined(_WIN32) && !defined(__GNUC__)
+  #include "win32/pthread.h"
+#else
+  #include <pthread.h>
+#endif
+
 // Different types of frames
 #define FRAME_CONTIGUOUS_TYPE 0
 #define FRAME_DIRECTORY_TYPE 1
@@ -50,10 +56,45 @@
 #define FRAME_TRAILER_LEN_OFFSET (22)  // offset to trailer length (counting from the end)
 #define FRAME_TRAILER_VLMETALAYERS (2)
 
+// When automatic, the offsets chunk is re-written after this number of appends at least...
+#define FRAME_OFFSETS_FLUSH_MIN (64)
+// ...and when the pending offsets are 1/FRAME_OFFSETS_FLUSH_RATIO of the total
+#define FRAME_OFFSETS_FLUSH_RATIO (8)
+
+// The number of file handles that a frame keeps open for reading (lazy) chunks
+#define FRAME_NHANDLES (4)
+
+
+// The fixed part of the frame header, parsed
+typedef struct {
+  int32_t header_len;
+  int64_t frame_len;
+  int64_t nbytes;
+  int64_t cbytes;
+  int32_t blocksize;
+  int32_t chunksize;
+  int32_t nchunks;
+  int32_t typesize;
+  uint8_t compcode;
+  uint8_t compcode_meta;
+  uint8_t clevel;
+  uint8_t nfilters;
+  uint8_t filters[BLOSC2_MAX_FILTERS];
+  uint8_t filters_meta[BLOSC2_MAX_FILTERS];
+} frame_header;
+
+// A file handle kept open for reading (lazy) chunks
+typedef struct {
+  void* fp;                 //!< The file handle; if NULL, the slot is empty
+  int64_t id;               //!< The id of the chunk file (sparse frames) or -1 (contiguous frames)
+  blosc2_io_cb* io_cb;      //!< The callbacks that opened @p fp
+  int32_t nreaders;         //!< The number of threads reading from @p fp
+} frame_handle;
 
 typedef struct {
   char* urlpath;            //!< The name of the file or directory if it's an sframe; if NULL, this is in-memory
   uint8_t* cframe;          //!< The in-memory, contiguous frame buffer
+  int64_t cframe_capacity;  //!< The bytes booked for @p cframe; if 0, they are unknown
   bool avoid_cframe_free;   //!< Whether the cframe can be freed (false) or not (true).
   uint8_t* coffsets;        //!< Pointers to the (compressed, on-disk) chunk offsets
   int64_t len;              //!< The current length of the frame in (compressed) bytes
@@ -61,8 +102,32 @@ typedef struct {
   uint32_t trailer_len;     //!< The current length of the trailer in (compressed) bytes
   bool sframe;              //!< Whether the frame is sparse (true) or not
   blosc2_schunk *schunk;    //!< The schunk associated
+  int64_t* offsets;         //!< The decompressed chunk offsets (built lazily)
+  int32_t noffsets;         //!< The number of chunk offsets in @p offsets
+  int32_t offsets_maxitems; //!< The capacity (in items) of @p offsets
+  int32_t offsets_pending;  //!< The number of appended offsets not yet written in the frame
+  int32_t offsets_maxpending;  //!< The maximum for @p offsets_pending; if 0, it is automatic
+  int64_t sframe_nextid;    //!< The id for the next chunk appended to a sparse frame
+  int32_t offsets_ready;    //!< Whether @p offsets are loaded (read and written atomically)
+  int32_t header_ready;     //!< Whether @p header is up to date (read and written atomically)
+  frame_header header;      //!< The cached header
+  pthread_mutex_t cache_mutex;           //!< Serializes the lazy loads of @p header and @p offsets
+  frame_handle handles[FRAME_NHANDLES];  //!< The file handles kept open for reading
+  pthread_mutex_t handles_mutex;         //!< Protects the @p handles slots
 } blosc2_frame_s;
 
+// A batch of reads in flight out of an on-disk frame
+typedef struct {
+  blosc2_frame_s* frame;
+  blosc2_io_cb* io_cb;
+  const blosc2_io_ext_cb* io_ext;
+  int64_t id;               //!< The id of the chunk file (sparse frames) or -1 (contiguous frames)
+  frame_handle* handle;     //!< The slot of the handle; if NULL, @p fp is not kept by the frame
+  bool reuse;               //!< Whether @p fp was already open in its slot
+  void* fp;
+  void* batch;              //!< The batch of the IO backend
+} frame_batch;
+
 
 /*********************************************************************
   Frame struct related functions.
@@ -151,6 +216,104 @@ int frame_decompress_chunk(blosc2_context* dctx, blosc2_frame_s* frame, int nchu
 int frame_update_header(blosc2_frame_s* frame, blosc2_schunk* schunk, bool new);
 int frame_update_trailer(blosc2_frame_s* frame, blosc2_schunk* schunk);
 
+/**
+ * @brief Write the offsets of the chunks appended so far (and the trailer) into the frame.
+ *
+ * Appending a chunk only writes the chunk data and the header, so the frame cannot be
+ * read by other readers until the offsets are flushed.  This happens automatically every
+ * now and then, and whenever the frame is serialized, modified in other ways or freed.
+ *
+ * @param frame The frame to be flushed.
+ *
+ * @return 0 if succeeds. Else, a negative value.
+ */
+int frame_flush_offsets(blosc2_frame_s* frame);
+
+/**
+ * @brief Read @p nbytes from an on-disk frame, reusing the file handles kept by the frame.
+ *
+ * This is safe to call from several threads at the same time.  When the IO backend has a
+ * positional read callback, all the threads share the same handle; else, each one takes its own.
+ *
+ * @param frame The (on-disk) frame.
+ * @param id The id of the chunk file for sparse frames; ignored for contiguous ones.
+ * @param offset The position to read from, in the frame file or in the chunk file.
+ * @param dest The buffer where the data is read into.
+ * @param nbytes The number of bytes to read.
+ *
+ * @return The number of bytes read. If an error occurs, a negative value.
+ */
+int64_t frame_read(blosc2_frame_s* frame, int64_t id, int64_t offset, void* dest, int64_t nbytes);
+
+/**
+ * @brief Read (and cache) the header and the chunk offsets of a frame.
+ *
+ * After this, getting the chunks of the frame does not modify it, so it can be
+ * done from several threads at once.
+ *
+ * @param frame The frame.
+ *
+ * @return 0 if succeeds. Else a negative code is returned.
+ */
+int frame_cache_offsets(blosc2_frame_s* frame);
+
+/**
+ * @brief Start reading several buffers out of an on-disk frame in the background.
+ *
+ * This only works when the IO backend supports batches of reads (e.g. BLOSC2_IO_FILESYSTEM_URING).
+ *
+ * @param frame The (on-disk) frame.
+ * @param id The id of the chunk file for sparse frames; ignored for contiguous ones.
+ * @param nreads The number of reads.
+ * @param ptrs The buffers where each read goes.
+ * @param nbytes The number of bytes of each read.
+ * @param offsets The position of each read, in the frame file or in the chunk file.
+ *
+ * @return The batch of reads. If the backend cannot read in the background, NULL.
+ */
+frame_batch* frame_submit_reads(blosc2_frame_s* frame, int64_t id, int32_t nreads, void** ptrs,
+                                const int64_t* nbytes, const int64_t* offsets);
+
+/**
+ * @brief Wait for a read of a batch to complete.  This is safe to call from several threads.
+ *
+ * @param batch The batch of reads.
+ * @param nread The index of the read in the batch.
+ *
+ * @return The number of bytes read. If an error occurs, a negative value.
+ */
+int64_t frame_complete_read(frame_batch* batch, int32_t nread);
+
+/**
+ * @brief Wait for all the reads in flight of a batch and free it.
+ *
+ * @param batch The batch of reads.
+ */
+void frame_release_reads(frame_batch* batch);
+
+/**
+ * @brief Get a pointer to @p nbytes at @p offset of an on-disk, contiguous frame.
+ *
+ * This only works when the IO backend has a map callback (e.g. BLOSC2_IO_FILESYSTEM_MMAP).
+ * The pointer is valid until the frame is modified or freed.
+ *
+ * @param frame The frame.
+ * @param offset The position in the frame file.
+ * @param nbytes The number of bytes that must be accessible.
+ *
+ * @return The pointer. If the backend cannot map the frame, NULL.
+ */
+uint8_t* frame_map(blosc2_frame_s* frame, int64_t offset, int64_t nbytes);
+
+/**
+ * @brief Close the file handles kept by the frame for reading.
+ *
+ * Must be called whenever the frame is written, so that no stale (buffered) data is read.
+ *
+ * @param frame The frame.
+ */
+void frame_close_handles(blosc2_frame_s* frame);
+
 int frame_fill_special(blosc2_frame_s* frame, int64_t nitems, int special_value,
                        int32_t chunksize, blosc2_schunk* schunk);
 
@@ -12,11 +12,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <inttypes.h>
 #include <sys/stat.h>
 #include "blosc2.h"
 #include "blosc-private.h"
+#include "context.h"
 #include "frame.h"
 #include "stune.h"
+#include "chunk-cache.h"
+#include "dctx-pool.h"
+#include "allocator.h"
 
 #if defined(_WIN32)
   #include <windows.h>
@@ -45,8 +50,10 @@
 int blosc2_schunk_get_cparams(blosc2_schunk *schunk, blosc2_cparams **cparams) {
   *cparams = calloc(sizeof(blosc2_cparams), 1);
   (*cparams)->schunk = schunk;
+  // The pipeline with the automatic filter is only kept in the compression context
+  bool auto_filter = schunk->cctx != NULL && schunk->cctx->auto_filter;
   for (int i = 0; i < BLOSC2_MAX_FILTERS; i++) {
-    (*cparams)->filters[i] = schunk->filters[i];
+    (*cparams)->filters[i] = auto_filter ? schunk->cctx->auto_filters[i] : schunk->filters[i];
     (*cparams)->filters_meta[i] = schunk->filters_meta[i];
   }
   (*cparams)->compcode = schunk->compcode;
@@ -85,6 +92,10 @@ void update_schunk_properties(struct blosc2_schunk* schunk) {
   for (int i = 0; i < BLOSC2_MAX_FILTERS; i++) {
     schunk->filters[i] = cparams->filters[i];
     schunk->filters_meta[i] = cparams->filters_meta[i];
+    if (schunk->filters[i] == BLOSC_AUTO_FILTER) {
+      // Frame headers get a filter that older libraries know (see store_auto_filter())
+      schunk->filters[i] = BLOSC_SHUFFLE;
+    }
   }
   schunk->compcode = cparams->compcode;
   schunk->compcode_meta = cparams->compcode_meta;
@@ -106,6 +117,13 @@ void update_schunk_properties(struct blosc2_schunk* schunk) {
   }
   dparams->schunk = schunk;
   schunk->dctx = blosc2_create_dctx(*dparams);
+  if (schunk->dctx_pool == NULL) {
+    schunk->dctx_pool = dctx_pool_new();
+  }
+  else {
+    // The idle contexts were made out of the former dparams
+    dctx_pool_clear(schunk->dctx_pool);
+  }
 }
 
 
@@ -115,6 +133,22 @@ static bool file_exists (char *filename) {
 }
 
 
+/* Keep the pipeline with the automatic filter in a vlmetalayer, so that the super-chunk
+   keeps choosing the filters of new chunks when reopened */
+static int store_auto_filter(blosc2_schunk* schunk) {
+  if (!schunk->cctx->auto_filter) {
+    return 0;
+  }
+  int rc = blosc2_vlmeta_add(schunk, BLOSC2_AUTO_FILTER_NAME, schunk->cctx->auto_filters,
+                             BLOSC2_MAX_FILTERS, NULL);
+  if (rc < 0) {
+    BLOSC_TRACE_ERROR("Cannot store the automatic filter in the super-chunk.");
+    return rc;
+  }
+  return 0;
+}
+
+
 /* Create a new super-chunk */
 blosc2_schunk* blosc2_schunk_new(blosc2_storage *storage) {
   blosc2_schunk* schunk = calloc(1, sizeof(blosc2_schunk));
@@ -184,6 +218,10 @@ blosc2_schunk* blosc2_schunk_new(blosc2_storage *storage) {
     schunk->frame = (blosc2_frame*)frame;
   }
 
+  if (store_auto_filter(schunk) < 0) {
+    return NULL;
+  }
+
   return schunk;
 }
 
@@ -198,6 +236,8 @@ blosc2_schunk* blosc2_schunk_copy(blosc2_schunk *schunk, blosc2_storage *storage
   // Check if cparams are equals
   bool cparams_equal = true;
   blosc2_cparams cparams = {0};
+  // The filters of a pipeline with an automatic filter are chosen for every chunk
+  uint8_t* filters = schunk->cctx->auto_filter ? schunk->cctx->auto_filters : schunk->cctx->filters;
   if (storage->cparams == NULL) {
     // When cparams are not specified, just use the same of schunk
     cparams.typesize = schunk->cctx->typesize;
@@ -206,7 +246,7 @@ blosc2_schunk* blosc2_schunk_copy(blosc2_schunk *schunk, blosc2_storage *storage
     cparams.compcode_meta = schunk->cctx->compcode_meta;
     cparams.use_dict = schunk->cctx->use_dict;
     cparams.blocksize = schunk->cctx->blocksize;
-    memcpy(cparams.filters, schunk->cctx->filters, BLOSC2_MAX_FILTERS);
+    memcpy(cparams.filters, filters, BLOSC2_MAX_FILTERS);
     memcpy(cparams.filters_meta, schunk->cctx->filters_meta, BLOSC2_MAX_FILTERS);
     storage->cparams = &cparams;
   }
@@ -231,7 +271,7 @@ blosc2_schunk* blosc2_schunk_copy(blosc2_schunk *schunk, blosc2_storage *storage
     cparams_equal = false;
   }
   for (int i = 0; i < BLOSC2_MAX_FILTERS; ++i) {
-    if (cparams.filters[i] != schunk->cctx->filters[i] ||
+    if (cparams.filters[i] != filters[i] ||
         cparams.filters_meta[i] != schunk->cctx->filters_meta[i]) {
       cparams_equal = false;
     }
@@ -288,6 +328,10 @@ blosc2_schunk* blosc2_schunk_copy(blosc2_schunk *schunk, blosc2_storage *storage
     uint8_t *content;
     uint32_t content_len;
     char* name = schunk->vlmetalayers[nmeta]->name;
+    if (strcmp(name, BLOSC2_AUTO_FILTER_NAME) == 0) {
+      // The new super-chunk stores its own when its cparams have an automatic filter
+      continue;
+    }
     if (blosc2_vlmeta_get(schunk, name, &content, &content_len) < 0) {
       BLOSC_TRACE_ERROR("Can not get %s `vlmetalayer`.", name);
     }
@@ -337,6 +381,11 @@ int64_t blosc2_schunk_to_buffer(blosc2_schunk* schunk, uint8_t** dest, bool* nee
 
   if ((schunk->storage->contiguous == true) && (schunk->storage->urlpath == NULL)) {
     frame =  (blosc2_frame_s*)(schunk->frame);
+    int rc = frame_flush_offsets(frame);
+    if (rc < 0) {
+      BLOSC_TRACE_ERROR("Cannot write the offsets of the frame.");
+      return rc;
+    }
     *dest = frame->cframe;
     cframe_len = frame->len;
     *needs_free = false;
@@ -350,6 +399,12 @@ int64_t blosc2_schunk_to_buffer(blosc2_schunk* schunk, uint8_t** dest, bool* nee
       return BLOSC2_ERROR_SCHUNK_COPY;
     }
     frame = (blosc2_frame_s*)(schunk_copy->frame);
+    int rc = frame_flush_offsets(frame);
+    if (rc < 0) {
+      BLOSC_TRACE_ERROR("Cannot write the offsets of the frame.");
+      blosc2_schunk_free(schunk_copy);
+      return rc;
+    }
     *dest = frame->cframe;
     cframe_len = frame->len;
     *needs_free = true;
@@ -369,6 +424,11 @@ int64_t frame_to_file(blosc2_frame_s* frame, const char* urlpath) {
     BLOSC_TRACE_ERROR("Error getting the input/output API");
     return BLOSC2_ERROR_PLUGIN_IO;
   }
+  int rc = frame_flush_offsets(frame);
+  if (rc < 0) {
+    BLOSC_TRACE_ERROR("Cannot write the offsets of the frame.");
+    return rc;
+  }
   void* fp = io_cb->open(urlpath, "wb", frame->schunk->storage->io);
   int64_t nitems = io_cb->write(frame->cframe, frame->len, 1, fp);
   io_cb->close(fp);
@@ -401,6 +461,12 @@ int64_t blosc2_schunk_to_file(blosc2_schunk* schunk, const char* urlpath) {
     return BLOSC2_ERROR_SCHUNK_COPY;
   }
   blosc2_frame_s* frame = (blosc2_frame_s*)(schunk_copy->frame);
+  int rc = frame_flush_offsets(frame);
+  if (rc < 0) {
+    BLOSC_TRACE_ERROR("Cannot write the offsets of the frame.");
+    blosc2_schunk_free(schunk_copy);
+    return rc;
+  }
   int64_t frame_len = frame->len;
   blosc2_schunk_free(schunk_copy);
   return frame_len;
@@ -409,6 +475,13 @@ int64_t blosc2_schunk_to_file(blosc2_schunk* schunk, const char* urlpath) {
 
 /* Free all memory from a super-chunk. */
 int blosc2_schunk_free(blosc2_schunk *schunk) {
+  if (schunk->frame != NULL) {
+    // Leave the frame in a consistent state for other readers
+    int rc = frame_flush_offsets((blosc2_frame_s *) schunk->frame);
+    if (rc < 0) {
+      BLOSC_TRACE_ERROR("Cannot write the offsets of the frame.");
+    }
+  }
   if (schunk->data != NULL) {
     for (int i = 0; i < schunk->nchunks; i++) {
       free(schunk->data[i]);
@@ -462,6 +535,12 @@ int blosc2_schunk_free(blosc2_schunk *schunk) {
   if (schunk->udbtune != NULL) {
     free(schunk->udbtune);
   }
+  if (schunk->cache != NULL) {
+    chunk_cache_free(schunk->cache);
+  }
+  if (schunk->dctx_pool != NULL) {
+    dctx_pool_free(schunk->dctx_pool);
+  }
   free(schunk);
 
   return 0;
@@ -615,16 +694,16 @@ int blosc2_schunk_append_chunk(blosc2_schunk *schunk, uint8_t *chunk, bool copy)
     }
   }
 
-  if (copy) {
-    // Make a copy of the chunk
-    uint8_t *chunk_copy = malloc(chunk_cbytes);
-    memcpy(chunk_copy, chunk, chunk_cbytes);
-    chunk = chunk_copy;
-  }
-
   // Update super-chunk or frame
   blosc2_frame_s* frame = (blosc2_frame_s*)schunk->frame;
   if (frame == NULL) {
+    if (copy) {
+      // Make a copy of the chunk
+      uint8_t *chunk_copy = malloc(chunk_cbytes);
+      memcpy(chunk_copy, chunk, chunk_cbytes);
+      chunk = chunk_copy;
+    }
+
     // Check that we are not appending a small chunk after another small chunk
     if ((schunk->nchunks > 0) && (chunk_nbytes < (size_t)schunk->chunksize)) {
       uint8_t* last_chunk = schunk->data[nchunks - 1];
@@ -655,10 +734,14 @@ int blosc2_schunk_append_chunk(blosc2_schunk *schunk, uint8_t *chunk, bool copy)
     schunk->data[nchunks] = chunk;
   }
   else {
+    // The frame keeps its own copy of the chunk
     if (frame_append_chunk(frame, chunk, schunk) == NULL) {
       BLOSC_TRACE_ERROR("Problems appending a chunk.");
       return BLOSC2_ERROR_CHUNK_APPEND;
     }
+    if (!copy) {
+      free(chunk);
+    }
   }
   return schunk->nchunks;
 }
@@ -712,6 +795,10 @@ int blosc2_schunk_insert_chunk(blosc2_schunk *schunk, int nchunk, uint8_t *chunk
     chunk = chunk_copy;
   }
 
+  if (schunk->cache != NULL) {
+    chunk_cache_insert(schunk->cache, nchunk);
+  }
+
   // Update super-chunk or frame
   blosc2_frame_s* frame = (blosc2_frame_s*)schunk->frame;
   if (frame == NULL) {
@@ -846,6 +933,10 @@ int blosc2_schunk_update_chunk(blosc2_schunk *schunk, int nchunk, uint8_t *chunk
     }
   }
 
+  if (schunk->cache != NULL) {
+    chunk_cache_invalidate(schunk->cache, nchunk);
+  }
+
   // Update super-chunk or frame
   if (schunk->frame == NULL) {
     if (!copy && (chunk_cbytes < chunk_nbytes)) {
@@ -913,6 +1004,10 @@ int blosc2_schunk_delete_chunk(blosc2_schunk *schunk, int nchunk) {
     }
   }
 
+  if (schunk->cache != NULL) {
+    chunk_cache_delete(schunk->cache, nchunk);
+  }
+
   // Update super-chunk or frame
   if (schunk->frame == NULL) {
     // Free old chunk
@@ -938,17 +1033,28 @@ int blosc2_schunk_delete_chunk(blosc2_schunk *schunk, int nchunk) {
 
 /* Append a data buffer to a super-chunk. */
 int blosc2_schunk_append_buffer(blosc2_schunk *schunk, void *src, int32_t nbytes) {
-  uint8_t* chunk = malloc(nbytes + BLOSC_MAX_OVERHEAD);
+  // Frames copy the chunk, so its buffer can come from the pool and be reused
+  bool pooled = schunk->frame != NULL;
+  uint8_t* chunk = pooled ? blosc_pool_malloc(nbytes + BLOSC_MAX_OVERHEAD) :
+                            malloc(nbytes + BLOSC_MAX_OVERHEAD);
   schunk->current_nchunk = schunk->nchunks;
   /* Compress the src buffer using super-chunk context */
   int cbytes = blosc2_compress_ctx(schunk->cctx, src, nbytes, chunk,
                                    nbytes + BLOSC_MAX_OVERHEAD);
   if (cbytes < 0) {
-    free(chunk);
+    if (pooled) {
+      blosc_pool_free(chunk);
+    }
+    else {
+      free(chunk);
+    }
     return cbytes;
   }
   // We don't need a copy of the chunk, as it will be shrunk if necessary
-  int nchunks = blosc2_schunk_append_chunk(schunk, chunk, false);
+  int nchunks = blosc2_schunk_append_chunk(schunk, chunk, pooled);
+  if (pooled) {
+    blosc_pool_free(chunk);
+  }
   if (nchunks < 0) {
     BLOSC_TRACE_ERROR("Error appending a buffer in super-chunk");
     return nchunks;
@@ -958,16 +1064,38 @@ int blosc2_schunk_append_buffer(blosc2_schunk *schunk, void *src, int32_t nbytes
 }
 
 
-/* Decompress and return a chunk that is part of a super-chunk. */
-int blosc2_schunk_decompress_chunk(blosc2_schunk *schunk, int nchunk,
-                                   void *dest, int32_t nbytes) {
+/* Get a private decompression context with `nthreads` threads for a reader of a super-chunk */
+static blosc2_context* take_dctx(blosc2_schunk *schunk, int16_t nthreads) {
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = nthreads;
+  dparams.schunk = schunk;
+  dparams.postfilter = schunk->dctx->postfilter;
+  dparams.postparams = schunk->dctx->postparams;
+  if (schunk->dctx_pool == NULL) {
+    return blosc2_create_dctx(dparams);
+  }
+  return dctx_pool_take(schunk->dctx_pool, dparams);
+}
+
+/* Return a context got with take_dctx() */
+static void give_dctx(blosc2_schunk *schunk, blosc2_context *dctx) {
+  if (schunk->dctx_pool == NULL) {
+    blosc2_free_ctx(dctx);
+    return;
+  }
+  dctx_pool_give(schunk->dctx_pool, dctx);
+}
+
+
+/* Decompress a chunk of a super-chunk with the context `dctx` */
+static int decompress_chunk_ctx(blosc2_schunk *schunk, blosc2_context *dctx, int nchunk,
+                                void *dest, int32_t nbytes) {
   int32_t chunk_nbytes;
   int32_t chunk_cbytes;
   int chunksize;
   int rc;
   blosc2_frame_s* frame = (blosc2_frame_s*)schunk->frame;
 
-  schunk->current_nchunk = nchunk;
   if (frame == NULL) {
     if (nchunk >= schunk->nchunks) {
       BLOSC_TRACE_ERROR("nchunk ('%d') exceeds the number of chunks "
@@ -990,7 +1118,7 @@ int blosc2_schunk_decompress_chunk(blosc2_schunk *schunk, int nchunk,
       return BLOSC2_ERROR_INVALID_PARAM;
     }
 
-    chunksize = blosc2_decompress_ctx(schunk->dctx, src, chunk_cbytes, dest, nbytes);
+    chunksize = blosc2_decompress_ctx(dctx, src, chunk_cbytes, dest, nbytes);
     if (chunksize < 0 || chunksize != chunk_nbytes) {
       BLOSC_TRACE_ERROR("Error in decompressing chunk.");
       if (chunksize < 0)
@@ -998,15 +1126,315 @@ int blosc2_schunk_decompress_chunk(blosc2_schunk *schunk, int nchunk,
       return BLOSC2_ERROR_FAILURE;
     }
   } else {
-    chunksize = frame_decompress_chunk(schunk->dctx, frame, nchunk, dest, nbytes);
-    if (chunksize < 0) {
+    chunksize = frame_decompress_chunk(dctx, frame, nchunk, dest, nbytes);
+  }
+  return chunksize;
+}
+
+
+/* Decompress a chunk of a super-chunk, going through the cache of chunks if enabled.
+ * A NULL `dctx` means that a context of the pool is used on a cache miss, so that
+ * concurrent readers do not share one. */
+static int decompress_chunk(blosc2_schunk *schunk, blosc2_context *dctx, int nchunk,
+                            void *dest, int32_t nbytes) {
+  int chunksize;
+
+  // A partial decompression (with a block maskout) cannot be cached
+  bool use_cache = schunk->cache != NULL && (dctx == NULL || dctx->block_maskout == NULL);
+  if (use_cache && nchunk >= 0 && nchunk < schunk->nchunks) {
+    chunksize = chunk_cache_get(schunk->cache, nchunk, dest, nbytes);
+    if (chunksize >= 0) {
       return chunksize;
     }
   }
+
+  // The cache lock is not held while decompressing, so misses are decompressed concurrently
+  blosc2_context* private_dctx = NULL;
+  if (dctx == NULL) {
+    private_dctx = take_dctx(schunk, (int16_t)schunk->dctx->nthreads);
+    if (private_dctx == NULL) {
+      BLOSC_TRACE_ERROR("Cannot create a decompression context.");
+      return BLOSC2_ERROR_MEMORY_ALLOC;
+    }
+    dctx = private_dctx;
+  }
+  dctx->nchunk = nchunk;
+  chunksize = decompress_chunk_ctx(schunk, dctx, nchunk, dest, nbytes);
+  dctx->nchunk = -1;
+  if (private_dctx != NULL) {
+    give_dctx(schunk, private_dctx);
+  }
+  if (chunksize < 0) {
+    return chunksize;
+  }
+
+  if (use_cache) {
+    chunk_cache_put(schunk->cache, nchunk, dest, chunksize);
+  }
   return chunksize;
 }
 
 
+/* Decompress and return a chunk that is part of a super-chunk. */
+int blosc2_schunk_decompress_chunk(blosc2_schunk *schunk, int nchunk,
+                                   void *dest, int32_t nbytes) {
+  if (schunk->cache != NULL && schunk->dctx->block_maskout == NULL) {
+    // Readers may be concurrent, so neither the shared context nor current_nchunk are used
+    return decompress_chunk(schunk, NULL, nchunk, dest, nbytes);
+  }
+  schunk->current_nchunk = nchunk;
+  return decompress_chunk(schunk, schunk->dctx, nchunk, dest, nbytes);
+}
+
+
+typedef struct chunk_job_s chunk_job;
+
+struct chunk_job_s {
+  blosc2_schunk* schunk;
+  blosc2_context* dctx;     // the decompression context of this job
+  int nchunks;
+  int32_t* next;            // the next chunk to read (relative to the caller); shared by all the jobs
+  int* results;             // the result of reading every chunk
+  int (*read_chunk)(chunk_job* job, int i);
+  void* params;             // the parameters of read_chunk; shared by all the jobs
+};
+
+static void t_chunk_job(void* arg) {
+  chunk_job* job = (chunk_job*)arg;
+  while (true) {
+    int32_t i = BLOSC_ATOMIC_FETCH_ADD32(job->next, 1);
+    if (i >= job->nchunks) {
+      break;
+    }
+    job->results[i] = job->read_chunk(job, i);
+  }
+}
+
+/* Read `nchunks` chunks of a super-chunk in parallel with `read_chunk`, which
+ * leaves the result for every chunk in `results`.  Every job takes a context
+ * from the pool of the super-chunk, and the threads that are left over work on
+ * the blocks. */
+static int run_chunk_jobs(blosc2_schunk* schunk, int nchunks, int (*read_chunk)(chunk_job*, int),
+                          void* params, int* results) {
+  // Read the offsets of the chunks here, once for all the jobs
+  blosc2_frame_s* frame = (blosc2_frame_s*)schunk->frame;
+  if (frame != NULL) {
+    int rc = frame_cache_offsets(frame);
+    if (rc < 0) {
+      BLOSC_TRACE_ERROR("Cannot get the chunk offsets of the frame.");
+      return rc;
+    }
+  }
+
+  int nthreads = schunk->dctx->nthreads;
+  int njobs = nthreads < nchunks ? nthreads : nchunks;
+  chunk_job* jobs = malloc(njobs * sizeof(chunk_job));
+  if (jobs == NULL) {
+    BLOSC_TRACE_ERROR("Error allocating memory for the jobs.");
+    return BLOSC2_ERROR_MEMORY_ALLOC;
+  }
+  int32_t next = 0;
+  int rc = BLOSC2_ERROR_SUCCESS;
+  for (int i = 0; i < njobs; i++) {
+    jobs[i].schunk = schunk;
+    jobs[i].dctx = take_dctx(schunk, (int16_t)(nthreads / njobs));
+    if (jobs[i].dctx == NULL) {
+      BLOSC_TRACE_ERROR("Cannot create a decompression context.");
+      rc = BLOSC2_ERROR_MEMORY_ALLOC;
+    }
+    jobs[i].nchunks = nchunks;
+    jobs[i].next = &next;
+    jobs[i].results = results;
+    jobs[i].read_chunk = read_chunk;
+    jobs[i].params = params;
+  }
+  if (rc == BLOSC2_ERROR_SUCCESS) {
+    blosc_run_parallel_jobs(t_chunk_job, njobs, sizeof(chunk_job), jobs);
+  }
+
+  for (int i = 0; i < njobs; i++) {
+    if (jobs[i].dctx != NULL) {
+      give_dctx(schunk, jobs[i].dctx);
+    }
+  }
+  free(jobs);
+
+  return rc;
+}
+
+
+typedef struct {
+  int start;
+  uint8_t* dest;
+  int64_t nbytes;
+} range_params;
+
+/* Decompress the chunk `start + i` of a range */
+static int decompress_range_chunk(chunk_job* job, int i) {
+  range_params* params = (range_params*)job->params;
+  int32_t chunksize = job->schunk->chunksize;
+  int64_t offset = (int64_t)i * chunksize;
+  int64_t room = params->nbytes - offset;
+  if (room > chunksize) {
+    room = chunksize;
+  }
+  if (room <= 0) {
+    return BLOSC2_ERROR_WRITE_BUFFER;
+  }
+  return decompress_chunk(job->schunk, job->dctx, params->start + i,
+                          params->dest + offset, (int32_t)room);
+}
+
+
+/* Decompress the chunks in [start, stop) of a super-chunk, in parallel */
+int64_t blosc2_schunk_decompress_range(blosc2_schunk *schunk, int start, int stop,
+                                       void *dest, int64_t nbytes) {
+  if (start < 0 || stop > schunk->nchunks || start > stop) {
+    BLOSC_TRACE_ERROR("The range [%d, %d) is not in the super-chunk (%d chunks).",
+                      start, stop, schunk->nchunks);
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  int nchunks = stop - start;
+  if (nchunks == 0) {
+    return 0;
+  }
+  if (schunk->chunksize <= 0) {
+    BLOSC_TRACE_ERROR("Decompressing a range needs chunks of the same size.");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+
+  int* results = malloc(nchunks * sizeof(int));
+  if (results == NULL) {
+    BLOSC_TRACE_ERROR("Error allocating memory for decompressing the range.");
+    return BLOSC2_ERROR_MEMORY_ALLOC;
+  }
+  range_params params = {start, dest, nbytes};
+  int64_t rc = run_chunk_jobs(schunk, nchunks, decompress_range_chunk, &params, results);
+  if (rc == 0) {
+    // Only the last chunk of the super-chunk can be smaller than chunksize
+    for (int i = 0; i < nchunks; i++) {
+      if (results[i] < 0) {
+        BLOSC_TRACE_ERROR("Error decompressing the chunk %d.", start + i);
+        rc = results[i];
+        break;
+      }
+      if (results[i] != schunk->chunksize && i < nchunks - 1) {
+        BLOSC_TRACE_ERROR("The chunk %d is smaller than the chunksize.", start + i);
+        rc = BLOSC2_ERROR_DATA;
+        break;
+      }
+      rc += results[i];
+    }
+  }
+  free(results);
+
+  return rc;
+}
+
+
+typedef struct {
+  int64_t start;            // the first item of the slice
+  int64_t stop;             // the item after the last one of the slice
+  int first_chunk;
+  uint8_t* dest;
+} slice_params;
+
+/* Read the items of the slice in the chunk `first_chunk + i`.  The chunks fully
+ * in the slice are decompressed straight into dest, and only the blocks with
+ * items in the slice are decompressed for the chunks at the boundaries. */
+static int get_slice_chunk(chunk_job* job, int i) {
+  slice_params* params = (slice_params*)job->params;
+  blosc2_schunk* schunk = job->schunk;
+  int nchunk = params->first_chunk + i;
+  int32_t typesize = schunk->typesize;
+  int64_t chunk_nitems = schunk->chunksize / typesize;
+  int64_t chunk_start = nchunk * chunk_nitems;
+  int64_t chunk_stop = chunk_start + chunk_nitems;
+  int64_t schunk_nitems = schunk->nbytes / typesize;
+  if (chunk_stop > schunk_nitems) {
+    chunk_stop = schunk_nitems;
+  }
+  int64_t start = params->start > chunk_start ? params->start : chunk_start;
+  int64_t stop = params->stop < chunk_stop ? params->stop : chunk_stop;
+  int32_t nbytes = (int32_t)((stop - start) * typesize);
+  uint8_t* dest = params->dest + (start - params->start) * typesize;
+
+  if (start == chunk_start && stop == chunk_stop) {
+    int rc = decompress_chunk(schunk, job->dctx, nchunk, dest, nbytes);
+    return rc == nbytes ? 0 : rc < 0 ? rc : BLOSC2_ERROR_DATA;
+  }
+
+  uint8_t* chunk;
+  bool needs_free = false;
+  int32_t cbytes;
+  if (schunk->frame != NULL) {
+    cbytes = frame_get_lazychunk((blosc2_frame_s*)schunk->frame, nchunk, &chunk, &needs_free);
+  }
+  else {
+    chunk = schunk->data[nchunk];
+    cbytes = 0;
+    if (chunk != NULL) {
+      int rc = blosc2_cbuffer_sizes(chunk, NULL, &cbytes, NULL);
+      if (rc < 0) {
+        return rc;
+      }
+    }
+  }
+  if (cbytes <= 0) {
+    BLOSC_TRACE_ERROR("Cannot get the chunk %d.", nchunk);
+    return cbytes < 0 ? cbytes : BLOSC2_ERROR_DATA;
+  }
+  int rc = blosc2_getitem_ctx(job->dctx, chunk, cbytes, (int)(start - chunk_start),
+                              (int)(stop - start), dest, nbytes);
+  if (needs_free) {
+    free(chunk);
+  }
+  return rc == nbytes ? 0 : rc < 0 ? rc : BLOSC2_ERROR_DATA;
+}
+
+
+/* Get the items in [start, stop) of a super-chunk, reading the chunks in parallel */
+int blosc2_schunk_get_slice_buffer(blosc2_schunk *schunk, int64_t start, int64_t stop, void *buffer) {
+  int64_t nitems = schunk->nbytes / schunk->typesize;
+  if (start < 0 || stop > nitems || start > stop) {
+    BLOSC_TRACE_ERROR("The slice [%" PRId64 ", %" PRId64 ") is not in the super-chunk (%" PRId64 " items).",
+                      start, stop, nitems);
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  if (start == stop) {
+    return BLOSC2_ERROR_SUCCESS;
+  }
+  if (schunk->chunksize <= 0) {
+    BLOSC_TRACE_ERROR("Getting a slice needs chunks of the same size.");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+
+  int64_t chunk_nitems = schunk->chunksize / schunk->typesize;
+  int first_chunk = (int)(start / chunk_nitems);
+  int nchunks = (int)((stop - 1) / chunk_nitems) + 1 - first_chunk;
+
+  int* results = malloc(nchunks * sizeof(int));
+  if (results == NULL) {
+    BLOSC_TRACE_ERROR("Error allocating memory for getting the slice.");
+    return BLOSC2_ERROR_MEMORY_ALLOC;
+  }
+  slice_params params = {start, stop, first_chunk, buffer};
+  int rc = run_chunk_jobs(schunk, nchunks, get_slice_chunk, &params, results);
+  if (rc == BLOSC2_ERROR_SUCCESS) {
+    for (int i = 0; i < nchunks; i++) {
+      if (results[i] < 0) {
+        BLOSC_TRACE_ERROR("Error getting the slice out of the chunk %d.", first_chunk + i);
+        rc = results[i];
+        break;
+      }
+    }
+  }
+  free(results);
+
+  return rc;
+}
+
+
 /* Return a compressed chunk that is part of a super-chunk in the `chunk` parameter.
  * If the super-chunk is backed by a frame that is disk-based, a buffer is allocated for the
  * (compressed) chunk, and hence a free is needed.  You can check if the chunk requires a free
@@ -1129,6 +1557,10 @@ int blosc2_schunk_reorder_offsets(blosc2_schunk *schunk, int *offsets_order) {
   }
   free(index_check);
 
+  if (schunk->cache != NULL) {
+    chunk_cache_clear(schunk->cache);
+  }
+
   blosc2_frame_s* frame = (blosc2_frame_s*)schunk->frame;
   if (frame != NULL) {
     return frame_reorder_offsets(frame, offsets_order, schunk);
@@ -1153,6 +1585,10 @@ int64_t blosc2_schunk_frame_len(blosc2_schunk* schunk) {
   int64_t len;
   blosc2_frame_s* frame_s = (blosc2_frame_s*)(schunk->frame);
   if (frame_s != NULL) {
+    int rc = frame_flush_offsets(frame_s);
+    if (rc < 0) {
+      return rc;
+    }
     len = frame_s->len;
   }
   else {
@@ -1164,6 +1600,156 @@ int64_t blosc2_schunk_frame_len(blosc2_schunk* schunk) {
 }
 
 
+// Set the maximum number of appends whose offsets are not written in the frame yet
+int blosc2_schunk_set_offsets_flush(blosc2_schunk *schunk, int32_t nappends) {
+  blosc2_frame_s* frame = (blosc2_frame_s*)(schunk->frame);
+  if (frame == NULL) {
+    BLOSC_TRACE_ERROR("This function needs a frame.");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  if (nappends < 0) {
+    BLOSC_TRACE_ERROR("The number of appends cannot be negative.");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  frame->offsets_maxpending = nappends;
+  if (nappends > 0 && frame->offsets_pending >= nappends) {
+    return frame_flush_offsets(frame);
+  }
+
+  return 0;
+}
+
+
+// Write the pending chunk offsets in the frame
+int blosc2_schunk_flush_offsets(blosc2_schunk *schunk) {
+  blosc2_frame_s* frame = (blosc2_frame_s*)(schunk->frame);
+  if (frame == NULL) {
+    BLOSC_TRACE_ERROR("This function needs a frame.");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+
+  return frame_flush_offsets(frame);
+}
+
+
+// Set the size of the cache of decompressed chunks
+int blosc2_schunk_set_cache_size(blosc2_schunk *schunk, int64_t nbytes) {
+  if (nbytes < 0) {
+    BLOSC_TRACE_ERROR("The size of the cache cannot be negative.");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  if (nbytes == 0) {
+    if (schunk->cache != NULL) {
+      chunk_cache_free(schunk->cache);
+      schunk->cache = NULL;
+    }
+    return 0;
+  }
+  if (schunk->cache == NULL) {
+    schunk->cache = chunk_cache_new(nbytes);
+    if (schunk->cache == NULL) {
+      BLOSC_TRACE_ERROR("Error while allocating the cache of chunks.");
+      return BLOSC2_ERROR_MEMORY_ALLOC;
+    }
+  }
+  else {
+    chunk_cache_resize(schunk->cache, nbytes);
+  }
+
+  return 0;
+}
+
+
+// Get the hits and misses of the cache of decompressed chunks
+int blosc2_schunk_get_cache_stats(blosc2_schunk *schunk, int64_t *hits, int64_t *misses) {
+  if (schunk->cache == NULL) {
+    BLOSC_TRACE_ERROR("The cache of chunks is not enabled.");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  chunk_cache_stats(schunk->cache, hits, misses);
+
+  return 0;
+}
+
+
+// Train the dictionary shared by all the (next) chunks of a super-chunk out of some samples
+int blosc2_schunk_train_dict(blosc2_schunk *schunk, const void *samples, int64_t nbytes) {
+  if (blosc2_vlmeta_exists(schunk, BLOSC2_SHARED_DICT_NAME) >= 0) {
+    // The existing chunks refer to it
+    BLOSC_TRACE_ERROR("The super-chunk already has a shared dictionary.");
+    return BLOSC2_ERROR_CODEC_DICT;
+  }
+
+  void *dict;
+  int32_t dict_size;
+  int rc = train_shared_dict(schunk->cctx, samples, nbytes, schunk->chunksize, &dict, &dict_size);
+  if (rc < 0) {
+    return rc;
+  }
+  rc = set_shared_dict(schunk->cctx, dict, dict_size);
+  if (rc < 0) {
+    goto end;
+  }
+  // The dictionary is stored just once in the super-chunk (and read from there for decompressing)
+  rc = blosc2_vlmeta_add(schunk, BLOSC2_SHARED_DICT_NAME, dict, dict_size, NULL);
+  if (rc < 0) {
+    BLOSC_TRACE_ERROR("Cannot store the shared dictionary in the super-chunk.");
+    goto end;
+  }
+  schunk->storage->cparams->use_dict = 1;
+  rc = 0;
+
+  end:
+  free(dict);
+  return rc;
+}
+
+
+// Train the dictionary shared by all the (next) chunks of a super-chunk out of its first chunks
+int blosc2_schunk_train_dict_from_chunks(blosc2_schunk *schunk, int nchunks) {
+  if (nchunks <= 0 || nchunks > schunk->nchunks) {
+    BLOSC_TRACE_ERROR("The number of chunks (%d) must be in [1, %d].", nchunks, schunk->nchunks);
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+
+  uint8_t *samples = NULL;
+  int64_t nbytes = 0;
+  int rc = 0;
+  for (int nchunk = 0; nchunk < nchunks && rc >= 0; nchunk++) {
+    uint8_t *chunk;
+    bool needs_free;
+    int32_t cbytes = blosc2_schunk_get_chunk(schunk, nchunk, &chunk, &needs_free);
+    if (cbytes < 0) {
+      rc = cbytes;
+      break;
+    }
+    int32_t chunk_nbytes;
+    rc = blosc2_cbuffer_sizes(chunk, &chunk_nbytes, NULL, NULL);
+    if (rc >= 0) {
+      uint8_t *samples_ = realloc(samples, (size_t)(nbytes + chunk_nbytes));
+      if (samples_ == NULL) {
+        BLOSC_TRACE_ERROR("Error allocating memory!");
+        rc = BLOSC2_ERROR_MEMORY_ALLOC;
+      }
+      else {
+        samples = samples_;
+        rc = blosc2_decompress_ctx(schunk->dctx, chunk, cbytes, samples + nbytes, chunk_nbytes);
+        nbytes += chunk_nbytes;
+      }
+    }
+    if (needs_free) {
+      free(chunk);
+    }
+  }
+  if (rc >= 0) {
+    rc = blosc2_schunk_train_dict(schunk, samples, nbytes);
+  }
+  free(samples);
+
+  return rc;
+}
+
+
 /**
  * @brief Flush metalayers content into a possible attached frame.
  *
@@ -0,0 +1,346 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#include "shuffle-generic.h"
+#include "shuffle-avx2.h"
+#include "shuffle-avx512.h"
+
+/* Make sure AVX512BW is available for the compilation target and compiler. */
+#if !defined(__AVX512F__) || !defined(__AVX512BW__)
+  #error AVX512BW is not supported by the target architecture/platform and/or this compiler.
+#endif
+
+#include <immintrin.h>
+
+
+/* The shuffles below work in three steps: the bytes of the elements in every
+   128-bit lane are grouped in-lane (vpshufb), the groups are gathered across
+   lanes (vpermd/vpermq/vpermw), and finally the lanes of several registers are
+   transposed, so that every register holds 64 consecutive bytes of a stream.
+   The unshuffles just undo these steps in reverse order. */
+
+/* In-lane byte masks (vpshufb) */
+static const uint8_t shmask2[16] = {0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15};
+static const uint8_t unshmask2[16] = {0, 8, 1, 9, 2, 10, 3, 11, 4, 12, 5, 13, 6, 14, 7, 15};
+/* This one is a 4x4 transpose, so it is its own inverse */
+static const uint8_t shmask4[16] = {0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15};
+static const uint8_t shmask8[16] = {0, 8, 1, 9, 2, 10, 3, 11, 4, 12, 5, 13, 6, 14, 7, 15};
+static const uint8_t unshmask8[16] = {0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15};
+
+/* Cross-lane permutations */
+static const int64_t perm2[8] = {0, 2, 4, 6, 1, 3, 5, 7};
+static const int64_t unperm2[8] = {0, 4, 1, 5, 2, 6, 3, 7};
+/* Again a 4x4 transpose */
+static const int32_t perm4[16] = {0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15};
+static const int16_t perm8[32] = {
+    0, 8, 16, 24, 1, 9, 17, 25, 2, 10, 18, 26, 3, 11, 19, 27,
+    4, 12, 20, 28, 5, 13, 21, 29, 6, 14, 22, 30, 7, 15, 23, 31};
+static const int16_t unperm8[32] = {
+    0, 4, 8, 12, 16, 20, 24, 28, 1, 5, 9, 13, 17, 21, 25, 29,
+    2, 6, 10, 14, 18, 22, 26, 30, 3, 7, 11, 15, 19, 23, 27, 31};
+
+
+static inline __m512i load_mask(const uint8_t* mask) {
+  return _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*)mask));
+}
+
+/* Transpose the 128-bit lanes of 4 registers. */
+static inline void transpose_lanes4(__m512i* zmm) {
+  __m512i t0 = _mm512_shuffle_i64x2(zmm[0], zmm[1], 0x44);
+  __m512i t1 = _mm512_shuffle_i64x2(zmm[0], zmm[1], 0xee);
+  __m512i t2 = _mm512_shuffle_i64x2(zmm[2], zmm[3], 0x44);
+  __m512i t3 = _mm512_shuffle_i64x2(zmm[2], zmm[3], 0xee);
+  zmm[0] = _mm512_shuffle_i64x2(t0, t2, 0x88);
+  zmm[1] = _mm512_shuffle_i64x2(t0, t2, 0xdd);
+  zmm[2] = _mm512_shuffle_i64x2(t1, t3, 0x88);
+  zmm[3] = _mm512_shuffle_i64x2(t1, t3, 0xdd);
+}
+
+/* Transpose the quad words of 8 registers. */
+static inline void transpose_qwords8(__m512i* zmm) {
+  const __m512i even = _mm512_set_epi64(13, 12, 5, 4, 9, 8, 1, 0);
+  const __m512i odd = _mm512_set_epi64(15, 14, 7, 6, 11, 10, 3, 2);
+  __m512i a[8], b[8];
+  int k;
+
+  for (k = 0; k < 4; k++) {
+    a[k * 2] = _mm512_unpacklo_epi64(zmm[k * 2], zmm[k * 2 + 1]);
+    a[k * 2 + 1] = _mm512_unpackhi_epi64(zmm[k * 2], zmm[k * 2 + 1]);
+  }
+  /* b[k] and b[k + 4] get the quad words k and k + 4 of 4 registers */
+  for (k = 0; k < 2; k++) {
+    b[k] = _mm512_permutex2var_epi64(a[k], even, a[k + 2]);
+    b[k + 2] = _mm512_permutex2var_epi64(a[k], odd, a[k + 2]);
+    b[k + 4] = _mm512_permutex2var_epi64(a[k + 4], even, a[k + 6]);
+    b[k + 6] = _mm512_permutex2var_epi64(a[k + 4], odd, a[k + 6]);
+  }
+  for (k = 0; k < 4; k++) {
+    zmm[k] = _mm512_shuffle_i64x2(b[k], b[k + 4], 0x44);
+    zmm[k + 4] = _mm512_shuffle_i64x2(b[k], b[k + 4], 0xee);
+  }
+}
+
+/* Routine optimized for shuffling a buffer for a type size of 2 bytes. */
+static void
+shuffle2_avx512(uint8_t* const dest, const uint8_t* const src,
+                const int32_t vectorizable_elements, const int32_t total_elements) {
+  static const int32_t bytesoftype = 2;
+  int32_t i;
+  int j;
+  __m512i zmm[2];
+
+  const __m512i shmask = load_mask(shmask2);
+  const __m512i perm = _mm512_loadu_si512(perm2);
+
+  for (i = 0; i < vectorizable_elements; i += sizeof(__m512i)) {
+    /* Fetch 64 elements (128 bytes) and group their bytes */
+    for (j = 0; j < 2; j++) {
+      zmm[j] = _mm512_loadu_si512(src + (i * bytesoftype) + (j * sizeof(__m512i)));
+      zmm[j] = _mm512_shuffle_epi8(zmm[j], shmask);
+      zmm[j] = _mm512_permutexvar_epi64(perm, zmm[j]);
+    }
+    /* Store the result vectors */
+    uint8_t* const dest_for_ith_element = dest + i;
+    _mm512_storeu_si512(dest_for_ith_element, _mm512_shuffle_i64x2(zmm[0], zmm[1], 0x44));
+    _mm512_storeu_si512(dest_for_ith_element + total_elements,
+                        _mm512_shuffle_i64x2(zmm[0], zmm[1], 0xee));
+  }
+}
+
+/* Routine optimized for shuffling a buffer for a type size of 4 bytes. */
+static void
+shuffle4_avx512(uint8_t* const dest, const uint8_t* const src,
+                const int32_t vectorizable_elements, const int32_t total_elements) {
+  static const int32_t bytesoftype = 4;
+  int32_t i;
+  int j;
+  __m512i zmm[4];
+
+  const __m512i shmask = load_mask(shmask4);
+  const __m512i perm = _mm512_loadu_si512(perm4);
+
+  for (i = 0; i < vectorizable_elements; i += sizeof(__m512i)) {
+    /* Fetch 64 elements (256 bytes) and group their bytes */
+    for (j = 0; j < 4; j++) {
+      zmm[j] = _mm512_loadu_si512(src + (i * bytesoftype) + (j * sizeof(__m512i)));
+      zmm[j] = _mm512_shuffle_epi8(zmm[j], shmask);
+      zmm[j] = _mm512_permutexvar_epi32(perm, zmm[j]);
+    }
+    transpose_lanes4(zmm);
+    /* Store the result vectors */
+    uint8_t* const dest_for_ith_element = dest + i;
+    for (j = 0; j < 4; j++) {
+      _mm512_storeu_si512(dest_for_ith_element + (j * total_elements), zmm[j]);
+    }
+  }
+}
+
+/* Routine optimized for shuffling a buffer for a type size of 8 bytes. */
+static void
+shuffle8_avx512(uint8_t* const dest, const uint8_t* const src,
+                const int32_t vectorizable_elements, const int32_t total_elements) {
+  static const int32_t bytesoftype = 8;
+  int32_t i;
+  int j;
+  __m512i zmm[8];
+
+  const __m512i shmask = load_mask(shmask8);
+  const __m512i perm = _mm512_loadu_si512(perm8);
+
+  for (i = 0; i < vectorizable_elements; i += sizeof(__m512i)) {
+    /* Fetch 64 elements (512 bytes) and group their bytes */
+    for (j = 0; j < 8; j++) {
+      zmm[j] = _mm512_loadu_si512(src + (i * bytesoftype) + (j * sizeof(__m512i)));
+      zmm[j] = _mm512_shuffle_epi8(zmm[j], shmask);
+      zmm[j] = _mm512_permutexvar_epi16(perm, zmm[j]);
+    }
+    transpose_qwords8(zmm);
+    /* Store the result vectors */
+    uint8_t* const dest_for_ith_element = dest + i;
+    for (j = 0; j < 8; j++) {
+      _mm512_storeu_si512(dest_for_ith_element + (j * total_elements), zmm[j]);
+    }
+  }
+}
+
+/* Routine optimized for unshuffling a buffer for a type size of 2 bytes. */
+static void
+unshuffle2_avx512(uint8_t* const dest, const uint8_t* const src,
+                  const int32_t vectorizable_elements, const int32_t total_elements) {
+  static const int32_t bytesoftype = 2;
+  int32_t i;
+  int j;
+  __m512i zmm[2], zmm1[2];
+
+  const __m512i shmask = load_mask(unshmask2);
+  const __m512i perm = _mm512_loadu_si512(unperm2);
+
+  for (i = 0; i < vectorizable_elements; i += sizeof(__m512i)) {
+    /* Load 64 elements (128 bytes) into 2 ZMM registers. */
+    const uint8_t* const src_for_ith_element = src + i;
+    for (j = 0; j < 2; j++) {
+      zmm[j] = _mm512_loadu_si512(src_for_ith_element + (j * total_elements));
+    }
+    zmm1[0] = _mm512_shuffle_i64x2(zmm[0], zmm[1], 0x44);
+    zmm1[1] = _mm512_shuffle_i64x2(zmm[0], zmm[1], 0xee);
+    /* Store the result vectors in proper order */
+    for (j = 0; j < 2; j++) {
+      zmm1[j] = _mm512_permutexvar_epi64(perm, zmm1[j]);
+      zmm1[j] = _mm512_shuffle_epi8(zmm1[j], shmask);
+      _mm512_storeu_si512(dest + (i * bytesoftype) + (j * sizeof(__m512i)), zmm1[j]);
+    }
+  }
+}
+
+/* Routine optimized for unshuffling a buffer for a type size of 4 bytes. */
+static void
+unshuffle4_avx512(uint8_t* const dest, const uint8_t* const src,
+                  const int32_t vectorizable_elements, const int32_t total_elements) {
+  static const int32_t bytesoftype = 4;
+  int32_t i;
+  int j;
+  __m512i zmm[4];
+
+  const __m512i shmask = load_mask(shmask4);
+  const __m512i perm = _mm512_loadu_si512(perm4);
+
+  for (i = 0; i < vectorizable_elements; i += sizeof(__m512i)) {
+    /* Load 64 elements (256 bytes) into 4 ZMM registers. */
+    const uint8_t* const src_for_ith_element = src + i;
+    for (j = 0; j < 4; j++) {
+      zmm[j] = _mm512_loadu_si512(src_for_ith_element + (j * total_elements));
+    }
+    transpose_lanes4(zmm);
+    /* Store the result vectors in proper order */
+    for (j = 0; j < 4; j++) {
+      zmm[j] = _mm512_permutexvar_epi32(perm, zmm[j]);
+      zmm[j] = _mm512_shuffle_epi8(zmm[j], shmask);
+      _mm512_storeu_si512(dest + (i * bytesoftype) + (j * sizeof(__m512i)), zmm[j]);
+    }
+  }
+}
+
+/* Routine optimized for unshuffling a buffer for a type size of 8 bytes. */
+static void
+unshuffle8_avx512(uint8_t* const dest, const uint8_t* const src,
+                  const int32_t vectorizable_elements, const int32_t total_elements) {
+  static const int32_t bytesoftype = 8;
+  int32_t i;
+  int j;
+  __m512i zmm[8];
+
+  const __m512i shmask = load_mask(unshmask8);
+  const __m512i perm = _mm512_loadu_si512(unperm8);
+
+  for (i = 0; i < vectorizable_elements; i += sizeof(__m512i)) {
+    /* Load 64 elements (512 bytes) into 8 ZMM registers. */
+    const uint8_t* const src_for_ith_element = src + i;
+    for (j = 0; j < 8; j++) {
+      zmm[j] = _mm512_loadu_si512(src_for_ith_element + (j * total_elements));
+    }
+    transpose_qwords8(zmm);
+    /* Store the result vectors in proper order */
+    for (j = 0; j < 8; j++) {
+      zmm[j] = _mm512_permutexvar_epi16(perm, zmm[j]);
+      zmm[j] = _mm512_shuffle_epi8(zmm[j], shmask);
+      _mm512_storeu_si512(dest + (i * bytesoftype) + (j * sizeof(__m512i)), zmm[j]);
+    }
+  }
+}
+
+/* Shuffle a block.  This can never fail. */
+void
+shuffle_avx512(const int32_t bytesoftype, const int32_t blocksize,
+               const uint8_t *_src, uint8_t *_dest) {
+  const int32_t vectorized_chunk_size = bytesoftype * sizeof(__m512i);
+
+  /* Other type sizes (or blocks too small to be vectorized with AVX512)
+     are better served by the AVX2 implementation. */
+  if ((bytesoftype != 2 && bytesoftype != 4 && bytesoftype != 8) ||
+      blocksize < vectorized_chunk_size) {
+    shuffle_avx2(bytesoftype, blocksize, _src, _dest);
+    return;
+  }
+
+  /* If the blocksize is not a multiple of both the typesize and
+     the vector size, round the blocksize down to the next value
+     which is a multiple of both. The vectorized shuffle can be
+     used for that portion of the data, and the naive implementation
+     can be used for the remaining portion. */
+  const int32_t vectorizable_bytes = blocksize - (blocksize % vectorized_chunk_size);
+
+  const int32_t vectorizable_elements = vectorizable_bytes / bytesoftype;
+  const int32_t total_elements = blocksize / bytesoftype;
+
+  /* Optimized shuffle implementations */
+  switch (bytesoftype) {
+    case 2:
+      shuffle2_avx512(_dest, _src, vectorizable_elements, total_elements);
+      break;
+    case 4:
+      shuffle4_avx512(_dest, _src, vectorizable_elements, total_elements);
+      break;
+    default:
+      shuffle8_avx512(_dest, _src, vectorizable_elements, total_elements);
+      break;
+  }
+
+  /* If the buffer had any bytes at the end which couldn't be handled
+     by the vectorized implementations, use the non-optimized version
+     to finish them up. */
+  if (vectorizable_bytes < blocksize) {
+    shuffle_generic_inline(bytesoftype, vectorizable_bytes, blocksize, _src, _dest);
+  }
+}
+
+/* Unshuffle a block.  This can never fail. */
+void
+unshuffle_avx512(const int32_t bytesoftype, const int32_t blocksize,
+                 const uint8_t *_src, uint8_t *_dest) {
+  const int32_t vectorized_chunk_size = bytesoftype * sizeof(__m512i);
+
+  /* Other type sizes (or blocks too small to be vectorized with AVX512)
+     are better served by the AVX2 implementation. */
+  if ((bytesoftype != 2 && bytesoftype != 4 && bytesoftype != 8) ||
+      blocksize < vectorized_chunk_size) {
+    unshuffle_avx2(bytesoftype, blocksize, _src, _dest);
+    return;
+  }
+
+  /* If the blocksize is not a multiple of both the typesize and
+     the vector size, round the blocksize down to the next value
+     which is a multiple of both. The vectorized unshuffle can be
+     used for that portion of the data, and the naive implementation
+     can be used for the remaining portion. */
+  const int32_t vectorizable_bytes = blocksize - (blocksize % vectorized_chunk_size);
+
+  const int32_t vectorizable_elements = vectorizable_bytes / bytesoftype;
+  const int32_t total_elements = blocksize / bytesoftype;
+
+  /* Optimized unshuffle implementations */
+  switch (bytesoftype) {
+    case 2:
+      unshuffle2_avx512(_dest, _src, vectorizable_elements, total_elements);
+      break;
+    case 4:
+      unshuffle4_avx512(_dest, _src, vectorizable_elements, total_elements);
+      break;
+    default:
+      unshuffle8_avx512(_dest, _src, vectorizable_elements, total_elements);
+      break;
+  }
+
+  /* If the buffer had any bytes at the end which couldn't be handled
+     by the vectorized implementations, use the non-optimized version
+     to finish them up. */
+  if (vectorizable_bytes < blocksize) {
+    unshuffle_generic_inline(bytesoftype, vectorizable_bytes, blocksize, _src, _dest);
+  }
+}
@@ -10,7 +10,15 @@
 
 #include <stdbool.h>
 #include <stdio.h>
+#include <math.h>
+#include <string.h>
+#if defined(USING_CMAKE)
+  #include "config.h"
+#endif /*  USING_CMAKE */
 #include "stune.h"
+#include "allocator.h"
+#include "cpuinfo.h"
+#include "blosc-private.h"
 
 
 /* Whether a codec is meant for High Compression Ratios
@@ -33,7 +41,267 @@ static bool is_HCR(blosc2_context * context) {
   }
 }
 
+/* The maximum number of bytes of a chunk that the trials of the adaptive tuner compress */
+#define STUNE_SAMPLE_NBYTES (1024 * 1024)
+
+/* The state of the adaptive tuner (kept in cctx->btune) */
+typedef struct {
+  blosc2_stune_config config;
+  bool tune_filters;     // whether the pipeline is made of the filters that are tried only
+  // The parameters in use
+  int compcode;
+  int clevel;
+  uint8_t filters[BLOSC2_MAX_FILTERS];
+  uint8_t filters_meta[BLOSC2_MAX_FILTERS];
+  int32_t blocksize;     // 0 means automatic
+  // The trials
+  uint8_t* cbuffer;
+  uint8_t* dbuffer;
+  int32_t buffer_nbytes;
+  bool probe;            // whether the next chunk has to be probed
+  double probe_cratio;   // the compression ratio of the chosen parameters when probed
+  int64_t nchunks;       // the chunks compressed since the last probe
+  int64_t nprobes;
+} stune_state;
+
+typedef struct {
+  int compcode;
+  int clevel;
+  uint8_t shuffle;       // the filter in the last slot of the pipeline
+  uint8_t delta;         // the filter in the slot before
+  int32_t blocksize;
+} stune_params;
+
+static const int stune_codecs[] = {
+    BLOSC_BLOSCLZ,
+    BLOSC_LZ4,
+    BLOSC_LZ4HC,
+#if defined(HAVE_ZLIB)
+    BLOSC_ZLIB,
+#endif
+#if defined(HAVE_ZSTD)
+    BLOSC_ZSTD,
+#endif
+};
+
+/* The filters tried, as {delta, shuffle} */
+static const uint8_t stune_filters[][2] = {
+    {BLOSC_NOFILTER, BLOSC_NOSHUFFLE},
+    {BLOSC_NOFILTER, BLOSC_SHUFFLE},
+    {BLOSC_NOFILTER, BLOSC_BITSHUFFLE},
+    {BLOSC_DELTA_SUB, BLOSC_SHUFFLE},
+};
+
+static const int stune_clevels[] = {1, 3, 5, 7, 9};
+
+/* 0 is the automatic blocksize */
+static const int32_t stune_blocksizes[] = {0, 32 * 1024, 128 * 1024, 512 * 1024};
+
+
 void blosc_stune_init(void * config, blosc2_context* cctx, blosc2_context* dctx) {
+  BLOSC_UNUSED_PARAM(dctx);
+  if (config == NULL) {
+    // Just the automatic blocksize
+    return;
+  }
+  stune_state* state = blosc_malloc(sizeof(stune_state));
+  if (state == NULL) {
+    return;
+  }
+  memset(state, 0, sizeof(stune_state));
+  state->config = *(blosc2_stune_config*)config;
+
+  // Only the filters that do not lose information and can be decoded on any chunk are tried
+  state->tune_filters = true;
+  for (int i = 0; i < BLOSC2_MAX_FILTERS - 2; i++) {
+    if (cctx->filters[i] != BLOSC_NOFILTER) {
+      state->tune_filters = false;
+    }
+  }
+  uint8_t delta = cctx->filters[BLOSC2_MAX_FILTERS - 2];
+  uint8_t shuffle = cctx->filters[BLOSC2_MAX_FILTERS - 1];
+  if ((delta != BLOSC_NOFILTER && delta != BLOSC_DELTA_SUB) ||
+      (shuffle != BLOSC_NOSHUFFLE && shuffle != BLOSC_SHUFFLE && shuffle != BLOSC_BITSHUFFLE) ||
+      cctx->filters_meta[BLOSC2_MAX_FILTERS - 1] != 0) {
+    state->tune_filters = false;
+  }
+
+  state->compcode = cctx->compcode;
+  state->clevel = cctx->clevel;
+  memcpy(state->filters, cctx->filters, BLOSC2_MAX_FILTERS);
+  memcpy(state->filters_meta, cctx->filters_meta, BLOSC2_MAX_FILTERS);
+  state->blocksize = cctx->blocksize;
+  state->probe = true;
+  cctx->btune = state;
+}
+
+
+/* Compress (and decompress, if needed) a sample with some parameters, and score them.
+ * Returns false if the parameters cannot be used. */
+static bool stune_trial(blosc2_context* context, stune_state* state, const stune_params* params,
+                        int32_t nbytes, double* score, double* cratio) {
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.compcode = (uint8_t)params->compcode;
+  cparams.clevel = (uint8_t)params->clevel;
+  cparams.typesize = context->typesize;
+  cparams.nthreads = 1;
+  cparams.blocksize = params->blocksize;
+  cparams.splitmode = context->splitmode;
+  memcpy(cparams.filters, state->filters, BLOSC2_MAX_FILTERS);
+  memcpy(cparams.filters_meta, state->filters_meta, BLOSC2_MAX_FILTERS);
+  if (state->tune_filters) {
+    cparams.filters[BLOSC2_MAX_FILTERS - 2] = params->delta;
+    cparams.filters[BLOSC2_MAX_FILTERS - 1] = params->shuffle;
+  }
+  blosc2_context* cctx = blosc2_create_cctx(cparams);
+  if (cctx == NULL) {
+    return false;
+  }
+  blosc_timestamp_t last, current;
+  blosc_set_timestamp(&last);
+  int cbytes = blosc2_compress_ctx(cctx, context->src, nbytes, state->cbuffer, state->buffer_nbytes);
+  blosc_set_timestamp(&current);
+  blosc2_free_ctx(cctx);
+  if (cbytes <= 0) {
+    return false;
+  }
+  double ctime = blosc_elapsed_secs(last, current);
+
+  double dtime = 0;
+  if (state->config.dspeed_weight != 0) {
+    blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+    blosc2_context* dctx = blosc2_create_dctx(dparams);
+    if (dctx == NULL) {
+      return false;
+    }
+    blosc_set_timestamp(&last);
+    int dbytes = blosc2_decompress_ctx(dctx, state->cbuffer, cbytes, state->dbuffer, nbytes);
+    blosc_set_timestamp(&current);
+    blosc2_free_ctx(dctx);
+    if (dbytes != nbytes) {
+      return false;
+    }
+    dtime = blosc_elapsed_secs(last, current);
+  }
+
+  // The score is the product of the (weighted) ratio and speeds, so it is taken in logs
+  *cratio = (double)nbytes / cbytes;
+  *score = state->config.ratio_weight * log(*cratio);
+  if (state->config.cspeed_weight != 0) {
+    *score += state->config.cspeed_weight * log(nbytes / (ctime > 1e-9 ? ctime : 1e-9));
+  }
+  if (state->config.dspeed_weight != 0) {
+    *score += state->config.dspeed_weight * log(nbytes / (dtime > 1e-9 ? dtime : 1e-9));
+  }
+  return true;
+}
+
+
+/* Look for the parameters with the best score on a sample of the chunk to be compressed.
+ * The codec and filters are chosen first, then the compression level, then the blocksize. */
+static void stune_probe(blosc2_context* context, stune_state* state) {
+  int32_t nbytes = context->sourcesize;
+  if (nbytes > STUNE_SAMPLE_NBYTES) {
+    nbytes = STUNE_SAMPLE_NBYTES / context->typesize * context->typesize;
+  }
+  if (nbytes + BLOSC_MAX_OVERHEAD > state->buffer_nbytes) {
+    blosc_free(state->cbuffer);
+    blosc_free(state->dbuffer);
+    state->buffer_nbytes = nbytes + BLOSC_MAX_OVERHEAD;
+    state->cbuffer = blosc_malloc(state->buffer_nbytes);
+    state->dbuffer = blosc_malloc(state->buffer_nbytes);
+    if (state->cbuffer == NULL || state->dbuffer == NULL) {
+      state->buffer_nbytes = 0;
+      return;
+    }
+  }
+
+  stune_params best = {state->compcode, state->clevel, state->filters[BLOSC2_MAX_FILTERS - 1],
+                       state->filters[BLOSC2_MAX_FILTERS - 2], state->blocksize};
+  double best_score = -INFINITY;
+  double best_cratio = 0;
+  double score, cratio;
+
+  int nfilters = state->tune_filters ? sizeof(stune_filters) / sizeof(stune_filters[0]) : 1;
+  for (size_t i = 0; i < sizeof(stune_codecs) / sizeof(stune_codecs[0]); i++) {
+    for (int j = 0; j < nfilters; j++) {
+      stune_params params = best;
+      params.compcode = stune_codecs[i];
+      params.clevel = 5;
+      params.blocksize = 0;
+      if (state->tune_filters) {
+        params.delta = stune_filters[j][0];
+        params.shuffle = stune_filters[j][1];
+      }
+      if (stune_trial(context, state, &params, nbytes, &score, &cratio) && score > best_score) {
+        best = params;
+        best_score = score;
+        best_cratio = cratio;
+      }
+    }
+  }
+  if (best_score == -INFINITY) {
+    // Keep the current parameters
+    return;
+  }
+
+  stune_params params = best;
+  for (size_t i = 0; i < sizeof(stune_clevels) / sizeof(stune_clevels[0]); i++) {
+    params.clevel = stune_clevels[i];
+    if (params.clevel != 5 && stune_trial(context, state, &params, nbytes, &score, &cratio) &&
+        score > best_score) {
+      best = params;
+      best_score = score;
+      best_cratio = cratio;
+    }
+  }
+
+  params = best;
+  for (size_t i = 0; i < sizeof(stune_blocksizes) / sizeof(stune_blocksizes[0]); i++) {
+    params.blocksize = stune_blocksizes[i];
+    if (params.blocksize != 0 && params.blocksize <= nbytes &&
+        stune_trial(context, state, &params, nbytes, &score, &cratio) && score > best_score) {
+      best = params;
+      best_score = score;
+      best_cratio = cratio;
+    }
+  }
+
+  state->compcode = best.compcode;
+  state->clevel = best.clevel;
+  if (state->tune_filters) {
+    state->filters[BLOSC2_MAX_FILTERS - 2] = best.delta;
+    state->filters[BLOSC2_MAX_FILTERS - 1] = best.shuffle;
+  }
+  state->blocksize = best.blocksize;
+  state->probe_cratio = best_cratio;
+  state->nprobes++;
+}
+
+/* Round `size` down to a power of 2 within [min, max] (both powers of 2) */
+static int32_t bound_cache_size(int32_t size, int32_t min, int32_t max) {
+  int32_t bounded = min;
+  while (bounded < max && 2 * bounded <= size) {
+    bounded *= 2;
+  }
+  return bounded;
+}
+
+/* Get the caches that automatic blocksizes are derived from.  The ones set by
+   the user are taken as they are.  The detected ones are kept close to the L1,
+   L2 and L3_PER_CORE sizes that the thresholds below were tuned for, as virtual
+   machines and containers often report bogus sizes or topologies, and rounded
+   down to powers of 2, like the blocksizes derived from the default caches. */
+static void get_cache_sizes(int32_t* l1, int32_t* l2, int32_t* l3_per_core) {
+  const blosc2_cpu_caches* caches = blosc_cpu_caches_get();
+  *l1 = caches->l1_size;
+  *l2 = caches->l2_size;
+  *l3_per_core = caches->l3_size / caches->l3_ncores;
+  if (!blosc_cpu_caches_user()) {
+    *l1 = bound_cache_size(*l1, L1 / 2, 2 * L1);
+    *l2 = bound_cache_size(*l2, L2 / 2, 4 * L2);
+    *l3_per_core = bound_cache_size(*l3_per_core, L3_PER_CORE / 4, 4 * L3_PER_CORE);
+  }
 }
 
 // Set the automatic blocksize 0 to its real value
@@ -42,7 +310,9 @@ void blosc_stune_next_blocksize(blosc2_context *context) {
   int32_t typesize = context->typesize;
   int32_t nbytes = context->sourcesize;
   int32_t user_blocksize = context->blocksize;
-  int32_t blocksize = nbytes;
+  // Wider than the blocksize, as the caches set by the user can be large
+  int64_t blocksize = nbytes;
+  int32_t l1, l2, l3_per_core;
 
   // Protection against very small buffers
   if (nbytes < typesize) {
@@ -55,8 +325,9 @@ void blosc_stune_next_blocksize(blosc2_context *context) {
     goto last;
   }
 
-  if (nbytes >= L1) {
-    blocksize = L1;
+  get_cache_sizes(&l1, &l2, &l3_per_core);
+  if (nbytes >= l1) {
+    blocksize = l1;
 
     /* For HCR codecs, increase the block sizes by a factor of 2 because they
         are meant for compressing large blocks (i.e. they show a big overhead
@@ -102,35 +373,48 @@ void blosc_stune_next_blocksize(blosc2_context *context) {
   }
 
   /* Now the blocksize for splittable codecs */
-  if (clevel > 0 && split_block(context, typesize, blocksize, true)) {
-    // For performance reasons, do not exceed 256 KB (it must fit in L2 cache)
+  if (clevel > 0 && split_block(context, typesize, (int32_t)(blocksize < INT32_MAX ? blocksize : INT32_MAX), true)) {
+    // For performance reasons, keep every split stream in L1 or in L2 cache
     switch (clevel) {
       case 1:
       case 2:
       case 3:
-        blocksize = 32 * 1024;
+        blocksize = l1;
         break;
       case 4:
       case 5:
       case 6:
       case 7:
       case 8:
-        blocksize = 256 * 1024;
+        blocksize = l2;
         break;
       case 9:
       default:
-        blocksize = 512 * 1024;
+        blocksize = 2 * (int64_t)l2;
         break;
     }
     // Multiply by typesize to get proper split sizes
     blocksize *= typesize;
-    // But do not exceed 4 MB per thread (having this capacity in L3 is normal in modern CPUs)
-    if (blocksize > 4 * 1024 * 1024) {
-      blocksize = 4 * 1024 * 1024;
+    // But do not exceed the share of L3 cache of a thread
+    if (blocksize > l3_per_core) {
+      blocksize = l3_per_core;
     }
-    if (blocksize < 32 * 1024) {
-      /* Do not use a too small blocksize (< 32 KB) when typesize is small */
-      blocksize = 32 * 1024;
+    if (blocksize < l1) {
+      /* Do not use a too small blocksize (< L1) when typesize is small */
+      blocksize = l1;
+    }
+  }
+
+  /* Leave at least 2 blocks in chunks larger than L1, so that large caches do not
+     turn the whole chunk into a single block.  This does not depend on nthreads, so
+     that the same data and cparams always give the same chunks. */
+  if (nbytes > l1) {
+    int64_t max_blocksize = nbytes / 2;
+    if (max_blocksize < l1) {
+      max_blocksize = l1;
+    }
+    if (blocksize > max_blocksize) {
+      blocksize = max_blocksize;
     }
   }
 
@@ -145,18 +429,66 @@ void blosc_stune_next_blocksize(blosc2_context *context) {
     blocksize = blocksize / typesize * typesize;
   }
 
-  context->blocksize = blocksize;
+  context->blocksize = (int32_t)blocksize;
 }
 
 void blosc_stune_next_cparams(blosc2_context * context) {
-    BLOSC_UNUSED_PARAM(context);
+  stune_state* state = (stune_state*)context->btune;
+  // Dictionaries are trained for a codec, so it cannot change
+  if (!context->use_dict) {
+    if (state->probe && context->sourcesize > 0 && context->src != NULL) {
+      stune_probe(context, state);
+      state->probe = false;
+      state->nchunks = 0;
+    }
+    context->compcode = state->compcode;
+    context->clevel = state->clevel;
+    // Otherwise the filters are the ones of the user (or the ones chosen by BLOSC_AUTO_FILTER)
+    if (state->tune_filters) {
+      memcpy(context->filters, state->filters, BLOSC2_MAX_FILTERS);
+      memcpy(context->filters_meta, state->filters_meta, BLOSC2_MAX_FILTERS);
+      context->filter_flags = filters_to_flags(context->filters);
+    }
+  }
+  context->blocksize = state->blocksize;
+  blosc_stune_next_blocksize(context);
 }
 
 void blosc_stune_update(blosc2_context * context, double ctime) {
-    BLOSC_UNUSED_PARAM(context);
-    BLOSC_UNUSED_PARAM(ctime);
+  BLOSC_UNUSED_PARAM(ctime);
+  stune_state* state = (stune_state*)context->btune;
+  state->nchunks++;
+  if (state->config.reprobe_nchunks > 0 && state->nchunks >= state->config.reprobe_nchunks) {
+    state->probe = true;
+  }
+  // The speeds are too noisy for telling a change in the data, but the ratio is not
+  if (state->config.drift > 0 && context->destsize > 0 && state->probe_cratio > 0) {
+    double cratio = (double)context->sourcesize / context->destsize;
+    if (fabs(cratio / state->probe_cratio - 1) > state->config.drift) {
+      state->probe = true;
+    }
+  }
 }
 
 void blosc_stune_free(blosc2_context * context) {
-    BLOSC_UNUSED_PARAM(context);
+  stune_state* state = (stune_state*)context->btune;
+  blosc_free(state->cbuffer);
+  blosc_free(state->dbuffer);
+  blosc_free(state);
+  context->btune = NULL;
+}
+
+int blosc2_stune_adaptive(blosc2_btune *btune, blosc2_stune_config *config) {
+  if (config->ratio_weight < 0 || config->cspeed_weight < 0 || config->dspeed_weight < 0 ||
+      config->ratio_weight + config->cspeed_weight + config->dspeed_weight == 0) {
+    BLOSC_TRACE_ERROR("The weights of the tuner must be non-negative, and not all zero.");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  if (config->reprobe_nchunks < 0 || config->drift < 0) {
+    BLOSC_TRACE_ERROR("The re-probe conditions of the tuner cannot be negative.");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  *btune = BTUNE_DEFAULTS;
+  btune->btune_config = config;
+  return 0;
 }
@@ -13,10 +13,14 @@
 
 #include "context.h"
 
+/* The caches that automatic blocksizes were tuned for (the actual ones are
+   detected at runtime, see cpuinfo.h) */
 /* The size of L1 cache.  32 KB is quite common nowadays. */
 #define L1 (32 * 1024)
 /* The size of L2 cache.  256 KB is quite common nowadays. */
 #define L2 (256 * 1024)
+/* The share of L3 cache of a core.  4 MB is quite common nowadays. */
+#define L3_PER_CORE (4 * 1024 * 1024)
 
 /* The maximum number of compressed data streams in a block for compression */
 #define MAX_STREAMS 16 /* Cannot be larger than 128 */
@@ -0,0 +1,277 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+/*********************************************************************
+  A process-wide pool of worker threads that can be shared by every
+  blosc2_context.  Contexts submit a batch of jobs (one per thread_context)
+  and any idle worker may execute them, so the number of OS threads stays
+  bounded no matter how many contexts are alive.
+**********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "blosc2.h"
+#include "context.h"
+#include "threadpool.h"
+
+#if defined(_WIN32)
+  #include <windows.h>
+#else
+  #include <unistd.h>
+#endif
+
+
+typedef struct blosc_pool_batch {
+  void (*dojob)(void *);
+  uint8_t *jobdata;
+  size_t jobdata_elsize;
+  int numjobs;
+  int next_job;                 /* next job to be dispatched */
+  int pending;                  /* jobs not finished yet */
+  pthread_cond_t done_cv;
+  struct blosc_pool_batch *next;
+} blosc_pool_batch;
+
+typedef struct {
+  bool mutex_initialized;
+  pthread_mutex_t mutex;
+  pthread_cond_t work_cv;
+  blosc_pool_batch *head;       /* FIFO queue of batches with jobs to dispatch */
+  blosc_pool_batch *tail;
+  int16_t nthreads;
+  int end_threads;
+  pthread_t *threads;
+} blosc_pool;
+
+static blosc_pool g_pool = {0};
+
+
+int blosc_get_ncores(void) {
+  long ncores = 1;
+#if defined(_WIN32)
+  SYSTEM_INFO sysinfo;
+  GetSystemInfo(&sysinfo);
+  ncores = (long)sysinfo.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+  ncores = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  if (ncores < 1) {
+    ncores = 1;
+  }
+  if (ncores > INT16_MAX) {
+    ncores = INT16_MAX;
+  }
+  return (int)ncores;
+}
+
+
+/* Pop the next job of the queue.  Must be called with the pool mutex held. */
+static blosc_pool_batch* pop_job(int *njob) {
+  blosc_pool_batch *batch = g_pool.head;
+  *njob = batch->next_job++;
+  if (batch->next_job == batch->numjobs) {
+    /* All the jobs in this batch have been dispatched */
+    g_pool.head = batch->next;
+    if (g_pool.head == NULL) {
+      g_pool.tail = NULL;
+    }
+  }
+  return batch;
+}
+
+
+/* Execute a job.  Must be called with the pool mutex held. */
+static void run_job(blosc_pool_batch *batch, int njob) {
+  pthread_mutex_unlock(&g_pool.mutex);
+  batch->dojob(batch->jobdata + (size_t)njob * batch->jobdata_elsize);
+  pthread_mutex_lock(&g_pool.mutex);
+  batch->pending--;
+  if (batch->pending == 0) {
+    pthread_cond_signal(&batch->done_cv);
+  }
+}
+
+
+static void* t_pool_worker(void *arg) {
+  (void)arg;
+  pthread_mutex_lock(&g_pool.mutex);
+  while (1) {
+    while (g_pool.head == NULL && !g_pool.end_threads) {
+      pthread_cond_wait(&g_pool.work_cv, &g_pool.mutex);
+    }
+    if (g_pool.end_threads) {
+      break;
+    }
+    int njob;
+    blosc_pool_batch *batch = pop_job(&njob);
+    run_job(batch, njob);
+  }
+  pthread_mutex_unlock(&g_pool.mutex);
+
+  return NULL;
+}
+
+
+bool blosc_shared_pool_active(void) {
+  return g_pool.nthreads > 0;
+}
+
+
+int16_t blosc_shared_pool_get(void) {
+  return g_pool.nthreads;
+}
+
+
+static void stop_pool(void) {
+  if (g_pool.nthreads == 0) {
+    return;
+  }
+  pthread_mutex_lock(&g_pool.mutex);
+  g_pool.end_threads = 1;
+  pthread_cond_broadcast(&g_pool.work_cv);
+  pthread_mutex_unlock(&g_pool.mutex);
+
+  for (int t = 0; t < g_pool.nthreads; t++) {
+    int rc = pthread_join(g_pool.threads[t], NULL);
+    if (rc) {
+      BLOSC_TRACE_ERROR("Return code from pthread_join() is %d\n"
+                        "\tError detail: %s.", rc, strerror(rc));
+    }
+  }
+  free(g_pool.threads);
+  g_pool.threads = NULL;
+  pthread_cond_destroy(&g_pool.work_cv);
+  g_pool.end_threads = 0;
+  g_pool.nthreads = 0;
+}
+
+
+int16_t blosc_shared_pool_set(int16_t nthreads) {
+  int16_t old_nthreads = g_pool.nthreads;
+
+  if (nthreads < 0) {
+    BLOSC_TRACE_ERROR("nthreads for the shared pool cannot be negative.");
+    return BLOSC2_ERROR_INVALID_PARAM;
+  }
+  /* Never start more threads than cores */
+  int ncores = blosc_get_ncores();
+  if (nthreads > ncores) {
+    nthreads = (int16_t)ncores;
+  }
+  if (nthreads == g_pool.nthreads) {
+    return old_nthreads;
+  }
+
+  stop_pool();
+  if (nthreads == 0) {
+    return old_nthreads;
+  }
+
+  if (!g_pool.mutex_initialized) {
+    pthread_mutex_init(&g_pool.mutex, NULL);
+    g_pool.mutex_initialized = true;
+  }
+  pthread_cond_init(&g_pool.work_cv, NULL);
+  g_pool.head = NULL;
+  g_pool.tail = NULL;
+  g_pool.threads = (pthread_t*)malloc(nthreads * sizeof(pthread_t));
+  if (g_pool.threads == NULL) {
+    BLOSC_TRACE_ERROR("Error allocating memory!");
+    return BLOSC2_ERROR_MEMORY_ALLOC;
+  }
+  for (int t = 0; t < nthreads; t++) {
+    int rc = pthread_create(&g_pool.threads[t], NULL, t_pool_worker, NULL);
+    if (rc) {
+      BLOSC_TRACE_ERROR("Return code from pthread_create() is %d.\n"
+                        "\tError detail: %s\n", rc, strerror(rc));
+      /* Keep the threads that could be started */
+      g_pool.nthreads = (int16_t)t;
+      if (t == 0) {
+        free(g_pool.threads);
+        g_pool.threads = NULL;
+        pthread_cond_destroy(&g_pool.work_cv);
+      }
+      return BLOSC2_ERROR_THREAD_CREATE;
+    }
+    g_pool.nthreads = (int16_t)(t + 1);
+  }
+
+  return old_nthreads;
+}
+
+
+void blosc_shared_pool_run(void (*dojob)(void *), int numjobs,
+                           size_t jobdata_elsize, void *jobdata) {
+  if (numjobs <= 0) {
+    return;
+  }
+  if (g_pool.nthreads == 0) {
+    /* No workers available; run the jobs serially in the caller */
+    for (int i = 0; i < numjobs; i++) {
+      dojob((uint8_t*)jobdata + (size_t)i * jobdata_elsize);
+    }
+    return;
+  }
+
+  blosc_pool_batch batch;
+  batch.dojob = dojob;
+  batch.jobdata = (uint8_t*)jobdata;
+  batch.jobdata_elsize = jobdata_elsize;
+  batch.numjobs = numjobs;
+  batch.next_job = 0;
+  batch.pending = numjobs;
+  batch.next = NULL;
+  pthread_cond_init(&batch.done_cv, NULL);
+
+  pthread_mutex_lock(&g_pool.mutex);
+  if (g_pool.tail == NULL) {
+    g_pool.head = &batch;
+  }
+  else {
+    g_pool.tail->next = &batch;
+  }
+  g_pool.tail = &batch;
+  if (numjobs > 1) {
+    pthread_cond_broadcast(&g_pool.work_cv);
+  }
+  else {
+    pthread_cond_signal(&g_pool.work_cv);
+  }
+
+  /* Help with the jobs of our own batch that have not been picked yet.
+   * Jobs are dispatched in order, so the job for tid 0 is always picked
+   * before any other one (delta decoding relies on that). */
+  while (batch.next_job < batch.numjobs) {
+    /* Our batch may not be at the head of the queue; take it out of order */
+    int njob = batch.next_job++;
+    if (batch.next_job == batch.numjobs) {
+      blosc_pool_batch **prev = &g_pool.head;
+      blosc_pool_batch *last = NULL;
+      while (*prev != &batch) {
+        last = *prev;
+        prev = &(*prev)->next;
+      }
+      *prev = batch.next;
+      if (g_pool.tail == &batch) {
+        g_pool.tail = last;
+      }
+    }
+    run_job(&batch, njob);
+  }
+
+  /* Wait for the jobs that are still running in the workers */
+  while (batch.pending > 0) {
+    pthread_cond_wait(&batch.done_cv, &g_pool.mutex);
+  }
+  pthread_mutex_unlock(&g_pool.mutex);
+  pthread_cond_destroy(&batch.done_cv);
+}
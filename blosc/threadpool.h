@@ -0,0 +1,39 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#ifndef BLOSC_THREADPOOL_H
+#define BLOSC_THREADPOOL_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Return the number of online cores in this machine (at least 1) */
+int blosc_get_ncores(void);
+
+/* Whether the process-wide shared pool has been started */
+bool blosc_shared_pool_active(void);
+
+/* Start (or resize) the shared pool.  A size of 0 stops the pool.
+ * Returns the previous size of the pool. */
+int16_t blosc_shared_pool_set(int16_t nthreads);
+
+/* Current size of the shared pool (0 if not active) */
+int16_t blosc_shared_pool_get(void);
+
+/* Execute `dojob(jobdata + i * jobdata_elsize)` for i in [0, numjobs) on the
+ * shared pool and return when all the jobs are done.  Jobs are dispatched in
+ * order and the calling thread helps executing the jobs of its own batch, so
+ * this makes progress even when all the workers are busy (or the pool is not
+ * active at all). */
+void blosc_shared_pool_run(void (*dojob)(void *), int numjobs,
+                           size_t jobdata_elsize, void *jobdata);
+
+#endif  /* BLOSC_THREADPOOL_H */
@@ -12,11 +12,48 @@
 #include "blosc2.h"
 #include "assert.h"
 #include "trunc-prec.h"
+#include "shuffle.h"
+#include "blosc2/blosc2-common.h"
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 #define BITS_MANTISSA_FLOAT 23
 #define BITS_MANTISSA_DOUBLE 52
 
 
+/* AND the bytes in src with a (periodic) vector mask.  Returns the number of
+   bytes processed, the rest is left for the scalar loops. */
+#if defined(__AVX2__)
+static int32_t and_mask_simd(const uint8_t* src, uint8_t* dest, int32_t nbytes, __m256i mask) {
+  int32_t i;
+  for (i = 0; i + (int32_t)sizeof(__m256i) <= nbytes; i += (int32_t)sizeof(__m256i)) {
+    __m256i x = _mm256_loadu_si256((const __m256i *)(src + i));
+    _mm256_storeu_si256((__m256i *)(dest + i), _mm256_and_si256(x, mask));
+  }
+  return i;
+}
+#elif defined(__SSE2__)
+static int32_t and_mask_simd(const uint8_t* src, uint8_t* dest, int32_t nbytes, __m128i mask) {
+  int32_t i;
+  for (i = 0; i + (int32_t)sizeof(__m128i) <= nbytes; i += (int32_t)sizeof(__m128i)) {
+    __m128i x = _mm_loadu_si128((const __m128i *)(src + i));
+    _mm_storeu_si128((__m128i *)(dest + i), _mm_and_si128(x, mask));
+  }
+  return i;
+}
+#elif defined(__ARM_NEON)
+static int32_t and_mask_simd(const uint8_t* src, uint8_t* dest, int32_t nbytes, uint8x16_t mask) {
+  int32_t i;
+  for (i = 0; i + 16 <= nbytes; i += 16) {
+    vst1q_u8(dest + i, vandq_u8(vld1q_u8(src + i), mask));
+  }
+  return i;
+}
+#endif
+
+
 void truncate_precision32(uint8_t prec_bits, int32_t nelems,
                           const int32_t* src, int32_t* dest) {
   if (prec_bits > BITS_MANTISSA_FLOAT) {
@@ -26,7 +63,16 @@ void truncate_precision32(uint8_t prec_bits, int32_t nelems,
   assert (prec_bits <= BITS_MANTISSA_FLOAT);
   int zeroed_bits = BITS_MANTISSA_FLOAT - prec_bits;
   int32_t mask = ~((1 << zeroed_bits) - 1);
-  for (int i = 0; i < nelems; i++) {
+  int i = 0;
+#if defined(__AVX2__)
+  i = and_mask_simd((const uint8_t*)src, (uint8_t*)dest, nelems * 4, _mm256_set1_epi32(mask)) / 4;
+#elif defined(__SSE2__)
+  i = and_mask_simd((const uint8_t*)src, (uint8_t*)dest, nelems * 4, _mm_set1_epi32(mask)) / 4;
+#elif defined(__ARM_NEON)
+  i = and_mask_simd((const uint8_t*)src, (uint8_t*)dest, nelems * 4,
+                    vreinterpretq_u8_s32(vdupq_n_s32(mask))) / 4;
+#endif
+  for (; i < nelems; i++) {
     dest[i] = src[i] & mask;
   }
 }
@@ -40,7 +86,18 @@ void truncate_precision64(uint8_t prec_bits, int32_t nelems,
   assert (prec_bits <= BITS_MANTISSA_DOUBLE);
   int zeroed_bits = BITS_MANTISSA_DOUBLE - prec_bits;
   uint64_t mask = ~((1ULL << zeroed_bits) - 1ULL);
-  for (int i = 0; i < nelems; i++) {
+  int i = 0;
+#if defined(__AVX2__)
+  i = and_mask_simd((const uint8_t*)src, (uint8_t*)dest, nelems * 8,
+                    _mm256_set1_epi64x((int64_t)mask)) / 8;
+#elif defined(__SSE2__)
+  i = and_mask_simd((const uint8_t*)src, (uint8_t*)dest, nelems * 8,
+                    _mm_set1_epi64x((int64_t)mask)) / 8;
+#elif defined(__ARM_NEON)
+  i = and_mask_simd((const uint8_t*)src, (uint8_t*)dest, nelems * 8,
+                    vreinterpretq_u8_u64(vdupq_n_u64(mask))) / 8;
+#endif
+  for (; i < nelems; i++) {
     dest[i] = src[i] & mask;
   }
 }
@@ -69,4 +126,77 @@ void truncate_precision(uint8_t prec_bits, int32_t typesize, int32_t nbytes,
               "not handled", (int)typesize);
       assert(0);
   }
+  // Copy the leftovers (not a whole element)
+  int32_t leftover = nbytes % typesize;
+  memcpy(dest + nbytes - leftover, src + nbytes - leftover, leftover);
+}
+
+/* Apply the truncate precision and then the (bit)shuffle filter to src in a
+   single sweep: the mantissa bits that are truncated are just zeroed in the
+   (bit)shuffled output, where they are contiguous.  Returns a negative value
+   on (bit)shuffle errors. */
+int truncate_precision_shuffle(uint8_t prec_bits, uint8_t filter, int32_t typesize,
+                               int32_t nbytes, const uint8_t* src, uint8_t* dest,
+                               uint8_t* tmp) {
+  int zeroed_bits;
+  if (prec_bits <= 0) {
+    fprintf(stderr, "The precision needs to be at least 1 bit");
+  }
+  assert (prec_bits > 0);
+  switch (typesize) {
+    case 4:
+      if (prec_bits > BITS_MANTISSA_FLOAT) {
+        fprintf(stderr, "The precision cannot be larger than %d bits for floats",
+                BITS_MANTISSA_FLOAT);
+      }
+      assert (prec_bits <= BITS_MANTISSA_FLOAT);
+      zeroed_bits = BITS_MANTISSA_FLOAT - prec_bits;
+      break;
+    case 8:
+      if (prec_bits > BITS_MANTISSA_DOUBLE) {
+        fprintf(stderr, "The precision cannot be larger than %d bits for doubles",
+                BITS_MANTISSA_DOUBLE);
+      }
+      assert (prec_bits <= BITS_MANTISSA_DOUBLE);
+      zeroed_bits = BITS_MANTISSA_DOUBLE - prec_bits;
+      break;
+    default:
+      fprintf(stderr, "Error in trunc-prec filter: Precision for typesize %d "
+              "not handled", (int)typesize);
+      assert(0);
+      return -1;
+  }
+
+  int32_t nelems = nbytes / typesize;
+  if (filter == BLOSC_SHUFFLE) {
+    // The byte j of all the elements is at dest + j * nelems
+    shuffle(typesize, nbytes, src, dest);
+    memset(dest, 0, (zeroed_bits / 8) * nelems);
+    if (zeroed_bits % 8) {
+      uint8_t* plane = dest + (zeroed_bits / 8) * nelems;
+      uint8_t mask = (uint8_t)(0xFF << (zeroed_bits % 8));
+      for (int32_t i = 0; i < nelems; i++) {
+        plane[i] &= mask;
+      }
+    }
+  }
+  else {
+    // The bit k of all the elements is at dest + k * size / 8
+    int32_t rc = bitshuffle(typesize, nbytes, src, dest, tmp);
+    if (rc < 0) {
+      return rc;
+    }
+    int32_t size = nelems - nelems % 8;
+    memset(dest, 0, zeroed_bits * (size / 8));
+    // Elements that are not a multiple of 8 are copied as they are
+    if (typesize == 4) {
+      truncate_precision32(prec_bits, nelems - size,
+                           (int32_t *)(dest + size * 4), (int32_t *)(dest + size * 4));
+    }
+    else {
+      truncate_precision64(prec_bits, nelems - size,
+                           (int64_t *)(dest + size * 8), (int64_t *)(dest + size * 8));
+    }
+  }
+  return 0;
 }
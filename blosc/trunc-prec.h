@@ -17,4 +17,8 @@
 void truncate_precision(uint8_t prec_bits, int32_t typesize, int32_t nbytes,
                         const uint8_t* src, uint8_t* dest);
 
+int truncate_precision_shuffle(uint8_t prec_bits, uint8_t filter, int32_t typesize,
+                               int32_t nbytes, const uint8_t* src, uint8_t* dest,
+                               uint8_t* tmp);
+
 #endif //BLOSC_TRUNC_PREC_H
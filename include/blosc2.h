@@ -32,6 +32,8 @@ extern "C" {
 #include "blosc2/blosc2-export.h"
 #include "blosc2/blosc2-common.h"
 #include "blosc2/blosc2-stdio.h"
+#include "blosc2/blosc2-mmap.h"
+#include "blosc2/blosc2-uring.h"
 #ifdef __cplusplus
 }
 #endif
@@ -162,9 +164,17 @@ enum {
   BLOSC_BITSHUFFLE = 2,  //!< Bit-wise shuffle.
   BLOSC_DELTA = 3,       //!< Delta filter.
   BLOSC_TRUNC_PREC = 4,  //!< Truncate precision filter.
-  BLOSC_LAST_FILTER = 5, //!< sentinel
+  BLOSC_DELTA_SUB = 5,   //!< Arithmetic delta filter (each element minus the previous one).
+  BLOSC_LAST_FILTER = 6, //!< sentinel
   BLOSC_LAST_REGISTERED_FILTER = BLOSC2_GLOBAL_REGISTERED_FILTERS_START + BLOSC2_GLOBAL_REGISTERED_FILTERS - 1,
   //!< Determine the last registered filter. It is used to check if a filter is registered or not.
+  BLOSC_AUTO_FILTER = BLOSC2_DEFINED_FILTERS_STOP,
+  //!< Choose the filter of every chunk among no filter, shuffle, bitshuffle and
+  //!< delta + shuffle (the latter when the previous slot is free), by
+  //!< trial-compressing a few of its blocks with a fast codec.  The chosen
+  //!< filters are the ones recorded in the chunk header.  Frames store
+  //!< #BLOSC_SHUFFLE in its place in their header (so that older libraries can
+  //!< open them), and the automatic mode in the "_b2_auto_filter" vlmetalayer.
 };
 
 /**
@@ -366,6 +376,10 @@ enum {
  * Blosc to be used simultaneously in a multi-threaded environment, in
  * which case you can use the #blosc2_compress_ctx #blosc2_decompress_ctx pair.
  *
+ * This function honors the **BLOSC_TILED_PIPELINE=(INTEGER)** environment
+ * variable: when it is 0, filter pipelines are always run one filter at a
+ * time on the whole block, instead of in tiles.
+ *
  * @sa #blosc_destroy
  */
 BLOSC_EXPORT void blosc_init(void);
@@ -564,6 +578,150 @@ typedef void (*blosc_threads_callback)(void *callback_data, void (*dojob)(void *
  */
 BLOSC_EXPORT void blosc_set_threads_callback(blosc_threads_callback callback, void *callback_data);
 
+/**
+ * @brief Start a process-wide pool of threads shared by all the contexts.
+ *
+ * When the shared pool is active, every context created afterwards (including
+ * the global one) submits its per-block jobs to this pool instead of starting
+ * its own threads.  The `nthreads` of each context still sets how many jobs a
+ * single compression/decompression is split into, but the number of OS
+ * threads is bounded by the size of the pool, and idle threads can serve the
+ * blocks of any context.
+ *
+ * This function is *not* thread-safe: it should be called when no other Blosc
+ * operation is in progress.  Callback threads set via
+ * #blosc_set_threads_callback take precedence over the shared pool.
+ *
+ * @param nthreads The number of threads in the pool.  It is capped to the
+ * number of cores in the machine.  0 stops the pool and reverts to the
+ * per-context threads.
+ *
+ * @return The previous size of the pool.  A negative value means an error.
+ */
+BLOSC_EXPORT int16_t blosc2_set_shared_threadpool(int16_t nthreads);
+
+/**
+ * @brief Get the number of threads in the shared pool (0 if not active).
+ */
+BLOSC_EXPORT int16_t blosc2_get_shared_threadpool(void);
+
+/**
+ * @brief The hooks for the memory used internally by Blosc.
+ */
+typedef struct {
+  void* (*alloc)(size_t size, size_t alignment, void* user_data);
+  //!< Book @p size bytes aligned to @p alignment (a power of two).  Returns NULL on failure.
+  void* (*resize)(void* block, size_t size, size_t alignment, void* user_data);
+  //!< Resize @p block keeping its contents, like realloc().  Blosc only relies on the
+  //!< natural alignment of malloc() for resized blocks.  Returns NULL on failure.
+  void (*dealloc)(void* block, void* user_data);
+  //!< Release a @p block booked by @p alloc or @p resize.
+  void* user_data;
+  //!< The data passed to every hook.
+} blosc2_allocator;
+
+/**
+ * @brief Set the allocator for the memory used internally by Blosc (contexts,
+ * thread temporaries, chunk offsets and short-lived buffers).
+ *
+ * The buffers handed over to the user with a `needs_free` flag (or that the
+ * user must free otherwise) are still booked with malloc(), so that they can
+ * be released with free().
+ *
+ * This function is *not* thread-safe: it should be called before any other
+ * Blosc function, or when no Blosc object (contexts, super-chunks) is alive.
+ * The buffers that other threads keep in their block pool are still released
+ * with the allocator that booked them (at their next use of the pool, or when
+ * they exit), so the previous hooks must stay valid until then.
+ *
+ * @param allocator The allocator hooks (copied).  NULL restores the default
+ * allocator (aligned malloc() and free()).
+ *
+ * @return If success, a 0 values is returned.  An error is signaled with a
+ * negative int.
+ */
+BLOSC_EXPORT int blosc2_set_allocator(const blosc2_allocator* allocator);
+
+/**
+ * @brief The default maximum of bytes kept by the block pool of every thread.
+ */
+#define BLOSC2_BLOCK_POOL_NBYTES (32 * 1024 * 1024)
+
+/**
+ * @brief Set the maximum of bytes that every thread keeps in its block pool.
+ *
+ * The short-lived buffers that Blosc needs for every chunk (e.g. when appending
+ * to, or decompressing out of, a frame) are cached by the thread that used them
+ * and reused for the next chunks, so that the steady state does not call the
+ * allocator.  The buffers that a thread does not reuse for a while are released,
+ * and so are all of them when it exits.  Changing the maximum (or the allocator),
+ * and #blosc_destroy, release the buffers of the calling thread, and the ones of
+ * the other threads at their next use of the pool.
+ *
+ * @param nbytes The maximum of bytes cached by every thread.  0 disables the
+ * pool.  The default is #BLOSC2_BLOCK_POOL_NBYTES.
+ *
+ * @return The previous maximum.  A negative value means an error.
+ */
+BLOSC_EXPORT int64_t blosc2_set_block_pool(int64_t nbytes);
+
+/**
+ * @brief The CPU caches that automatic blocksizes are derived from.
+ */
+typedef struct {
+  int32_t l1_size;
+  //!< The size of the L1 data cache of a core (in bytes).
+  int32_t l2_size;
+  //!< The share of the L2 cache of a core (in bytes).
+  int32_t l3_size;
+  //!< The size of the last-level cache (in bytes).
+  int16_t l3_ncores;
+  //!< The number of cores sharing the last-level cache.
+  int16_t ncores;
+  //!< The number of cores of the host.
+} blosc2_cpu_caches;
+
+/**
+ * @brief The caches that the automatic blocksizes were tuned for, and that are
+ * used when the ones of the host cannot be detected.
+ */
+static const blosc2_cpu_caches BLOSC2_CPU_CACHES_DEFAULTS = {
+    32 * 1024, 256 * 1024, 4 * 1024 * 1024, 1, 1
+};
+
+/**
+ * @brief Get the CPU caches that automatic blocksizes are derived from.
+ *
+ * They are detected in #blosc_init (through sysfs on Linux, sysctl on macOS,
+ * GetLogicalProcessorInformation on Windows, or CPUID on other x86 hosts).
+ *
+ * @param caches The caches in use.
+ *
+ * @return If success, a 0 values is returned.  An error is signaled with a
+ * negative int.
+ */
+BLOSC_EXPORT int blosc2_get_cpu_caches(blosc2_cpu_caches* caches);
+
+/**
+ * @brief Set the CPU caches that automatic blocksizes are derived from.
+ *
+ * The block sizes chosen for new chunks are kept within the L1, the L2 share
+ * of a core and the share of the last-level cache of a core, depending on the
+ * compression level.  The sizes are used as they are (unlike the detected
+ * ones, which are kept close to #BLOSC2_CPU_CACHES_DEFAULTS).  Use
+ * #BLOSC2_CPU_CACHES_DEFAULTS for getting the same blocksizes on every host.
+ *
+ * This function is *not* thread-safe: it should not be called while other
+ * threads are compressing.
+ *
+ * @param caches The caches to use (copied).  NULL detects the ones of the host
+ * again.
+ *
+ * @return If success, a 0 values is returned.  An error is signaled with a
+ * negative int.
+ */
+BLOSC_EXPORT int blosc2_set_cpu_caches(const blosc2_cpu_caches* caches);
+
 
 /**
  * @brief Returns the current number of threads that are used for
@@ -803,7 +961,9 @@ BLOSC_EXPORT const char* blosc_cbuffer_complib(const void* cbuffer);
 
 enum {
   BLOSC2_IO_FILESYSTEM = 0,
-  BLOSC_IO_LAST_BLOSC_DEFINED = 1,  // sentinel
+  BLOSC2_IO_FILESYSTEM_MMAP = 1,
+  BLOSC2_IO_FILESYSTEM_URING = 2,
+  BLOSC_IO_LAST_BLOSC_DEFINED = 3,  // sentinel
   BLOSC_IO_LAST_REGISTERED = 32,  // sentinel
 };
 
@@ -820,6 +980,12 @@ typedef int     (*blosc2_seek_cb)(void *stream, int64_t offset, int whence);
 typedef int64_t (*blosc2_write_cb)(const void *ptr, int64_t size, int64_t nitems, void *stream);
 typedef int64_t (*blosc2_read_cb)(void *ptr, int64_t size, int64_t nitems, void *stream);
 typedef int     (*blosc2_truncate_cb)(void *stream, int64_t size);
+typedef int64_t (*blosc2_pread_cb)(void *ptr, int64_t size, int64_t nitems, int64_t offset, void *stream);
+typedef void*   (*blosc2_map_cb)(void *stream, int64_t offset, int64_t nbytes);
+typedef void*   (*blosc2_submit_cb)(void *stream, int32_t nreads, void **ptrs,
+                                    const int64_t *nbytes, const int64_t *offsets);
+typedef int64_t (*blosc2_complete_cb)(void *batch, int32_t nread);
+typedef void    (*blosc2_release_cb)(void *batch);
 
 
 /*
@@ -883,6 +1049,54 @@ BLOSC_EXPORT int blosc2_register_io_cb(const blosc2_io_cb *io);
 
 BLOSC_EXPORT blosc2_io_cb *blosc2_get_io_cb(uint8_t id);
 
+/*
+ * Optional Input/Output callbacks.  They are registered apart from #blosc2_io_cb
+ * (with #blosc2_register_io_ext_cb), so that the IO backends that do not know about
+ * them keep working as they are.
+ */
+typedef struct {
+  uint8_t id;
+  //!< The identifier of the IO (already registered with #blosc2_register_io_cb).
+  blosc2_pread_cb pread;
+  //!< The IO positional read callback (optional). It reads at the given offset without
+  //!< moving the position of the stream, so that several threads can use the same stream at once.
+  //!< Without it, each thread seeks and reads with its own stream.
+  blosc2_map_cb map;
+  //!< The IO map callback (optional). It returns a pointer to @p nbytes at @p offset of the
+  //!< stream (or NULL), that must stay valid until the stream is closed or written.  Chunks of
+  //!< contiguous frames are then returned as views into the stream, without copies.
+  blosc2_submit_cb submit;
+  //!< The IO submit callback (optional). It starts reading a batch of @p nreads buffers
+  //!< (each one at its own offset) in the background, and returns the batch (or NULL if
+  //!< the reads must be done synchronously instead).
+  blosc2_complete_cb complete;
+  //!< The IO complete callback (optional, but needed with @p submit). It waits for the read
+  //!< @p nread of a batch and returns the number of bytes read. It may be called from several
+  //!< threads at the same time.
+  blosc2_release_cb release;
+  //!< The IO release callback (optional, but needed with @p submit). It waits for the pending
+  //!< reads of a batch and frees it.
+} blosc2_io_ext_cb;
+
+/**
+ * @brief Register the optional input/output callbacks of a user-defined IO.
+ *
+ * @param io_ext The optional callbacks.  The callbacks that are not provided must be NULL.
+ * Its @p id must be the one of an IO already registered with #blosc2_register_io_cb.
+ *
+ * @return 0 if succeeds. Else a negative code is returned.
+ */
+BLOSC_EXPORT int blosc2_register_io_ext_cb(const blosc2_io_ext_cb *io_ext);
+
+/**
+ * @brief Get the optional input/output callbacks of an IO.
+ *
+ * @param id The identifier of the IO.
+ *
+ * @return The optional callbacks, or NULL if the IO has none.
+ */
+BLOSC_EXPORT const blosc2_io_ext_cb *blosc2_get_io_ext_cb(uint8_t id);
+
 /*********************************************************************
   Structures and functions related with contexts.
 *********************************************************************/
@@ -904,6 +1118,68 @@ typedef struct {
   //!> BTune configuration.
 }blosc2_btune;
 
+/**
+ * @brief The configuration of the built-in adaptive tuner (see #blosc2_stune_adaptive).
+ *
+ * The tuner scores the parameters with ratio^ratio_weight * cspeed^cspeed_weight *
+ * dspeed^dspeed_weight, where cspeed and dspeed are the compression and
+ * decompression speeds.
+ */
+typedef struct {
+  float ratio_weight;
+  //!< The weight of the compression ratio in the score.
+  float cspeed_weight;
+  //!< The weight of the compression speed in the score.
+  float dspeed_weight;
+  //!< The weight of the decompression speed in the score.
+  int32_t reprobe_nchunks;
+  //!< Probe the parameters again after this number of chunks (0 means never).
+  float drift;
+  //!< Probe the parameters again when the compression ratio of a chunk differs from
+  //!< the one of the probe by more than this fraction (0 means never).
+} blosc2_stune_config;
+
+/**
+ * @brief Default configuration for the adaptive tuner (a balance of ratio and speeds).
+ */
+static const blosc2_stune_config BLOSC2_STUNE_CONFIG_DEFAULTS = {1.f, 1.f, 1.f, 0, 0.2f};
+
+/**
+ * @brief Configuration for the adaptive tuner that favors the compression ratio.
+ */
+static const blosc2_stune_config BLOSC2_STUNE_CONFIG_RATIO = {1.f, 0.f, 0.f, 0, 0.2f};
+
+/**
+ * @brief Configuration for the adaptive tuner that favors the compression speed.
+ */
+static const blosc2_stune_config BLOSC2_STUNE_CONFIG_CSPEED = {0.1f, 1.f, 0.f, 0, 0.2f};
+
+/**
+ * @brief Configuration for the adaptive tuner that favors the decompression speed.
+ */
+static const blosc2_stune_config BLOSC2_STUNE_CONFIG_DSPEED = {0.1f, 0.f, 1.f, 0, 0.2f};
+
+/**
+ * @brief Set up @p btune with the built-in adaptive tuner.
+ *
+ * Pass @p btune in the `udbtune` field of the compression parameters of a new
+ * super-chunk.  Then, the first chunk appended is compressed (a sample of 1 MB of
+ * it, actually) with every codec and shuffle (none, shuffle, bitshuffle, or
+ * subtractive delta plus shuffle); the compression level and the blocksize are
+ * refined for the best of them, and the parameters with the best score are used
+ * for the next chunks, until a re-probe is due (see #blosc2_stune_config).
+ * Filters other than the ones above are kept as they are, and then only the codec,
+ * compression level and blocksize are tuned.  The trials are run with 1 thread.
+ *
+ * @param btune The tuner to set up.
+ * @param config The configuration of the tuner.  It is copied when the super-chunk
+ * is created.
+ *
+ * @return If success, a 0 values is returned.  An error is signaled with a
+ * negative int.
+ */
+BLOSC_EXPORT int blosc2_stune_adaptive(blosc2_btune *btune, blosc2_stune_config *config);
+
 
 /**
  * @brief The parameters for a prefilter function.
@@ -971,7 +1247,7 @@ typedef struct {
   uint8_t clevel;
   //!< The compression level (5).
   int use_dict;
-  //!< Use dicts or not when compressing (only for ZSTD).
+  //!< Use dicts or not when compressing (only for ZSTD, LZ4, LZ4HC and BloscLZ).
   int32_t typesize;
   //!< The type size (8).
   int16_t nthreads;
@@ -1096,6 +1372,105 @@ BLOSC_EXPORT int blosc2_ctx_get_dparams(blosc2_context *ctx, blosc2_dparams *dpa
  */
 BLOSC_EXPORT int blosc2_set_maskout(blosc2_context *ctx, bool *maskout, int nblocks);
 
+/**
+ * @brief The default minimum entropy (in bits per byte) for the incompressibility probe.
+ */
+#define BLOSC2_PROBE_MIN_ENTROPY 7.9f
+
+/**
+ * @brief Set the probe that spots incompressible (e.g. encrypted or already
+ * compressed) data before running the codec on it.
+ *
+ * The probe samples the data and computes the entropy of its bytes, and how
+ * often 4-byte sequences repeat.  When the entropy is at least @p min_entropy
+ * and there are hardly any repetitions, the data is stored without trying to
+ * compress it.
+ *
+ * @param ctx The compression context to update.
+ * @param min_entropy The minimum entropy (in bits per byte, up to 8) for data to
+ * be taken as incompressible.  0 disables the probe.  The default is
+ * #BLOSC2_PROBE_MIN_ENTROPY.
+ * @param probe_blocks Whether every (filtered) block is probed too, and not only
+ * the whole chunk.  The default is false.
+ *
+ * @return If success, a 0 values is returned.  An error is signaled with a
+ * negative int.
+ */
+BLOSC_EXPORT int blosc2_set_probe(blosc2_context *ctx, float min_entropy, bool probe_blocks);
+
+/**
+ * @brief Get how many times the incompressibility probe has fired in a context.
+ *
+ * @param ctx The compression context.
+ * @param nchunks The number of chunks that have been stored without compressing them.
+ * @param nblocks The number of blocks (or block splits) that have been stored
+ * without compressing them.
+ *
+ * @return If success, a 0 values is returned.  An error is signaled with a
+ * negative int.
+ */
+BLOSC_EXPORT int blosc2_get_probe_stats(blosc2_context *ctx, int64_t *nchunks, int64_t *nblocks);
+
+/**
+ * @brief The performance counters of a context.
+ *
+ * The times are added up over all the threads, so they can be larger than the
+ * wall time of the operations.
+ */
+typedef struct {
+  int64_t nchunks;
+  //!< The number of chunks compressed or decompressed.
+  int64_t nblocks;
+  //!< The number of blocks compressed or decompressed (#blosc2_getitem_ctx included).
+  int64_t nbytes;
+  //!< The uncompressed bytes of the chunks.
+  int64_t cbytes;
+  //!< The compressed bytes of the chunks.
+  int64_t nmemcpyed;
+  //!< The number of chunks that have been stored without compression.
+  int64_t lazy_nbytes;
+  //!< The bytes of blocks of lazy chunks read from storage.
+  int64_t lazy_nreads;
+  //!< The number of reads of blocks of lazy chunks.
+  double prefilter_time;
+  //!< The time spent in the prefilter (in seconds).
+  double filter_time;
+  //!< The time spent in the filter pipeline (in seconds).
+  double codec_time;
+  //!< The time spent encoding or decoding the blocks (in seconds).
+  double memcpy_time;
+  //!< The time spent copying the blocks of chunks stored without compression (in seconds).
+  double postfilter_time;
+  //!< The time spent in the postfilter (in seconds).
+  double wait_time;
+  //!< The time that threads have been waiting for the others (in seconds).
+} blosc2_stats;
+
+/**
+ * @brief Get the performance counters of a context.
+ *
+ * The counters add up since the context was created, or since the last call to
+ * #blosc2_ctx_reset_stats.  Keeping them is cheap, but they can be compiled out
+ * with the DEACTIVATE_STATS CMake option.
+ *
+ * @param ctx The context.
+ * @param stats The counters.
+ *
+ * @return If success, a 0 values is returned.  An error is signaled with a
+ * negative int (e.g. when the counters have been compiled out).
+ */
+BLOSC_EXPORT int blosc2_ctx_get_stats(blosc2_context *ctx, blosc2_stats *stats);
+
+/**
+ * @brief Reset the performance counters of a context.
+ *
+ * @param ctx The context.
+ *
+ * @return If success, a 0 values is returned.  An error is signaled with a
+ * negative int.
+ */
+BLOSC_EXPORT int blosc2_ctx_reset_stats(blosc2_context *ctx);
+
 /**
  * @brief Compress a block of data in the @p src buffer and returns the size of
  * compressed block.
@@ -1409,6 +1784,8 @@ typedef struct {
 static const blosc2_storage BLOSC2_STORAGE_DEFAULTS = {false, NULL, NULL, NULL, NULL};
 
 typedef struct blosc2_frame_s blosc2_frame;   /* opaque type */
+typedef struct blosc2_chunk_cache_s blosc2_chunk_cache;   /* opaque type */
+typedef struct blosc2_dctx_pool_s blosc2_dctx_pool;   /* opaque type */
 
 /**
  * @brief This struct is meant to store metadata information inside
@@ -1477,6 +1854,10 @@ typedef struct blosc2_schunk {
   int16_t nvlmetalayers;
   //!< The number of variable-length metalayers.
   blosc2_btune *udbtune;
+  blosc2_chunk_cache *cache;
+  //!< The cache of decompressed chunks (NULL if disabled).
+  blosc2_dctx_pool *dctx_pool;
+  //!< The idle decompression contexts for concurrent and parallel readers.
 } blosc2_schunk;
 
 
@@ -1669,6 +2050,53 @@ BLOSC_EXPORT int blosc2_schunk_append_buffer(blosc2_schunk *schunk, void *src, i
  */
 BLOSC_EXPORT int blosc2_schunk_decompress_chunk(blosc2_schunk *schunk, int nchunk, void *dest, int32_t nbytes);
 
+/**
+ * @brief Decompress the chunks in [@p start, @p stop) of a super-chunk, in parallel.
+ *
+ * The chunks are decompressed one after the other in @p dest.  Up to the number of
+ * threads of the decompression context of @p schunk are decompressing different chunks at
+ * the same time (each with its own context), so this scales with the number of cores even
+ * for chunks with few blocks.  The threads are taken from the threads callback or the shared
+ * pool when any of them is set.
+ *
+ * @param schunk The super-chunk from where the chunks will be decompressed.  All its
+ * chunks (but the last one) must have the same size.
+ * @param start The first chunk to be decompressed (0 indexed).
+ * @param stop The chunk after the last one to be decompressed.
+ * @param dest The buffer where the decompressed data will be put.
+ * @param nbytes The size of the area pointed by @p *dest.
+ *
+ * @remark A block maskout set in the decompression context of @p schunk is not used here.
+ *
+ * @return The number of decompressed bytes. If some problem is detected, a negative code
+ * is returned instead.
+ */
+BLOSC_EXPORT int64_t blosc2_schunk_decompress_range(blosc2_schunk *schunk, int start, int stop,
+                                                    void *dest, int64_t nbytes);
+
+/**
+ * @brief Get the items in [@p start, @p stop) of a super-chunk, across its chunks.
+ *
+ * The chunks that are fully in the slice are decompressed straight into @p buffer,
+ * and only the blocks with items in the slice are decompressed for the (lazy) chunks
+ * at the boundaries, so the cost is proportional to the size of the slice.  Like
+ * in #blosc2_schunk_decompress_range, the chunks are read in parallel by up to the
+ * number of threads of the decompression context of @p schunk.
+ *
+ * @param schunk The super-chunk from where the items will be read.  All its
+ * chunks (but the last one) must have the same size.
+ * @param start The first item of the slice (0 indexed, in units of typesize).
+ * @param stop The item after the last one of the slice.
+ * @param buffer The buffer where the items will be put.  It must have room for
+ * (@p stop - @p start) * typesize bytes.
+ *
+ * @remark A block maskout set in the decompression context of @p schunk is not used here.
+ *
+ * @return 0 if succeeds. Else a negative code is returned.
+ */
+BLOSC_EXPORT int blosc2_schunk_get_slice_buffer(blosc2_schunk *schunk, int64_t start, int64_t stop,
+                                                void *buffer);
+
 /**
  * @brief Return a compressed chunk that is part of a super-chunk in the @p chunk parameter.
  *
@@ -1761,6 +2189,100 @@ BLOSC_EXPORT int blosc2_schunk_reorder_offsets(blosc2_schunk *schunk, int *offse
  */
 BLOSC_EXPORT int64_t blosc2_schunk_frame_len(blosc2_schunk* schunk);
 
+/**
+ * @brief Set how often the chunk offsets are written when appending to the frame of a super-chunk.
+ *
+ * Appending a chunk to a frame only writes the chunk; the index of chunk offsets (and
+ * the trailer) are re-written after @p nappends appends, or when the super-chunk is
+ * serialized, modified in other ways, or freed.  In the meanwhile, the frame can
+ * only be read through @p schunk.
+ *
+ * @param schunk The super-chunk.
+ * @param nappends The maximum number of appends whose offsets can be pending.  If 0
+ * (the default for in-memory frames), Blosc decides, so that appending a chunk has an
+ * amortized O(1) cost.  On-disk frames default to 1, so that the file is complete (and
+ * readable by other processes, or after a crash) after every append; opt in to 0 (or
+ * larger values) for faster appends, and call #blosc2_schunk_flush_offsets when needed.
+ *
+ * @return 0 if succeeds. Else a negative code is returned.
+ */
+BLOSC_EXPORT int blosc2_schunk_set_offsets_flush(blosc2_schunk *schunk, int32_t nappends);
+
+/**
+ * @brief Write the pending chunk offsets (and the trailer) in the frame of a super-chunk.
+ *
+ * Afterwards, the frame is complete (e.g. an on-disk frame can be opened by other
+ * processes) until the next append.  See #blosc2_schunk_set_offsets_flush.
+ *
+ * @param schunk The super-chunk.
+ *
+ * @return 0 if succeeds. Else a negative code is returned.
+ */
+BLOSC_EXPORT int blosc2_schunk_flush_offsets(blosc2_schunk *schunk);
+
+/**
+ * @brief Set the size of the cache of decompressed chunks of a super-chunk.
+ *
+ * The chunks decompressed by #blosc2_schunk_decompress_chunk are kept in a
+ * least-recently-used cache of (at most) @p nbytes, so that decompressing them
+ * again is just a copy.  Updating, inserting or deleting chunks keeps the cache
+ * coherent.  Several threads can read from the super-chunk at once: the chunks
+ * that miss the cache are decompressed concurrently, each with a private context
+ * (so the postfilter gets the chunk in its params, and `current_nchunk` is not set).
+ *
+ * @param schunk The super-chunk.
+ * @param nbytes The maximum number of decompressed bytes in the cache.  If 0
+ * (the default), the cache is disabled (and freed).
+ *
+ * @return 0 if succeeds. Else a negative code is returned.
+ */
+BLOSC_EXPORT int blosc2_schunk_set_cache_size(blosc2_schunk *schunk, int64_t nbytes);
+
+/**
+ * @brief Get the number of hits and misses in the cache of decompressed chunks of a super-chunk.
+ *
+ * @param schunk The super-chunk.
+ * @param hits The number of decompressions served by the cache (if not NULL).
+ * @param misses The number of decompressions not served by the cache (if not NULL).
+ *
+ * @return 0 if succeeds. Else (e.g. if the cache is disabled) a negative code is returned.
+ */
+BLOSC_EXPORT int blosc2_schunk_get_cache_stats(blosc2_schunk *schunk, int64_t *hits, int64_t *misses);
+
+/**
+ * @brief Train a dictionary to be shared by all the chunks to come of a super-chunk.
+ *
+ * The dictionary is trained out of the outcome of the filters over @p samples, and it is
+ * stored just once in the super-chunk (in the "_b2_dict" vlmetalayer).  The chunks to come
+ * just refer to it, so they are compressed in a single pass, and the dictionary is digested
+ * only once per (de)compression context.  The chunks already in the super-chunk are kept
+ * as they are.
+ *
+ * ZSTD dictionaries are trained with ZDICT.  LZ4, LZ4HC and BloscLZ dictionaries are just
+ * raw content (at most 64 KB) taken from the filtered samples.
+ *
+ * @param schunk The super-chunk.  Its codec must be ZSTD, LZ4, LZ4HC or BloscLZ, and it
+ * cannot have a shared dictionary already.
+ * @param samples The data to train the dictionary from.
+ * @param nbytes The size of @p samples.
+ *
+ * @return 0 if succeeds. Else a negative code is returned.
+ */
+BLOSC_EXPORT int blosc2_schunk_train_dict(blosc2_schunk *schunk, const void *samples, int64_t nbytes);
+
+/**
+ * @brief Train a dictionary to be shared by all the chunks to come of a super-chunk
+ * out of its first @p nchunks chunks.
+ *
+ * See #blosc2_schunk_train_dict.
+ *
+ * @param schunk The super-chunk.
+ * @param nchunks The number of (first) chunks to train the dictionary from.
+ *
+ * @return 0 if succeeds. Else a negative code is returned.
+ */
+BLOSC_EXPORT int blosc2_schunk_train_dict_from_chunks(blosc2_schunk *schunk, int nchunks);
+
 /**
  * @brief Quickly fill an empty frame with special values (zeros, NaNs, uninit).
  *
@@ -0,0 +1,64 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+
+#ifndef BLOSC_BLOSC2_MMAP_H
+#define BLOSC_BLOSC2_MMAP_H
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "blosc2-export.h"
+
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+
+/* stdint.h only available in VS2010 (VC++ 16.0) and newer */
+   #if defined(_MSC_VER) && _MSC_VER < 1600
+     #include "win32/stdint-windows.h"
+   #else
+     #include <stdint.h>
+   #endif
+
+#else
+#include <stdint.h>
+#endif
+
+/* The memory-mapped backend is only available on POSIX systems */
+#if !defined(_WIN32)
+  #define BLOSC2_HAVE_MMAP_IO
+#endif
+
+#if defined(BLOSC2_HAVE_MMAP_IO)
+
+typedef struct {
+  int fd;
+  uint8_t *addr;      //!< The mapping; NULL if nothing is mapped
+  int64_t mapped;     //!< The length of the mapping
+  int64_t size;       //!< The length of the file
+  int64_t position;   //!< The current position of the stream
+  bool writable;
+  bool append;
+} blosc2_mmap_file;
+
+BLOSC_EXPORT void *blosc2_mmap_open(const char *urlpath, const char *mode, void* params);
+BLOSC_EXPORT int blosc2_mmap_close(void *stream);
+BLOSC_EXPORT int64_t blosc2_mmap_tell(void *stream);
+BLOSC_EXPORT int blosc2_mmap_seek(void *stream, int64_t offset, int whence);
+BLOSC_EXPORT int64_t blosc2_mmap_write(const void *ptr, int64_t size, int64_t nitems, void *stream);
+BLOSC_EXPORT int64_t blosc2_mmap_read(void *ptr, int64_t size, int64_t nitems, void *stream);
+BLOSC_EXPORT int blosc2_mmap_truncate(void *stream, int64_t size);
+BLOSC_EXPORT int64_t blosc2_mmap_pread(void *ptr, int64_t size, int64_t nitems, int64_t offset, void *stream);
+BLOSC_EXPORT void *blosc2_mmap_map(void *stream, int64_t offset, int64_t nbytes);
+
+#endif  /* BLOSC2_HAVE_MMAP_IO */
+
+#endif //BLOSC_BLOSC2_MMAP_H
@@ -48,5 +48,6 @@ BLOSC_EXPORT int blosc2_stdio_seek(void *stream, int64_t offset, int whence);
 BLOSC_EXPORT int64_t blosc2_stdio_write(const void *ptr, int64_t size, int64_t nitems, void *stream);
 BLOSC_EXPORT int64_t blosc2_stdio_read(void *ptr, int64_t size, int64_t nitems, void *stream);
 BLOSC_EXPORT int blosc2_stdio_truncate(void *stream, int64_t size);
+BLOSC_EXPORT int64_t blosc2_stdio_pread(void *ptr, int64_t size, int64_t nitems, int64_t offset, void *stream);
 
 #endif //BLOSC_BLOSC2_STDIO_H
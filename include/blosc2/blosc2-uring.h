@@ -0,0 +1,42 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+
+#ifndef BLOSC_BLOSC2_URING_H
+#define BLOSC_BLOSC2_URING_H
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "blosc2-export.h"
+#include "blosc2-stdio.h"
+
+
+/* Streams of the io_uring backend.  When io_uring is not available (at build or run time),
+ * they work just like the ones of the stdio backend. */
+typedef struct {
+  blosc2_stdio_file stdio;  //!< The stream for synchronous IO
+  void *ring;               //!< The io_uring instance (created on the first batch of reads)
+} blosc2_uring_file;
+
+BLOSC_EXPORT void *blosc2_uring_open(const char *urlpath, const char *mode, void* params);
+BLOSC_EXPORT int blosc2_uring_close(void *stream);
+BLOSC_EXPORT int64_t blosc2_uring_tell(void *stream);
+BLOSC_EXPORT int blosc2_uring_seek(void *stream, int64_t offset, int whence);
+BLOSC_EXPORT int64_t blosc2_uring_write(const void *ptr, int64_t size, int64_t nitems, void *stream);
+BLOSC_EXPORT int64_t blosc2_uring_read(void *ptr, int64_t size, int64_t nitems, void *stream);
+BLOSC_EXPORT int blosc2_uring_truncate(void *stream, int64_t size);
+BLOSC_EXPORT int64_t blosc2_uring_pread(void *ptr, int64_t size, int64_t nitems, int64_t offset, void *stream);
+BLOSC_EXPORT void *blosc2_uring_submit(void *stream, int32_t nreads, void **ptrs,
+                                       const int64_t *nbytes, const int64_t *offsets);
+BLOSC_EXPORT int64_t blosc2_uring_complete(void *batch, int32_t nread);
+BLOSC_EXPORT void blosc2_uring_release(void *batch);
+
+#endif //BLOSC_BLOSC2_URING_H
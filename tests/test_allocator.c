@@ -0,0 +1,266 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Unit tests for the user-defined allocator and the block pool.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "blosc2.h"
+#include "cutest.h"
+
+#define CHUNKSHAPE (200 * 1000)
+#define NWARMUP 4
+#define NCHUNKS 20
+
+
+typedef struct {
+  int64_t nallocs;
+  int64_t nresizes;
+  int64_t ndeallocs;
+  int64_t nlive;
+} alloc_counters;
+
+static alloc_counters counters;
+static alloc_counters other_counters;
+// The hooks are called from the threads of the contexts too
+static pthread_mutex_t counters_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+/* The original block and its size are kept right before the aligned block */
+static void* counting_alloc(size_t size, size_t alignment, void* user_data) {
+  alloc_counters* c = (alloc_counters*)user_data;
+  uint8_t* block = malloc(size + alignment + 2 * sizeof(void*));
+  if (block == NULL) {
+    return NULL;
+  }
+  uintptr_t start = (uintptr_t)(block + 2 * sizeof(void*));
+  uint8_t* aligned = (uint8_t*)((start + alignment - 1) & ~(uintptr_t)(alignment - 1));
+  ((void**)aligned)[-1] = block;
+  ((size_t*)aligned)[-2] = size;
+  pthread_mutex_lock(&counters_mutex);
+  c->nallocs++;
+  c->nlive++;
+  pthread_mutex_unlock(&counters_mutex);
+  return aligned;
+}
+
+static void counting_dealloc(void* block, void* user_data) {
+  alloc_counters* c = (alloc_counters*)user_data;
+  pthread_mutex_lock(&counters_mutex);
+  c->ndeallocs++;
+  c->nlive--;
+  pthread_mutex_unlock(&counters_mutex);
+  free(((void**)block)[-1]);
+}
+
+static void* counting_resize(void* block, size_t size, size_t alignment, void* user_data) {
+  alloc_counters* c = (alloc_counters*)user_data;
+  size_t old_size = ((size_t*)block)[-2];
+  void* new_block = counting_alloc(size, alignment, user_data);
+  if (new_block == NULL) {
+    return NULL;
+  }
+  memcpy(new_block, block, old_size < size ? old_size : size);
+  counting_dealloc(block, user_data);
+  pthread_mutex_lock(&counters_mutex);
+  c->nallocs--;
+  c->ndeallocs--;
+  c->nresizes++;
+  pthread_mutex_unlock(&counters_mutex);
+  return new_block;
+}
+
+static int64_t ncalls(void) {
+  pthread_mutex_lock(&counters_mutex);
+  int64_t n = counters.nallocs + counters.nresizes + counters.ndeallocs;
+  pthread_mutex_unlock(&counters_mutex);
+  return n;
+}
+
+
+/* A thread that fills its block pool, and then waits for the allocator to change before exiting */
+typedef struct {
+  int16_t nthreads;
+  int32_t* src;
+  bool filled;
+  bool switched;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  int rc;
+} pool_user_args;
+
+static void* pool_user(void* arg) {
+  pool_user_args* args = (pool_user_args*)arg;
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  cparams.nthreads = args->nthreads;
+  blosc2_storage storage = {.contiguous=true, .cparams=&cparams};
+  blosc2_schunk* schunk = blosc2_schunk_new(&storage);
+  args->rc = schunk != NULL ? 0 : -1;
+  for (int nchunk = 0; nchunk < NWARMUP && args->rc == 0; nchunk++) {
+    if (blosc2_schunk_append_buffer(schunk, args->src, CHUNKSHAPE * sizeof(int32_t)) != nchunk + 1) {
+      args->rc = -1;
+    }
+  }
+  if (schunk != NULL) {
+    blosc2_schunk_free(schunk);
+  }
+
+  pthread_mutex_lock(&args->mutex);
+  args->filled = true;
+  pthread_cond_signal(&args->cond);
+  while (!args->switched) {
+    pthread_cond_wait(&args->cond, &args->mutex);
+  }
+  pthread_mutex_unlock(&args->mutex);
+  return NULL;
+}
+
+
+CUTEST_TEST_DATA(allocator) {
+  blosc2_cparams cparams;
+  blosc2_dparams dparams;
+};
+
+CUTEST_TEST_SETUP(allocator) {
+  blosc2_allocator allocator = {counting_alloc, counting_resize, counting_dealloc, &counters};
+  blosc2_set_allocator(&allocator);
+  data->cparams = BLOSC2_CPARAMS_DEFAULTS;
+  data->cparams.typesize = sizeof(int32_t);
+  data->cparams.compcode = BLOSC_LZ4;
+  data->dparams = BLOSC2_DPARAMS_DEFAULTS;
+
+  CUTEST_PARAMETRIZE(urlpath, char*, CUTEST_DATA(
+      NULL,
+      "test_allocator.b2frame",
+  ));
+  CUTEST_PARAMETRIZE(nthreads, int16_t, CUTEST_DATA(
+      1,
+      4,
+  ));
+  CUTEST_PARAMETRIZE(pool, bool, CUTEST_DATA(
+      true,
+      false,
+  ));
+}
+
+
+CUTEST_TEST_TEST(allocator) {
+  CUTEST_GET_PARAMETER(urlpath, char*);
+  CUTEST_GET_PARAMETER(nthreads, int16_t);
+  CUTEST_GET_PARAMETER(pool, bool);
+
+  memset(&counters, 0, sizeof(counters));
+  blosc_init();
+  blosc2_allocator bad_allocator = {counting_alloc, NULL, counting_dealloc, &counters};
+  CUTEST_ASSERT("ERROR: allocator without resize accepted", blosc2_set_allocator(&bad_allocator) < 0);
+  CUTEST_ASSERT("ERROR: negative pool accepted", blosc2_set_block_pool(-1) < 0);
+  blosc2_set_block_pool(pool ? BLOSC2_BLOCK_POOL_NBYTES : 0);
+
+  int32_t *src = malloc(CHUNKSHAPE * sizeof(int32_t));
+  int32_t *dest = malloc(CHUNKSHAPE * sizeof(int32_t));
+  for (int32_t i = 0; i < CHUNKSHAPE; i++) {
+    src[i] = i * 3 + i % 7;
+  }
+
+  blosc2_cparams cparams = data->cparams;
+  cparams.nthreads = nthreads;
+  blosc2_dparams dparams = data->dparams;
+  dparams.nthreads = nthreads;
+  blosc2_storage storage = {.contiguous=true, .urlpath=urlpath, .cparams=&cparams, .dparams=&dparams};
+  blosc2_remove_urlpath(urlpath);
+  blosc2_schunk* schunk = blosc2_schunk_new(&storage);
+  CUTEST_ASSERT("ERROR: cannot create the super-chunk", schunk != NULL);
+  CUTEST_ASSERT("ERROR: the allocator is not used", counters.nallocs > 0);
+  if (urlpath != NULL) {
+    // Do not write the offsets in the file after every append
+    blosc2_schunk_set_offsets_flush(schunk, 0);
+  }
+
+  // Appends
+  for (int nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    if (nchunk == NWARMUP) {
+      counters.nallocs = counters.nresizes = counters.ndeallocs = 0;
+    }
+    int nchunks = blosc2_schunk_append_buffer(schunk, src, CHUNKSHAPE * sizeof(int32_t));
+    CUTEST_ASSERT("ERROR: cannot append", nchunks == nchunk + 1);
+  }
+  if (pool) {
+    CUTEST_ASSERT("ERROR: appends call the allocator", ncalls() == 0);
+  }
+  else {
+    CUTEST_ASSERT("ERROR: appends do not call the allocator", ncalls() > 0);
+  }
+
+  // Decompressions
+  for (int nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    if (nchunk == NWARMUP) {
+      counters.nallocs = counters.nresizes = counters.ndeallocs = 0;
+    }
+    int dsize = blosc2_schunk_decompress_chunk(schunk, nchunk, dest, CHUNKSHAPE * sizeof(int32_t));
+    CUTEST_ASSERT("ERROR: cannot decompress", dsize == CHUNKSHAPE * sizeof(int32_t));
+    CUTEST_ASSERT("ERROR: bad roundtrip", memcmp(src, dest, dsize) == 0);
+  }
+  if (pool) {
+    CUTEST_ASSERT("ERROR: decompressions call the allocator", ncalls() == 0);
+  }
+
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(urlpath);
+  free(dest);
+
+  // Everything booked with the allocator is released
+  blosc_destroy();
+  CUTEST_ASSERT("ERROR: memory from the allocator is leaked", counters.nlive == 0);
+
+  // The buffers cached by another thread are released with the allocator that booked
+  // them, even if the allocator changes in the meanwhile
+  memset(&counters, 0, sizeof(counters));
+  memset(&other_counters, 0, sizeof(other_counters));
+  blosc_init();
+  blosc2_set_block_pool(pool ? BLOSC2_BLOCK_POOL_NBYTES : 0);
+  pool_user_args args = {.nthreads = nthreads, .src = src};
+  pthread_mutex_init(&args.mutex, NULL);
+  pthread_cond_init(&args.cond, NULL);
+  pthread_t thread;
+  pthread_create(&thread, NULL, pool_user, &args);
+  pthread_mutex_lock(&args.mutex);
+  while (!args.filled) {
+    pthread_cond_wait(&args.cond, &args.mutex);
+  }
+  pthread_mutex_unlock(&args.mutex);
+  // Nothing booked by this thread is alive when switching the allocator
+  blosc_destroy();
+  blosc2_allocator other_allocator = {counting_alloc, counting_resize, counting_dealloc, &other_counters};
+  blosc2_set_allocator(&other_allocator);
+  pthread_mutex_lock(&args.mutex);
+  args.switched = true;
+  pthread_cond_signal(&args.cond);
+  pthread_mutex_unlock(&args.mutex);
+  pthread_join(thread, NULL);
+  pthread_cond_destroy(&args.cond);
+  pthread_mutex_destroy(&args.mutex);
+  CUTEST_ASSERT("ERROR: cannot fill the pool of another thread", args.rc == 0);
+  CUTEST_ASSERT("ERROR: memory booked before the switch is leaked", counters.nlive == 0);
+  CUTEST_ASSERT("ERROR: memory released with another allocator", other_counters.ndeallocs == 0);
+  free(src);
+  // Back to the allocator of the next tests
+  blosc2_allocator allocator = {counting_alloc, counting_resize, counting_dealloc, &counters};
+  blosc2_set_allocator(&allocator);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(allocator) {
+  blosc2_set_allocator(NULL);
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(allocator)
+}
@@ -0,0 +1,207 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Unit tests for the automatic choice of the filters of every chunk.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "blosc2.h"
+#include "cutest.h"
+
+#define CHUNKSHAPE (500 * 1000)
+#define NCHUNKS 4
+
+enum {
+  DATA_RAMP,
+  DATA_SMALL_INTS,
+  DATA_TEXT,
+  DATA_RANDOM,
+};
+
+
+CUTEST_TEST_DATA(auto_filter) {
+  blosc2_cparams cparams;
+  blosc2_dparams dparams;
+};
+
+CUTEST_TEST_SETUP(auto_filter) {
+  blosc_init();
+  data->cparams = BLOSC2_CPARAMS_DEFAULTS;
+  data->cparams.typesize = sizeof(int32_t);
+  data->cparams.compcode = BLOSC_LZ4;
+  data->cparams.filters[BLOSC2_MAX_FILTERS - 1] = BLOSC_AUTO_FILTER;
+  data->dparams = BLOSC2_DPARAMS_DEFAULTS;
+
+  CUTEST_PARAMETRIZE(content, int, CUTEST_DATA(
+      DATA_RAMP,
+      DATA_SMALL_INTS,
+      DATA_TEXT,
+      DATA_RANDOM,
+  ));
+  CUTEST_PARAMETRIZE(nthreads, int16_t, CUTEST_DATA(
+      1,
+      2,
+  ));
+}
+
+
+static void fill_chunk(int32_t *buffer, int content) {
+  static const char *words[] = {"temperature ", "sensor ", "the ", "value ", "reading ",
+                                "of ", "station ", "north ", "humidity "};
+  uint32_t seed = 1234;
+  char *text = (char *)buffer;
+  int32_t pos = 0;
+
+  for (int32_t i = 0; i < CHUNKSHAPE; i++) {
+    seed = seed * 1103515245 + 12345;
+    switch (content) {
+      case DATA_RAMP:
+        buffer[i] = i * 3;
+        break;
+      case DATA_SMALL_INTS:
+        buffer[i] = (int32_t)((seed >> 16) % 4);
+        break;
+      case DATA_RANDOM:
+        buffer[i] = (int32_t)(seed ^ (seed >> 13) * 2654435761U);
+        break;
+      default:
+        break;
+    }
+  }
+  if (content == DATA_TEXT) {
+    int32_t nbytes = CHUNKSHAPE * (int32_t)sizeof(int32_t);
+    while (pos < nbytes - 16) {
+      seed = seed * 1103515245 + 12345;
+      const char *word = words[(seed >> 16) % 9];
+      memcpy(text + pos, word, strlen(word));
+      pos += (int32_t)strlen(word);
+    }
+    memset(text + pos, ' ', nbytes - pos);
+  }
+}
+
+
+CUTEST_TEST_TEST(auto_filter) {
+  CUTEST_GET_PARAMETER(content, int);
+  CUTEST_GET_PARAMETER(nthreads, int16_t);
+
+  int32_t nbytes = CHUNKSHAPE * sizeof(int32_t);
+  int32_t *src = malloc(nbytes);
+  int32_t *dest = malloc(nbytes);
+  uint8_t *cdata = malloc(nbytes + BLOSC_MAX_OVERHEAD);
+  fill_chunk(src, content);
+
+  blosc2_cparams cparams = data->cparams;
+  cparams.filters[0] = BLOSC_AUTO_FILTER;
+  CUTEST_ASSERT("ERROR: two automatic filters accepted", blosc2_create_cctx(cparams) == NULL);
+
+  // The filters of a chunk
+  cparams = data->cparams;
+  cparams.nthreads = nthreads;
+  blosc2_context *cctx = blosc2_create_cctx(cparams);
+  CUTEST_ASSERT("ERROR: cannot create the context", cctx != NULL);
+  int cbytes = blosc2_compress_ctx(cctx, src, nbytes, cdata, nbytes + BLOSC_MAX_OVERHEAD);
+  CUTEST_ASSERT("ERROR: cannot compress", cbytes > 0);
+  uint8_t filter = cdata[BLOSC2_CHUNK_FILTER_CODES + BLOSC2_MAX_FILTERS - 1];
+  uint8_t delta = cdata[BLOSC2_CHUNK_FILTER_CODES + BLOSC2_MAX_FILTERS - 2];
+  switch (content) {
+    case DATA_RAMP:
+      CUTEST_ASSERT("ERROR: no shuffle for a ramp", filter == BLOSC_SHUFFLE || filter == BLOSC_BITSHUFFLE);
+      break;
+    case DATA_SMALL_INTS:
+      CUTEST_ASSERT("ERROR: no bitshuffle for small ints", filter == BLOSC_BITSHUFFLE && delta == BLOSC_NOFILTER);
+      break;
+    case DATA_TEXT:
+      CUTEST_ASSERT("ERROR: filters for text", filter == BLOSC_NOFILTER && delta == BLOSC_NOFILTER);
+      break;
+    default:
+      CUTEST_ASSERT("ERROR: automatic filter in the chunk", filter != BLOSC_AUTO_FILTER);
+  }
+  blosc2_cparams cparams2;
+  blosc2_ctx_get_cparams(cctx, &cparams2);
+  CUTEST_ASSERT("ERROR: the automatic filter is lost",
+                cparams2.filters[BLOSC2_MAX_FILTERS - 1] == BLOSC_AUTO_FILTER);
+  blosc2_free_ctx(cctx);
+
+  blosc2_dparams dparams = data->dparams;
+  dparams.nthreads = nthreads;
+  blosc2_context *dctx = blosc2_create_dctx(dparams);
+  int dsize = blosc2_decompress_ctx(dctx, cdata, cbytes, dest, nbytes);
+  CUTEST_ASSERT("ERROR: cannot decompress", dsize == nbytes);
+  CUTEST_ASSERT("ERROR: bad roundtrip", memcmp(src, dest, nbytes) == 0);
+  blosc2_free_ctx(dctx);
+
+  // Other filters in the pipeline are kept, and leave no room for delta
+  cparams.filters[BLOSC2_MAX_FILTERS - 2] = BLOSC_DELTA_SUB;
+  cctx = blosc2_create_cctx(cparams);
+  cbytes = blosc2_compress_ctx(cctx, src, nbytes, cdata, nbytes + BLOSC_MAX_OVERHEAD);
+  CUTEST_ASSERT("ERROR: cannot compress", cbytes > 0);
+  CUTEST_ASSERT("ERROR: filter replaced",
+                cdata[BLOSC2_CHUNK_FILTER_CODES + BLOSC2_MAX_FILTERS - 2] == BLOSC_DELTA_SUB);
+  blosc2_free_ctx(cctx);
+  dsize = blosc2_decompress(cdata, cbytes, dest, nbytes);
+  CUTEST_ASSERT("ERROR: bad roundtrip", dsize == nbytes && memcmp(src, dest, nbytes) == 0);
+
+  // A super-chunk whose chunks get different filters, and that keeps choosing them when reopened
+  char *urlpath = "test_auto_filter.b2frame";
+  blosc2_remove_urlpath(urlpath);
+  cparams = data->cparams;
+  cparams.nthreads = nthreads;
+  blosc2_storage storage = {.contiguous=true, .urlpath=urlpath, .cparams=&cparams, .dparams=&dparams};
+  blosc2_schunk *schunk = blosc2_schunk_new(&storage);
+  CUTEST_ASSERT("ERROR: cannot create the super-chunk", schunk != NULL);
+  for (int nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    fill_chunk(src, nchunk % 2 == 0 ? content : DATA_TEXT);
+    int nchunks = blosc2_schunk_append_buffer(schunk, src, nbytes);
+    CUTEST_ASSERT("ERROR: cannot append", nchunks == nchunk + 1);
+  }
+  blosc2_schunk_free(schunk);
+  schunk = blosc2_schunk_open(urlpath);
+  CUTEST_ASSERT("ERROR: cannot open the super-chunk", schunk != NULL);
+  // Older libraries read a shuffle from the header, and the automatic filter from a vlmetalayer
+  CUTEST_ASSERT("ERROR: the frame header has no fallback filter",
+                schunk->filters[BLOSC2_MAX_FILTERS - 1] == BLOSC_SHUFFLE);
+  blosc2_cparams *schunk_cparams;
+  blosc2_schunk_get_cparams(schunk, &schunk_cparams);
+  CUTEST_ASSERT("ERROR: the automatic filter is not stored",
+                schunk_cparams->filters[BLOSC2_MAX_FILTERS - 1] == BLOSC_AUTO_FILTER);
+  free(schunk_cparams);
+  fill_chunk(src, DATA_SMALL_INTS);
+  CUTEST_ASSERT("ERROR: cannot append", blosc2_schunk_append_buffer(schunk, src, nbytes) == NCHUNKS + 1);
+  for (int nchunk = 0; nchunk <= NCHUNKS; nchunk++) {
+    fill_chunk(src, nchunk == NCHUNKS ? DATA_SMALL_INTS : nchunk % 2 == 0 ? content : DATA_TEXT);
+    dsize = blosc2_schunk_decompress_chunk(schunk, nchunk, dest, nbytes);
+    CUTEST_ASSERT("ERROR: cannot decompress", dsize == nbytes);
+    CUTEST_ASSERT("ERROR: bad roundtrip", memcmp(src, dest, nbytes) == 0);
+  }
+  uint8_t *chunk;
+  bool needs_free;
+  int csize = blosc2_schunk_get_chunk(schunk, NCHUNKS, &chunk, &needs_free);
+  CUTEST_ASSERT("ERROR: cannot get the chunk", csize > 0);
+  CUTEST_ASSERT("ERROR: no bitshuffle for small ints after reopening",
+                chunk[BLOSC2_CHUNK_FILTER_CODES + BLOSC2_MAX_FILTERS - 1] == BLOSC_BITSHUFFLE);
+  if (needs_free) {
+    free(chunk);
+  }
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(urlpath);
+
+  free(src);
+  free(dest);
+  free(cdata);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(auto_filter) {
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(auto_filter)
+}
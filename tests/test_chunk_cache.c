@@ -0,0 +1,193 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Unit tests for the cache of decompressed chunks of super-chunks.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "blosc2.h"
+#include "cutest.h"
+#include "test_common.h"
+
+#define NCHUNKS (10)
+#define CHUNKSHAPE (20 * 1000)
+#define NREADERS (4)
+#define NREADS (200)
+
+typedef struct {
+  bool contiguous;
+  char *urlpath;
+}test_chunk_cache_backend;
+
+CUTEST_TEST_DATA(chunk_cache) {
+  blosc2_cparams cparams;
+  blosc2_dparams dparams;
+};
+
+CUTEST_TEST_SETUP(chunk_cache) {
+  blosc_init();
+  data->cparams = BLOSC2_CPARAMS_DEFAULTS;
+  data->cparams.typesize = sizeof(int32_t);
+  data->cparams.clevel = 5;
+  data->cparams.blocksize = 16 * 1024;
+  data->cparams.nthreads = 2;
+  data->dparams = BLOSC2_DPARAMS_DEFAULTS;
+  data->dparams.nthreads = 2;
+
+  CUTEST_PARAMETRIZE(backend, test_chunk_cache_backend, CUTEST_DATA(
+      {false, NULL},  // memory - schunk
+      {true, NULL},  // memory - cframe
+      {true, "test_chunk_cache.b2frame"}, // disk - cframe
+      {false, "test_chunk_cache_s.b2frame"}, // disk - sframe
+  ));
+}
+
+
+typedef struct {
+  blosc2_schunk* schunk;
+  int32_t* values;
+  int first;
+  int rc;
+} reader_args;
+
+static void* reader(void* arg) {
+  reader_args* args = (reader_args*)arg;
+  int32_t isize = CHUNKSHAPE * sizeof(int32_t);
+  int32_t *data_dest = malloc(isize);
+  args->rc = 0;
+  // More chunks than the cache holds, so that the readers miss it concurrently
+  for (int i = 0; i < NREADS && args->rc == 0; i++) {
+    int nchunk = (i + args->first) % NCHUNKS;
+    int dsize = blosc2_schunk_decompress_chunk(args->schunk, nchunk, data_dest, isize);
+    if (dsize != isize || data_dest[CHUNKSHAPE - 1] != args->values[nchunk] + CHUNKSHAPE - 1) {
+      args->rc = -1;
+    }
+  }
+  free(data_dest);
+  return NULL;
+}
+
+
+CUTEST_TEST_TEST(chunk_cache) {
+  int32_t values[NCHUNKS + 1];
+  int64_t hits, misses;
+  int32_t isize = CHUNKSHAPE * sizeof(int32_t);
+
+  CUTEST_GET_PARAMETER(backend, test_chunk_cache_backend);
+
+  blosc2_remove_urlpath(backend.urlpath);
+  blosc2_storage storage = {.cparams=&data->cparams, .dparams=&data->dparams,
+                            .urlpath=backend.urlpath, .contiguous=backend.contiguous};
+  blosc2_schunk* schunk = blosc2_schunk_new(&storage);
+  CUTEST_ASSERT("Error creating schunk", schunk != NULL);
+  for (int i = 0; i < NCHUNKS; ++i) {
+    values[i] = i * CHUNKSHAPE;
+    CUTEST_ASSERT("ERROR: bad append", blosc_test_append_chunk(schunk, CHUNKSHAPE, values[i]) == i + 1);
+  }
+
+  CUTEST_ASSERT("ERROR: stats without a cache", blosc2_schunk_get_cache_stats(schunk, &hits, &misses) < 0);
+  // Room for 3 chunks
+  CUTEST_ASSERT("ERROR: cannot set the cache", blosc2_schunk_set_cache_size(schunk, 3 * isize) == 0);
+
+  for (int i = 0; i < NCHUNKS; i++) {
+    CUTEST_ASSERT("ERROR: bad roundtrip", blosc_test_check_chunk(schunk, i, CHUNKSHAPE, values[i]) == 0);
+  }
+  for (int i = NCHUNKS - 3; i < NCHUNKS; i++) {
+    CUTEST_ASSERT("ERROR: bad cached roundtrip", blosc_test_check_chunk(schunk, i, CHUNKSHAPE, values[i]) == 0);
+  }
+  CUTEST_ASSERT("ERROR: cannot get stats", blosc2_schunk_get_cache_stats(schunk, &hits, &misses) == 0);
+  CUTEST_ASSERT("ERROR: bad number of hits", hits == 3);
+  CUTEST_ASSERT("ERROR: bad number of misses", misses == NCHUNKS);
+  // The least recently used chunks have been evicted
+  CUTEST_ASSERT("ERROR: bad roundtrip", blosc_test_check_chunk(schunk, 0, CHUNKSHAPE, values[0]) == 0);
+  blosc2_schunk_get_cache_stats(schunk, &hits, &misses);
+  CUTEST_ASSERT("ERROR: evicted chunk is a hit", hits == 3 && misses == NCHUNKS + 1);
+
+  // Updates, insertions and deletions keep the cache coherent
+  for (int i = 0; i < 3; i++) {
+    CUTEST_ASSERT("ERROR: bad roundtrip", blosc_test_check_chunk(schunk, i, CHUNKSHAPE, values[i]) == 0);
+  }
+  values[1] = -1000 * 1000;
+  uint8_t *chunk = blosc_test_make_chunk(schunk, CHUNKSHAPE, values[1]);
+  CUTEST_ASSERT("ERROR: cannot update chunk", blosc2_schunk_update_chunk(schunk, 1, chunk, true) == NCHUNKS);
+  free(chunk);
+  CUTEST_ASSERT("ERROR: stale chunk after update", blosc_test_check_chunk(schunk, 1, CHUNKSHAPE, values[1]) == 0);
+
+  for (int i = NCHUNKS; i > 0; i--) {
+    values[i] = values[i - 1];
+  }
+  values[0] = 3000 * 1000;
+  chunk = blosc_test_make_chunk(schunk, CHUNKSHAPE, values[0]);
+  CUTEST_ASSERT("ERROR: cannot insert chunk", blosc2_schunk_insert_chunk(schunk, 0, chunk, true) == NCHUNKS + 1);
+  free(chunk);
+  for (int i = 0; i < 3; i++) {
+    CUTEST_ASSERT("ERROR: stale chunk after insert", blosc_test_check_chunk(schunk, i, CHUNKSHAPE, values[i]) == 0);
+  }
+
+  CUTEST_ASSERT("ERROR: cannot delete chunk", blosc2_schunk_delete_chunk(schunk, 1) == NCHUNKS);
+  for (int i = 1; i < NCHUNKS; i++) {
+    values[i] = values[i + 1];
+  }
+  for (int i = 0; i < 3; i++) {
+    CUTEST_ASSERT("ERROR: stale chunk after delete", blosc_test_check_chunk(schunk, i, CHUNKSHAPE, values[i]) == 0);
+  }
+
+  // A partial decompression does not go through the cache
+  int32_t blocksize = data->cparams.blocksize;
+  int32_t nblocks = isize / blocksize + (isize % blocksize ? 1 : 0);
+  bool *maskout = calloc(nblocks, sizeof(bool));
+  maskout[0] = true;
+  blosc2_schunk_get_cache_stats(schunk, &hits, &misses);
+  int64_t hits_ = hits;
+  CUTEST_ASSERT("ERROR: cannot set the maskout", blosc2_set_maskout(schunk->dctx, maskout, nblocks) == 0);
+  int32_t *data_dest = malloc(isize);
+  CUTEST_ASSERT("ERROR: bad decompression", blosc2_schunk_decompress_chunk(schunk, 0, data_dest, isize) == isize);
+  free(data_dest);
+  free(maskout);
+  blosc2_schunk_get_cache_stats(schunk, &hits, &misses);
+  CUTEST_ASSERT("ERROR: maskout hits the cache", hits == hits_);
+
+  // Several readers at once
+  blosc2_schunk_get_cache_stats(schunk, &hits, &misses);
+  int64_t nreads_ = hits + misses;
+  int64_t misses_ = misses;
+  pthread_t threads[NREADERS];
+  reader_args args[NREADERS];
+  for (int i = 0; i < NREADERS; i++) {
+    args[i].schunk = schunk;
+    args[i].values = values;
+    args[i].first = i;
+    pthread_create(&threads[i], NULL, reader, &args[i]);
+  }
+  for (int i = 0; i < NREADERS; i++) {
+    pthread_join(threads[i], NULL);
+    CUTEST_ASSERT("ERROR: bad concurrent read", args[i].rc == 0);
+  }
+  blosc2_schunk_get_cache_stats(schunk, &hits, &misses);
+  CUTEST_ASSERT("ERROR: bad number of concurrent reads", hits + misses == nreads_ + NREADERS * NREADS);
+  CUTEST_ASSERT("ERROR: concurrent reads do not miss the cache", misses - misses_ >= NREADS);
+
+  // Disabling the cache
+  CUTEST_ASSERT("ERROR: cannot disable the cache", blosc2_schunk_set_cache_size(schunk, 0) == 0);
+  CUTEST_ASSERT("ERROR: bad roundtrip", blosc_test_check_chunk(schunk, 0, CHUNKSHAPE, values[0]) == 0);
+
+  /* Free resources */
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(backend.urlpath);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(chunk_cache) {
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(chunk_cache)
+}
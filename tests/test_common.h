@@ -118,6 +118,81 @@ inline static void blosc_test_fill_random(void* const ptr, const size_t size) {
   }
 }
 
+/*
+  Super-chunk functions.
+*/
+
+/** Fills a chunk of `nitems` int32 values counting up from `value`. */
+inline static void blosc_test_fill_chunk(int32_t* chunk, const int32_t nitems, const int32_t value) {
+  for (int32_t j = 0; j < nitems; j++) {
+    chunk[j] = value + j;
+  }
+}
+
+/** Compresses a chunk filled by blosc_test_fill_chunk with the compression
+    context of `schunk`.  Returns NULL on error. */
+inline static uint8_t* blosc_test_make_chunk(blosc2_schunk* schunk, const int32_t nitems,
+                                             const int32_t value) {
+  int32_t isize = nitems * (int32_t)sizeof(int32_t);
+  int32_t* data_ = malloc(isize);
+  blosc_test_fill_chunk(data_, nitems, value);
+  uint8_t* chunk = malloc(isize + BLOSC_MAX_OVERHEAD);
+  int csize = blosc2_compress_ctx(schunk->cctx, data_, isize, chunk, isize + BLOSC_MAX_OVERHEAD);
+  free(data_);
+  if (csize < 0) {
+    free(chunk);
+    return NULL;
+  }
+  return chunk;
+}
+
+/** Appends a chunk filled by blosc_test_fill_chunk to `schunk`.  Returns the
+    number of chunks, or a negative value on error. */
+inline static int blosc_test_append_chunk(blosc2_schunk* schunk, const int32_t nitems,
+                                          const int32_t value) {
+  int32_t isize = nitems * (int32_t)sizeof(int32_t);
+  int32_t* data_ = malloc(isize);
+  blosc_test_fill_chunk(data_, nitems, value);
+  int rc = blosc2_schunk_append_buffer(schunk, data_, isize);
+  free(data_);
+  return rc;
+}
+
+/** Checks that the chunk `nchunk` of `schunk` is the one filled by
+    blosc_test_fill_chunk out of `value`.  Returns 0 if it is. */
+inline static int blosc_test_check_chunk(blosc2_schunk* schunk, const int nchunk, const int32_t nitems,
+                                         const int32_t value) {
+  int32_t isize = nitems * (int32_t)sizeof(int32_t);
+  int32_t* data_dest = malloc(isize);
+  int rc = 0;
+  int dsize = blosc2_schunk_decompress_chunk(schunk, nchunk, data_dest, isize);
+  if (dsize != isize) {
+    rc = -1;
+  }
+  for (int32_t j = 0; j < nitems && rc == 0; j++) {
+    if (data_dest[j] != value + j) {
+      rc = -1;
+    }
+  }
+  free(data_dest);
+  return rc;
+}
+
+/** Checks that `schunk` has `nchunks` chunks, filled by blosc_test_fill_chunk
+    out of `values`.  Returns 0 if it does. */
+inline static int blosc_test_check_chunks(blosc2_schunk* schunk, const int32_t* values, const int nchunks,
+                                          const int32_t nitems) {
+  if (schunk->nchunks != nchunks) {
+    return -1;
+  }
+  for (int i = 0; i < nchunks; i++) {
+    if (blosc_test_check_chunk(schunk, i, nitems, values[i]) < 0) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
 /*
   Argument parsing.
 */
@@ -0,0 +1,159 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Unit tests for the CPU caches that automatic blocksizes are derived from.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "blosc2.h"
+#include "cpuinfo.h"
+#include "cutest.h"
+
+#define KB 1024
+#define MB (1024 * KB)
+#define NBYTES (16 * MB)
+
+enum {
+  CACHES_DEFAULTS,
+  CACHES_SMALL,
+  CACHES_LARGE,
+  CACHES_ODD,
+  CACHES_BOGUS,
+};
+
+static const blosc2_cpu_caches small_caches = {16 * KB, 128 * KB, 512 * KB, 1, 4};
+static const blosc2_cpu_caches large_caches = {64 * KB, 2 * MB, 64 * MB, 8, 64};
+static const blosc2_cpu_caches odd_caches = {48 * KB, 1280 * KB, 30 * MB, 12, 12};
+// As reported by some virtual machines
+static const blosc2_cpu_caches bogus_caches = {32 * KB, 2 * MB, 300 * MB, 1, 1};
+
+
+CUTEST_TEST_DATA(cpu_caches) {
+  blosc2_cparams cparams;
+  uint8_t *src;
+  uint8_t *dest;
+};
+
+CUTEST_TEST_SETUP(cpu_caches) {
+  blosc_init();
+  data->cparams = BLOSC2_CPARAMS_DEFAULTS;
+  data->cparams.compcode = BLOSC_LZ4;
+  data->cparams.nthreads = 1;
+  data->src = malloc(NBYTES);
+  data->dest = malloc(NBYTES + BLOSC_MAX_OVERHEAD);
+  for (int32_t i = 0; i < NBYTES / 4; i++) {
+    ((int32_t *)data->src)[i] = i;
+  }
+
+  CUTEST_PARAMETRIZE(caches, int, CUTEST_DATA(
+      CACHES_DEFAULTS,
+      CACHES_SMALL,
+      CACHES_LARGE,
+      CACHES_ODD,
+      CACHES_BOGUS,
+  ));
+  CUTEST_PARAMETRIZE(typesize, int32_t, CUTEST_DATA(
+      4,
+      8,
+  ));
+}
+
+
+/* The blocksize chosen automatically for a clevel */
+static int32_t auto_blocksize(blosc2_cparams cparams, int clevel, uint8_t *src, uint8_t *dest) {
+  cparams.clevel = clevel;
+  blosc2_context *cctx = blosc2_create_cctx(cparams);
+  int cbytes = blosc2_compress_ctx(cctx, src, NBYTES, dest, NBYTES + BLOSC_MAX_OVERHEAD);
+  blosc2_free_ctx(cctx);
+  if (cbytes < 0) {
+    return cbytes;
+  }
+  int32_t nbytes, blocksize;
+  blosc2_cbuffer_sizes(dest, &nbytes, &cbytes, &blocksize);
+  return blocksize;
+}
+
+
+CUTEST_TEST_TEST(cpu_caches) {
+  CUTEST_GET_PARAMETER(caches, int);
+  CUTEST_GET_PARAMETER(typesize, int32_t);
+
+  blosc2_cpu_caches detected;
+  CUTEST_ASSERT("ERROR: cannot get the caches", blosc2_get_cpu_caches(&detected) == 0);
+  CUTEST_ASSERT("ERROR: bad detected caches", detected.l1_size > 0 && detected.l2_size > 0 &&
+                detected.l3_size > 0 && detected.l3_ncores > 0 && detected.ncores > 0);
+  blosc2_cpu_caches bad_caches = detected;
+  bad_caches.l3_ncores = 0;
+  CUTEST_ASSERT("ERROR: no cores sharing the L3 accepted", blosc2_set_cpu_caches(&bad_caches) < 0);
+  bad_caches = detected;
+  bad_caches.l1_size = -1;
+  CUTEST_ASSERT("ERROR: negative L1 accepted", blosc2_set_cpu_caches(&bad_caches) < 0);
+
+  // The L1 bounds the blocks of low clevels and the L2 and L3 the ones of higher clevels
+  int32_t l1_blocksize, l2_blocksize;
+  switch (caches) {
+    case CACHES_SMALL:
+      blosc2_set_cpu_caches(&small_caches);
+      l1_blocksize = 16 * KB * typesize;
+      // The caches set are used as they are, so blocks do not exceed the 512 KB of L3
+      l2_blocksize = 512 * KB;
+      break;
+    case CACHES_LARGE:
+      blosc2_set_cpu_caches(&large_caches);
+      l1_blocksize = 64 * KB * typesize;
+      // The 2 MB of L2 times the typesize, up to the 8 MB of L3 of a core
+      l2_blocksize = 8 * MB;
+      break;
+    case CACHES_ODD:
+      // Sizes that are not powers of 2 are not rounded
+      blosc2_set_cpu_caches(&odd_caches);
+      l1_blocksize = 48 * KB * typesize;
+      l2_blocksize = 2560 * KB;
+      break;
+    case CACHES_BOGUS:
+      // Detected caches are kept close to the default ones: 1 MB of L2 and 16 MB of L3
+      blosc_cpu_caches_set(&bogus_caches, false);
+      l1_blocksize = 32 * KB * typesize;
+      l2_blocksize = 1 * MB * typesize;
+      break;
+    default:
+      blosc2_set_cpu_caches(&BLOSC2_CPU_CACHES_DEFAULTS);
+      l1_blocksize = 32 * KB * typesize;
+      l2_blocksize = 256 * KB * typesize;
+  }
+  blosc2_cpu_caches in_use;
+  blosc2_get_cpu_caches(&in_use);
+  CUTEST_ASSERT("ERROR: caches not set", caches != CACHES_SMALL || in_use.l1_size == 16 * KB);
+
+  blosc2_cparams cparams = data->cparams;
+  cparams.typesize = typesize;
+  CUTEST_ASSERT("ERROR: bad blocksize for clevel 1",
+                auto_blocksize(cparams, 1, data->src, data->dest) == l1_blocksize);
+  CUTEST_ASSERT("ERROR: bad blocksize for clevel 5",
+                auto_blocksize(cparams, 5, data->src, data->dest) == l2_blocksize);
+  // A block is never the whole chunk
+  CUTEST_ASSERT("ERROR: blocksize for clevel 9 too large",
+                auto_blocksize(cparams, 9, data->src, data->dest) <= NBYTES / 2);
+
+  // Back to the detected caches
+  CUTEST_ASSERT("ERROR: cannot detect the caches again", blosc2_set_cpu_caches(NULL) == 0);
+  blosc2_get_cpu_caches(&in_use);
+  CUTEST_ASSERT("ERROR: caches not detected again", memcmp(&in_use, &detected, sizeof(in_use)) == 0);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(cpu_caches) {
+  free(data->src);
+  free(data->dest);
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(cpu_caches)
+}
@@ -0,0 +1,170 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Unit tests for the (SIMD) XOR delta and the subtractive delta filters.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "blosc2.h"
+#include "cutest.h"
+#include "../blosc/delta.h"
+
+#define NELEMS (50 * 1000 + 3)
+
+
+CUTEST_TEST_DATA(delta_sub) {
+  blosc2_cparams cparams;
+  blosc2_dparams dparams;
+};
+
+CUTEST_TEST_SETUP(delta_sub) {
+  blosc_init();
+  data->cparams = BLOSC2_CPARAMS_DEFAULTS;
+  data->cparams.compcode = BLOSC_LZ4;
+  data->cparams.blocksize = 16 * 1024;
+  data->dparams = BLOSC2_DPARAMS_DEFAULTS;
+
+  CUTEST_PARAMETRIZE(typesize, int32_t, CUTEST_DATA(
+      1, 2, 4, 8, 3, 12, 16,
+  ));
+  CUTEST_PARAMETRIZE(nthreads, int, CUTEST_DATA(
+      1,
+      4,
+  ));
+}
+
+
+// Monotonic timestamps with some jitter
+static void fill_buffer(uint8_t *buffer, int32_t nbytes) {
+  uint64_t value = 1600000000000ULL;
+  uint32_t seed = 1234;
+  for (int32_t i = 0; i < nbytes; i++) {
+    seed = seed * 1103515245 + 12345;
+    buffer[i] = (uint8_t)(seed >> 16);
+  }
+  if (nbytes % 8 == 0) {
+    for (int32_t i = 0; i < nbytes / 8; i++) {
+      seed = seed * 1103515245 + 12345;
+      value += 1000 + (seed >> 16) % 16;
+      memcpy(buffer + i * 8, &value, sizeof(value));
+    }
+  }
+}
+
+
+// The scalar XOR delta, as it was before being vectorized (plus copying the leftovers)
+static void xor_reference(const uint8_t *dref, int32_t offset, int32_t nbytes, int32_t typesize,
+                          const uint8_t *src, uint8_t *dest) {
+  if (typesize != 1 && typesize != 2 && typesize != 4 && typesize != 8) {
+    typesize = (typesize % 8) == 0 ? 8 : 1;
+  }
+  int32_t vbytes = nbytes / typesize * typesize;
+  memcpy(dest + vbytes, src + vbytes, nbytes - vbytes);
+  for (int32_t i = 0; i < vbytes; i++) {
+    if (offset == 0) {
+      dest[i] = (uint8_t)(i < typesize ? dref[i] : src[i] ^ dref[i - typesize]);
+    } else {
+      dest[i] = src[i] ^ dref[i];
+    }
+  }
+}
+
+
+CUTEST_TEST_TEST(delta_sub) {
+  CUTEST_GET_PARAMETER(typesize, int32_t);
+  CUTEST_GET_PARAMETER(nthreads, int);
+
+  int32_t nbytes = NELEMS * 8;
+  uint8_t *src = malloc(nbytes);
+  uint8_t *dref = malloc(nbytes);
+  uint8_t *dest = malloc(nbytes);
+  uint8_t *expected = malloc(nbytes);
+  fill_buffer(src, nbytes);
+  for (int32_t i = 0; i < nbytes; i++) {
+    dref[i] = src[i] ^ (uint8_t)(i * 7);
+  }
+
+  // XOR delta is byte-exact with the scalar version (block sizes not multiple of vectors)
+  for (int32_t bsize = 1; bsize < 200; bsize += 7) {
+    for (int32_t offset = 0; offset < 2; offset++) {
+      memset(dest, 0, bsize);
+      memset(expected, 0, bsize);
+      delta_encoder(dref, offset, bsize, typesize, src, dest);
+      xor_reference(dref, offset, bsize, typesize, src, expected);
+      CUTEST_ASSERT("ERROR: XOR delta does not match the scalar version",
+                    memcmp(dest, expected, bsize) == 0);
+    }
+  }
+
+  // XOR delta roundtrip (the reference block is decoded in place)
+  delta_encoder(src, 0, nbytes, typesize, src, dest);
+  delta_decoder(dest, 0, nbytes, typesize, dest);
+  CUTEST_ASSERT("ERROR: bad XOR delta roundtrip", memcmp(src, dest, nbytes) == 0);
+  delta_encoder(dref, 1, nbytes, typesize, src, dest);
+  delta_decoder(dref, 1, nbytes, typesize, dest);
+  CUTEST_ASSERT("ERROR: bad XOR delta roundtrip", memcmp(src, dest, nbytes) == 0);
+
+  // Subtractive delta roundtrip, including leftover bytes
+  for (int32_t bsize = 1; bsize < 200; bsize += 7) {
+    delta_sub_encoder(bsize, typesize, src, dest);
+    delta_sub_decoder(bsize, typesize, dest, expected);
+    CUTEST_ASSERT("ERROR: bad subtractive delta roundtrip", memcmp(src, expected, bsize) == 0);
+  }
+  if (typesize == 8) {
+    delta_sub_encoder(nbytes, typesize, src, dest);
+    for (int32_t i = 1; i < NELEMS; i++) {
+      uint64_t diff = ((uint64_t *)src)[i] - ((uint64_t *)src)[i - 1];
+      CUTEST_ASSERT("ERROR: bad subtractive delta", ((uint64_t *)dest)[i] == diff);
+    }
+  }
+
+  // Roundtrip through the compression pipeline
+  int cbytes[2];
+  uint8_t filters[2] = {BLOSC_DELTA, BLOSC_DELTA_SUB};
+  uint8_t *cdata = malloc(nbytes + BLOSC_MAX_OVERHEAD);
+  for (int i = 0; i < 2; i++) {
+    blosc2_cparams cparams = data->cparams;
+    cparams.typesize = typesize;
+    cparams.nthreads = (int16_t)nthreads;
+    cparams.filters[BLOSC2_MAX_FILTERS - 2] = filters[i];
+    cparams.filters[BLOSC2_MAX_FILTERS - 1] = BLOSC_SHUFFLE;
+    blosc2_context *cctx = blosc2_create_cctx(cparams);
+    cbytes[i] = blosc2_compress_ctx(cctx, src, nbytes, cdata, nbytes + BLOSC_MAX_OVERHEAD);
+    CUTEST_ASSERT("ERROR: cannot compress", cbytes[i] > 0);
+    blosc2_free_ctx(cctx);
+
+    blosc2_dparams dparams = data->dparams;
+    dparams.nthreads = (int16_t)nthreads;
+    blosc2_context *dctx = blosc2_create_dctx(dparams);
+    int dsize = blosc2_decompress_ctx(dctx, cdata, cbytes[i], dest, nbytes);
+    CUTEST_ASSERT("ERROR: bad decompression", dsize == nbytes);
+    CUTEST_ASSERT("ERROR: bad roundtrip", memcmp(src, dest, nbytes) == 0);
+    blosc2_free_ctx(dctx);
+  }
+  if (typesize == 8) {
+    CUTEST_ASSERT("ERROR: subtractive delta should compress timestamps better",
+                  cbytes[1] < cbytes[0]);
+  }
+
+  /* Free resources */
+  free(cdata);
+  free(src);
+  free(dref);
+  free(dest);
+  free(expected);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(delta_sub) {
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(delta_sub)
+}
@@ -0,0 +1,139 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Unit tests for the dictionaries of the LZ4, LZ4HC and BloscLZ codecs.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "blosc2.h"
+#include "cutest.h"
+
+#define NCHUNKS (6)
+#define NTRAIN (2)
+#define CHUNKSHAPE (50 * 1000)
+
+CUTEST_TEST_DATA(dict_codecs) {
+  blosc2_cparams cparams;
+  blosc2_dparams dparams;
+};
+
+CUTEST_TEST_SETUP(dict_codecs) {
+  blosc_init();
+  data->cparams = BLOSC2_CPARAMS_DEFAULTS;
+  data->cparams.typesize = sizeof(int32_t);
+  data->cparams.clevel = 5;
+  data->dparams = BLOSC2_DPARAMS_DEFAULTS;
+
+  CUTEST_PARAMETRIZE(compcode, uint8_t, CUTEST_DATA(
+      BLOSC_BLOSCLZ,
+      BLOSC_LZ4,
+      BLOSC_LZ4HC,
+  ));
+  CUTEST_PARAMETRIZE(shared, bool, CUTEST_DATA(
+      false,  // a dictionary per chunk
+      true,  // a dictionary shared by the super-chunk
+  ));
+  CUTEST_PARAMETRIZE(nthreads, int, CUTEST_DATA(
+      1,
+      4,
+  ));
+}
+
+
+// Values out of a small set, so that a dictionary makes a difference
+static void fill_chunk(int32_t *data_, int nchunk) {
+  uint32_t seed = 1234 + nchunk;
+  for (int j = 0; j < CHUNKSHAPE; j++) {
+    seed = seed * 1103515245 + 12345;
+    data_[j] = (int32_t)((seed >> 16) % 64) * 1000003;
+  }
+}
+
+
+CUTEST_TEST_TEST(dict_codecs) {
+  CUTEST_GET_PARAMETER(compcode, uint8_t);
+  CUTEST_GET_PARAMETER(shared, bool);
+  CUTEST_GET_PARAMETER(nthreads, int);
+
+  data->cparams.compcode = compcode;
+  data->cparams.use_dict = !shared;
+  data->cparams.nthreads = (int16_t)nthreads;
+  data->dparams.nthreads = (int16_t)nthreads;
+  blosc2_storage storage = {.cparams=&data->cparams, .dparams=&data->dparams};
+  blosc2_schunk *schunk = blosc2_schunk_new(&storage);
+  CUTEST_ASSERT("Error creating schunk", schunk != NULL);
+
+  int32_t *data_ = malloc(CHUNKSHAPE * sizeof(int32_t));
+  int32_t *data_dest = malloc(CHUNKSHAPE * sizeof(int32_t));
+  for (int i = 0; i < NCHUNKS; i++) {
+    if (shared && i == NTRAIN) {
+      CUTEST_ASSERT("ERROR: cannot train the dictionary",
+                    blosc2_schunk_train_dict_from_chunks(schunk, NTRAIN) == 0);
+    }
+    fill_chunk(data_, i);
+    int rc = blosc2_schunk_append_buffer(schunk, data_, CHUNKSHAPE * sizeof(int32_t));
+    CUTEST_ASSERT("ERROR: bad append", rc == i + 1);
+  }
+
+  // Decompress with the context of the super-chunk
+  for (int i = 0; i < NCHUNKS; i++) {
+    fill_chunk(data_, i);
+    int dsize = blosc2_schunk_decompress_chunk(schunk, i, data_dest, CHUNKSHAPE * sizeof(int32_t));
+    CUTEST_ASSERT("ERROR: bad decompression", dsize == CHUNKSHAPE * sizeof(int32_t));
+    CUTEST_ASSERT("ERROR: bad roundtrip", memcmp(data_, data_dest, CHUNKSHAPE * sizeof(int32_t)) == 0);
+  }
+
+  // Items out of the last chunk
+  uint8_t *chunk;
+  bool needs_free;
+  int cbytes = blosc2_schunk_get_chunk(schunk, NCHUNKS - 1, &chunk, &needs_free);
+  CUTEST_ASSERT("ERROR: cannot get chunk", cbytes > 0);
+  CUTEST_ASSERT("ERROR: the chunk does not use a dictionary",
+                chunk[BLOSC2_CHUNK_BLOSC2_FLAGS] & BLOSC2_USEDICT);
+  int32_t items[10];
+  int rc = blosc2_getitem_ctx(schunk->dctx, chunk, cbytes, 1000, 10, items, sizeof(items));
+  CUTEST_ASSERT("ERROR: bad getitem", rc == sizeof(items));
+  CUTEST_ASSERT("ERROR: bad getitem value", memcmp(items, data_ + 1000, sizeof(items)) == 0);
+  if (needs_free) {
+    free(chunk);
+  }
+
+  // A new super-chunk out of the frame (with fresh contexts)
+  uint8_t *cframe;
+  bool cframe_needs_free;
+  int64_t len = blosc2_schunk_to_buffer(schunk, &cframe, &cframe_needs_free);
+  CUTEST_ASSERT("ERROR: cannot get the frame", len > 0);
+  blosc2_schunk *schunk2 = blosc2_schunk_from_buffer(cframe, len, true);
+  CUTEST_ASSERT("ERROR: cannot open the frame", schunk2 != NULL);
+  for (int i = 0; i < NCHUNKS; i++) {
+    fill_chunk(data_, i);
+    int dsize = blosc2_schunk_decompress_chunk(schunk2, i, data_dest, CHUNKSHAPE * sizeof(int32_t));
+    CUTEST_ASSERT("ERROR: bad decompression after reopening", dsize == CHUNKSHAPE * sizeof(int32_t));
+    CUTEST_ASSERT("ERROR: bad roundtrip after reopening",
+                  memcmp(data_, data_dest, CHUNKSHAPE * sizeof(int32_t)) == 0);
+  }
+
+  /* Free resources */
+  blosc2_schunk_free(schunk2);
+  if (cframe_needs_free) {
+    free(cframe);
+  }
+  free(data_);
+  free(data_dest);
+  blosc2_schunk_free(schunk);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(dict_codecs) {
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(dict_codecs)
+}
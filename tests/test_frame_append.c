@@ -0,0 +1,235 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Unit tests for appending lots of chunks to frames (the offsets are written lazily).
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "blosc2.h"
+#include "cutest.h"
+
+
+#define CHUNKSHAPE (1000)
+#define NTHREADS 2
+#define COUNTING_IO_ID 246
+
+// Every flush of the offsets re-writes the trailer and truncates the frame after it
+static int64_t ntruncates = 0;
+
+typedef struct {
+  bool contiguous;
+  char *urlpath;
+}test_frame_append_backend;
+
+static void* counting_open(const char *urlpath, const char *mode, void *params) {
+  (void)params;
+  return blosc2_stdio_open(urlpath, mode, NULL);
+}
+
+static int counting_close(void *stream) {
+  return blosc2_stdio_close(stream);
+}
+
+static int64_t counting_tell(void *stream) {
+  return blosc2_stdio_tell(stream);
+}
+
+static int counting_seek(void *stream, int64_t offset, int whence) {
+  return blosc2_stdio_seek(stream, offset, whence);
+}
+
+static int64_t counting_write(const void *ptr, int64_t size, int64_t nitems, void *stream) {
+  return blosc2_stdio_write(ptr, size, nitems, stream);
+}
+
+static int64_t counting_read(void *ptr, int64_t size, int64_t nitems, void *stream) {
+  return blosc2_stdio_read(ptr, size, nitems, stream);
+}
+
+static int counting_truncate(void *stream, int64_t size) {
+  ntruncates++;
+  return blosc2_stdio_truncate(stream, size);
+}
+
+
+CUTEST_TEST_DATA(frame_append) {
+  blosc2_cparams cparams;
+  blosc2_dparams dparams;
+  blosc2_io io;
+};
+
+CUTEST_TEST_SETUP(frame_append) {
+  blosc_init();
+  data->cparams = BLOSC2_CPARAMS_DEFAULTS;
+  blosc2_cparams* cparams = &data->cparams;
+  cparams->typesize = sizeof(int32_t);
+  cparams->clevel = 5;
+  cparams->nthreads = NTHREADS;
+  data->dparams = BLOSC2_DPARAMS_DEFAULTS;
+  blosc2_dparams* dparams = &data->dparams;
+  dparams->nthreads = NTHREADS;
+
+  blosc2_io_cb io_cb = {.id=COUNTING_IO_ID, .open=counting_open, .close=counting_close,
+                        .tell=counting_tell, .seek=counting_seek, .write=counting_write,
+                        .read=counting_read, .truncate=counting_truncate};
+  blosc2_register_io_cb(&io_cb);
+  data->io.id = COUNTING_IO_ID;
+  data->io.params = NULL;
+
+  CUTEST_PARAMETRIZE(nchunks, int, CUTEST_DATA(
+      1,
+      63,
+      100,
+      1000,
+  ));
+  CUTEST_PARAMETRIZE(backend, test_frame_append_backend, CUTEST_DATA(
+      {true, NULL},  // memory - cframe
+      {true, "test_frame_append.b2frame"}, // disk - cframe
+      {false, "test_frame_append_s.b2frame"}, // disk - sframe
+  ));
+}
+
+
+static int check_chunks(blosc2_schunk* schunk, int nchunks, int32_t *data_dest) {
+  int32_t isize = CHUNKSHAPE * sizeof(int32_t);
+  if (schunk->nchunks != nchunks) {
+    return -1;
+  }
+  for (int i = 0; i < nchunks; i++) {
+    int dsize = blosc2_schunk_decompress_chunk(schunk, i, data_dest, isize);
+    if (dsize != isize) {
+      return -1;
+    }
+    for (int j = 0; j < CHUNKSHAPE; j++) {
+      // Every 7th chunk is made of zeros (a special chunk)
+      int32_t expected = (i % 7 == 0) ? 0 : i * CHUNKSHAPE + j;
+      if (data_dest[j] != expected) {
+        return -1;
+      }
+    }
+  }
+  return 0;
+}
+
+
+CUTEST_TEST_TEST(frame_append) {
+  blosc2_cparams* cparams = &data->cparams;
+  blosc2_dparams* dparams = &data->dparams;
+  int32_t isize = CHUNKSHAPE * sizeof(int32_t);
+
+  CUTEST_GET_PARAMETER(nchunks, int);
+  CUTEST_GET_PARAMETER(backend, test_frame_append_backend);
+
+  blosc2_remove_urlpath(backend.urlpath);
+
+  blosc2_storage storage = {
+          .cparams=cparams, .dparams=dparams,
+          .urlpath=backend.urlpath, .contiguous=backend.contiguous, .io=&data->io};
+  blosc2_schunk* schunk = blosc2_schunk_new(&storage);
+  CUTEST_ASSERT("Error creating schunk", schunk != NULL);
+  int rc;
+  if (backend.urlpath != NULL) {
+    // On-disk frames write the offsets after every append unless asked otherwise
+    CUTEST_ASSERT("ERROR: cannot defer the offsets", blosc2_schunk_set_offsets_flush(schunk, 0) == 0);
+  }
+
+  int32_t *data_ = malloc(isize);
+  int32_t *data_dest = malloc(isize);
+  uint8_t *chunk = malloc(BLOSC_EXTENDED_HEADER_LENGTH);
+  rc = blosc2_chunk_zeros(*cparams, isize, chunk, BLOSC_EXTENDED_HEADER_LENGTH);
+  CUTEST_ASSERT("ERROR: cannot create a zeros chunk", rc >= 0);
+  ntruncates = 0;
+  for (int i = 0; i < nchunks; ++i) {
+    int _nchunks;
+    if (i % 7 == 0) {
+      _nchunks = blosc2_schunk_append_chunk(schunk, chunk, true);
+    }
+    else {
+      for (int j = 0; j < CHUNKSHAPE; j++) {
+        data_[j] = i * CHUNKSHAPE + j;
+      }
+      _nchunks = blosc2_schunk_append_buffer(schunk, data_, isize);
+    }
+    CUTEST_ASSERT("ERROR: bad append in frame", _nchunks == i + 1);
+  }
+  if (backend.urlpath != NULL) {
+    // On-disk frames do not re-write the offsets (nor the trailer) on every append
+    CUTEST_ASSERT("ERROR: the offsets are written too often", ntruncates * 32 <= nchunks);
+  }
+
+  // Appended chunks can be read before the offsets are written to the frame
+  CUTEST_ASSERT("ERROR: bad roundtrip before flushing", check_chunks(schunk, nchunks, data_dest) == 0);
+
+  // Flushing on demand makes the on-disk frame complete for other readers
+  rc = blosc2_schunk_flush_offsets(schunk);
+  CUTEST_ASSERT("ERROR: cannot flush the offsets", rc == 0);
+  if (backend.urlpath != NULL) {
+    blosc2_schunk* reader = blosc2_schunk_open_udio(backend.urlpath, &data->io);
+    CUTEST_ASSERT("ERROR: cannot open the flushed frame", reader != NULL);
+    CUTEST_ASSERT("ERROR: bad roundtrip after flushing", check_chunks(reader, nchunks, data_dest) == 0);
+    blosc2_schunk_free(reader);
+  }
+
+  // Serializing the frame writes the pending offsets
+  uint8_t* cframe;
+  bool cframe_needs_free;
+  int64_t cframe_len = blosc2_schunk_to_buffer(schunk, &cframe, &cframe_needs_free);
+  CUTEST_ASSERT("ERROR: cannot get the frame buffer", cframe_len > 0);
+  blosc2_schunk* schunk2 = blosc2_schunk_from_buffer(cframe, cframe_len, false);
+  CUTEST_ASSERT("ERROR: cannot get a schunk from the frame buffer", schunk2 != NULL);
+  CUTEST_ASSERT("ERROR: bad roundtrip from buffer", check_chunks(schunk2, nchunks, data_dest) == 0);
+  blosc2_schunk_free(schunk2);
+  if (cframe_needs_free) {
+    free(cframe);
+  }
+
+  // Keep appending after a flush, and then free the super-chunk
+  for (int j = 0; j < CHUNKSHAPE; j++) {
+    data_[j] = nchunks * CHUNKSHAPE + j;
+  }
+  if (nchunks % 7 == 0) {
+    rc = blosc2_schunk_append_chunk(schunk, chunk, true);
+  }
+  else {
+    rc = blosc2_schunk_append_buffer(schunk, data_, isize);
+  }
+  CUTEST_ASSERT("ERROR: bad append in frame", rc == nchunks + 1);
+  nchunks += 1;
+
+  if (backend.urlpath != NULL) {
+    blosc2_schunk_free(schunk);
+    // The frame on disk must be readable after closing it
+    schunk = blosc2_schunk_open_udio(backend.urlpath, &data->io);
+    CUTEST_ASSERT("ERROR: cannot open the frame", schunk != NULL);
+  }
+  CUTEST_ASSERT("ERROR: bad roundtrip after reopening", check_chunks(schunk, nchunks, data_dest) == 0);
+
+  // Deleting a chunk with pending offsets
+  rc = blosc2_schunk_append_buffer(schunk, data_, isize);
+  CUTEST_ASSERT("ERROR: bad append in frame", rc == nchunks + 1);
+  rc = blosc2_schunk_delete_chunk(schunk, nchunks);
+  CUTEST_ASSERT("ERROR: cannot delete the last chunk", rc == nchunks);
+  CUTEST_ASSERT("ERROR: bad roundtrip after deleting", check_chunks(schunk, nchunks, data_dest) == 0);
+
+  /* Free resources */
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(backend.urlpath);
+  free(data_);
+  free(data_dest);
+  free(chunk);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(frame_append) {
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(frame_append)
+}
@@ -0,0 +1,148 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Unit tests for reading the blocks of lazy chunks out of on-disk frames (the
+  file handles are kept open by the frame and must not return stale data after
+  the frame is modified).
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "blosc2.h"
+#include "cutest.h"
+#include "test_common.h"
+
+
+#define NCHUNKS (10)
+#define CHUNKSHAPE (50 * 1000)
+#define BLOCKSIZE (4 * 1024)
+
+typedef struct {
+  bool contiguous;
+  char *urlpath;
+}test_lazy_reads_backend;
+
+CUTEST_TEST_DATA(lazy_reads) {
+  blosc2_cparams cparams;
+  blosc2_dparams dparams;
+};
+
+CUTEST_TEST_SETUP(lazy_reads) {
+  blosc_init();
+  data->cparams = BLOSC2_CPARAMS_DEFAULTS;
+  blosc2_cparams* cparams = &data->cparams;
+  cparams->typesize = sizeof(int32_t);
+  cparams->clevel = 5;
+  cparams->blocksize = BLOCKSIZE;
+  data->dparams = BLOSC2_DPARAMS_DEFAULTS;
+
+  CUTEST_PARAMETRIZE(nthreads, int, CUTEST_DATA(
+      1,
+      4,
+  ));
+  CUTEST_PARAMETRIZE(backend, test_lazy_reads_backend, CUTEST_DATA(
+      {true, "test_lazy_reads.b2frame"}, // disk - cframe
+      {false, "test_lazy_reads_s.b2frame"}, // disk - sframe
+  ));
+}
+
+
+// Check the chunks (and some items through lazy chunks) against `values`
+static int check_chunks(blosc2_schunk* schunk, const int32_t *values, int nchunks) {
+  int rc = blosc_test_check_chunks(schunk, values, nchunks, CHUNKSHAPE);
+  // Get single items out of lazy chunks, in reverse order
+  for (int i = nchunks - 1; i >= 0 && rc == 0; i--) {
+    uint8_t *lazy_chunk;
+    bool needs_free;
+    int cbytes = blosc2_schunk_get_lazychunk(schunk, i, &lazy_chunk, &needs_free);
+    if (cbytes < 0) {
+      rc = -1;
+      break;
+    }
+    for (int j = CHUNKSHAPE - 1; j >= 0; j -= CHUNKSHAPE / 7) {
+      int32_t item;
+      int nbytes = blosc2_getitem_ctx(schunk->dctx, lazy_chunk, cbytes, j, 1, &item, sizeof(item));
+      if (nbytes != sizeof(item) || item != values[i] + j) {
+        rc = -1;
+        break;
+      }
+    }
+    if (needs_free) {
+      free(lazy_chunk);
+    }
+  }
+  return rc;
+}
+
+
+static int update_chunk(blosc2_schunk* schunk, int nchunk, int32_t value) {
+  uint8_t *chunk = blosc_test_make_chunk(schunk, CHUNKSHAPE, value);
+  if (chunk == NULL) {
+    return -1;
+  }
+  int rc = blosc2_schunk_update_chunk(schunk, nchunk, chunk, true);
+  free(chunk);
+  return rc;
+}
+
+
+CUTEST_TEST_TEST(lazy_reads) {
+  blosc2_cparams* cparams = &data->cparams;
+  blosc2_dparams* dparams = &data->dparams;
+  int32_t values[NCHUNKS + 1];
+
+  CUTEST_GET_PARAMETER(nthreads, int);
+  CUTEST_GET_PARAMETER(backend, test_lazy_reads_backend);
+  cparams->nthreads = (int16_t)nthreads;
+  dparams->nthreads = (int16_t)nthreads;
+
+  blosc2_remove_urlpath(backend.urlpath);
+
+  blosc2_storage storage = {
+          .cparams=cparams, .dparams=dparams,
+          .urlpath=backend.urlpath, .contiguous=backend.contiguous};
+  blosc2_schunk* schunk = blosc2_schunk_new(&storage);
+  CUTEST_ASSERT("Error creating schunk", schunk != NULL);
+
+  for (int i = 0; i < NCHUNKS; ++i) {
+    values[i] = i * CHUNKSHAPE;
+    int rc = blosc_test_append_chunk(schunk, CHUNKSHAPE, values[i]);
+    CUTEST_ASSERT("ERROR: bad append in frame", rc == i + 1);
+  }
+  CUTEST_ASSERT("ERROR: bad roundtrip after appending", check_chunks(schunk, values, NCHUNKS) == 0);
+
+  // The data read after modifying the frame must be the new one
+  values[3] = -1000 * 1000;
+  int rc = update_chunk(schunk, 3, values[3]);
+  CUTEST_ASSERT("ERROR: cannot update chunk", rc == NCHUNKS);
+  CUTEST_ASSERT("ERROR: bad roundtrip after updating", check_chunks(schunk, values, NCHUNKS) == 0);
+
+  values[NCHUNKS] = 2000 * 1000;
+  rc = blosc_test_append_chunk(schunk, CHUNKSHAPE, values[NCHUNKS]);
+  CUTEST_ASSERT("ERROR: bad append in frame", rc == NCHUNKS + 1);
+  CUTEST_ASSERT("ERROR: bad roundtrip after appending", check_chunks(schunk, values, NCHUNKS + 1) == 0);
+
+  // Read the frame from a different super-chunk too
+  blosc2_schunk* schunk2 = blosc2_schunk_open(backend.urlpath);
+  CUTEST_ASSERT("ERROR: cannot open the frame", schunk2 != NULL);
+  CUTEST_ASSERT("ERROR: bad roundtrip after reopening", check_chunks(schunk2, values, NCHUNKS + 1) == 0);
+  blosc2_schunk_free(schunk2);
+
+  /* Free resources */
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(backend.urlpath);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(lazy_reads) {
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(lazy_reads)
+}
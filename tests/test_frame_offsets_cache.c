@@ -0,0 +1,173 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Unit tests for the cache of chunk offsets in frames, that must be kept in
+  sync when the frame is modified.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "blosc2.h"
+#include "cutest.h"
+#include "test_common.h"
+
+
+#define NCHUNKS (50)
+#define CHUNKSHAPE (1000)
+#define NTHREADS 2
+#define NREADERS 4
+
+typedef struct {
+  bool contiguous;
+  char *urlpath;
+}test_offsets_cache_backend;
+
+CUTEST_TEST_DATA(offsets_cache) {
+  blosc2_cparams cparams;
+  blosc2_dparams dparams;
+};
+
+CUTEST_TEST_SETUP(offsets_cache) {
+  blosc_init();
+  data->cparams = BLOSC2_CPARAMS_DEFAULTS;
+  blosc2_cparams* cparams = &data->cparams;
+  cparams->typesize = sizeof(int32_t);
+  cparams->clevel = 5;
+  cparams->nthreads = NTHREADS;
+  data->dparams = BLOSC2_DPARAMS_DEFAULTS;
+  blosc2_dparams* dparams = &data->dparams;
+  dparams->nthreads = NTHREADS;
+
+  CUTEST_PARAMETRIZE(backend, test_offsets_cache_backend, CUTEST_DATA(
+      {true, NULL},  // memory - cframe
+      {true, "test_offsets_cache.b2frame"}, // disk - cframe
+      {false, "test_offsets_cache_s.b2frame"}, // disk - sframe
+  ));
+}
+
+
+typedef struct {
+  blosc2_schunk* schunk;
+  const int32_t* values;
+  int nchunks;
+  int rc;
+} reader_args;
+
+static void* reader(void* arg) {
+  reader_args* args = (reader_args*)arg;
+  args->rc = blosc_test_check_chunks(args->schunk, args->values, args->nchunks, CHUNKSHAPE);
+  return NULL;
+}
+
+
+CUTEST_TEST_TEST(offsets_cache) {
+  blosc2_cparams* cparams = &data->cparams;
+  blosc2_dparams* dparams = &data->dparams;
+  int32_t values[NCHUNKS + 1];
+
+  CUTEST_GET_PARAMETER(backend, test_offsets_cache_backend);
+
+  blosc2_remove_urlpath(backend.urlpath);
+
+  blosc2_storage storage = {
+          .cparams=cparams, .dparams=dparams,
+          .urlpath=backend.urlpath, .contiguous=backend.contiguous};
+  blosc2_schunk* schunk = blosc2_schunk_new(&storage);
+  CUTEST_ASSERT("Error creating schunk", schunk != NULL);
+
+  for (int i = 0; i < NCHUNKS; ++i) {
+    values[i] = i * CHUNKSHAPE;
+    uint8_t *chunk = blosc_test_make_chunk(schunk, CHUNKSHAPE, values[i]);
+    CUTEST_ASSERT("ERROR: cannot create a chunk", chunk != NULL);
+    int _nchunks = blosc2_schunk_append_chunk(schunk, chunk, false);
+    CUTEST_ASSERT("ERROR: bad append in frame", _nchunks == i + 1);
+  }
+  // This builds the cache of offsets
+  CUTEST_ASSERT("ERROR: bad roundtrip after appending", blosc_test_check_chunks(schunk, values, NCHUNKS, CHUNKSHAPE) == 0);
+
+  // Update
+  values[10] = 1000;
+  uint8_t *chunk = blosc_test_make_chunk(schunk, CHUNKSHAPE, values[10]);
+  int rc = blosc2_schunk_update_chunk(schunk, 10, chunk, true);
+  free(chunk);
+  CUTEST_ASSERT("ERROR: cannot update chunk", rc == NCHUNKS);
+  CUTEST_ASSERT("ERROR: bad roundtrip after updating", blosc_test_check_chunks(schunk, values, NCHUNKS, CHUNKSHAPE) == 0);
+
+  // Insert
+  for (int i = NCHUNKS; i > 20; i--) {
+    values[i] = values[i - 1];
+  }
+  values[20] = 2000;
+  chunk = blosc_test_make_chunk(schunk, CHUNKSHAPE, values[20]);
+  rc = blosc2_schunk_insert_chunk(schunk, 20, chunk, true);
+  free(chunk);
+  CUTEST_ASSERT("ERROR: cannot insert chunk", rc == NCHUNKS + 1);
+  CUTEST_ASSERT("ERROR: bad roundtrip after inserting", blosc_test_check_chunks(schunk, values, NCHUNKS + 1, CHUNKSHAPE) == 0);
+
+  // Delete
+  for (int i = 5; i < NCHUNKS; i++) {
+    values[i] = values[i + 1];
+  }
+  rc = blosc2_schunk_delete_chunk(schunk, 5);
+  CUTEST_ASSERT("ERROR: cannot delete chunk", rc == NCHUNKS);
+  CUTEST_ASSERT("ERROR: bad roundtrip after deleting", blosc_test_check_chunks(schunk, values, NCHUNKS, CHUNKSHAPE) == 0);
+
+  // Reorder
+  int order[NCHUNKS];
+  int32_t reordered[NCHUNKS + 1];
+  for (int i = 0; i < NCHUNKS; i++) {
+    order[i] = NCHUNKS - 1 - i;
+    reordered[i] = values[NCHUNKS - 1 - i];
+  }
+  rc = blosc2_schunk_reorder_offsets(schunk, order);
+  CUTEST_ASSERT("ERROR: cannot reorder chunks", rc == 0);
+  CUTEST_ASSERT("ERROR: bad roundtrip after reordering", blosc_test_check_chunks(schunk, reordered, NCHUNKS, CHUNKSHAPE) == 0);
+
+  // Append after all of the above
+  reordered[NCHUNKS] = 3000;
+  chunk = blosc_test_make_chunk(schunk, CHUNKSHAPE, reordered[NCHUNKS]);
+  rc = blosc2_schunk_append_chunk(schunk, chunk, false);
+  CUTEST_ASSERT("ERROR: bad append in frame", rc == NCHUNKS + 1);
+  CUTEST_ASSERT("ERROR: bad roundtrip after appending", blosc_test_check_chunks(schunk, reordered, NCHUNKS + 1, CHUNKSHAPE) == 0);
+
+  if (backend.urlpath != NULL) {
+    blosc2_schunk_free(schunk);
+    schunk = blosc2_schunk_open(backend.urlpath);
+    CUTEST_ASSERT("ERROR: cannot open the frame", schunk != NULL);
+    // Several readers load the header and the offsets at once (a cache that holds no chunk
+    // lets them decompress concurrently)
+    CUTEST_ASSERT("ERROR: cannot set the cache", blosc2_schunk_set_cache_size(schunk, 1) == 0);
+    pthread_t threads[NREADERS];
+    reader_args args[NREADERS];
+    for (int i = 0; i < NREADERS; i++) {
+      args[i].schunk = schunk;
+      args[i].values = reordered;
+      args[i].nchunks = NCHUNKS + 1;
+      pthread_create(&threads[i], NULL, reader, &args[i]);
+    }
+    for (int i = 0; i < NREADERS; i++) {
+      pthread_join(threads[i], NULL);
+      CUTEST_ASSERT("ERROR: bad concurrent read after reopening", args[i].rc == 0);
+    }
+    CUTEST_ASSERT("ERROR: bad roundtrip after reopening", blosc_test_check_chunks(schunk, reordered, NCHUNKS + 1, CHUNKSHAPE) == 0);
+  }
+
+  /* Free resources */
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(backend.urlpath);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(offsets_cache) {
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(offsets_cache)
+}
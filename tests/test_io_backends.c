@@ -0,0 +1,170 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Unit tests for the memory-mapped and the io_uring input/output backends.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "blosc2.h"
+#include "cutest.h"
+#include "test_common.h"
+
+#define NCHUNKS (20)
+#define CHUNKSHAPE (20 * 1000)
+
+typedef struct {
+  int io_id;
+  bool contiguous;
+  char *urlpath;
+}test_io_backend;
+
+CUTEST_TEST_DATA(io_backends) {
+  blosc2_cparams cparams;
+  blosc2_dparams dparams;
+};
+
+CUTEST_TEST_SETUP(io_backends) {
+  blosc_init();
+  data->cparams = BLOSC2_CPARAMS_DEFAULTS;
+  blosc2_cparams* cparams = &data->cparams;
+  cparams->typesize = sizeof(int32_t);
+  cparams->clevel = 5;
+  cparams->blocksize = 8 * 1024;
+  data->dparams = BLOSC2_DPARAMS_DEFAULTS;
+
+  CUTEST_PARAMETRIZE(nthreads, int, CUTEST_DATA(
+      1,
+      4,
+  ));
+  CUTEST_PARAMETRIZE(backend, test_io_backend, CUTEST_DATA(
+      {BLOSC2_IO_FILESYSTEM_MMAP, true, "test_mmap_io.b2frame"}, // disk - cframe
+      {BLOSC2_IO_FILESYSTEM_MMAP, false, "test_mmap_io_s.b2frame"}, // disk - sframe
+      {BLOSC2_IO_FILESYSTEM_URING, true, "test_uring_io.b2frame"}, // disk - cframe
+      {BLOSC2_IO_FILESYSTEM_URING, false, "test_uring_io_s.b2frame"}, // disk - sframe
+  ));
+}
+
+
+CUTEST_TEST_TEST(io_backends) {
+  blosc2_cparams* cparams = &data->cparams;
+  blosc2_dparams* dparams = &data->dparams;
+  int32_t values[NCHUNKS + 1];
+
+  CUTEST_GET_PARAMETER(nthreads, int);
+  CUTEST_GET_PARAMETER(backend, test_io_backend);
+  cparams->nthreads = (int16_t)nthreads;
+  dparams->nthreads = (int16_t)nthreads;
+
+#if !defined(BLOSC2_HAVE_MMAP_IO)
+  if (backend.io_id == BLOSC2_IO_FILESYSTEM_MMAP) {
+    printf("The memory-mapped backend is not available in this platform\n");
+    return 0;
+  }
+#endif
+
+  blosc2_remove_urlpath(backend.urlpath);
+
+  blosc2_io io = {.id = (uint8_t)backend.io_id, .params = NULL};
+  blosc2_storage storage = {
+          .cparams=cparams, .dparams=dparams,
+          .urlpath=backend.urlpath, .contiguous=backend.contiguous, .io=&io};
+  blosc2_schunk* schunk = blosc2_schunk_new(&storage);
+  CUTEST_ASSERT("Error creating schunk", schunk != NULL);
+
+  for (int i = 0; i < NCHUNKS; ++i) {
+    values[i] = i * CHUNKSHAPE;
+    uint8_t *chunk = blosc_test_make_chunk(schunk, CHUNKSHAPE, values[i]);
+    CUTEST_ASSERT("ERROR: cannot create a chunk", chunk != NULL);
+    int _nchunks = blosc2_schunk_append_chunk(schunk, chunk, false);
+    CUTEST_ASSERT("ERROR: bad append in frame", _nchunks == i + 1);
+  }
+  CUTEST_ASSERT("ERROR: bad roundtrip after appending", blosc_test_check_chunks(schunk, values, NCHUNKS, CHUNKSHAPE) == 0);
+
+  // Decompress only some of the blocks (batched reads with io_uring)
+  int32_t isize = CHUNKSHAPE * sizeof(int32_t);
+  int32_t nblocks = isize / cparams->blocksize + (isize % cparams->blocksize ? 1 : 0);
+  bool *maskout = malloc(nblocks);
+  for (int j = 0; j < nblocks; j++) {
+    maskout[j] = (j % 3 != 0);
+  }
+  int32_t *data_dest = calloc(CHUNKSHAPE, sizeof(int32_t));
+  CUTEST_ASSERT("ERROR: cannot set the maskout", blosc2_set_maskout(schunk->dctx, maskout, nblocks) == 0);
+  int dsize = blosc2_schunk_decompress_chunk(schunk, 3, data_dest, isize);
+  CUTEST_ASSERT("ERROR: cannot decompress with a maskout", dsize == isize);
+  int32_t block_items = cparams->blocksize / (int32_t)sizeof(int32_t);
+  for (int j = 0; j < CHUNKSHAPE; j++) {
+    if (!maskout[j / block_items]) {
+      CUTEST_ASSERT("ERROR: bad value with a maskout", data_dest[j] == values[3] + j);
+    }
+  }
+  free(data_dest);
+  free(maskout);
+
+  // Single items out of a lazy chunk
+  uint8_t *chunk;
+  bool needs_free;
+  int cbytes = blosc2_schunk_get_lazychunk(schunk, 7, &chunk, &needs_free);
+  CUTEST_ASSERT("ERROR: cannot get a lazy chunk", cbytes > 0);
+  int32_t item;
+  int rc = blosc2_getitem_ctx(schunk->dctx, chunk, cbytes, CHUNKSHAPE - 1, 1, &item, sizeof(item));
+  CUTEST_ASSERT("ERROR: cannot get an item", rc == sizeof(item));
+  CUTEST_ASSERT("ERROR: bad item", item == values[7] + CHUNKSHAPE - 1);
+  if (needs_free) {
+    free(chunk);
+  }
+
+  // Chunks of contiguous frames are views into the mapping
+  if (backend.io_id == BLOSC2_IO_FILESYSTEM_MMAP) {
+    cbytes = blosc2_schunk_get_chunk(schunk, 1, &chunk, &needs_free);
+    CUTEST_ASSERT("ERROR: cannot get a chunk", cbytes > 0);
+    CUTEST_ASSERT("ERROR: chunk should be a view", needs_free == !backend.contiguous);
+    if (needs_free) {
+      free(chunk);
+    }
+  }
+
+  // Modify the frame and read it again
+  values[5] = -1000 * 1000;
+  chunk = blosc_test_make_chunk(schunk, CHUNKSHAPE, values[5]);
+  rc = blosc2_schunk_update_chunk(schunk, 5, chunk, true);
+  free(chunk);
+  CUTEST_ASSERT("ERROR: cannot update chunk", rc == NCHUNKS);
+  for (int i = NCHUNKS; i > 10; i--) {
+    values[i] = values[i - 1];
+  }
+  values[10] = 3000 * 1000;
+  chunk = blosc_test_make_chunk(schunk, CHUNKSHAPE, values[10]);
+  rc = blosc2_schunk_insert_chunk(schunk, 10, chunk, true);
+  free(chunk);
+  CUTEST_ASSERT("ERROR: cannot insert chunk", rc == NCHUNKS + 1);
+  CUTEST_ASSERT("ERROR: bad roundtrip after modifying", blosc_test_check_chunks(schunk, values, NCHUNKS + 1, CHUNKSHAPE) == 0);
+  blosc2_schunk_free(schunk);
+
+  // The frame can be read with both the backend and stdio
+  schunk = blosc2_schunk_open_udio(backend.urlpath, &io);
+  CUTEST_ASSERT("ERROR: cannot open the frame", schunk != NULL);
+  CUTEST_ASSERT("ERROR: bad roundtrip after reopening", blosc_test_check_chunks(schunk, values, NCHUNKS + 1, CHUNKSHAPE) == 0);
+  blosc2_schunk_free(schunk);
+  schunk = blosc2_schunk_open(backend.urlpath);
+  CUTEST_ASSERT("ERROR: cannot open the frame with stdio", schunk != NULL);
+  CUTEST_ASSERT("ERROR: bad roundtrip with stdio", blosc_test_check_chunks(schunk, values, NCHUNKS + 1, CHUNKSHAPE) == 0);
+
+  /* Free resources */
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(backend.urlpath);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(io_backends) {
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(io_backends)
+}
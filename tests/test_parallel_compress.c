@@ -0,0 +1,115 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Unit tests for checking that parallel compression produces the same
+  output than serial compression.
+
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#include "test_common.h"
+
+#define NTHREADS 4
+
+int tests_run = 0;
+
+/* Global vars */
+int32_t *data, *data_dest;
+uint8_t *serial_out, *parallel_out;
+int32_t isize;
+int compcode;
+int32_t blocksize;
+
+
+static int compress_with(int16_t nthreads, uint8_t* out) {
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.typesize = sizeof(int32_t);
+  cparams.compcode = compcode;
+  cparams.clevel = 5;
+  cparams.nthreads = nthreads;
+  cparams.blocksize = blocksize;
+  blosc2_context* cctx = blosc2_create_cctx(cparams);
+  int csize = blosc2_compress_ctx(cctx, data, isize, out, isize + BLOSC_MAX_OVERHEAD);
+  blosc2_free_ctx(cctx);
+  return csize;
+}
+
+
+static char *test_same_output(void) {
+  int csize = compress_with(1, serial_out);
+  mu_assert("ERROR: serial compression failed", csize > 0);
+  /* Several times to exercise different thread interleavings */
+  for (int i = 0; i < 3; i++) {
+    int pcsize = compress_with(NTHREADS, parallel_out);
+    mu_assert("ERROR: sizes of serial and parallel outputs differ", pcsize == csize);
+    mu_assert("ERROR: serial and parallel outputs differ",
+              memcmp(serial_out, parallel_out, csize) == 0);
+  }
+
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = NTHREADS;
+  blosc2_context* dctx = blosc2_create_dctx(dparams);
+  int dsize = blosc2_decompress_ctx(dctx, parallel_out, csize, data_dest, isize);
+  blosc2_free_ctx(dctx);
+  mu_assert("ERROR: decompression failed", dsize == isize);
+  mu_assert("ERROR: roundtrip failed", memcmp(data, data_dest, isize) == 0);
+
+  return 0;
+}
+
+
+static char *all_tests(void) {
+  int codecs[] = {BLOSC_BLOSCLZ, BLOSC_LZ4, BLOSC_LZ4HC};
+  int32_t nitems[] = {100 * 1000, 2 * 1000 * 1000};
+
+  for (int i = 0; i < (int)(sizeof(nitems) / sizeof(int32_t)); i++) {
+    isize = nitems[i] * (int32_t)sizeof(int32_t);
+    data = malloc(isize);
+    data_dest = malloc(isize);
+    serial_out = malloc(isize + BLOSC_MAX_OVERHEAD);
+    parallel_out = malloc(isize + BLOSC_MAX_OVERHEAD);
+    /* Poorly compressible data so that large buffers are compacted in parallel */
+    srand(1);
+    for (int j = 0; j < nitems[i]; j++) {
+      data[j] = j % 3 == 0 ? rand() : j;
+    }
+    for (int j = 0; j < (int)(sizeof(codecs) / sizeof(int)); j++) {
+      compcode = codecs[j];
+      blocksize = 0;
+      mu_run_test(test_same_output);
+      blocksize = 8 * KB;
+      mu_run_test(test_same_output);
+    }
+    free(data);
+    free(data_dest);
+    free(serial_out);
+    free(parallel_out);
+  }
+
+  return 0;
+}
+
+
+int main(void) {
+  char *result;
+
+  install_blosc_callback_test(); /* optionally install callback test */
+  blosc_init();
+
+  result = all_tests();
+  if (result != 0) {
+    printf(" (%s)\n", result);
+  }
+  else {
+    printf(" ALL TESTS PASSED\n");
+  }
+  printf("\tTests run: %d\n", tests_run);
+
+  blosc_destroy();
+
+  return result != 0;
+}
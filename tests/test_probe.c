@@ -0,0 +1,137 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Unit tests for the probe that spots incompressible data before compressing it.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "blosc2.h"
+#include "cutest.h"
+
+#define NBYTES (1024 * 1024)
+
+enum {
+  DATA_RANDOM,
+  DATA_RAMP,
+  DATA_MIXED,
+};
+
+
+CUTEST_TEST_DATA(probe) {
+  blosc2_cparams cparams;
+  blosc2_dparams dparams;
+};
+
+CUTEST_TEST_SETUP(probe) {
+  blosc_init();
+  data->cparams = BLOSC2_CPARAMS_DEFAULTS;
+  data->cparams.typesize = 4;
+  data->cparams.blocksize = 64 * 1024;
+  data->dparams = BLOSC2_DPARAMS_DEFAULTS;
+
+  CUTEST_PARAMETRIZE(content, int, CUTEST_DATA(
+      DATA_RANDOM,
+      DATA_RAMP,
+      DATA_MIXED,
+  ));
+  CUTEST_PARAMETRIZE(compcode, uint8_t, CUTEST_DATA(
+      BLOSC_BLOSCLZ,
+      BLOSC_LZ4,
+  ));
+  CUTEST_PARAMETRIZE(nthreads, int16_t, CUTEST_DATA(
+      1,
+      4,
+  ));
+}
+
+
+static void fill_buffer(uint8_t *buffer, int32_t nbytes, int content) {
+  uint32_t seed = 1234;
+  for (int32_t i = 0; i < nbytes / 4; i++) {
+    seed = seed * 1103515245 + 12345;
+    uint32_t value = seed ^ (seed >> 13) * 2654435761U;
+    if (content == DATA_RAMP || (content == DATA_MIXED && i * 4 >= nbytes / 2)) {
+      value = (uint32_t)i;
+    }
+    memcpy(buffer + i * 4, &value, 4);
+  }
+}
+
+
+CUTEST_TEST_TEST(probe) {
+  CUTEST_GET_PARAMETER(content, int);
+  CUTEST_GET_PARAMETER(compcode, uint8_t);
+  CUTEST_GET_PARAMETER(nthreads, int16_t);
+
+  uint8_t *src = malloc(NBYTES);
+  uint8_t *dest = malloc(NBYTES);
+  uint8_t *cdata = malloc(NBYTES + BLOSC_MAX_OVERHEAD);
+  fill_buffer(src, NBYTES, content);
+
+  blosc2_cparams cparams = data->cparams;
+  cparams.compcode = compcode;
+  cparams.nthreads = nthreads;
+  blosc2_dparams dparams = data->dparams;
+  dparams.nthreads = nthreads;
+  blosc2_context *dctx = blosc2_create_dctx(dparams);
+  CUTEST_ASSERT("ERROR: probe set in a decompression context",
+                blosc2_set_probe(dctx, BLOSC2_PROBE_MIN_ENTROPY, false) < 0);
+
+  // Chunk probe (the default), block probe and no probe at all
+  for (int mode = 0; mode < 3; mode++) {
+    blosc2_context *cctx = blosc2_create_cctx(cparams);
+    CUTEST_ASSERT("ERROR: bad entropy accepted", blosc2_set_probe(cctx, 9.f, false) < 0);
+    if (mode == 1) {
+      CUTEST_ASSERT("ERROR: cannot set probe", blosc2_set_probe(cctx, BLOSC2_PROBE_MIN_ENTROPY, true) == 0);
+    }
+    else if (mode == 2) {
+      CUTEST_ASSERT("ERROR: cannot unset probe", blosc2_set_probe(cctx, 0.f, false) == 0);
+    }
+    int cbytes = blosc2_compress_ctx(cctx, src, NBYTES, cdata, NBYTES + BLOSC_MAX_OVERHEAD);
+    CUTEST_ASSERT("ERROR: cannot compress", cbytes > 0);
+    int64_t nchunks, nblocks;
+    blosc2_get_probe_stats(cctx, &nchunks, &nblocks);
+    blosc2_free_ctx(cctx);
+
+    bool memcpyed = cdata[BLOSC2_CHUNK_FLAGS] & BLOSC_MEMCPYED;
+    switch (content) {
+      case DATA_RANDOM:
+        // Stored as is, whether the probe fires or not
+        CUTEST_ASSERT("ERROR: random data is not memcpyed", memcpyed);
+        CUTEST_ASSERT("ERROR: probe did not fire on random data", nchunks == (mode < 2));
+        break;
+      case DATA_RAMP:
+        CUTEST_ASSERT("ERROR: probe fired on a ramp", nchunks == 0 && nblocks == 0);
+        CUTEST_ASSERT("ERROR: ramp is memcpyed", !memcpyed);
+        break;
+      default:
+        CUTEST_ASSERT("ERROR: probe fired on compressible chunk", nchunks == 0 && !memcpyed);
+        CUTEST_ASSERT("ERROR: block probe did not fire on random blocks", (nblocks > 0) == (mode == 1));
+    }
+
+    int dsize = blosc2_decompress_ctx(dctx, cdata, cbytes, dest, NBYTES);
+    CUTEST_ASSERT("ERROR: bad decompression", dsize == NBYTES);
+    CUTEST_ASSERT("ERROR: bad roundtrip", memcmp(src, dest, NBYTES) == 0);
+  }
+  blosc2_free_ctx(dctx);
+
+  /* Free resources */
+  free(src);
+  free(dest);
+  free(cdata);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(probe) {
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(probe)
+}
@@ -0,0 +1,124 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Unit tests for decompressing ranges of chunks of a super-chunk in parallel.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "blosc2.h"
+#include "cutest.h"
+
+#define NCHUNKS (50)
+#define CHUNKSHAPE (5 * 1000)
+#define LASTSHAPE (1234)
+
+typedef struct {
+  bool contiguous;
+  char *urlpath;
+}test_range_backend;
+
+CUTEST_TEST_DATA(decompress_range) {
+  blosc2_cparams cparams;
+  blosc2_dparams dparams;
+};
+
+CUTEST_TEST_SETUP(decompress_range) {
+  blosc_init();
+  data->cparams = BLOSC2_CPARAMS_DEFAULTS;
+  data->cparams.typesize = sizeof(int32_t);
+  data->cparams.clevel = 5;
+  data->dparams = BLOSC2_DPARAMS_DEFAULTS;
+
+  CUTEST_PARAMETRIZE(nthreads, int, CUTEST_DATA(
+      1,
+      4,
+      64,
+  ));
+  CUTEST_PARAMETRIZE(shared_pool, bool, CUTEST_DATA(
+      false,
+      true,
+  ));
+  CUTEST_PARAMETRIZE(backend, test_range_backend, CUTEST_DATA(
+      {false, NULL},  // memory - schunk
+      {true, NULL},  // memory - cframe
+      {true, "test_decompress_range.b2frame"}, // disk - cframe
+      {false, "test_decompress_range_s.b2frame"}, // disk - sframe
+  ));
+}
+
+
+CUTEST_TEST_TEST(decompress_range) {
+  CUTEST_GET_PARAMETER(nthreads, int);
+  CUTEST_GET_PARAMETER(shared_pool, bool);
+  CUTEST_GET_PARAMETER(backend, test_range_backend);
+
+  if (shared_pool) {
+    blosc2_set_shared_threadpool(4);
+  }
+  data->cparams.nthreads = (int16_t)nthreads;
+  data->dparams.nthreads = (int16_t)nthreads;
+  blosc2_remove_urlpath(backend.urlpath);
+  blosc2_storage storage = {.cparams=&data->cparams, .dparams=&data->dparams,
+                            .urlpath=backend.urlpath, .contiguous=backend.contiguous};
+  blosc2_schunk* schunk = blosc2_schunk_new(&storage);
+  CUTEST_ASSERT("Error creating schunk", schunk != NULL);
+
+  // The last chunk is shorter
+  int64_t nitems = (NCHUNKS - 1) * CHUNKSHAPE + LASTSHAPE;
+  int32_t *data_ = malloc(CHUNKSHAPE * sizeof(int32_t));
+  for (int i = 0; i < NCHUNKS; i++) {
+    int32_t shape = i < NCHUNKS - 1 ? CHUNKSHAPE : LASTSHAPE;
+    for (int j = 0; j < shape; j++) {
+      data_[j] = i * CHUNKSHAPE + j;
+    }
+    int rc = blosc2_schunk_append_buffer(schunk, data_, shape * (int32_t)sizeof(int32_t));
+    CUTEST_ASSERT("ERROR: bad append", rc == i + 1);
+  }
+  free(data_);
+
+  int32_t *dest = malloc(nitems * sizeof(int32_t));
+  int64_t nbytes = blosc2_schunk_decompress_range(schunk, 0, NCHUNKS, dest, nitems * sizeof(int32_t));
+  CUTEST_ASSERT("ERROR: bad size of the whole range", nbytes == nitems * (int64_t)sizeof(int32_t));
+  for (int64_t i = 0; i < nitems; i++) {
+    CUTEST_ASSERT("ERROR: bad value in the whole range", dest[i] == i);
+  }
+
+  // A range in the middle
+  memset(dest, 0, nitems * sizeof(int32_t));
+  nbytes = blosc2_schunk_decompress_range(schunk, 7, 13, dest, 6 * CHUNKSHAPE * sizeof(int32_t));
+  CUTEST_ASSERT("ERROR: bad size of the range", nbytes == 6 * CHUNKSHAPE * sizeof(int32_t));
+  for (int64_t i = 0; i < 6 * CHUNKSHAPE; i++) {
+    CUTEST_ASSERT("ERROR: bad value in the range", dest[i] == 7 * CHUNKSHAPE + i);
+  }
+
+  // Errors
+  nbytes = blosc2_schunk_decompress_range(schunk, 0, NCHUNKS, dest, (nitems - 1) * sizeof(int32_t));
+  CUTEST_ASSERT("ERROR: dest should be too small", nbytes < 0);
+  nbytes = blosc2_schunk_decompress_range(schunk, 3, NCHUNKS + 1, dest, nitems * sizeof(int32_t));
+  CUTEST_ASSERT("ERROR: the range should be out of bounds", nbytes < 0);
+  nbytes = blosc2_schunk_decompress_range(schunk, 3, 3, dest, nitems * sizeof(int32_t));
+  CUTEST_ASSERT("ERROR: the range should be empty", nbytes == 0);
+
+  /* Free resources */
+  free(dest);
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(backend.urlpath);
+  if (shared_pool) {
+    blosc2_set_shared_threadpool(0);
+  }
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(decompress_range) {
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(decompress_range)
+}
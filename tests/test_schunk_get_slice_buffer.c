@@ -0,0 +1,127 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Unit tests for getting slices of items across the chunks of a super-chunk.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "blosc2.h"
+#include "cutest.h"
+
+#define NCHUNKS (20)
+#define CHUNKSHAPE (5 * 1000)
+#define LASTSHAPE (1234)
+
+typedef struct {
+  bool contiguous;
+  char *urlpath;
+}test_slice_backend;
+
+typedef struct {
+  int64_t start;
+  int64_t stop;
+}test_slice;
+
+CUTEST_TEST_DATA(get_slice_buffer) {
+  blosc2_cparams cparams;
+  blosc2_dparams dparams;
+};
+
+CUTEST_TEST_SETUP(get_slice_buffer) {
+  blosc_init();
+  data->cparams = BLOSC2_CPARAMS_DEFAULTS;
+  data->cparams.typesize = sizeof(int32_t);
+  data->cparams.clevel = 5;
+  // Several blocks per chunk, so that just some of them are in the slices at the boundaries
+  data->cparams.blocksize = 4 * 1024;
+  data->dparams = BLOSC2_DPARAMS_DEFAULTS;
+
+  CUTEST_PARAMETRIZE(nthreads, int, CUTEST_DATA(
+      1,
+      4,
+  ));
+  CUTEST_PARAMETRIZE(backend, test_slice_backend, CUTEST_DATA(
+      {false, NULL},  // memory - schunk
+      {true, NULL},  // memory - cframe
+      {true, "test_get_slice_buffer.b2frame"}, // disk - cframe
+      {false, "test_get_slice_buffer_s.b2frame"}, // disk - sframe
+  ));
+  CUTEST_PARAMETRIZE(slice, test_slice, CUTEST_DATA(
+      {0, (NCHUNKS - 1) * CHUNKSHAPE + LASTSHAPE},  // all the items
+      {1234, 3456},  // within a chunk
+      {CHUNKSHAPE - 10, CHUNKSHAPE + 10},  // across two chunks
+      {3 * CHUNKSHAPE + 17, 11 * CHUNKSHAPE - 5},  // partial chunks around full ones
+      {4 * CHUNKSHAPE, 9 * CHUNKSHAPE},  // full chunks only
+      {(NCHUNKS - 1) * CHUNKSHAPE - 3, (NCHUNKS - 1) * CHUNKSHAPE + LASTSHAPE},  // the short last chunk
+      {42, 43},  // a single item
+  ));
+}
+
+
+CUTEST_TEST_TEST(get_slice_buffer) {
+  CUTEST_GET_PARAMETER(nthreads, int);
+  CUTEST_GET_PARAMETER(backend, test_slice_backend);
+  CUTEST_GET_PARAMETER(slice, test_slice);
+
+  data->cparams.nthreads = (int16_t)nthreads;
+  data->dparams.nthreads = (int16_t)nthreads;
+  blosc2_remove_urlpath(backend.urlpath);
+  blosc2_storage storage = {.cparams=&data->cparams, .dparams=&data->dparams,
+                            .urlpath=backend.urlpath, .contiguous=backend.contiguous};
+  blosc2_schunk* schunk = blosc2_schunk_new(&storage);
+  CUTEST_ASSERT("Error creating schunk", schunk != NULL);
+
+  // The last chunk is shorter
+  int64_t nitems = (NCHUNKS - 1) * CHUNKSHAPE + LASTSHAPE;
+  int32_t *data_ = malloc(CHUNKSHAPE * sizeof(int32_t));
+  for (int i = 0; i < NCHUNKS; i++) {
+    int32_t shape = i < NCHUNKS - 1 ? CHUNKSHAPE : LASTSHAPE;
+    for (int j = 0; j < shape; j++) {
+      data_[j] = i * CHUNKSHAPE + j;
+    }
+    int rc = blosc2_schunk_append_buffer(schunk, data_, shape * (int32_t)sizeof(int32_t));
+    CUTEST_ASSERT("ERROR: bad append", rc == i + 1);
+  }
+  free(data_);
+
+  // Guard items after the slice, so that writing past it is detected
+  int64_t slice_nitems = slice.stop - slice.start;
+  int32_t *dest = malloc((slice_nitems + 1) * sizeof(int32_t));
+  dest[slice_nitems] = -1;
+  int rc = blosc2_schunk_get_slice_buffer(schunk, slice.start, slice.stop, dest);
+  CUTEST_ASSERT("ERROR: cannot get the slice", rc == 0);
+  for (int64_t i = 0; i < slice_nitems; i++) {
+    CUTEST_ASSERT("ERROR: bad value in the slice", dest[i] == slice.start + i);
+  }
+  CUTEST_ASSERT("ERROR: written past the slice", dest[slice_nitems] == -1);
+
+  // Errors
+  rc = blosc2_schunk_get_slice_buffer(schunk, -1, slice.stop, dest);
+  CUTEST_ASSERT("ERROR: a negative start should fail", rc < 0);
+  rc = blosc2_schunk_get_slice_buffer(schunk, slice.start, nitems + 1, dest);
+  CUTEST_ASSERT("ERROR: the slice should be out of bounds", rc < 0);
+  rc = blosc2_schunk_get_slice_buffer(schunk, slice.stop, slice.start, dest);
+  CUTEST_ASSERT("ERROR: a reversed slice should fail", rc < 0);
+  rc = blosc2_schunk_get_slice_buffer(schunk, slice.start, slice.start, dest);
+  CUTEST_ASSERT("ERROR: an empty slice should succeed", rc == 0);
+
+  /* Free resources */
+  free(dest);
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(backend.urlpath);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(get_slice_buffer) {
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(get_slice_buffer)
+}
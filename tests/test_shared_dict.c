@@ -0,0 +1,209 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Unit tests for the dictionaries shared by all the chunks of a super-chunk.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "blosc2.h"
+#include "context.h"
+#include "cutest.h"
+
+#define NCHUNKS (10)
+#define NTRAIN (4)
+#define CHUNKSHAPE (50 * 1000)
+
+typedef struct {
+  bool contiguous;
+  char *urlpath;
+}test_shared_dict_backend;
+
+CUTEST_TEST_DATA(shared_dict) {
+  blosc2_cparams cparams;
+  blosc2_dparams dparams;
+};
+
+CUTEST_TEST_SETUP(shared_dict) {
+  blosc_init();
+  data->cparams = BLOSC2_CPARAMS_DEFAULTS;
+  data->cparams.typesize = sizeof(int32_t);
+  data->cparams.compcode = BLOSC_ZSTD;
+  data->cparams.clevel = 5;
+  data->dparams = BLOSC2_DPARAMS_DEFAULTS;
+
+  CUTEST_PARAMETRIZE(nthreads, int, CUTEST_DATA(
+      1,
+      4,
+  ));
+  CUTEST_PARAMETRIZE(backend, test_shared_dict_backend, CUTEST_DATA(
+      {false, NULL},  // memory - schunk
+      {true, NULL},  // memory - cframe
+      {true, "test_shared_dict.b2frame"}, // disk - cframe
+      {false, "test_shared_dict_s.b2frame"}, // disk - sframe
+  ));
+}
+
+
+// Values out of a small set, so that a dictionary makes a difference
+static void fill_chunk(int32_t *data_, int nchunk) {
+  uint32_t seed = 1234 + nchunk;
+  for (int j = 0; j < CHUNKSHAPE; j++) {
+    seed = seed * 1103515245 + 12345;
+    data_[j] = (int32_t)((seed >> 16) % 64) * 1000003;
+  }
+}
+
+
+static int check_chunks(blosc2_schunk *schunk, int nchunks) {
+  int32_t *data_ = malloc(CHUNKSHAPE * sizeof(int32_t));
+  int32_t *data_dest = malloc(CHUNKSHAPE * sizeof(int32_t));
+  int rc = 0;
+  for (int i = 0; i < nchunks && rc == 0; i++) {
+    fill_chunk(data_, i);
+    int dsize = blosc2_schunk_decompress_chunk(schunk, i, data_dest, CHUNKSHAPE * sizeof(int32_t));
+    if (dsize != CHUNKSHAPE * sizeof(int32_t) ||
+        memcmp(data_, data_dest, CHUNKSHAPE * sizeof(int32_t)) != 0) {
+      rc = -1;
+    }
+  }
+  free(data_);
+  free(data_dest);
+  return rc;
+}
+
+
+// Whether the chunk refers to the dictionary shared by the super-chunk
+static bool refers_shared_dict(blosc2_schunk *schunk, int nchunk) {
+  uint8_t *chunk;
+  bool needs_free;
+  int32_t nbytes, blocksize;
+  int cbytes = blosc2_schunk_get_chunk(schunk, nchunk, &chunk, &needs_free);
+  if (cbytes < 0) {
+    return false;
+  }
+  blosc2_cbuffer_sizes(chunk, &nbytes, NULL, &blocksize);
+  int32_t nblocks = nbytes / blocksize + (nbytes % blocksize ? 1 : 0);
+  int32_t dsize;
+  memcpy(&dsize, chunk + BLOSC_EXTENDED_HEADER_LENGTH + nblocks * sizeof(int32_t), sizeof(int32_t));
+  bool shared = (chunk[BLOSC2_CHUNK_BLOSC2_FLAGS] & BLOSC2_USEDICT) && dsize < 0;
+  if (needs_free) {
+    free(chunk);
+  }
+  return shared;
+}
+
+
+CUTEST_TEST_TEST(shared_dict) {
+  CUTEST_GET_PARAMETER(nthreads, int);
+  CUTEST_GET_PARAMETER(backend, test_shared_dict_backend);
+
+  data->cparams.nthreads = (int16_t)nthreads;
+  data->dparams.nthreads = (int16_t)nthreads;
+  blosc2_remove_urlpath(backend.urlpath);
+  blosc2_storage storage = {.cparams=&data->cparams, .dparams=&data->dparams,
+                            .urlpath=backend.urlpath, .contiguous=backend.contiguous};
+  blosc2_schunk *schunk = blosc2_schunk_new(&storage);
+  CUTEST_ASSERT("Error creating schunk", schunk != NULL);
+
+  int32_t *data_ = malloc(CHUNKSHAPE * sizeof(int32_t));
+  for (int i = 0; i < NTRAIN; i++) {
+    fill_chunk(data_, i);
+    int rc = blosc2_schunk_append_buffer(schunk, data_, CHUNKSHAPE * sizeof(int32_t));
+    CUTEST_ASSERT("ERROR: bad append", rc == i + 1);
+  }
+  CUTEST_ASSERT("ERROR: cannot train the dictionary",
+                blosc2_schunk_train_dict_from_chunks(schunk, NTRAIN) == 0);
+  CUTEST_ASSERT("ERROR: the dictionary can only be trained once",
+                blosc2_schunk_train_dict_from_chunks(schunk, NTRAIN) < 0);
+  for (int i = NTRAIN; i < NCHUNKS; i++) {
+    fill_chunk(data_, i);
+    int rc = blosc2_schunk_append_buffer(schunk, data_, CHUNKSHAPE * sizeof(int32_t));
+    CUTEST_ASSERT("ERROR: bad append", rc == i + 1);
+    CUTEST_ASSERT("ERROR: the chunk does not refer to the dictionary", refers_shared_dict(schunk, i));
+  }
+  CUTEST_ASSERT("ERROR: the first chunks should not change", !refers_shared_dict(schunk, 0));
+  CUTEST_ASSERT("ERROR: bad roundtrip", check_chunks(schunk, NCHUNKS) == 0);
+
+  // Several contexts at once
+  int32_t *dest = malloc(NCHUNKS * CHUNKSHAPE * sizeof(int32_t));
+  int64_t nbytes = blosc2_schunk_decompress_range(schunk, 0, NCHUNKS, dest,
+                                                  NCHUNKS * CHUNKSHAPE * sizeof(int32_t));
+  CUTEST_ASSERT("ERROR: bad range decompression", nbytes == NCHUNKS * CHUNKSHAPE * sizeof(int32_t));
+  fill_chunk(data_, NCHUNKS - 1);
+  CUTEST_ASSERT("ERROR: bad range roundtrip",
+                memcmp(dest + (NCHUNKS - 1) * CHUNKSHAPE, data_, CHUNKSHAPE * sizeof(int32_t)) == 0);
+  free(dest);
+
+  // Items out of a chunk
+  uint8_t *chunk;
+  bool needs_free;
+  int cbytes = blosc2_schunk_get_chunk(schunk, NCHUNKS - 1, &chunk, &needs_free);
+  CUTEST_ASSERT("ERROR: cannot get chunk", cbytes > 0);
+  int32_t items[10];
+  int rc = blosc2_getitem_ctx(schunk->dctx, chunk, cbytes, 1000, 10, items, sizeof(items));
+  CUTEST_ASSERT("ERROR: bad getitem", rc == sizeof(items));
+  CUTEST_ASSERT("ERROR: bad getitem value", memcmp(items, data_ + 1000, sizeof(items)) == 0);
+
+  // Other contexts of the super-chunk share the dictionary, digested just once
+  blosc2_dparams dparams = data->dparams;
+  dparams.schunk = schunk;
+  blosc2_context *dctx = blosc2_create_dctx(dparams);
+  rc = blosc2_decompress_ctx(dctx, chunk, cbytes, data_, CHUNKSHAPE * sizeof(int32_t));
+  CUTEST_ASSERT("ERROR: bad decompression with another context", rc == CHUNKSHAPE * sizeof(int32_t));
+  CUTEST_ASSERT("ERROR: the dictionary is not digested", schunk->dctx->dict_ddict != NULL);
+  CUTEST_ASSERT("ERROR: the dictionary is not shared",
+                dctx->dict_ddict == schunk->dctx->dict_ddict && dctx->dict_buffer == schunk->dctx->dict_buffer);
+  blosc2_free_ctx(dctx);
+  if (needs_free) {
+    free(chunk);
+  }
+
+  // A new super-chunk out of the frame (with fresh contexts)
+  if (backend.contiguous || backend.urlpath != NULL) {
+    blosc2_schunk *schunk2;
+    uint8_t *cframe = NULL;
+    bool cframe_needs_free;
+    if (backend.urlpath != NULL) {
+      blosc2_schunk_free(schunk);
+      schunk2 = blosc2_schunk_open(backend.urlpath);
+    }
+    else {
+      int64_t len = blosc2_schunk_to_buffer(schunk, &cframe, &cframe_needs_free);
+      CUTEST_ASSERT("ERROR: cannot get the frame", len > 0);
+      schunk2 = blosc2_schunk_from_buffer(cframe, len, true);
+      blosc2_schunk_free(schunk);
+    }
+    CUTEST_ASSERT("ERROR: cannot open the frame", schunk2 != NULL);
+    CUTEST_ASSERT("ERROR: bad roundtrip after reopening", check_chunks(schunk2, NCHUNKS) == 0);
+    // New chunks keep using the shared dictionary
+    fill_chunk(data_, NCHUNKS);
+    rc = blosc2_schunk_append_buffer(schunk2, data_, CHUNKSHAPE * sizeof(int32_t));
+    CUTEST_ASSERT("ERROR: bad append after reopening", rc == NCHUNKS + 1);
+    CUTEST_ASSERT("ERROR: the chunk does not refer to the dictionary", refers_shared_dict(schunk2, NCHUNKS));
+    CUTEST_ASSERT("ERROR: bad roundtrip after appending", check_chunks(schunk2, NCHUNKS + 1) == 0);
+    schunk = schunk2;
+    if (cframe != NULL && cframe_needs_free) {
+      free(cframe);
+    }
+  }
+
+  /* Free resources */
+  free(data_);
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(backend.urlpath);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(shared_dict) {
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(shared_dict)
+}
@@ -0,0 +1,171 @@
+/*********************************************************************
+  Blosc - Blocked Shuffling and Compression Library
+
+  Unit tests for the process-wide shared pool of threads.
+
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  See LICENSE.txt for details about copyright and rights to use.
+**********************************************************************/
+
+#include "test_common.h"
+
+#include <pthread.h>
+
+#define NCONTEXTS 8
+#define NTHREADS 4
+#define SIZE (500 * 1000)
+
+int tests_run = 0;
+
+typedef struct {
+  uint8_t filter;
+  int rc;
+} job_t;
+
+
+static void* roundtrip(void* arg) {
+  job_t* job = (job_t*)arg;
+  int32_t isize = SIZE * sizeof(int32_t);
+  int32_t* data = malloc(isize);
+  int32_t* data_dest = malloc(isize);
+  uint8_t* data_out = malloc(isize + BLOSC_MAX_OVERHEAD);
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+
+  for (int i = 0; i < SIZE; i++) {
+    data[i] = i * job->filter;
+  }
+  cparams.typesize = sizeof(int32_t);
+  cparams.compcode = BLOSC_LZ4;
+  cparams.filters[BLOSC2_MAX_FILTERS - 1] = job->filter;
+  cparams.nthreads = NTHREADS;
+  cparams.blocksize = 16 * KB;
+  dparams.nthreads = NTHREADS;
+  blosc2_context* cctx = blosc2_create_cctx(cparams);
+  blosc2_context* dctx = blosc2_create_dctx(dparams);
+
+  job->rc = 0;
+  for (int n = 0; n < 10 && job->rc == 0; n++) {
+    int csize = blosc2_compress_ctx(cctx, data, isize, data_out, isize + BLOSC_MAX_OVERHEAD);
+    if (csize <= 0) {
+      job->rc = 1;
+      break;
+    }
+    int dsize = blosc2_decompress_ctx(dctx, data_out, csize, data_dest, isize);
+    if (dsize != isize || memcmp(data, data_dest, isize) != 0) {
+      job->rc = 2;
+    }
+  }
+
+  blosc2_free_ctx(cctx);
+  blosc2_free_ctx(dctx);
+  free(data);
+  free(data_dest);
+  free(data_out);
+  return NULL;
+}
+
+
+static char *test_pool_size(void) {
+  int16_t old = blosc2_set_shared_threadpool(INT16_MAX);
+  mu_assert("ERROR: shared pool should not be active", old == 0);
+  int16_t nthreads = blosc2_get_shared_threadpool();
+  mu_assert("ERROR: shared pool should be active", nthreads > 0);
+  /* Capped to the number of cores, so it cannot grow further */
+  old = blosc2_set_shared_threadpool(INT16_MAX);
+  mu_assert("ERROR: shared pool has not been capped", old == nthreads);
+
+  blosc2_set_shared_threadpool(0);
+  mu_assert("ERROR: shared pool not stopped", blosc2_get_shared_threadpool() == 0);
+
+  return 0;
+}
+
+
+static char *test_concurrent_contexts(void) {
+  pthread_t threads[NCONTEXTS];
+  job_t jobs[NCONTEXTS];
+  uint8_t filters[] = {BLOSC_SHUFFLE, BLOSC_BITSHUFFLE, BLOSC_DELTA, BLOSC_NOFILTER};
+
+  blosc2_set_shared_threadpool(2);
+  for (int i = 0; i < NCONTEXTS; i++) {
+    jobs[i].filter = filters[i % 4];
+    pthread_create(&threads[i], NULL, roundtrip, &jobs[i]);
+  }
+  for (int i = 0; i < NCONTEXTS; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  blosc2_set_shared_threadpool(0);
+
+  for (int i = 0; i < NCONTEXTS; i++) {
+    mu_assert("ERROR: compression failed", jobs[i].rc != 1);
+    mu_assert("ERROR: roundtrip failed", jobs[i].rc != 2);
+  }
+
+  return 0;
+}
+
+
+static char *test_global_context(void) {
+  job_t job = {BLOSC_SHUFFLE, 0};
+
+  /* A single worker plus the caller must run all the jobs */
+  blosc2_set_shared_threadpool(1);
+  blosc_set_nthreads(NTHREADS);
+  roundtrip(&job);
+  mu_assert("ERROR: roundtrip failed", job.rc == 0);
+
+  size_t isize = SIZE * sizeof(int32_t);
+  int32_t* data = malloc(isize);
+  int32_t* data_dest = malloc(isize);
+  uint8_t* data_out = malloc(isize + BLOSC_MAX_OVERHEAD);
+  for (int i = 0; i < SIZE; i++) {
+    data[i] = i;
+  }
+  int csize = blosc_compress(5, BLOSC_SHUFFLE, sizeof(int32_t), isize, data,
+                             data_out, isize + BLOSC_MAX_OVERHEAD);
+  int dsize = blosc_decompress(data_out, data_dest, isize);
+  bool equal = memcmp(data, data_dest, isize) == 0;
+  free(data);
+  free(data_dest);
+  free(data_out);
+  blosc_set_nthreads(1);
+  blosc2_set_shared_threadpool(0);
+  mu_assert("ERROR: compression failed", csize > 0);
+  mu_assert("ERROR: decompression failed", dsize == (int)isize);
+  mu_assert("ERROR: roundtrip failed", equal);
+
+  return 0;
+}
+
+
+static char *all_tests(void) {
+  mu_run_test(test_pool_size);
+  mu_run_test(test_concurrent_contexts);
+  mu_run_test(test_global_context);
+
+  return 0;
+}
+
+
+int main(void) {
+  char *result;
+
+  blosc_init();
+
+  result = all_tests();
+  if (result != 0) {
+    printf(" (%s)\n", result);
+  }
+  else {
+    printf(" ALL TESTS PASSED\n");
+  }
+  printf("\tTests run: %d\n", tests_run);
+
+  blosc_destroy();
+
+  return result != 0;
+}
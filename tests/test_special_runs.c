@@ -0,0 +1,154 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Unit tests for encoding chunks made of a repeated value as special chunks.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "blosc2.h"
+#include "cutest.h"
+
+#define NELEMS (100 * 1000)
+
+enum {
+  RUN_ZERO,
+  RUN_NAN,
+  RUN_VALUE,
+  RUN_BROKEN,
+};
+
+
+CUTEST_TEST_DATA(special_runs) {
+  blosc2_cparams cparams;
+  blosc2_dparams dparams;
+};
+
+CUTEST_TEST_SETUP(special_runs) {
+  blosc_init();
+  data->cparams = BLOSC2_CPARAMS_DEFAULTS;
+  data->cparams.compcode = BLOSC_LZ4;
+  data->dparams = BLOSC2_DPARAMS_DEFAULTS;
+
+  CUTEST_PARAMETRIZE(typesize, int32_t, CUTEST_DATA(
+      1, 2, 4, 8, 12,
+  ));
+  CUTEST_PARAMETRIZE(run, int, CUTEST_DATA(
+      RUN_ZERO,
+      RUN_NAN,
+      RUN_VALUE,
+      RUN_BROKEN,
+  ));
+  CUTEST_PARAMETRIZE(nthreads, int16_t, CUTEST_DATA(
+      1,
+      4,
+  ));
+  CUTEST_PARAMETRIZE(compcode, uint8_t, CUTEST_DATA(
+      BLOSC_BLOSCLZ,
+      BLOSC_LZ4,
+      BLOSC_ZSTD,
+  ));
+  CUTEST_PARAMETRIZE(use_dict, int, CUTEST_DATA(
+      0,
+      1,
+  ));
+}
+
+
+CUTEST_TEST_TEST(special_runs) {
+  CUTEST_GET_PARAMETER(typesize, int32_t);
+  CUTEST_GET_PARAMETER(run, int);
+  CUTEST_GET_PARAMETER(nthreads, int16_t);
+  CUTEST_GET_PARAMETER(compcode, uint8_t);
+  CUTEST_GET_PARAMETER(use_dict, int);
+
+  if (run == RUN_NAN && typesize != 4 && typesize != 8) {
+    return 0;
+  }
+  if (run == RUN_BROKEN && use_dict && compcode == BLOSC_ZSTD) {
+    // ZDICT cannot train a dictionary out of (almost) constant samples
+    return 0;
+  }
+
+  int32_t nbytes = NELEMS * typesize;
+  uint8_t *src = malloc(nbytes);
+  uint8_t *dest = malloc(nbytes);
+  uint8_t *cdata = malloc(nbytes + BLOSC_MAX_OVERHEAD);
+  uint8_t value[12];
+  for (int i = 0; i < typesize; i++) {
+    value[i] = (uint8_t)(run == RUN_ZERO ? 0 : 0x40 + i);
+  }
+  if (run == RUN_NAN) {
+    float nan4 = nanf("");
+    double nan8 = nan("");
+    memcpy(value, typesize == 4 ? (void *)&nan4 : (void *)&nan8, typesize);
+  }
+  for (int32_t i = 0; i < NELEMS; i++) {
+    memcpy(src + i * typesize, value, typesize);
+  }
+  if (run == RUN_BROKEN) {
+    // The last byte breaks the run
+    src[nbytes - 1] ^= 1;
+  }
+
+  blosc2_cparams cparams = data->cparams;
+  cparams.typesize = typesize;
+  cparams.nthreads = nthreads;
+  cparams.compcode = compcode;
+  // Special chunks are not compressed again with a dictionary
+  cparams.use_dict = use_dict;
+  blosc2_context *cctx = blosc2_create_cctx(cparams);
+  int cbytes = blosc2_compress_ctx(cctx, src, nbytes, cdata, nbytes + BLOSC_MAX_OVERHEAD);
+  CUTEST_ASSERT("ERROR: cannot compress", cbytes > 0);
+  blosc2_free_ctx(cctx);
+
+  int special_type = (cdata[BLOSC2_CHUNK_BLOSC2_FLAGS] >> 4) & BLOSC2_SPECIAL_MASK;
+  switch (run) {
+    case RUN_ZERO:
+      CUTEST_ASSERT("ERROR: zeros are not a special chunk", special_type == BLOSC2_SPECIAL_ZERO);
+      CUTEST_ASSERT("ERROR: bad size for zeros", cbytes == BLOSC_EXTENDED_HEADER_LENGTH);
+      break;
+    case RUN_NAN:
+      CUTEST_ASSERT("ERROR: NaNs are not a special chunk", special_type == BLOSC2_SPECIAL_NAN);
+      CUTEST_ASSERT("ERROR: bad size for NaNs", cbytes == BLOSC_EXTENDED_HEADER_LENGTH);
+      break;
+    case RUN_VALUE:
+      CUTEST_ASSERT("ERROR: repeated value is not a special chunk", special_type == BLOSC2_SPECIAL_VALUE);
+      CUTEST_ASSERT("ERROR: bad size for repeated value", cbytes == BLOSC_EXTENDED_HEADER_LENGTH + typesize);
+      break;
+    default:
+      CUTEST_ASSERT("ERROR: broken run is a special chunk", special_type == BLOSC2_NO_SPECIAL);
+  }
+
+  blosc2_dparams dparams = data->dparams;
+  dparams.nthreads = nthreads;
+  blosc2_context *dctx = blosc2_create_dctx(dparams);
+  int dsize = blosc2_decompress_ctx(dctx, cdata, cbytes, dest, nbytes);
+  CUTEST_ASSERT("ERROR: bad decompression", dsize == nbytes);
+  CUTEST_ASSERT("ERROR: bad roundtrip", memcmp(src, dest, nbytes) == 0);
+  // Items past the first block
+  dsize = blosc2_getitem_ctx(dctx, cdata, cbytes, NELEMS - 10, 10, dest, nbytes);
+  CUTEST_ASSERT("ERROR: bad getitem", dsize == 10 * typesize);
+  CUTEST_ASSERT("ERROR: bad getitem roundtrip", memcmp(src + nbytes - dsize, dest, dsize) == 0);
+  blosc2_free_ctx(dctx);
+
+  /* Free resources */
+  free(src);
+  free(dest);
+  free(cdata);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(special_runs) {
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(special_runs)
+}
@@ -0,0 +1,172 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Unit tests for the performance counters of contexts.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "blosc2.h"
+#include "cutest.h"
+
+#define NBYTES (1024 * 1024)
+#define BLOCKSIZE (64 * 1024)
+#define NBLOCKS (NBYTES / BLOCKSIZE)
+
+enum {
+  DATA_RAMP,
+  DATA_RANDOM,
+};
+
+
+CUTEST_TEST_DATA(stats) {
+  blosc2_cparams cparams;
+  blosc2_dparams dparams;
+};
+
+CUTEST_TEST_SETUP(stats) {
+  blosc_init();
+  data->cparams = BLOSC2_CPARAMS_DEFAULTS;
+  data->cparams.typesize = 4;
+  data->cparams.blocksize = BLOCKSIZE;
+  data->cparams.compcode = BLOSC_LZ4;
+  data->dparams = BLOSC2_DPARAMS_DEFAULTS;
+
+  CUTEST_PARAMETRIZE(content, int, CUTEST_DATA(
+      DATA_RAMP,
+      DATA_RANDOM,
+  ));
+  CUTEST_PARAMETRIZE(nthreads, int16_t, CUTEST_DATA(
+      1,
+      4,
+  ));
+}
+
+
+static void fill_buffer(uint8_t *buffer, int32_t nbytes, int content) {
+  uint32_t seed = 1234;
+  for (int32_t i = 0; i < nbytes / 4; i++) {
+    seed = seed * 1103515245 + 12345;
+    uint32_t value = content == DATA_RAMP ? (uint32_t)i : seed ^ (seed >> 13) * 2654435761U;
+    memcpy(buffer + i * 4, &value, 4);
+  }
+}
+
+
+CUTEST_TEST_TEST(stats) {
+  CUTEST_GET_PARAMETER(content, int);
+  CUTEST_GET_PARAMETER(nthreads, int16_t);
+
+  uint8_t *src = malloc(NBYTES);
+  uint8_t *dest = malloc(NBYTES);
+  uint8_t *cdata = malloc(NBYTES + BLOSC_MAX_OVERHEAD);
+  fill_buffer(src, NBYTES, content);
+  blosc2_stats stats;
+
+  // Compression
+  blosc2_cparams cparams = data->cparams;
+  cparams.nthreads = nthreads;
+  blosc2_context *cctx = blosc2_create_cctx(cparams);
+  if (blosc2_ctx_get_stats(cctx, &stats) < 0) {
+    // Compiled out
+    blosc2_free_ctx(cctx);
+    free(src);
+    free(dest);
+    free(cdata);
+    return 0;
+  }
+  CUTEST_ASSERT("ERROR: counters of a new context are not 0", stats.nchunks == 0 && stats.codec_time == 0);
+  int cbytes = 0;
+  for (int i = 0; i < 2; i++) {
+    cbytes = blosc2_compress_ctx(cctx, src, NBYTES, cdata, NBYTES + BLOSC_MAX_OVERHEAD);
+    CUTEST_ASSERT("ERROR: cannot compress", cbytes > 0);
+  }
+  blosc2_ctx_get_stats(cctx, &stats);
+  CUTEST_ASSERT("ERROR: bad nchunks", stats.nchunks == 2);
+  CUTEST_ASSERT("ERROR: bad nblocks", stats.nblocks == 2 * NBLOCKS);
+  CUTEST_ASSERT("ERROR: bad nbytes", stats.nbytes == 2 * NBYTES);
+  CUTEST_ASSERT("ERROR: bad cbytes", stats.cbytes == 2 * cbytes);
+  CUTEST_ASSERT("ERROR: negative wait time", stats.wait_time >= 0);
+  CUTEST_ASSERT("ERROR: time in pre/postfilter without them",
+                stats.prefilter_time == 0 && stats.postfilter_time == 0);
+  if (content == DATA_RAMP) {
+    CUTEST_ASSERT("ERROR: bad nmemcpyed", stats.nmemcpyed == 0);
+    CUTEST_ASSERT("ERROR: no time in codec", stats.codec_time > 0);
+    CUTEST_ASSERT("ERROR: no time in filters", stats.filter_time > 0);
+    CUTEST_ASSERT("ERROR: time in memcpy", stats.memcpy_time == 0);
+  }
+  else {
+    CUTEST_ASSERT("ERROR: bad nmemcpyed", stats.nmemcpyed == 2);
+    CUTEST_ASSERT("ERROR: no time in memcpy", stats.memcpy_time > 0);
+    CUTEST_ASSERT("ERROR: time in codec", stats.codec_time == 0);
+  }
+  CUTEST_ASSERT("ERROR: cannot reset stats", blosc2_ctx_reset_stats(cctx) == 0);
+  blosc2_ctx_get_stats(cctx, &stats);
+  CUTEST_ASSERT("ERROR: counters not reset", stats.nchunks == 0 && stats.nblocks == 0 &&
+                stats.codec_time == 0 && stats.memcpy_time == 0 && stats.wait_time == 0);
+  blosc2_free_ctx(cctx);
+
+  // Decompression
+  blosc2_dparams dparams = data->dparams;
+  dparams.nthreads = nthreads;
+  blosc2_context *dctx = blosc2_create_dctx(dparams);
+  int dsize = blosc2_decompress_ctx(dctx, cdata, cbytes, dest, NBYTES);
+  CUTEST_ASSERT("ERROR: bad decompression", dsize == NBYTES);
+  blosc2_ctx_get_stats(dctx, &stats);
+  CUTEST_ASSERT("ERROR: bad nchunks", stats.nchunks == 1);
+  CUTEST_ASSERT("ERROR: bad nblocks", stats.nblocks == NBLOCKS);
+  CUTEST_ASSERT("ERROR: bad nbytes", stats.nbytes == NBYTES);
+  CUTEST_ASSERT("ERROR: bad cbytes", stats.cbytes == cbytes);
+  CUTEST_ASSERT("ERROR: lazy reads of an in-memory chunk", stats.lazy_nreads == 0);
+  if (content == DATA_RAMP) {
+    CUTEST_ASSERT("ERROR: no time in codec", stats.codec_time > 0);
+  }
+  else {
+    CUTEST_ASSERT("ERROR: no time in memcpy", stats.memcpy_time > 0);
+  }
+  blosc2_ctx_reset_stats(dctx);
+  dsize = blosc2_getitem_ctx(dctx, cdata, cbytes, 0, 10, dest, NBYTES);
+  CUTEST_ASSERT("ERROR: bad getitem", dsize == 10 * 4);
+  blosc2_ctx_get_stats(dctx, &stats);
+  CUTEST_ASSERT("ERROR: getitem counted as a chunk", stats.nchunks == 0);
+  // Items of chunks stored without compression are copied straight away
+  CUTEST_ASSERT("ERROR: bad getitem nblocks", stats.nblocks == (content == DATA_RAMP ? 1 : 0));
+  blosc2_free_ctx(dctx);
+
+  // Lazy chunks
+  char *urlpath = "test_stats.b2frame";
+  blosc2_remove_urlpath(urlpath);
+  blosc2_storage storage = {.contiguous=true, .urlpath=urlpath, .cparams=&cparams, .dparams=&dparams};
+  blosc2_schunk *schunk = blosc2_schunk_new(&storage);
+  CUTEST_ASSERT("ERROR: cannot create the super-chunk", schunk != NULL);
+  int nchunks = blosc2_schunk_append_buffer(schunk, src, NBYTES);
+  CUTEST_ASSERT("ERROR: cannot append", nchunks == 1);
+  blosc2_ctx_reset_stats(schunk->dctx);
+  dsize = blosc2_schunk_decompress_chunk(schunk, 0, dest, NBYTES);
+  CUTEST_ASSERT("ERROR: bad decompression", dsize == NBYTES);
+  CUTEST_ASSERT("ERROR: bad roundtrip", memcmp(src, dest, NBYTES) == 0);
+  blosc2_ctx_get_stats(schunk->dctx, &stats);
+  CUTEST_ASSERT("ERROR: bad nchunks", stats.nchunks == 1);
+  CUTEST_ASSERT("ERROR: bad lazy nreads", stats.lazy_nreads == NBLOCKS);
+  CUTEST_ASSERT("ERROR: bad lazy nbytes", stats.lazy_nbytes > 0 && stats.lazy_nbytes <= cbytes);
+  blosc2_schunk_free(schunk);
+  blosc2_remove_urlpath(urlpath);
+
+  free(src);
+  free(dest);
+  free(cdata);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(stats) {
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(stats)
+}
@@ -0,0 +1,161 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Unit tests for the built-in adaptive tuner.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "blosc2.h"
+#include "cutest.h"
+
+#define CHUNKSHAPE (250 * 1000)
+#define NCHUNKS 4
+
+enum {
+  TUNE_RATIO,
+  TUNE_CSPEED,
+  TUNE_DEFAULTS,
+  TUNE_REPROBE,
+};
+
+
+CUTEST_TEST_DATA(stune) {
+  blosc2_cparams cparams;
+  blosc2_dparams dparams;
+};
+
+CUTEST_TEST_SETUP(stune) {
+  blosc_init();
+  data->cparams = BLOSC2_CPARAMS_DEFAULTS;
+  data->cparams.typesize = sizeof(int32_t);
+  data->dparams = BLOSC2_DPARAMS_DEFAULTS;
+
+  CUTEST_PARAMETRIZE(tune, int, CUTEST_DATA(
+      TUNE_RATIO,
+      TUNE_CSPEED,
+      TUNE_DEFAULTS,
+      TUNE_REPROBE,
+  ));
+  CUTEST_PARAMETRIZE(nthreads, int16_t, CUTEST_DATA(
+      1,
+      2,
+  ));
+}
+
+
+/* The first half of the chunks are smooth, and the second half look like text */
+static void fill_chunk(int32_t *buffer, int nchunk) {
+  uint32_t seed = 1234 + nchunk;
+  for (int32_t i = 0; i < CHUNKSHAPE; i++) {
+    seed = seed * 1103515245 + 12345;
+    if (nchunk < NCHUNKS / 2) {
+      buffer[i] = nchunk * CHUNKSHAPE + i * 3 + (int32_t)((seed >> 16) % 4);
+    }
+    else {
+      uint8_t letters[4];
+      for (int j = 0; j < 4; j++) {
+        seed = seed * 1103515245 + 12345;
+        letters[j] = (uint8_t)('a' + (seed >> 16) % 12);
+      }
+      memcpy(buffer + i, letters, 4);
+    }
+  }
+}
+
+
+static int64_t fill_schunk(blosc2_schunk *schunk, int32_t *src, int32_t *dest) {
+  for (int nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    fill_chunk(src, nchunk);
+    int nchunks = blosc2_schunk_append_buffer(schunk, src, CHUNKSHAPE * sizeof(int32_t));
+    if (nchunks != nchunk + 1) {
+      return -1;
+    }
+  }
+  for (int nchunk = 0; nchunk < NCHUNKS; nchunk++) {
+    fill_chunk(src, nchunk);
+    int dsize = blosc2_schunk_decompress_chunk(schunk, nchunk, dest, CHUNKSHAPE * sizeof(int32_t));
+    if (dsize != CHUNKSHAPE * sizeof(int32_t) || memcmp(src, dest, dsize) != 0) {
+      return -1;
+    }
+  }
+  return schunk->cbytes;
+}
+
+
+CUTEST_TEST_TEST(stune) {
+  CUTEST_GET_PARAMETER(tune, int);
+  CUTEST_GET_PARAMETER(nthreads, int16_t);
+
+  int32_t *src = malloc(CHUNKSHAPE * sizeof(int32_t));
+  int32_t *dest = malloc(CHUNKSHAPE * sizeof(int32_t));
+
+  blosc2_stune_config config;
+  switch (tune) {
+    case TUNE_RATIO:
+      config = BLOSC2_STUNE_CONFIG_RATIO;
+      break;
+    case TUNE_CSPEED:
+      config = BLOSC2_STUNE_CONFIG_CSPEED;
+      break;
+    case TUNE_REPROBE:
+      config = BLOSC2_STUNE_CONFIG_DEFAULTS;
+      config.reprobe_nchunks = 1;
+      break;
+    default:
+      config = BLOSC2_STUNE_CONFIG_DEFAULTS;
+  }
+  blosc2_btune btune;
+  blosc2_stune_config bad_config = config;
+  bad_config.ratio_weight = -1;
+  CUTEST_ASSERT("ERROR: negative weight accepted", blosc2_stune_adaptive(&btune, &bad_config) < 0);
+  bad_config = config;
+  bad_config.drift = -1;
+  CUTEST_ASSERT("ERROR: negative drift accepted", blosc2_stune_adaptive(&btune, &bad_config) < 0);
+  CUTEST_ASSERT("ERROR: cannot set the tuner", blosc2_stune_adaptive(&btune, &config) == 0);
+
+  // The tuned super-chunk
+  blosc2_cparams cparams = data->cparams;
+  cparams.nthreads = nthreads;
+  cparams.udbtune = &btune;
+  blosc2_dparams dparams = data->dparams;
+  dparams.nthreads = nthreads;
+  blosc2_storage storage = {.cparams=&cparams, .dparams=&dparams};
+  blosc2_schunk *schunk = blosc2_schunk_new(&storage);
+  CUTEST_ASSERT("ERROR: cannot create the super-chunk", schunk != NULL);
+  int64_t cbytes = fill_schunk(schunk, src, dest);
+  CUTEST_ASSERT("ERROR: bad roundtrip with the tuner", cbytes > 0);
+  blosc2_schunk_free(schunk);
+
+  // The same without tuner
+  blosc2_cparams cparams2 = data->cparams;
+  cparams2.nthreads = nthreads;
+  storage.cparams = &cparams2;
+  schunk = blosc2_schunk_new(&storage);
+  CUTEST_ASSERT("ERROR: cannot create the super-chunk", schunk != NULL);
+  int64_t cbytes2 = fill_schunk(schunk, src, dest);
+  CUTEST_ASSERT("ERROR: bad roundtrip without the tuner", cbytes2 > 0);
+  blosc2_schunk_free(schunk);
+
+  if (tune == TUNE_RATIO) {
+    // The default parameters are among the ones tried
+    CUTEST_ASSERT("ERROR: tuning for ratio gives a worse ratio", cbytes <= cbytes2 * 1.05);
+  }
+
+  free(src);
+  free(dest);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(stune) {
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(stune)
+}
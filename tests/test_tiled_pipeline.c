@@ -0,0 +1,140 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Unit tests for running the filter pipeline of a block in tiles.  The tiled
+  pipeline must be byte-exact with running the filters on whole blocks.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "blosc2.h"
+#include "cutest.h"
+
+// Not a multiple of 8 elements, nor of the typesize
+#define NBYTES (1000 * 1000 + 77)
+
+typedef struct {
+  uint8_t filters[2];
+  uint8_t filters_meta[2];
+} test_pipeline;
+
+
+CUTEST_TEST_DATA(tiled_pipeline) {
+  blosc2_cparams cparams;
+  blosc2_dparams dparams;
+};
+
+CUTEST_TEST_SETUP(tiled_pipeline) {
+  blosc_init();
+  data->cparams = BLOSC2_CPARAMS_DEFAULTS;
+  data->cparams.compcode = BLOSC_LZ4;
+  data->cparams.clevel = 5;
+  data->cparams.blocksize = 64 * 1024 + 40;
+  data->dparams = BLOSC2_DPARAMS_DEFAULTS;
+
+  CUTEST_PARAMETRIZE(typesize, int32_t, CUTEST_DATA(
+      1, 2, 4, 8, 12,
+  ));
+  CUTEST_PARAMETRIZE(pipeline, test_pipeline, CUTEST_DATA(
+      {{BLOSC_DELTA, BLOSC_SHUFFLE}, {0, 0}},
+      {{BLOSC_DELTA_SUB, BLOSC_SHUFFLE}, {0, 0}},
+      {{BLOSC_DELTA_SUB, BLOSC_BITSHUFFLE}, {0, 0}},
+      {{BLOSC_DELTA, BLOSC_BITSHUFFLE}, {0, 0}},
+      {{BLOSC_TRUNC_PREC, BLOSC_SHUFFLE}, {10, 0}},
+      {{BLOSC_TRUNC_PREC, BLOSC_BITSHUFFLE}, {10, 0}},
+  ));
+  CUTEST_PARAMETRIZE(nthreads, int16_t, CUTEST_DATA(
+      1,
+      3,
+  ));
+}
+
+
+/* Tiled pipelines are enabled or disabled when the library is initialized */
+static void set_tiled_pipeline(int enabled) {
+  blosc_destroy();
+#if defined(_WIN32)
+  _putenv_s("BLOSC_TILED_PIPELINE", enabled ? "1" : "0");
+#else
+  setenv("BLOSC_TILED_PIPELINE", enabled ? "1" : "0", 1);
+#endif
+  blosc_init();
+}
+
+
+CUTEST_TEST_TEST(tiled_pipeline) {
+  CUTEST_GET_PARAMETER(typesize, int32_t);
+  CUTEST_GET_PARAMETER(pipeline, test_pipeline);
+  CUTEST_GET_PARAMETER(nthreads, int16_t);
+
+  if (pipeline.filters[0] == BLOSC_TRUNC_PREC && typesize != 4 && typesize != 8) {
+    // Precision can only be truncated for floats and doubles
+    return 0;
+  }
+
+  uint8_t *src = malloc(NBYTES);
+  uint8_t *dest = malloc(NBYTES);
+  uint8_t *cdata[2];
+  int cbytes[2];
+  uint32_t seed = 1234;
+  for (int32_t i = 0; i < NBYTES; i++) {
+    seed = seed * 1103515245 + 12345;
+    // A ramp with some noise in the low bits
+    src[i] = (uint8_t)(i / 64 + ((seed >> 16) & 3));
+  }
+
+  blosc2_cparams cparams = data->cparams;
+  cparams.typesize = typesize;
+  cparams.nthreads = nthreads;
+  cparams.filters[BLOSC2_MAX_FILTERS - 2] = pipeline.filters[0];
+  cparams.filters_meta[BLOSC2_MAX_FILTERS - 2] = pipeline.filters_meta[0];
+  cparams.filters[BLOSC2_MAX_FILTERS - 1] = pipeline.filters[1];
+  cparams.filters_meta[BLOSC2_MAX_FILTERS - 1] = pipeline.filters_meta[1];
+  blosc2_dparams dparams = data->dparams;
+  dparams.nthreads = nthreads;
+
+  for (int tiled = 0; tiled < 2; tiled++) {
+    set_tiled_pipeline(tiled);
+    cdata[tiled] = malloc(NBYTES + BLOSC_MAX_OVERHEAD);
+    blosc2_context *cctx = blosc2_create_cctx(cparams);
+    cbytes[tiled] = blosc2_compress_ctx(cctx, src, NBYTES, cdata[tiled], NBYTES + BLOSC_MAX_OVERHEAD);
+    CUTEST_ASSERT("ERROR: cannot compress", cbytes[tiled] > 0);
+    blosc2_free_ctx(cctx);
+  }
+  CUTEST_ASSERT("ERROR: tiled pipeline does not match",
+                cbytes[0] == cbytes[1] && memcmp(cdata[0], cdata[1], cbytes[0]) == 0);
+
+  // Decompress with the tiled pipeline (still enabled) and without it
+  for (int tiled = 1; tiled >= 0; tiled--) {
+    set_tiled_pipeline(tiled);
+    blosc2_context *dctx = blosc2_create_dctx(dparams);
+    int dsize = blosc2_decompress_ctx(dctx, cdata[0], cbytes[0], dest, NBYTES);
+    CUTEST_ASSERT("ERROR: bad decompression", dsize == NBYTES);
+    blosc2_free_ctx(dctx);
+    if (pipeline.filters[0] != BLOSC_TRUNC_PREC) {
+      CUTEST_ASSERT("ERROR: bad roundtrip", memcmp(src, dest, NBYTES) == 0);
+    }
+  }
+
+  /* Free resources */
+  free(src);
+  free(dest);
+  free(cdata[0]);
+  free(cdata[1]);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(tiled_pipeline) {
+  set_tiled_pipeline(1);
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(tiled_pipeline)
+}
@@ -0,0 +1,121 @@
+/*
+  Copyright (C) 2021  The Blosc Developers <blosc@blosc.org>
+  https://blosc.org
+  License: BSD 3-Clause (see LICENSE.txt)
+
+  Unit tests for the truncate precision filter and its fusion with (bit)shuffle.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "blosc2.h"
+#include "cutest.h"
+#include "../blosc/trunc-prec.h"
+#include "../blosc/shuffle.h"
+
+#define NELEMS (10 * 1000 + 5)
+
+
+CUTEST_TEST_DATA(trunc_prec) {
+  blosc2_cparams cparams;
+  blosc2_dparams dparams;
+};
+
+CUTEST_TEST_SETUP(trunc_prec) {
+  blosc_init();
+  data->cparams = BLOSC2_CPARAMS_DEFAULTS;
+  data->cparams.compcode = BLOSC_LZ4;
+  data->dparams = BLOSC2_DPARAMS_DEFAULTS;
+
+  CUTEST_PARAMETRIZE(typesize, int32_t, CUTEST_DATA(
+      4,
+      8,
+  ));
+  CUTEST_PARAMETRIZE(filter, uint8_t, CUTEST_DATA(
+      BLOSC_SHUFFLE,
+      BLOSC_BITSHUFFLE,
+  ));
+  CUTEST_PARAMETRIZE(prec_bits, uint8_t, CUTEST_DATA(
+      1, 7, 8, 13, 23,
+  ));
+}
+
+
+static void fill_buffer(uint8_t *buffer, int32_t nelems, int32_t typesize) {
+  for (int32_t i = 0; i < nelems; i++) {
+    double value = sin(i * 0.001) * 1000.;
+    if (typesize == 4) {
+      ((float *)buffer)[i] = (float)value;
+    }
+    else {
+      ((double *)buffer)[i] = value;
+    }
+  }
+}
+
+
+CUTEST_TEST_TEST(trunc_prec) {
+  CUTEST_GET_PARAMETER(typesize, int32_t);
+  CUTEST_GET_PARAMETER(filter, uint8_t);
+  CUTEST_GET_PARAMETER(prec_bits, uint8_t);
+
+  int32_t nbytes = NELEMS * typesize;
+  uint8_t *src = malloc(nbytes);
+  uint8_t *truncated = malloc(nbytes);
+  uint8_t *expected = malloc(nbytes);
+  uint8_t *dest = malloc(nbytes);
+  uint8_t *tmp = malloc(nbytes);
+  fill_buffer(src, NELEMS, typesize);
+
+  // The fused kernel is byte-exact with truncating and then (bit)shuffling
+  for (int32_t bsize = typesize; bsize < 300; bsize += 13) {
+    truncate_precision(prec_bits, typesize, bsize, src, truncated);
+    if (filter == BLOSC_SHUFFLE) {
+      shuffle(typesize, bsize, truncated, expected);
+    }
+    else {
+      CUTEST_ASSERT("ERROR: bitshuffle failed", bitshuffle(typesize, bsize, truncated, expected, tmp) >= 0);
+    }
+    CUTEST_ASSERT("ERROR: fused filter failed",
+                  truncate_precision_shuffle(prec_bits, filter, typesize, bsize, src, dest, tmp) == 0);
+    CUTEST_ASSERT("ERROR: fused filter does not match", memcmp(dest, expected, bsize) == 0);
+  }
+
+  // Roundtrip through the compression pipeline (the fused path is picked automatically)
+  data->cparams.typesize = typesize;
+  data->cparams.filters[BLOSC2_MAX_FILTERS - 2] = BLOSC_TRUNC_PREC;
+  data->cparams.filters_meta[BLOSC2_MAX_FILTERS - 2] = prec_bits;
+  data->cparams.filters[BLOSC2_MAX_FILTERS - 1] = filter;
+  uint8_t *cdata = malloc(nbytes + BLOSC_MAX_OVERHEAD);
+  blosc2_context *cctx = blosc2_create_cctx(data->cparams);
+  int cbytes = blosc2_compress_ctx(cctx, src, nbytes, cdata, nbytes + BLOSC_MAX_OVERHEAD);
+  CUTEST_ASSERT("ERROR: cannot compress", cbytes > 0);
+  blosc2_free_ctx(cctx);
+  blosc2_context *dctx = blosc2_create_dctx(data->dparams);
+  int dsize = blosc2_decompress_ctx(dctx, cdata, cbytes, dest, nbytes);
+  CUTEST_ASSERT("ERROR: bad decompression", dsize == nbytes);
+  blosc2_free_ctx(dctx);
+  truncate_precision(prec_bits, typesize, nbytes, src, truncated);
+  CUTEST_ASSERT("ERROR: bad roundtrip", memcmp(dest, truncated, nbytes) == 0);
+
+  /* Free resources */
+  free(cdata);
+  free(src);
+  free(truncated);
+  free(expected);
+  free(dest);
+  free(tmp);
+
+  return 0;
+}
+
+CUTEST_TEST_TEARDOWN(trunc_prec) {
+  blosc_destroy();
+}
+
+
+int main() {
+  CUTEST_TEST_RUN(trunc_prec)
+}
@@ -19,6 +19,7 @@ typedef struct {
   int32_t write;
   int32_t read;
   int32_t truncate;
+  int32_t pread;
 } test_udio_params;
 
 
@@ -75,6 +76,12 @@ int64_t test_truncate(void *stream, int64_t size) {
   return blosc2_stdio_truncate(my->bfile, size);
 }
 
+int64_t test_pread(void *ptr, int64_t size, int64_t nitems, int64_t offset, void *stream) {
+  test_file *my = (test_file *) stream;
+  my->params->pread++;
+  return blosc2_stdio_pread(ptr, size, nitems, offset, my->bfile);
+}
+
 
 typedef struct {
   bool contiguous;
@@ -101,6 +108,14 @@ CUTEST_TEST_SETUP(udio) {
 
   blosc2_register_io_cb(&io_cb);
 
+  // The same, but with positional reads
+  io_cb.id = 245;
+  blosc2_register_io_cb(&io_cb);
+  blosc2_io_ext_cb io_ext = {0};
+  io_ext.id = 245;
+  io_ext.pread = (blosc2_pread_cb) test_pread;
+  blosc2_register_io_ext_cb(&io_ext);
+
   data->cparams = BLOSC2_CPARAMS_DEFAULTS;
   data->cparams.typesize = sizeof(int32_t);
   data->cparams.compcode = BLOSC_BLOSCLZ;
@@ -111,11 +126,16 @@ CUTEST_TEST_SETUP(udio) {
       {true, "test_udio.b2frame"}, // disk - cframe
       {false, "test_udio_s.b2frame"}, // disk - sframe
   ));
+  CUTEST_PARAMETRIZE(io_id, uint8_t, CUTEST_DATA(
+      244,
+      245,
+  ));
 }
 
 
 CUTEST_TEST_TEST(udio) {
   CUTEST_GET_PARAMETER(backend, test_udio_backend);
+  CUTEST_GET_PARAMETER(io_id, uint8_t);
 
   /* Free resources */
   blosc2_remove_urlpath(backend.urlpath);
@@ -132,7 +152,7 @@ CUTEST_TEST_TEST(udio) {
   cparams.nthreads = 2;
 
   test_udio_params io_params = {0};
-  blosc2_io io = {.id = 244, .params = &io_params};
+  blosc2_io io = {.id = io_id, .params = &io_params};
   blosc2_storage storage = {.cparams=&cparams, .contiguous=backend.contiguous, .urlpath = backend.urlpath, .io=&io};
 
   blosc2_schunk *schunk = blosc2_schunk_new(&storage);
@@ -159,6 +179,9 @@ CUTEST_TEST_TEST(udio) {
   CUTEST_ASSERT("Write must be positive", io_params.write > 0);
   CUTEST_ASSERT("Read must be positive", io_params.read > 0);
   CUTEST_ASSERT("Truncate must be positive", io_params.truncate > 0);
+  if (io_id == 245) {
+    CUTEST_ASSERT("Pread must be positive", io_params.pread > 0);
+  }
 
   blosc2_schunk_free(schunk);
   blosc2_schunk_free(schunk2);